@@ -11,12 +11,14 @@
 #endif
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/FileWatcher.h"
 #include "Core/Math/Random.h"
 #include "Core/Process/Process.h"
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AStackString.h"
 
 // system
+#include <memory.h> // for memcmp
 #if defined( __LINUX__ )
     #include <unistd.h>
 #endif
@@ -33,8 +35,11 @@ private:
     void FileCopy() const;
     void FileCopySymlink() const;
     void FileMove() const;
+    void FileHardLink() const;
     void ReadOnly() const;
     void FileTime() const;
+    void FileTimeBatch() const;
+    void FileWatcherChanges() const;
     void LongPaths() const;
     #if defined( __WINDOWS__ )
         void NormalizeWindowsPathCasing() const;
@@ -53,8 +58,11 @@ REGISTER_TESTS_BEGIN( TestFileIO )
     REGISTER_TEST( FileCopy )
     REGISTER_TEST( FileCopySymlink )
     REGISTER_TEST( FileMove )
+    REGISTER_TEST( FileHardLink )
     REGISTER_TEST( ReadOnly )
     REGISTER_TEST( FileTime )
+    REGISTER_TEST( FileTimeBatch )
+    REGISTER_TEST( FileWatcherChanges )
     REGISTER_TEST( LongPaths )
     #if defined( __WINDOWS__ )
         REGISTER_TEST( NormalizeWindowsPathCasing )
@@ -238,6 +246,49 @@ void TestFileIO::FileMove() const
     VERIFY( FileIO::FileDelete( pathCopy.Get() ) );
 }
 
+// FileHardLink
+//------------------------------------------------------------------------------
+void TestFileIO::FileHardLink() const
+{
+    // generate a process unique file path
+    AStackString<> path;
+    GenerateTempFileName( path );
+
+    // generate link file name
+    AStackString<> pathLink( path );
+    pathLink += ".link";
+
+    // make sure nothing is left from previous runs
+    FileIO::FileDelete( path.Get() );
+    FileIO::FileDelete( pathLink.Get() );
+
+    // create it
+    const char data[] = "HardLinkContent";
+    FileStream f;
+    TEST_ASSERT( f.Open( path.Get(), FileStream::WRITE_ONLY ) == true );
+    TEST_ASSERT( f.Write( data, sizeof( data ) ) == sizeof( data ) );
+    f.Close();
+
+    // link it
+    TEST_ASSERT( FileIO::FileHardLink( path, pathLink ) );
+    TEST_ASSERT( FileIO::FileExists( path.Get() ) == true );
+    TEST_ASSERT( FileIO::FileExists( pathLink.Get() ) == true );
+
+    // linking over an existing file fails
+    TEST_ASSERT( FileIO::FileHardLink( path, pathLink ) == false );
+
+    // link remains valid after original is deleted
+    VERIFY( FileIO::FileDelete( path.Get() ) );
+    char buffer[ sizeof( data ) ];
+    TEST_ASSERT( f.Open( pathLink.Get(), FileStream::READ_ONLY ) == true );
+    TEST_ASSERT( f.Read( buffer, sizeof( buffer ) ) == sizeof( buffer ) );
+    f.Close();
+    TEST_ASSERT( memcmp( data, buffer, sizeof( data ) ) == 0 );
+
+    // cleanup
+    VERIFY( FileIO::FileDelete( pathLink.Get() ) );
+}
+
 // ReadOnly
 //------------------------------------------------------------------------------
 void TestFileIO::ReadOnly() const
@@ -313,6 +364,164 @@ void TestFileIO::FileTime() const
     TEST_ASSERT( timeNow == oldTime );
 }
 
+// FileTimeBatch
+//------------------------------------------------------------------------------
+void TestFileIO::FileTimeBatch() const
+{
+    // Two files in the same directory, and one which doesn't exist
+    AStackString<> pathA;
+    AStackString<> pathB;
+    AStackString<> pathMissing;
+    GenerateTempFileName( pathA );
+    GenerateTempFileName( pathB );
+    GenerateTempFileName( pathMissing );
+    FileIO::FileDelete( pathMissing.Get() );
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( pathA.Get(), FileStream::WRITE_ONLY ) == true );
+        f.Close();
+        TEST_ASSERT( f.Open( pathB.Get(), FileStream::WRITE_ONLY ) == true );
+        f.Close();
+    }
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( pathB, FileIO::GetFileLastWriteTime( pathA ) + 10000000000ULL ) );
+
+    // Batched times should match those retrieved individually
+    const AString * fileNames[] = { &pathA, &pathB, &pathMissing, &pathA };
+    uint64_t fileTimes[ 4 ] = { 1, 1, 1, 1 };
+    FileIO::GetFileLastWriteTimes( fileNames, 4, fileTimes );
+    TEST_ASSERT( fileTimes[ 0 ] == FileIO::GetFileLastWriteTime( pathA ) );
+    TEST_ASSERT( fileTimes[ 1 ] == FileIO::GetFileLastWriteTime( pathB ) );
+    TEST_ASSERT( fileTimes[ 0 ] != fileTimes[ 1 ] );
+    TEST_ASSERT( fileTimes[ 2 ] == 0 );
+    TEST_ASSERT( fileTimes[ 3 ] == fileTimes[ 0 ] );
+
+    FileIO::FileDelete( pathA.Get() );
+    FileIO::FileDelete( pathB.Get() );
+}
+
+// FileWatcherChanges
+//------------------------------------------------------------------------------
+void TestFileIO::FileWatcherChanges() const
+{
+    if ( FileWatcher::IsSupported() == false )
+    {
+        return;
+    }
+
+    // Directory with a sub-directory
+    AStackString<> dir;
+    GenerateTempFileName( dir );
+    AStackString<> subDir( dir );
+    subDir += "/Sub";
+    TEST_ASSERT( FileIO::EnsurePathExists( subDir ) );
+
+    FileWatcher watcher;
+    TEST_ASSERT( watcher.AddDirectory( dir, true ) );
+
+    // No changes yet
+    Array< AString > changes;
+    Array< AString > dirChanges;
+    bool allChanged = true;
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( changes.IsEmpty() );
+    TEST_ASSERT( dirChanges.IsEmpty() );
+    TEST_ASSERT( allChanged == false );
+
+    // Create a file in the sub-directory
+    AStackString<> file( subDir );
+    file += "/File.txt";
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( file.Get(), FileStream::WRITE_ONLY ) == true );
+        f.Close();
+    }
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( changes.IsEmpty() == false );
+    for ( const AString & change : changes )
+    {
+        TEST_ASSERT( change == file );
+    }
+    TEST_ASSERT( dirChanges.IsEmpty() );
+    TEST_ASSERT( allChanged == false );
+
+    // Nothing further changed
+    changes.Clear();
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( changes.IsEmpty() );
+    TEST_ASSERT( dirChanges.IsEmpty() );
+    TEST_ASSERT( allChanged == false );
+
+    // A directory which doesn't exist yet is noticed when created
+    AStackString<> missingDir( subDir );
+    missingDir += "/Missing";
+    TEST_ASSERT( watcher.AddDirectory( missingDir, false ) );
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    TEST_ASSERT( FileIO::EnsurePathExists( missingDir ) );
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    TEST_ASSERT( changes.IsEmpty() );
+    TEST_ASSERT( dirChanges.Find( missingDir ) );
+
+    // ...and is then watched itself
+    AStackString<> missingDirFile( missingDir );
+    missingDirFile += "/File.txt";
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( missingDirFile.Get(), FileStream::WRITE_ONLY ) == true );
+        f.Close();
+    }
+    dirChanges.Clear();
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    TEST_ASSERT( changes.Find( missingDirFile ) );
+    TEST_ASSERT( dirChanges.IsEmpty() );
+
+    // Deleting a directory is reported as a change to that directory
+    changes.Clear();
+    TEST_ASSERT( FileIO::FileDelete( missingDirFile.Get() ) );
+    TEST_ASSERT( FileIO::DirectoryDelete( missingDir ) );
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    TEST_ASSERT( changes.Find( missingDirFile ) );
+    TEST_ASSERT( dirChanges.Find( missingDir ) );
+
+    // Renaming a directory is reported as a change to both directories
+    AStackString<> renamedDir( dir );
+    renamedDir += "/Renamed";
+    changes.Clear();
+    dirChanges.Clear();
+    TEST_ASSERT( FileIO::FileMove( subDir, renamedDir ) );
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    TEST_ASSERT( dirChanges.Find( subDir ) );
+    TEST_ASSERT( dirChanges.Find( renamedDir ) );
+
+    // ...and changes are reported using the current path after renaming back
+    TEST_ASSERT( FileIO::FileMove( renamedDir, subDir ) );
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    changes.Clear();
+    dirChanges.Clear();
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( file.Get(), FileStream::WRITE_ONLY ) == true );
+        f.Close();
+    }
+    watcher.GetChanges( changes, dirChanges, allChanged );
+    TEST_ASSERT( allChanged == false );
+    TEST_ASSERT( changes.IsEmpty() == false );
+    for ( const AString & change : changes )
+    {
+        TEST_ASSERT( change == file );
+    }
+
+    // Cleanup
+    TEST_ASSERT( FileIO::FileDelete( file.Get() ) );
+    TEST_ASSERT( FileIO::DirectoryDelete( subDir ) );
+    TEST_ASSERT( FileIO::DirectoryDelete( dir ) );
+}
+
 // LongPaths
 //------------------------------------------------------------------------------
 void TestFileIO::LongPaths() const
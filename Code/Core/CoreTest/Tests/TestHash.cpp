@@ -25,6 +25,7 @@ private:
 
     void CompareHashTimes_Large() const;
     void CompareHashTimes_Small() const;
+    void xxHash3_Calc64Lower() const;
 };
 
 // Register Tests
@@ -32,6 +33,7 @@ private:
 REGISTER_TESTS_BEGIN( TestHash )
     REGISTER_TEST( CompareHashTimes_Large )
     REGISTER_TEST( CompareHashTimes_Small )
+    REGISTER_TEST( xxHash3_Calc64Lower )
 REGISTER_TESTS_END
 
 // CompareHashTimes_Large
@@ -267,6 +269,42 @@ void TestHash::CompareHashTimes_Small() const
         const float speed = ( (float)dataSize / (float)( 1024 * 1024 * 1024 ) ) / time;
         OUTPUT( "CRC32Lower      : %2.3fs @ %6.3f GiB/s (hash: 0x%x)\n", (double)time, (double)speed, crc );
     }
+
+    // xxHash3 - 64 Lower
+    {
+        const Timer t;
+        uint64_t crc( 0 );
+        for ( size_t j = 0; j < numIterations; ++j )
+        {
+            for ( size_t i = 0; i < numStrings; ++i )
+            {
+                crc += xxHash3::Calc64Lower( strings[ i ].Get(), strings[ i ].GetLength() );
+            }
+        }
+        const float time = t.GetElapsed();
+        const float speed = ( (float)dataSize / (float)( 1024 * 1024 * 1024 ) ) / time;
+        OUTPUT( "xxHash3-64Lower : %2.3fs @ %6.3f GiB/s (hash: %016" PRIx64 ")\n", (double)time, (double)speed, crc );
+    }
+}
+
+// xxHash3_Calc64Lower
+//------------------------------------------------------------------------------
+void TestHash::xxHash3_Calc64Lower() const
+{
+    // Mixed case strings of various lengths, including those hashed in several chunks
+    AString mixedCase;
+    for ( uint32_t len = 0; len < 1100; ++len )
+    {
+        const uint64_t hash = xxHash3::Calc64Lower( mixedCase );
+
+        // Must match hashing the lower case string
+        AString lowerCase( mixedCase );
+        lowerCase.ToLower();
+        TEST_ASSERT( hash == xxHash3::Calc64( lowerCase ) );
+        TEST_ASSERT( hash == xxHash3::Calc64Lower( lowerCase ) );
+
+        mixedCase += (char)( ( len % 2 ) ? ( 'A' + ( len % 26 ) ) : ( 'a' + ( len % 26 ) ) );
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -7,6 +7,7 @@
 
 // Core
 #include "Core/Containers/UniquePtr.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Network/TCPConnectionPool.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/Semaphore.h"
@@ -17,6 +18,9 @@
 #include "Core/Tracing/Tracing.h"
 
 #include <memory.h> // for memset
+#if !defined( __WINDOWS__ )
+    #include <sys/resource.h> // for getrlimit
+#endif
 
 // Defines
 //------------------------------------------------------------------------------
@@ -47,11 +51,14 @@ private:
     void TestMultipleServersOneClient() const;
     void TestConnectionCount() const;
     void TestDataTransfer() const;
+    void TestGatherSend() const;
 
     void TestConnectionStuckDuringSend() const;
     static uint32_t TestConnectionStuckDuringSend_ThreadFunc( void * userData );
 
     void TestConnectionFailure() const;
+    void TestConnectMultiple() const;
+    void TestManyConnections() const;
 };
 
 // Helper Macros
@@ -74,8 +81,11 @@ REGISTER_TESTS_BEGIN( TestTestTCPConnectionPool )
     REGISTER_TEST( TestMultipleServersOneClient )
     REGISTER_TEST( TestConnectionCount )
     REGISTER_TEST( TestDataTransfer )
+    REGISTER_TEST( TestGatherSend )
     REGISTER_TEST( TestConnectionStuckDuringSend )
     REGISTER_TEST( TestConnectionFailure )
+    REGISTER_TEST( TestConnectMultiple )
+    REGISTER_TEST( TestManyConnections )
 REGISTER_TESTS_END
 
 // TestOneServerMultipleClients
@@ -264,6 +274,86 @@ void TestTestTCPConnectionPool::TestDataTransfer() const
     client.ShutdownAllConnections();
 }
 
+// TestGatherSend
+//------------------------------------------------------------------------------
+void TestTestTCPConnectionPool::TestGatherSend() const
+{
+    // a server which expects a message followed by a payload
+    class TestServer : public TCPConnectionPool
+    {
+    public:
+        virtual ~TestServer() override { ShutdownAllConnections(); }
+        virtual void OnReceive( const ConnectionInfo *, void * data, uint32_t size, bool & ) override
+        {
+            if ( m_ExpectPayload == false )
+            {
+                TEST_ASSERT( size == m_MessageSize );
+                TEST_ASSERT( memcmp( data, m_ExpectedMessage, size ) == 0 );
+            }
+            else
+            {
+                TEST_ASSERT( size == m_PayloadSize );
+                TEST_ASSERT( memcmp( data, m_ExpectedPayload, size ) == 0 );
+                m_PayloadReceivedSemaphore.Signal();
+            }
+            m_ExpectPayload = !m_ExpectPayload;
+        }
+        bool m_ExpectPayload = false;
+        uint32_t m_MessageSize = 0;
+        const char * m_ExpectedMessage = nullptr;
+        uint32_t m_PayloadSize = 0;
+        const char * m_ExpectedPayload = nullptr;
+        Semaphore m_PayloadReceivedSemaphore;
+    };
+
+    const uint16_t testPort( TEST_PORT );
+
+    // some data, initialized to a known pattern
+    const uint32_t dataSize( 1024 * 1024 * 4 );
+    UniquePtr< char > data( (char *)ALLOC( dataSize ) );
+    for ( uint32_t i = 0; i < dataSize; ++i )
+    {
+        data.Get()[ i ] = (char)( i * 7 );
+    }
+
+    // Split the data into more buffers than can be sent in one go, of varying
+    // sizes (including empty buffers) so partial sends cross buffer boundaries
+    Array< TCPConnectionPool::SendBuffer > buffers;
+    uint32_t offset = 0;
+    uint32_t bufferSize = 0;
+    while ( offset < dataSize )
+    {
+        const uint32_t size = Math::Min( bufferSize, dataSize - offset );
+        buffers.Append( TCPConnectionPool::SendBuffer{ size, data.Get() + offset } );
+        offset += size;
+        bufferSize = ( bufferSize * 2 ) + 1;
+    }
+    TEST_ASSERT( buffers.GetSize() > 16 );
+
+    const char message[] = "Message";
+
+    TestServer server;
+    server.m_MessageSize = sizeof( message );
+    server.m_ExpectedMessage = message;
+    server.m_PayloadSize = dataSize;
+    server.m_ExpectedPayload = data.Get();
+    TEST_ASSERT( server.Listen( testPort ) );
+
+    // client
+    TCPConnectionPool client;
+    const ConnectionInfo * ci = client.Connect( AStackString<>( "127.0.0.1" ), testPort );
+    TEST_ASSERT( ci );
+
+    // Payload gathered from many buffers must arrive as one contiguous payload
+    for ( uint32_t i = 0; i < 4; ++i )
+    {
+        TEST_ASSERT( client.Send( ci, message, sizeof( message ), buffers.Begin(), (uint32_t)buffers.GetSize() ) );
+        server.m_PayloadReceivedSemaphore.Wait();
+    }
+
+    client.ShutdownAllConnections();
+}
+
 // TestConnectionStuckDuringSend
 //------------------------------------------------------------------------------
 void TestTestTCPConnectionPool::TestConnectionStuckDuringSend() const
@@ -342,4 +432,135 @@ void TestTestTCPConnectionPool::TestConnectionFailure() const
     client.ShutdownAllConnections();
 }
 
+// TestConnectMultiple
+//------------------------------------------------------------------------------
+void TestTestTCPConnectionPool::TestConnectMultiple() const
+{
+    const uint16_t testPort( TEST_PORT );
+    const uint32_t timeoutMS( 1000 );
+    const uint32_t localHost( 0x0100007f ); // 127.0.0.1
+
+    TCPConnectionPool server;
+    TEST_ASSERT( server.Listen( testPort ) );
+    TCPConnectionPool client;
+
+    // several successful connections at once
+    Array< uint32_t > hostIPs;
+    Array< void * > userData;
+    for ( size_t i = 0; i < 4; ++i )
+    {
+        hostIPs.Append( localHost );
+        userData.Append( nullptr );
+    }
+    Array< const ConnectionInfo * > connections;
+    client.ConnectMultiple( hostIPs, testPort, timeoutMS, userData, connections );
+    TEST_ASSERT( connections.GetSize() == hostIPs.GetSize() );
+    for ( const ConnectionInfo * ci : connections )
+    {
+        TEST_ASSERT( ci != nullptr );
+    }
+    WAIT_UNTIL_WITH_TIMEOUT( server.GetNumConnections() == hostIPs.GetSize() );
+
+    // several failures at once are reported without waiting for the timeout
+    const Timer t;
+    client.ConnectMultiple( hostIPs, (uint16_t)( testPort + 1 ), timeoutMS, userData, connections );
+    TEST_ASSERT( connections.GetSize() == hostIPs.GetSize() );
+    for ( const ConnectionInfo * ci : connections )
+    {
+        TEST_ASSERT( ci == nullptr );
+    }
+    #if !defined( __WINDOWS__ ) // Refused connections are retried for several seconds on Windows
+        TEST_ASSERT( t.GetElapsedMS() < (float)timeoutMS );
+    #endif
+
+    client.ShutdownAllConnections();
+    server.ShutdownAllConnections();
+}
+
+// TestManyConnections
+//------------------------------------------------------------------------------
+void TestTestTCPConnectionPool::TestManyConnections() const
+{
+    // a server which counts the messages it receives
+    class CountingServer : public TCPConnectionPool
+    {
+    public:
+        virtual ~CountingServer() override { ShutdownAllConnections(); }
+        virtual void OnReceive( const ConnectionInfo *, void *, uint32_t, bool & ) override
+        {
+            m_NumReceived.Increment();
+        }
+        Atomic< uint32_t > m_NumReceived{ 0 };
+    };
+
+    const uint16_t testPort( TEST_PORT );
+    const uint32_t localHost( 0x0100007f ); // 127.0.0.1
+
+    // Each connection uses a socket at both ends
+    uint32_t numConnections = 1000;
+    #if !defined( __WINDOWS__ )
+        struct rlimit limit;
+        if ( getrlimit( RLIMIT_NOFILE, &limit ) == 0 )
+        {
+            const rlim_t required = ( ( numConnections * 2 ) + 64 );
+            if ( ( limit.rlim_cur != RLIM_INFINITY ) && ( limit.rlim_cur < required ) )
+            {
+                limit.rlim_cur = ( limit.rlim_max == RLIM_INFINITY ) ? required : Math::Min( required, limit.rlim_max );
+                setrlimit( RLIMIT_NOFILE, &limit );
+                VERIFY( getrlimit( RLIMIT_NOFILE, &limit ) == 0 );
+                numConnections = Math::Min( numConnections, (uint32_t)( ( limit.rlim_cur - 64 ) / 2 ) );
+            }
+        }
+    #endif
+
+    CountingServer server;
+    TEST_ASSERT( server.Listen( testPort ) );
+    TCPConnectionPool client;
+
+    // connect
+    const Timer timer;
+    Array< const ConnectionInfo * > connections( numConnections );
+    {
+        const uint32_t batchSize = 100;
+        Array< uint32_t > hostIPs;
+        Array< void * > userData;
+        Array< const ConnectionInfo * > batch;
+        while ( connections.GetSize() < numConnections )
+        {
+            const uint32_t num = Math::Min( batchSize, numConnections - (uint32_t)connections.GetSize() );
+            hostIPs.SetSize( num );
+            userData.SetSize( num );
+            for ( uint32_t i = 0; i < num; ++i )
+            {
+                hostIPs[ i ] = localHost;
+                userData[ i ] = nullptr;
+            }
+            client.ConnectMultiple( hostIPs, testPort, 5000, userData, batch );
+            for ( const ConnectionInfo * ci : batch )
+            {
+                TEST_ASSERT( ci );
+                connections.Append( ci );
+            }
+        }
+    }
+    WAIT_UNTIL_WITH_TIMEOUT( server.GetNumConnections() == numConnections );
+    const float connectTime = timer.GetElapsedMS();
+
+    // send a message on every connection
+    const uint32_t msg = 0x12345678;
+    for ( const ConnectionInfo * ci : connections )
+    {
+        TEST_ASSERT( client.Send( ci, &msg, sizeof( msg ) ) );
+    }
+    WAIT_UNTIL_WITH_TIMEOUT( server.m_NumReceived.Load() == numConnections );
+    const float sendTime = ( timer.GetElapsedMS() - connectTime );
+
+    // disconnect
+    client.ShutdownAllConnections();
+    WAIT_UNTIL_WITH_TIMEOUT( server.GetNumConnections() == 0 );
+    const float disconnectTime = ( timer.GetElapsedMS() - connectTime - sendTime );
+
+    OUTPUT( "Connections: %u, Connect: %2.1f ms, Send: %2.1f ms, Disconnect: %2.1f ms\n", numConnections, (double)connectTime, (double)sendTime, (double)disconnectTime );
+}
+
 //------------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #endif
 #if defined( __LINUX__ )
     #include <fcntl.h>
+    #include <string.h> // for memcmp
     #include <sys/sendfile.h>
 #endif
 #if defined( __APPLE__ )
@@ -296,6 +297,20 @@
 #endif
 }
 
+// FileHardLink
+//------------------------------------------------------------------------------
+/*static*/ bool FileIO::FileHardLink( const AString & srcFileName, const AString & dstFileName )
+{
+    // NOTE: Fails if dstFileName already exists, or if the files are on different volumes
+#if defined( __WINDOWS__ )
+    return ( TRUE == ::CreateHardLink( dstFileName.Get(), srcFileName.Get(), nullptr ) );
+#elif defined( __LINUX__ ) || defined( __APPLE__ )
+    return ( link( srcFileName.Get(), dstFileName.Get() ) == 0 );
+#else
+    #error Unknown platform
+#endif
+}
+
 // GetFiles
 //------------------------------------------------------------------------------
 /*static*/ bool FileIO::GetFiles( const AString & path,
@@ -770,6 +785,68 @@
     return 0;
 }
 
+// GetFileLastWriteTimes
+//------------------------------------------------------------------------------
+/*static*/ void FileIO::GetFileLastWriteTimes( const AString * const * fileNames, size_t numFiles, uint64_t * outFileTimes )
+{
+    #if defined( __LINUX__ )
+        // Consecutive files in the same directory are stat'd relative to a shared
+        // handle for that directory, avoiding resolving the full path each time
+        int dirFD = -1;
+        const char * dirName = nullptr; // Directory dirFD refers to (not terminated)
+        size_t dirNameLen = 0;
+        for ( size_t i = 0; i < numFiles; ++i )
+        {
+            const AString & fileName = *fileNames[ i ];
+            const char * lastSlash = fileName.FindLast( '/' );
+            if ( lastSlash == nullptr )
+            {
+                outFileTimes[ i ] = GetFileLastWriteTime( fileName );
+                continue;
+            }
+
+            // Open the directory if it differs from the previous file
+            const size_t len = (size_t)( lastSlash - fileName.Get() );
+            if ( ( dirName == nullptr ) || ( len != dirNameLen ) || ( memcmp( dirName, fileName.Get(), len ) != 0 ) )
+            {
+                if ( dirFD != -1 )
+                {
+                    close( dirFD );
+                }
+                const AStackString<> dir( fileName.Get(), lastSlash + 1 ); // Keep slash to handle root
+                dirFD = open( dir.Get(), O_PATH | O_DIRECTORY | O_CLOEXEC );
+                dirName = fileName.Get();
+                dirNameLen = len;
+            }
+
+            if ( dirFD == -1 )
+            {
+                outFileTimes[ i ] = GetFileLastWriteTime( fileName );
+                continue;
+            }
+
+            struct stat st;
+            if ( fstatat( dirFD, lastSlash + 1, &st, AT_SYMLINK_NOFOLLOW ) == 0 )
+            {
+                outFileTimes[ i ] = ( ( (uint64_t)st.st_mtim.tv_sec * 1000000000ULL ) + (uint64_t)st.st_mtim.tv_nsec );
+            }
+            else
+            {
+                outFileTimes[ i ] = 0;
+            }
+        }
+        if ( dirFD != -1 )
+        {
+            close( dirFD );
+        }
+    #else
+        for ( size_t i = 0; i < numFiles; ++i )
+        {
+            outFileTimes[ i ] = GetFileLastWriteTime( *fileNames[ i ] );
+        }
+    #endif
+}
+
 // SetFileLastWriteTime
 //------------------------------------------------------------------------------
 /*static*/ bool FileIO::SetFileLastWriteTime( const AString & fileName, uint64_t fileTime )
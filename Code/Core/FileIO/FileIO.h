@@ -21,6 +21,7 @@ public:
     static bool FileDelete( const char * fileName );
     static bool FileCopy( const char * srcFileName, const char * dstFileName, bool allowOverwrite = true );
     static bool FileMove( const AString & srcFileName, const AString & dstFileName );
+    static bool FileHardLink( const AString & srcFileName, const AString & dstFileName );
     static bool DirectoryDelete( const AString & path );
 
     // directory listing
@@ -60,6 +61,7 @@ public:
     #endif
 
     static uint64_t GetFileLastWriteTime( const AString & fileName );
+    static void     GetFileLastWriteTimes( const AString * const * fileNames, size_t numFiles, uint64_t * outFileTimes );
     static bool     SetFileLastWriteTime( const AString & fileName, uint64_t fileTime );
     static bool     SetFileLastWriteTimeToNow( const AString & fileName );
 
@@ -70,9 +70,18 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
         }
         else if ( ( fileMode & WRITE_ONLY ) != 0 )
         {
-            desiredAccess       |= GENERIC_WRITE;
-            shareMode           |= FILE_SHARE_READ; // allow other readers
-            creationDisposition |= CREATE_ALWAYS; // overwrite existing
+            if ( ( fileMode & APPEND ) != 0 )
+            {
+                desiredAccess       |= FILE_APPEND_DATA; // all writes go to end of file
+                shareMode           |= FILE_SHARE_READ; // allow other readers
+                creationDisposition |= OPEN_ALWAYS; // keep existing
+            }
+            else
+            {
+                desiredAccess       |= GENERIC_WRITE;
+                shareMode           |= FILE_SHARE_READ; // allow other readers
+                creationDisposition |= CREATE_ALWAYS; // overwrite existing
+            }
         }
         else
         {
@@ -132,7 +141,8 @@ bool FileStream::Open( const char * fileName, uint32_t fileMode )
         }
         else if ( ( fileMode & WRITE_ONLY ) != 0 )
         {
-            flags |= ( O_WRONLY | O_CREAT | O_TRUNC );
+            flags |= ( O_WRONLY | O_CREAT );
+            flags |= ( ( fileMode & APPEND ) != 0 ) ? O_APPEND : O_TRUNC;
         }
         else
         {
@@ -18,6 +18,7 @@ public:
         READ_ONLY                     = 0x1,
         WRITE_ONLY                    = 0x2,
         TEMP                          = 0x4,
+        APPEND                        = 0x8, // With WRITE_ONLY: keep existing contents and write to end
         NO_RETRY_ON_SHARING_VIOLATION = 0x80,
     };
 
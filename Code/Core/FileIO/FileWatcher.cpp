@@ -0,0 +1,406 @@
+// FileWatcher
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FileWatcher.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/Strings/AStackString.h"
+
+// system
+#if defined( __LINUX__ )
+    #include <dirent.h>
+    #include <errno.h>
+    #include <sys/inotify.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+FileWatcher::FileWatcher()
+    : m_AllChanged( false )
+    , m_RetryMissingDirs( false )
+    , m_MissingDirs( 0, true )
+    #if defined( __LINUX__ )
+        , m_INotifyFD( inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) )
+        , m_WatchDescriptorPaths( 1024, true )
+        , m_WatchDescriptorRecursive( 1024, true )
+    #endif
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+FileWatcher::~FileWatcher()
+{
+    #if defined( __LINUX__ )
+        if ( m_INotifyFD != -1 )
+        {
+            close( m_INotifyFD ); // Removes all watches
+        }
+    #endif
+}
+
+// IsSupported
+//------------------------------------------------------------------------------
+/*static*/ bool FileWatcher::IsSupported()
+{
+    #if defined( __LINUX__ )
+        return true;
+    #else
+        // Not implemented on Windows (ReadDirectoryChangesW) or OSX (FSEvents).
+        // GetChanges always reports everything as changed (including when only
+        // a directory was created or deleted), so callers remain correct, just
+        // without the benefit of incremental change tracking.
+        return false;
+    #endif
+}
+
+// AddDirectory
+//------------------------------------------------------------------------------
+bool FileWatcher::AddDirectory( const AString & path, bool recursive )
+{
+    // Normalize so each directory is only watched once
+    AStackString<> dir( path );
+    while ( ( dir.GetLength() > 1 ) && ( dir.EndsWith( '/' ) || dir.EndsWith( '\\' ) ) )
+    {
+        dir.SetLength( dir.GetLength() - 1 );
+    }
+
+    bool watchedParent = false;
+    if ( AddWatchOrParent( dir, recursive, watchedParent ) == false )
+    {
+        return false;
+    }
+
+    // Watch the directory itself once it is created
+    if ( watchedParent )
+    {
+        AddMissingDir( dir, recursive );
+    }
+    return true;
+}
+
+// AddMissingDir
+//------------------------------------------------------------------------------
+void FileWatcher::AddMissingDir( const AString & path, bool recursive )
+{
+    for ( MissingDir & missingDir : m_MissingDirs )
+    {
+        if ( missingDir.m_Path == path )
+        {
+            missingDir.m_Recursive = ( missingDir.m_Recursive || recursive );
+            return; // Already waiting for this directory
+        }
+    }
+    MissingDir & missingDir = m_MissingDirs.EmplaceBack();
+    missingDir.m_Path = path;
+    missingDir.m_Recursive = recursive;
+}
+
+// AddWatchOrParent
+//------------------------------------------------------------------------------
+bool FileWatcher::AddWatchOrParent( const AString & path, bool recursive, bool & outWatchedParent )
+{
+    outWatchedParent = false;
+
+    AStackString<> dir( path );
+    for ( ;; )
+    {
+        if ( AddWatch( dir, recursive ) )
+        {
+            return true;
+        }
+
+        // Watching can fail if limits are exceeded, in which case changes in
+        // this directory can't be seen
+        if ( FileIO::DirectoryExists( dir ) )
+        {
+            m_AllChanged = true;
+            return false;
+        }
+
+        // For a directory which doesn't exist, watch the closest parent which does
+        // instead, so the directory being created will be noticed
+        const char * lastSlash = dir.FindLast( '/' );
+        lastSlash = lastSlash ? lastSlash : dir.FindLast( '\\' );
+        if ( ( lastSlash == nullptr ) || ( lastSlash == dir.Get() ) )
+        {
+            m_AllChanged = true;
+            return false;
+        }
+        dir.SetLength( (uint32_t)( lastSlash - dir.Get() ) );
+        recursive = false;
+        outWatchedParent = true;
+    }
+}
+
+// GetChanges
+//------------------------------------------------------------------------------
+void FileWatcher::GetChanges( Array< AString > & outChangedFiles, Array< AString > & outChangedDirs, bool & outAllChanged )
+{
+    #if defined( __LINUX__ )
+        if ( m_INotifyFD == -1 )
+        {
+            m_AllChanged = true;
+        }
+        else
+        {
+            // Drain all pending events
+            alignas( struct inotify_event ) char buffer[ 64 * 1024 ];
+            for ( ;; )
+            {
+                const ssize_t len = read( m_INotifyFD, buffer, sizeof( buffer ) );
+                if ( len <= 0 )
+                {
+                    if ( ( len < 0 ) && ( errno == EINTR ) )
+                    {
+                        continue;
+                    }
+                    break; // EAGAIN - no more events
+                }
+
+                const char * pos = buffer;
+                const char * const end = ( buffer + len );
+                while ( pos < end )
+                {
+                    const struct inotify_event * event = reinterpret_cast< const struct inotify_event * >( pos );
+                    pos += ( sizeof( struct inotify_event ) + event->len );
+
+                    if ( event->mask & IN_Q_OVERFLOW )
+                    {
+                        m_AllChanged = true; // Events were lost
+                        continue;
+                    }
+
+                    const bool knownWatch = ( event->wd >= 0 ) &&
+                                            ( (size_t)event->wd < m_WatchDescriptorPaths.GetSize() ) &&
+                                            ( m_WatchDescriptorPaths[ (size_t)event->wd ].IsEmpty() == false );
+                    if ( knownWatch == false )
+                    {
+                        continue; // Event for a watch already removed
+                    }
+                    const AString & dir = m_WatchDescriptorPaths[ (size_t)event->wd ];
+
+                    // Watched directory removed or renamed
+                    if ( event->mask & ( IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED ) )
+                    {
+                        outChangedDirs.Append( dir );
+                        if ( event->mask & IN_MOVE_SELF )
+                        {
+                            // Watches follow the directory, so would report changes
+                            // under the old path. Remove them (including those of
+                            // sub-directories), ignoring the IN_IGNORED which follows.
+                            AStackString<> dirPrefix( dir );
+                            dirPrefix += '/';
+                            for ( size_t wd = 0; wd < m_WatchDescriptorPaths.GetSize(); ++wd )
+                            {
+                                if ( m_WatchDescriptorPaths[ wd ].BeginsWith( dirPrefix ) )
+                                {
+                                    inotify_rm_watch( m_INotifyFD, (int)wd );
+                                    RemoveWatch( wd );
+                                }
+                            }
+                            inotify_rm_watch( m_INotifyFD, event->wd );
+                        }
+                        if ( event->mask & ( IN_MOVE_SELF | IN_IGNORED ) )
+                        {
+                            RemoveWatch( (size_t)event->wd ); // NOTE: Invalidates dir
+                        }
+                        continue;
+                    }
+
+                    // Sub-directory created, removed or renamed
+                    if ( event->mask & IN_ISDIR )
+                    {
+                        AString & subDir = outChangedDirs.EmplaceBack( dir );
+                        subDir += '/';
+                        subDir += event->name;
+                        if ( event->mask & ( IN_CREATE | IN_MOVED_TO ) )
+                        {
+                            if ( m_WatchDescriptorRecursive[ (size_t)event->wd ] )
+                            {
+                                AddWatch( subDir, true );
+                            }
+                            m_RetryMissingDirs = true; // Might be (or contain) a missing directory
+                        }
+                        continue;
+                    }
+
+                    // File changed
+                    AString & changedFile = outChangedFiles.EmplaceBack( dir );
+                    changedFile += '/';
+                    changedFile += event->name;
+                }
+            }
+
+            if ( m_RetryMissingDirs )
+            {
+                m_RetryMissingDirs = false;
+                RetryMissingDirs( outChangedDirs );
+            }
+        }
+    #else
+        (void)outChangedFiles;
+        (void)outChangedDirs;
+    #endif
+
+    // Without change notification, everything must be assumed to have changed
+    // NOTE: On Windows and OSX this is always the case, even if only a directory
+    // was created or deleted
+    outAllChanged = ( m_AllChanged || ( IsSupported() == false ) );
+    m_AllChanged = false;
+}
+
+// RetryMissingDirs
+//------------------------------------------------------------------------------
+void FileWatcher::RetryMissingDirs( Array< AString > & outChangedDirs )
+{
+    for ( size_t i = 0; i < m_MissingDirs.GetSize(); )
+    {
+        // Take a copy, as adding watches can add missing directories
+        const AStackString<> path( m_MissingDirs[ i ].m_Path );
+        const bool recursive = m_MissingDirs[ i ].m_Recursive;
+        bool watchedParent = false;
+        if ( AddWatchOrParent( path, recursive, watchedParent ) && ( watchedParent == false ) )
+        {
+            // Changes made in the directory before it was watched were missed
+            outChangedDirs.Append( path );
+            m_MissingDirs.EraseIndex( i );
+            continue;
+        }
+        ++i;
+    }
+}
+
+// RemoveWatch
+//  - Forget a watch which was removed, watching the directory again if it
+//    exists later
+//------------------------------------------------------------------------------
+void FileWatcher::RemoveWatch( size_t wd )
+{
+    #if defined( __LINUX__ )
+        AString & path = m_WatchDescriptorPaths[ wd ];
+        UnorderedMap< AString, int32_t >::KeyValue * watched = m_WatchedDirs.Find( path );
+        if ( watched && ( watched->m_Value == (int32_t)wd ) )
+        {
+            watched->m_Value = -1;
+        }
+        AddMissingDir( path, m_WatchDescriptorRecursive[ wd ] );
+        m_RetryMissingDirs = true;
+        path.Clear();
+    #else
+        (void)wd;
+    #endif
+}
+
+// AddWatch
+//------------------------------------------------------------------------------
+bool FileWatcher::AddWatch( const AString & path, bool recursive )
+{
+    #if defined( __LINUX__ )
+        if ( m_INotifyFD == -1 )
+        {
+            return false;
+        }
+
+        // Already watched?
+        UnorderedMap< AString, int32_t >::KeyValue * existing = m_WatchedDirs.Find( path );
+        if ( existing && ( existing->m_Value >= 0 ) && ( ( recursive == false ) || m_WatchDescriptorRecursive[ (size_t)existing->m_Value ] ) )
+        {
+            return true;
+        }
+
+        const uint32_t mask = ( IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_DELETE_SELF |
+                                IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR );
+        const int wd = inotify_add_watch( m_INotifyFD, path.Get(), mask );
+        if ( wd < 0 )
+        {
+            return false; // Directory doesn't exist or watch limit reached
+        }
+
+        // Record watch (the same descriptor is returned if the directory was
+        // previously watched via a different path, or was watched before being
+        // renamed, in which case the old path is no longer watched)
+        if ( ( (size_t)wd < m_WatchDescriptorPaths.GetSize() ) &&
+             ( m_WatchDescriptorPaths[ (size_t)wd ].IsEmpty() == false ) &&
+             ( m_WatchDescriptorPaths[ (size_t)wd ] != path ) )
+        {
+            const AString & previousPath = m_WatchDescriptorPaths[ (size_t)wd ];
+            UnorderedMap< AString, int32_t >::KeyValue * previous = m_WatchedDirs.Find( previousPath );
+            if ( previous )
+            {
+                previous->m_Value = -1;
+            }
+            if ( FileIO::DirectoryExists( previousPath ) == false )
+            {
+                AddMissingDir( previousPath, m_WatchDescriptorRecursive[ (size_t)wd ] );
+            }
+        }
+        if ( existing )
+        {
+            existing->m_Value = wd;
+        }
+        else
+        {
+            m_WatchedDirs.Insert( path, wd );
+        }
+        while ( m_WatchDescriptorPaths.GetSize() <= (size_t)wd )
+        {
+            m_WatchDescriptorPaths.EmplaceBack();
+            m_WatchDescriptorRecursive.Append( false );
+        }
+        m_WatchDescriptorPaths[ (size_t)wd ] = path;
+        m_WatchDescriptorRecursive[ (size_t)wd ] = ( recursive || m_WatchDescriptorRecursive[ (size_t)wd ] );
+
+        // Watch sub-directories
+        bool result = true;
+        if ( recursive )
+        {
+            DIR * d = opendir( path.Get() );
+            if ( d == nullptr )
+            {
+                return false;
+            }
+            while ( const struct dirent * entry = readdir( d ) )
+            {
+                if ( ( ( entry->d_type != DT_DIR ) && ( entry->d_type != DT_UNKNOWN ) ) ||
+                     ( AString::StrNCmp( entry->d_name, ".", 2 ) == 0 ) ||
+                     ( AString::StrNCmp( entry->d_name, "..", 3 ) == 0 ) )
+                {
+                    continue;
+                }
+                AStackString<> subDir( path );
+                if ( subDir.EndsWith( '/' ) == false )
+                {
+                    subDir += '/';
+                }
+                subDir += entry->d_name;
+
+                // Some file systems don't provide the type, so it must be queried.
+                // Symlinks are not followed, consistent with DT_LNK entries.
+                if ( entry->d_type == DT_UNKNOWN )
+                {
+                    struct stat st;
+                    if ( ( lstat( subDir.Get(), &st ) != 0 ) || ( S_ISDIR( st.st_mode ) == false ) )
+                    {
+                        continue;
+                    }
+                }
+                result &= AddWatch( subDir, true );
+            }
+            closedir( d );
+        }
+        return result;
+    #else
+        (void)path;
+        (void)recursive;
+        return false;
+    #endif
+}
+
+//------------------------------------------------------------------------------
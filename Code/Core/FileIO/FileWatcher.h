@@ -0,0 +1,63 @@
+// FileWatcher - track changes to files in a set of directories
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Containers/UnorderedMap.h"
+#include "Core/Strings/AString.h"
+
+// FileWatcher
+//------------------------------------------------------------------------------
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    // Change notification is only implemented on Linux (inotify). Elsewhere
+    // GetChanges always sets outAllChanged
+    [[nodiscard]] static bool IsSupported();
+
+    // Start watching a directory (and optionally its sub-directories). Adding a
+    // directory which is already watched is cheap. If the directory doesn't exist
+    // its closest existing parent is watched until it is created, and its creation
+    // is reported as a change.
+    bool AddDirectory( const AString & path, bool recursive );
+
+    // Retrieve files changed (modified, created or deleted) and directories
+    // changed (created, deleted or renamed) since the last call, without blocking.
+    // The contents of a changed directory are unknown, so callers should assume
+    // anything beneath it changed. If changes may have been missed (because of an
+    // overflow or a directory that couldn't be watched) outAllChanged is set and
+    // callers should assume everything changed.
+    // NOTE: Only implemented on Linux. On Windows and OSX outAllChanged is always
+    // set, so individual files and directories are never reported.
+    void GetChanges( Array< AString > & outChangedFiles, Array< AString > & outChangedDirs, bool & outAllChanged );
+
+private:
+    bool                AddWatch( const AString & path, bool recursive );
+    bool                AddWatchOrParent( const AString & path, bool recursive, bool & outWatchedParent );
+    void                AddMissingDir( const AString & path, bool recursive );
+    void                RetryMissingDirs( Array< AString > & outChangedDirs );
+    void                RemoveWatch( size_t wd );
+
+    struct MissingDir
+    {
+        AString         m_Path;
+        bool            m_Recursive;
+    };
+
+    bool                m_AllChanged;       // Changes may have been missed since last GetChanges
+    bool                m_RetryMissingDirs; // A directory was created or a watch was lost
+    Array< MissingDir > m_MissingDirs;      // Directories to watch which don't exist (a parent is watched instead)
+    #if defined( __LINUX__ )
+        int             m_INotifyFD;
+        UnorderedMap< AString, int32_t > m_WatchedDirs;     // Path -> watch descriptor
+        Array< AString > m_WatchDescriptorPaths;            // Watch descriptor -> path
+        Array< bool >   m_WatchDescriptorRecursive;         // Watch descriptor -> recursive
+    #endif
+};
+
+//------------------------------------------------------------------------------
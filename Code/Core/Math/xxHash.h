@@ -16,6 +16,13 @@ extern "C"
 
     // xxhash3
     unsigned long long xxHashLib_XXH3_64bits( const void * input, size_t length );
+
+    // xxhash3 (streaming) - state is opaque
+    void * xxHashLib_XXH3_createState( void );
+    int xxHashLib_XXH3_freeState( void * state );
+    int xxHashLib_XXH3_64bits_reset( void * state );
+    int xxHashLib_XXH3_64bits_update( void * state, const void * input, size_t length );
+    unsigned long long xxHashLib_XXH3_64bits_digest( const void * state );
 };
 
 // xxHash
@@ -40,6 +47,13 @@ public:
     inline static uint64_t  Calc64( const void * buffer, size_t len );
 
     inline static uint64_t  Calc64( const AString & string ) { return Calc64( string.Get(), string.GetLength() ); }
+
+    // Hash of lower case version of string (same as lowering and then hashing)
+    inline static uint64_t  Calc64Lower( const char * string, size_t len );
+    inline static uint64_t  Calc64Lower( const AString & string ) { return Calc64Lower( string.Get(), string.GetLength() ); }
+private:
+    enum : uint32_t { LOWER_CHUNK_SIZE = 256 }; // Strings up to this size are hashed without streaming
+    inline static void      ToLower( const char * src, size_t len, char * dst );
 };
 
 // Calc32
@@ -63,4 +77,43 @@ public:
     return xxHashLib_XXH3_64bits( buffer, len );
 }
 
+// Calc64Lower (xxHash3)
+//------------------------------------------------------------------------------
+/*static*/ uint64_t xxHash3::Calc64Lower( const char * string, size_t len )
+{
+    // Lower case on the stack, so typical strings are hashed without allocations
+    char buffer[ LOWER_CHUNK_SIZE ];
+    if ( len <= sizeof( buffer ) )
+    {
+        ToLower( string, len, buffer );
+        return Calc64( buffer, len );
+    }
+
+    // Stream longer strings a chunk at a time
+    void * state = xxHashLib_XXH3_createState();
+    xxHashLib_XXH3_64bits_reset( state );
+    while ( len > 0 )
+    {
+        const size_t chunkLen = ( len < sizeof( buffer ) ) ? len : sizeof( buffer );
+        ToLower( string, chunkLen, buffer );
+        xxHashLib_XXH3_64bits_update( state, buffer, chunkLen );
+        string += chunkLen;
+        len -= chunkLen;
+    }
+    const uint64_t hash = xxHashLib_XXH3_64bits_digest( state );
+    xxHashLib_XXH3_freeState( state );
+    return hash;
+}
+
+// ToLower (xxHash3)
+//------------------------------------------------------------------------------
+/*static*/ void xxHash3::ToLower( const char * src, size_t len, char * dst )
+{
+    for ( size_t i = 0; i < len; ++i )
+    {
+        const char c = src[ i ];
+        dst[ i ] = ( ( c >= 'A' ) && ( c <= 'Z' ) ) ? (char)( 'a' + ( c - 'A' ) ) : c;
+    }
+}
+
 //------------------------------------------------------------------------------
@@ -7,11 +7,13 @@
 
 // Core
 #include "Core/Containers/UniquePtr.h"
+#include "Core/Mem/Mem.h"
 #include "Core/Network/NetworkStartupHelper.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
 
 // system
 #if defined( __WINDOWS__ )
@@ -144,87 +146,117 @@
 // GetHostIPFromName
 //------------------------------------------------------------------------------
 /*static*/ uint32_t Network::GetHostIPFromName( const AString & hostName, uint32_t timeoutMS )
+{
+    Array< AString > hostNames;
+    hostNames.Append( hostName );
+    Array< uint32_t > hostIPs;
+    GetHostIPsFromNames( hostNames, timeoutMS, hostIPs );
+    return hostIPs[ 0 ];
+}
+
+// GetHostIPsFromNames
+//------------------------------------------------------------------------------
+/*static*/ void Network::GetHostIPsFromNames( const Array< AString > & hostNames, uint32_t timeoutMS, Array< uint32_t > & outHostIPs )
 {
     PROFILE_FUNCTION;
 
-    // Fast path for "localhost". Although we have a fast path for detecting ip4
-    // format adresses, it can still take several ms to call
-    if ( hostName == "127.0.0.1" )
-    {
-        return 0x0100007f;
-    }
+    const size_t numHosts = hostNames.GetSize();
+    outHostIPs.SetSize( numHosts );
+
+    // Data to communicate between threads (sized up front so it never moves)
+    Array< NameResolutionData > data;
+    data.SetSize( numHosts );
+    Array< Thread * > threads;
+    threads.SetSize( numHosts );
 
-    // see if string it already in ip4 format
-    PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // Deprecated...
-    PRAGMA_DISABLE_PUSH_CLANG_WINDOWS( "-Wdeprecated-declarations" ) // 'inet_addr' is deprecated: This function or variable may be unsafe...
-    const uint32_t ip = inet_addr( hostName.Get() ); // TODO:C Consider using inet_pton()
-    PRAGMA_DISABLE_POP_CLANG_WINDOWS // -Wdeprecated-declarations
-    PRAGMA_DISABLE_POP_MSVC // 4996
-    if ( ip != INADDR_NONE )
+    for ( size_t i = 0; i < numHosts; ++i )
     {
-        return ip;
-    }
+        outHostIPs[ i ] = 0;
+        threads[ i ] = nullptr;
+
+        const AString & hostName = hostNames[ i ];
 
-    // Perform name resolution on another thread
+        // Fast path for "localhost". Although we have a fast path for detecting ip4
+        // format adresses, it can still take several ms to call
+        if ( hostName == "127.0.0.1" )
+        {
+            outHostIPs[ i ] = 0x0100007f;
+            continue;
+        }
 
-    // Data to communicate between threads
-    NameResolutionData data;
-    data.hostName = hostName;
-    data.safeToFree = false; // will be marked by other thread
+        // see if string it already in ip4 format
+        PRAGMA_DISABLE_PUSH_MSVC( 4996 ) // Deprecated...
+        PRAGMA_DISABLE_PUSH_CLANG_WINDOWS( "-Wdeprecated-declarations" ) // 'inet_addr' is deprecated: This function or variable may be unsafe...
+        const uint32_t ip = inet_addr( hostName.Get() ); // TODO:C Consider using inet_pton()
+        PRAGMA_DISABLE_POP_CLANG_WINDOWS // -Wdeprecated-declarations
+        PRAGMA_DISABLE_POP_MSVC // 4996
+        if ( ip != INADDR_NONE )
+        {
+            outHostIPs[ i ] = ip;
+            continue;
+        }
 
-    // Create thread to perform resolution
-    Thread thread;
-    thread.Start( NameResolutionThreadFunc, "NameResolution", &data, ( 32 * KILOBYTE ) );
+        // Perform name resolution on another thread, so all names
+        // are resolved concurrently and share a single timeout
+        data[ i ].hostName = hostName;
+        data[ i ].safeToFree = false; // will be marked by other thread
+        threads[ i ] = FNEW( Thread );
+        threads[ i ]->Start( NameResolutionThreadFunc, "NameResolution", &data[ i ], ( 32 * KILOBYTE ) );
+    }
 
     // wait for name resolution with timeout
-    bool timedOut( false );
-    uint32_t returnCode( 0 );
-    uint32_t remainingTimeMS( timeoutMS );
+    const Timer timer;
     const uint32_t sleepInterval( 100 ); // Check exit condition periodically - TODO:C would be better to use an event
-    for ( ;; )
+    for ( size_t i = 0; i < numHosts; ++i )
     {
-        returnCode = thread.JoinWithTimeout( sleepInterval, timedOut ); // TODO:B Remove use of this unsafe API
-
-        // Are we shutting down?
-        if ( NetworkStartupHelper::IsShuttingDown() )
+        Thread * thread = threads[ i ];
+        if ( thread == nullptr )
         {
-            returnCode = 0; // ignore whatever we may have gotten back
-            break;
+            continue;
         }
 
-        // Manage timeout
-        if ( timedOut )
+        bool timedOut( false );
+        uint32_t returnCode( 0 );
+        for ( ;; )
         {
-            if ( remainingTimeMS < sleepInterval )
+            returnCode = thread->JoinWithTimeout( sleepInterval, timedOut ); // TODO:B Remove use of this unsafe API
+
+            // Are we shutting down?
+            if ( NetworkStartupHelper::IsShuttingDown() )
             {
-                break; // timeout hit
+                returnCode = 0; // ignore whatever we may have gotten back
+                break;
             }
 
-            remainingTimeMS -= sleepInterval;
-            continue; // keep waiting
-        }
+            // Manage timeout
+            if ( timedOut )
+            {
+                if ( timer.GetElapsedMS() >= (float)timeoutMS )
+                {
+                    break; // timeout hit
+                }
+                continue; // keep waiting
+            }
 
-        break; // success!
-    }
-    if ( timedOut )
-    {
-        thread.Detach(); // TODO:B Remove use of this unsafe API
-    }
+            break; // success!
+        }
+        if ( timedOut )
+        {
+            thread->Detach(); // TODO:B Remove use of this unsafe API
+            returnCode = 0; // timeout was hit
+        }
+        FDELETE thread;
 
-    // handle race where timeout occurred before thread marked data as
-    // safe to delete (this could happen if system was under load and timeout was very small)
-    while ( !data.safeToFree )
-    {
-        Thread::Sleep( 1 );
-    }
+        // handle race where timeout occurred before thread marked data as
+        // safe to delete (this could happen if system was under load and timeout was very small)
+        while ( !data[ i ].safeToFree )
+        {
+            Thread::Sleep( 1 );
+        }
 
-    if ( timedOut )
-    {
-        returnCode = 0; // timeout was hit
+        // return result of resolution (could also have failed)
+        outHostIPs[ i ] = returnCode;
     }
-
-    // return result of resolution (could also have failed)
-    return returnCode;
 }
 
 // NameResolutionThreadFunc
@@ -4,6 +4,7 @@
 
 // Includes
 //------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
 #include "Core/Process/Mutex.h"
 #include "Core/Process/Thread.h"
 #include "Core/Strings/AStackString.h"
@@ -21,6 +22,7 @@ public:
     static void GetDomainName( AString & domainName );
     static void GetIPv4Addresses( Array<AString> & outAddresses );
     static uint32_t GetHostIPFromName( const AString & hostName, uint32_t timeoutMS = 1000 );
+    static void GetHostIPsFromNames( const Array< AString > & hostNames, uint32_t timeoutMS, Array< uint32_t > & outHostIPs );
 
 private:
     static uint32_t NameResolutionThreadFunc( void * userData );
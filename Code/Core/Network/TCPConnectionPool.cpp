@@ -26,7 +26,11 @@
     #include <netdb.h>
     #include <netinet/in.h>
     #include <netinet/tcp.h>
+    #include <poll.h>
     #include <string.h>
+    #if defined( __LINUX__ )
+        #include <sys/epoll.h>
+    #endif
     #include <sys/ioctl.h>
     #include <sys/socket.h>
     #include <sys/uio.h>
@@ -49,6 +53,19 @@
     #define TCPDEBUG( ... ) (void)0
 #endif
 
+// Connections are serviced by a small number of I/O threads, using epoll
+// where available or poll otherwise
+#if defined( __LINUX__ )
+    #define TCP_CONNECTION_POOL_USE_EPOLL
+#endif
+#define TCP_CONNECTION_POOL_MAX_IO_THREADS ( 4 )
+#define TCP_CONNECTION_POOL_IO_TIMEOUT_MS ( 10 )    // Frequency new and closed connections are checked for
+#define TCP_CONNECTION_POOL_PAUSED_TIMEOUT_MS ( 1 ) // Frequency paused connections are checked for resumption
+#define TCP_CONNECTION_POOL_LISTEN_BACKLOG ( SOMAXCONN )
+#define TCP_CONNECTION_POOL_MAX_SEND_BUFFERS ( 16 )     // Max buffers passed to a single writev/WSASend
+#define TCP_CONNECTION_POOL_MAX_DISPATCH_THREADS ( 16 ) // Threads calling OnReceive for all connections
+#define TCP_CONNECTION_POOL_MAX_UNDISPATCHED_BYTES ( 16 * 1024 * 1024 ) // Received per connection before reading pauses
+
 // TCPConnectionPoolProfileHelper
 //------------------------------------------------------------------------------
 #if defined( PROFILING_ENABLED )
@@ -136,6 +153,14 @@ ConnectionInfo::ConnectionInfo( TCPConnectionPool * ownerPool )
     , m_ThreadQuitNotification( false )
     , m_TCPConnectionPool( ownerPool )
     , m_UserData( nullptr )
+    , m_ReceiveSize( 0 )
+    , m_ReceiveSizeBytes( 0 )
+    , m_ReceiveBytes( 0 )
+    , m_ReceiveBuffer( nullptr )
+    , m_ReadPaused( false )
+    , m_DispatchQueued( false )
+    , m_NumUndispatched( 0 )
+    , m_UndispatchedBytes( 0 )
     #ifdef DEBUG
         , m_SendSocketInUseThreadId( INVALID_THREAD_ID )
     #endif
@@ -143,11 +168,38 @@ ConnectionInfo::ConnectionInfo( TCPConnectionPool * ownerPool )
     ASSERT( ownerPool );
 }
 
+// IOThread
+//------------------------------------------------------------------------------
+struct TCPConnectionPool::IOThread
+{
+    explicit IOThread( TCPConnectionPool * pool )
+        : m_Pool( pool )
+        , m_NewConnections( 8, true )
+        , m_Connections( 32, true )
+    {}
+
+    TCPConnectionPool *         m_Pool;
+    Thread                      m_Thread;
+    Atomic<bool>                m_Quit{ false };
+    Atomic<uint32_t>            m_NumConnections{ 0 };  // Including those not yet adopted
+    Mutex                       m_NewConnectionsMutex;
+    Array< ConnectionInfo * >   m_NewConnections;       // Waiting to be adopted by the thread
+    Array< ConnectionInfo * >   m_Connections;          // Only accessed by the thread
+    #if defined( TCP_CONNECTION_POOL_USE_EPOLL )
+        int                     m_EpollFD = -1;
+    #endif
+};
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 TCPConnectionPool::TCPConnectionPool()
     : m_ListenConnection( nullptr )
     , m_Connections( 8, true )
+    , m_IOThreads( 0, true )
+    , m_DispatchQueue( 8, true )
+    , m_DispatchThreads( 0, true )
+    , m_NumIdleDispatchThreads( 0 )
+    , m_DispatchQuit( false )
     , m_ShuttingDown( false )
 {
 }
@@ -196,7 +248,20 @@ void TCPConnectionPool::ShutdownAllConnections()
         m_ShutdownSemaphore.Wait( 1 );
         m_ConnectionsMutex.Lock();
     }
+
+    // stop I/O threads, which now have no connections to service
+    Array< IOThread * > ioThreads( 0, true );
+    ioThreads.Swap( m_IOThreads );
     m_ConnectionsMutex.Unlock();
+    for ( IOThread * ioThread : ioThreads )
+    {
+        ioThread->m_Quit.Store( true );
+        ioThread->m_Thread.Join();
+        FDELETE ioThread;
+    }
+
+    // all messages have been dispatched before connections are closed
+    ShutdownDispatchThreads();
 }
 
 // GetAddressAsString
@@ -245,7 +310,7 @@ bool TCPConnectionPool::Listen( uint16_t port )
 
     // listen
     TCPDEBUG( "Listen on port %i (%x)\n", port, (uint32_t)sockfd );
-    if ( listen( sockfd, 0 ) == SOCKET_ERROR ) // no backlog
+    if ( listen( sockfd, TCP_CONNECTION_POOL_LISTEN_BACKLOG ) == SOCKET_ERROR )
     {
         TCPDEBUG( "Listen FAILED %i (%x)\n", port, (uint32_t)sockfd );
         CloseSocket( sockfd );
@@ -282,41 +347,11 @@ const ConnectionInfo * TCPConnectionPool::Connect( uint32_t hostIP, uint16_t por
 {
     PROFILE_FUNCTION;
 
-    // create a socket
-    const TCPSocket sockfd = CreateSocket();
+    // create a socket and initiate connection
+    const TCPSocket sockfd = BeginConnect( hostIP, port );
     if ( sockfd == INVALID_SOCKET )
     {
-        return nullptr; // outright failure?
-    }
-
-    // Configure socket
-    DisableSigPipe( sockfd );       // Prevent socket inheritence by child processes
-    DisableNagle( sockfd );         // Disable Nagle's algorithm
-    SetLargeBufferSizes( sockfd );  // Set large send/recv buffer sizes
-    SetNonBlocking( sockfd );       // Set non-blocking
-
-    // setup destination address
-    struct sockaddr_in destAddr;
-    memset( &destAddr, 0, sizeof( destAddr ) );
-    destAddr.sin_family = AF_INET;
-    destAddr.sin_port = htons( port );
-    destAddr.sin_addr.s_addr = hostIP;
-
-    // initiate connection
-    if ( connect( sockfd, (struct sockaddr *)&destAddr, sizeof( destAddr ) ) != 0 )
-    {
-        // we expect WSAEWOULDBLOCK
-        if ( !WouldBlock() )
-        {
-            // connection initiation failed
-            #ifdef TCPCONNECTION_DEBUG
-                AStackString<> host;
-                GetAddressAsString( hostIP, host );
-                TCPDEBUG( "connect() failed. Error: %s (Host: %s, Port: %u)\n", LAST_NETWORK_ERROR_STR, host.Get(), port );
-            #endif
-            CloseSocket( sockfd );
-            return nullptr;
-        }
+        return nullptr;
     }
 
     const Timer connectionTimer;
@@ -438,7 +473,112 @@ const ConnectionInfo * TCPConnectionPool::Connect( uint32_t hostIP, uint16_t por
         ASSERT( false ); // should never get here
     }
 
-    return CreateConnectionThread( sockfd, hostIP, port, userData );
+    return CreateConnection( sockfd, hostIP, port, userData );
+}
+
+// ConnectMultiple
+//------------------------------------------------------------------------------
+void TCPConnectionPool::ConnectMultiple( const Array< uint32_t > & hostIPs,
+                                         uint16_t port,
+                                         uint32_t timeout,
+                                         const Array< void * > & userData,
+                                         Array< const ConnectionInfo * > & outConnections )
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( userData.GetSize() == hostIPs.GetSize() );
+    const size_t numHosts = hostIPs.GetSize();
+    outConnections.SetSize( numHosts );
+
+    // initiate all connections
+    Array< TCPSocket > sockets( numHosts );
+    size_t numPending = 0;
+    for ( size_t i = 0; i < numHosts; ++i )
+    {
+        outConnections[ i ] = nullptr;
+        sockets.Append( BeginConnect( hostIPs[ i ], port ) );
+        if ( sockets[ i ] != INVALID_SOCKET )
+        {
+            ++numPending;
+        }
+    }
+
+    // wait for all of them to complete (or fail) together
+    #if defined( __WINDOWS__ )
+        Array< WSAPOLLFD > pollFDs( numPending );
+    #else
+        Array< pollfd > pollFDs( numPending );
+    #endif
+    Array< size_t > pollHosts( numPending );
+    const Timer connectionTimer;
+    while ( numPending > 0 )
+    {
+        pollFDs.Clear();
+        pollHosts.Clear();
+        for ( size_t i = 0; i < numHosts; ++i )
+        {
+            if ( sockets[ i ] != INVALID_SOCKET )
+            {
+                pollFDs.EmplaceBack();
+                pollFDs.Top().fd = sockets[ i ];
+                pollFDs.Top().events = POLLOUT;
+                pollFDs.Top().revents = 0;
+                pollHosts.Append( i );
+            }
+        }
+
+        // check connections every 10ms
+        const int pollRet = Poll( pollFDs.Begin(), (uint32_t)pollFDs.GetSize(), 10 );
+        if ( pollRet == SOCKET_ERROR )
+        {
+            TCPDEBUG( "poll() after connect() failed. Error: %s\n", LAST_NETWORK_ERROR_STR );
+            break;
+        }
+
+        // complete connections which are ready
+        for ( size_t j = 0; ( j < pollFDs.GetSize() ) && ( pollRet > 0 ); ++j )
+        {
+            if ( pollFDs[ j ].revents == 0 )
+            {
+                continue;
+            }
+            const size_t i = pollHosts[ j ];
+            const bool connected = ( ( pollFDs[ j ].revents & ( POLLERR | POLLHUP | POLLNVAL ) ) == 0 ) &&
+                                   GetConnectResult( sockets[ i ] );
+            if ( connected )
+            {
+                outConnections[ i ] = CreateConnection( sockets[ i ], hostIPs[ i ], port, userData[ i ] );
+            }
+            else
+            {
+                #ifdef TCPCONNECTION_DEBUG
+                    AStackString<> host;
+                    GetAddressAsString( hostIPs[ i ], host );
+                    TCPDEBUG( "connect() failed, revents: %i (Host: %s, Port: %u)\n", pollFDs[ j ].revents, host.Get(), port );
+                #endif
+                CloseSocket( sockets[ i ] );
+            }
+            sockets[ i ] = INVALID_SOCKET;
+            --numPending;
+        }
+
+        // are we shutting down or have we hit our real connection timeout?
+        if ( AtomicLoadRelaxed( &m_ShuttingDown ) ||
+             ( connectionTimer.GetElapsedMS() >= (float)timeout ) )
+        {
+            TCPDEBUG( "connect() aborted or timed out (%u pending)\n", (uint32_t)numPending );
+            break;
+        }
+    }
+
+    // abandon any incomplete connections
+    for ( const TCPSocket sockfd : sockets )
+    {
+        if ( sockfd != INVALID_SOCKET )
+        {
+            CloseSocket( sockfd );
+        }
+    }
 }
 
 // Disconnect
@@ -533,6 +673,40 @@ bool TCPConnectionPool::Send( const ConnectionInfo * connection, const void * da
     return SendInternal( connection, buffers, 4, timeoutMS );
 }
 
+//------------------------------------------------------------------------------
+bool TCPConnectionPool::Send( const ConnectionInfo * connection, const void * data, size_t size, const SendBuffer * payloadBuffers, uint32_t numPayloadBuffers, uint32_t timeoutMS )
+{
+    // size + data + payloadSize + payloadBuffers
+    StackArray< SendBuffer, 3 + TCP_CONNECTION_POOL_MAX_SEND_BUFFERS > buffers;
+    buffers.SetCapacity( 3 + numPayloadBuffers );
+
+    // size
+    const uint32_t sizeData = (uint32_t)size;
+    buffers.Append( SendBuffer{ sizeof( sizeData ), &sizeData } );
+
+    // data
+    buffers.Append( SendBuffer{ (uint32_t)size, data } );
+
+    // payloadSize
+    uint32_t payloadSizeData = 0;
+    for ( uint32_t i = 0; i < numPayloadBuffers; ++i )
+    {
+        payloadSizeData += payloadBuffers[ i ].size;
+    }
+    buffers.Append( SendBuffer{ sizeof( payloadSizeData ), &payloadSizeData } );
+
+    // payloadBuffers
+    for ( uint32_t i = 0; i < numPayloadBuffers; ++i )
+    {
+        if ( payloadBuffers[ i ].size > 0 )
+        {
+            buffers.Append( payloadBuffers[ i ] );
+        }
+    }
+
+    return SendInternal( connection, buffers.Begin(), (uint32_t)buffers.GetSize(), timeoutMS );
+}
+
 // SendInternal
 //------------------------------------------------------------------------------
 bool TCPConnectionPool::SendInternal( const ConnectionInfo * connection, const TCPConnectionPool::SendBuffer * buffers, uint32_t numBuffers, uint32_t timeoutMS )
@@ -547,11 +721,10 @@ bool TCPConnectionPool::SendInternal( const ConnectionInfo * connection, const T
         return false;
     }
 
-    ASSERT( numBuffers <= 4 ); // Worst case = size + data + payloadSize + payload
     #if defined( __WINDOWS__ )
-        WSABUF sendBuffers[ 4 ];
+        WSABUF sendBuffers[ TCP_CONNECTION_POOL_MAX_SEND_BUFFERS ];
     #else
-        struct iovec sendBuffers[ 4 ];
+        struct iovec sendBuffers[ TCP_CONNECTION_POOL_MAX_SEND_BUFFERS ];
     #endif
 
     // Calculate total to send
@@ -576,30 +749,29 @@ bool TCPConnectionPool::SendInternal( const ConnectionInfo * connection, const T
 
     // Repeat until all bytes sent
     uint32_t bytesSent = 0;
+    uint32_t bufferIndex = 0;   // first buffer with unsent data
+    uint32_t bufferOffset = 0;  // bytes of that buffer already sent
     while ( bytesSent < totalBytes )
     {
-        // Fill buffers for any unsent data
+        // Fill buffers for any unsent data (directly from the caller's memory)
         uint32_t numSendBuffers( 0 );
-        uint32_t offset( 0 );
-        for ( uint32_t i = 0; i < numBuffers; ++i )
+        for ( uint32_t i = bufferIndex; ( i < numBuffers ) && ( numSendBuffers < TCP_CONNECTION_POOL_MAX_SEND_BUFFERS ); ++i )
         {
-            const uint32_t overlap = bytesSent > offset ? ( bytesSent - offset ) : 0;
+            const uint32_t overlap = ( i == bufferIndex ) ? bufferOffset : 0;
             if ( overlap < buffers[ i ].size )
             {
                 // add remaining data for this buffer
                 const uint32_t remainder = ( buffers[ i ].size - overlap );
                 #if defined( __WINDOWS__ )
                     sendBuffers[ numSendBuffers ].len = remainder;
-                    sendBuffers[ numSendBuffers ].buf = const_cast< CHAR * >( (const char *)buffers[ i ].data + buffers[ i ].size - remainder );
+                    sendBuffers[ numSendBuffers ].buf = const_cast< CHAR * >( (const char *)buffers[ i ].data + overlap );
                 #else
                     sendBuffers[ numSendBuffers ].iov_len = remainder;
-                    sendBuffers[ numSendBuffers ].iov_base = const_cast< char * >( (const char *)buffers[ i ].data + buffers[ i ].size - remainder );
+                    sendBuffers[ numSendBuffers ].iov_base = const_cast< char * >( (const char *)buffers[ i ].data + overlap );
                 #endif
                 ++numSendBuffers;
             }
-            offset += buffers[ i ].size;
         }
-        ASSERT( offset == totalBytes ); // sanity check
         ASSERT( numSendBuffers > 0 ); // shouldn't be in loop if there was no data to send!
 
         // Try send
@@ -636,7 +808,15 @@ bool TCPConnectionPool::SendInternal( const ConnectionInfo * connection, const T
             sendOK = false;
             break;
         }
-        bytesSent += sent;
+        bytesSent += (uint32_t)sent;
+
+        // Advance past fully sent buffers
+        bufferOffset += (uint32_t)sent;
+        while ( ( bufferIndex < numBuffers ) && ( bufferOffset >= buffers[ bufferIndex ].size ) )
+        {
+            bufferOffset -= buffers[ bufferIndex ].size;
+            ++bufferIndex;
+        }
     }
 
     #ifdef DEBUG
@@ -678,75 +858,72 @@ bool TCPConnectionPool::Broadcast( const void * data, size_t size )
 }
 
 // HandleRead
+//  - Receive whatever data is available without blocking, dispatching a
+//    message if one is completed. Returns false if the connection was lost.
 //------------------------------------------------------------------------------
 bool TCPConnectionPool::HandleRead( ConnectionInfo * ci )
 {
     PROFILE_FUNCTION;
 
     // work out how many bytes there are
-    uint32_t size( 0 );
-    uint32_t bytesToRead = 4;
-    while ( bytesToRead > 0 )
+    if ( ci->m_ReceiveSizeBytes < sizeof( ci->m_ReceiveSize ) )
     {
-        const int numBytes = (int)recv( ci->m_Socket, ( (char *)&size ) + 4 - bytesToRead, (int32_t)bytesToRead, 0 );
+        const uint32_t bytesToRead = ( sizeof( ci->m_ReceiveSize ) - ci->m_ReceiveSizeBytes );
+        const int numBytes = (int)recv( ci->m_Socket, ( (char *)&ci->m_ReceiveSize ) + ci->m_ReceiveSizeBytes, (int32_t)bytesToRead, 0 );
         if ( numBytes <= 0 )
         {
-            if ( WouldBlock() )
+            if ( ( numBytes < 0 ) && WouldBlock() )
             {
-                if ( ci->m_ThreadQuitNotification.Load() || AtomicLoadRelaxed( &m_ShuttingDown ) )
-                {
-                    return false;
-                }
-
-                Thread::Sleep( 1 );
-                continue;
+                return true; // wait for more data
             }
             TCPDEBUG( "recv() failed (A). Error: %s (Read: %i, Socket: %x)\n", LAST_NETWORK_ERROR_STR, numBytes, (uint32_t)( ci->m_Socket ) );
             return false;
         }
-        bytesToRead -= (uint32_t)numBytes;
-    }
+        ci->m_ReceiveSizeBytes += (uint32_t)numBytes;
+        if ( ci->m_ReceiveSizeBytes < sizeof( ci->m_ReceiveSize ) )
+        {
+            return true; // wait for more data
+        }
 
-    TCPDEBUG( "Handle read: %i (%x)\n", size, (uint32_t)( ci->m_Socket ) );
+        TCPDEBUG( "Handle read: %i (%x)\n", ci->m_ReceiveSize, (uint32_t)( ci->m_Socket ) );
 
-    // get output location
-    void * buffer = AllocBuffer( size );
-    ASSERT( buffer );
+        // get output location
+        ci->m_ReceiveBuffer = AllocBuffer( ci->m_ReceiveSize );
+        ASSERT( ci->m_ReceiveBuffer );
+        ci->m_ReceiveBytes = 0;
+    }
 
     // read data into the user supplied buffer
-    uint32_t bytesRemaining = size;
-    char * dest = (char *)buffer;
-    while ( bytesRemaining > 0 )
+    if ( ci->m_ReceiveBytes < ci->m_ReceiveSize )
     {
-        int numBytes = (int)recv( ci->m_Socket, dest, (int32_t)bytesRemaining, 0 );
+        const uint32_t bytesRemaining = ( ci->m_ReceiveSize - ci->m_ReceiveBytes );
+        char * dest = ( (char *)ci->m_ReceiveBuffer + ci->m_ReceiveBytes );
+        const int numBytes = (int)recv( ci->m_Socket, dest, (int32_t)bytesRemaining, 0 );
         if ( numBytes <= 0 )
         {
-            if ( WouldBlock() )
+            if ( ( numBytes < 0 ) && WouldBlock() )
             {
-                if ( ci->m_ThreadQuitNotification.Load() || AtomicLoadRelaxed( &m_ShuttingDown ) )
-                {
-                    FreeBuffer( buffer );
-                    return false;
-                }
-
-                Thread::Sleep( 1 );
-                continue;
+                return true; // wait for more data
             }
             TCPDEBUG( "recv() failed (B). Error: %s (Read: %i, Socket: %x)\n", LAST_NETWORK_ERROR_STR, numBytes, (uint32_t)( ci->m_Socket ) );
-            FreeBuffer( buffer );
-            return false;
+            return false; // buffer is freed when connection is closed
+        }
+        ci->m_ReceiveBytes += (uint32_t)numBytes;
+        if ( ci->m_ReceiveBytes < ci->m_ReceiveSize )
+        {
+            return true; // wait for more data
         }
-        bytesRemaining -= (uint32_t)numBytes;
-        dest += numBytes;
     }
 
+    // message is complete - ready for the next one
+    void * buffer = ci->m_ReceiveBuffer;
+    const uint32_t size = ci->m_ReceiveSize;
+    ci->m_ReceiveBuffer = nullptr;
+    ci->m_ReceiveSizeBytes = 0;
+    ci->m_ReceiveBytes = 0;
+
     // tell user the data is in their buffer
-    bool keepMemory = false;
-    OnReceive( ci, buffer, size, keepMemory );
-    if ( !keepMemory )
-    {
-        FreeBuffer( buffer );
-    }
+    QueueReceive( ci, buffer, size );
 
     return true;
 }
@@ -806,6 +983,22 @@ int TCPConnectionPool::Select( TCPSocket socket,
                    a_TimeOut );
 }
 
+// Poll
+//------------------------------------------------------------------------------
+int TCPConnectionPool::Poll( void * pollFDs,
+                             uint32_t numPollFDs,
+                             int32_t timeoutMS ) const
+{
+    PROFILE_SECTION( "Poll" );
+    #if defined( __WINDOWS__ )
+        return WSAPoll( (WSAPOLLFD *)pollFDs, numPollFDs, timeoutMS );
+    #elif defined( __APPLE__ ) || defined( __LINUX__ )
+        return poll( (pollfd *)pollFDs, numPollFDs, timeoutMS );
+    #else
+        #error Unknown platform
+    #endif
+}
+
 // Accept
 //------------------------------------------------------------------------------
 TCPSocket TCPConnectionPool::Accept( TCPSocket socket,
@@ -907,6 +1100,70 @@ void TCPConnectionPool::FDSet( TCPSocket fd, void * set ) const
     PRAGMA_DISABLE_POP_MSVC
 }
 
+// BeginConnect
+//  - Create a socket and initiate a non-blocking connection
+//------------------------------------------------------------------------------
+TCPSocket TCPConnectionPool::BeginConnect( uint32_t hostIP, uint16_t port ) const
+{
+    // create a socket
+    const TCPSocket sockfd = CreateSocket();
+    if ( sockfd == INVALID_SOCKET )
+    {
+        return INVALID_SOCKET; // outright failure?
+    }
+
+    // Configure socket
+    DisableSigPipe( sockfd );       // Prevent socket inheritence by child processes
+    DisableNagle( sockfd );         // Disable Nagle's algorithm
+    SetLargeBufferSizes( sockfd );  // Set large send/recv buffer sizes
+    SetNonBlocking( sockfd );       // Set non-blocking
+
+    // setup destination address
+    struct sockaddr_in destAddr;
+    memset( &destAddr, 0, sizeof( destAddr ) );
+    destAddr.sin_family = AF_INET;
+    destAddr.sin_port = htons( port );
+    destAddr.sin_addr.s_addr = hostIP;
+
+    // initiate connection
+    if ( connect( sockfd, (struct sockaddr *)&destAddr, sizeof( destAddr ) ) != 0 )
+    {
+        // we expect WSAEWOULDBLOCK
+        if ( !WouldBlock() )
+        {
+            // connection initiation failed
+            #ifdef TCPCONNECTION_DEBUG
+                AStackString<> host;
+                GetAddressAsString( hostIP, host );
+                TCPDEBUG( "connect() failed. Error: %s (Host: %s, Port: %u)\n", LAST_NETWORK_ERROR_STR, host.Get(), port );
+            #endif
+            CloseSocket( sockfd );
+            return INVALID_SOCKET;
+        }
+    }
+
+    return sockfd;
+}
+
+// GetConnectResult
+//  - A socket being writable only means connect() completed, not that it succeeded
+//------------------------------------------------------------------------------
+bool TCPConnectionPool::GetConnectResult( TCPSocket socket ) const
+{
+    int32_t error = 0;
+    #if defined( __WINDOWS__ )
+        int size = sizeof( error );
+    #else
+        socklen_t size = sizeof( error );
+    #endif
+    if ( getsockopt( socket, SOL_SOCKET, SO_ERROR, (char *)&error, &size ) == SOCKET_ERROR )
+    {
+        TCPDEBUG( "getsockopt() failed. Error: %s\n", LAST_NETWORK_ERROR_STR );
+        return false;
+    }
+    return ( error == 0 );
+}
+
 // CreateListenThread
 //------------------------------------------------------------------------------
 void TCPConnectionPool::CreateListenThread( TCPSocket socket, uint32_t host, uint16_t port )
@@ -993,9 +1250,9 @@ void TCPConnectionPool::ListenThreadFunction( ConnectionInfo * ci )
         SetNonBlocking( newSocket );        // Set non-blocking
 
         // keep the new connected socket
-        CreateConnectionThread( newSocket,
-                                remoteAddrInfo.sin_addr.s_addr,
-                                ntohs( remoteAddrInfo.sin_port ) );
+        CreateConnection( newSocket,
+                          remoteAddrInfo.sin_addr.s_addr,
+                          ntohs( remoteAddrInfo.sin_port ) );
 
         continue; // keep listening for more connections
     }
@@ -1019,12 +1276,19 @@ void TCPConnectionPool::ListenThreadFunction( ConnectionInfo * ci )
     TCPDEBUG( "Listen thread exited\n" );
 }
 
-// CreateConnectionThread
+// CreateConnection
 //------------------------------------------------------------------------------
-ConnectionInfo * TCPConnectionPool::CreateConnectionThread( TCPSocket socket, uint32_t host, uint16_t port, void * userData )
+ConnectionInfo * TCPConnectionPool::CreateConnection( TCPSocket socket, uint32_t host, uint16_t port, void * userData )
 {
     MutexHolder mh( m_ConnectionsMutex );
 
+    // I/O threads are being stopped
+    if ( AtomicLoadRelaxed( &m_ShuttingDown ) )
+    {
+        CloseSocket( socket );
+        return nullptr;
+    }
+
     ConnectionInfo * ci = FNEW( ConnectionInfo( this ) );
     ci->m_Socket = socket;
     ci->m_RemoteAddress = host;
@@ -1038,104 +1302,415 @@ ConnectionInfo * TCPConnectionPool::CreateConnectionThread( TCPSocket socket, ui
         TCPDEBUG( "Connected to %s : %i (%x)\n", addr.Get(), port, (uint32_t)socket );
     #endif
 
-    // Spawn thread to handle socket
-    Thread thread;
-    thread.Start( &ConnectionThreadWrapperFunction, "TCPConnection", ci );
-    thread.Detach(); // TODO:B Remove use of this unsafe API
+    // Use the least busy I/O thread, spawning another if all are busy
+    IOThread * ioThread = nullptr;
+    for ( IOThread * thread : m_IOThreads )
+    {
+        if ( ( ioThread == nullptr ) ||
+             ( thread->m_NumConnections.Load() < ioThread->m_NumConnections.Load() ) )
+        {
+            ioThread = thread;
+        }
+    }
+    if ( ( ioThread == nullptr ) ||
+         ( ( ioThread->m_NumConnections.Load() > 0 ) && ( m_IOThreads.GetSize() < TCP_CONNECTION_POOL_MAX_IO_THREADS ) ) )
+    {
+        ioThread = FNEW( IOThread( this ) );
+        ioThread->m_Thread.Start( &IOThreadWrapperFunction, "TCPConnection", ioThread );
+        m_IOThreads.Append( ioThread );
+    }
+
+    // Hand over to I/O thread
+    ioThread->m_NumConnections.Increment();
+    {
+        MutexHolder mh2( ioThread->m_NewConnectionsMutex );
+        ioThread->m_NewConnections.Append( ci );
+    }
 
     m_Connections.Append( ci );
 
     return ci;
 }
 
-// ConnectionThreadWrapperFunction
+// CloseConnection
+//------------------------------------------------------------------------------
+void TCPConnectionPool::CloseConnection( IOThread * ioThread, ConnectionInfo * ci )
+{
+    OnDisconnected( ci ); // Do callback
+
+    // close the socket (also removing it from the epoll set, if used)
+    CloseSocket( ci->m_Socket );
+    ci->m_Socket = INVALID_SOCKET;
+
+    // free any partially received message
+    if ( ci->m_ReceiveBuffer )
+    {
+        FreeBuffer( ci->m_ReceiveBuffer );
+        ci->m_ReceiveBuffer = nullptr;
+    }
+
+    ASSERT( ioThread->m_NumConnections.Load() > 0 );
+    ioThread->m_NumConnections.Decrement();
+
+    {
+        // try to remove from connection list
+        // could validly be removed by another
+        // thread already due to simultaneously
+        // closing a connection while it is dropped
+        MutexHolder mh( m_ConnectionsMutex );
+        ConnectionInfo ** iter = m_Connections.Find( ci );
+        ASSERT( iter );
+        m_Connections.Erase( iter );
+        FDELETE ci;
+        if ( AtomicLoadRelaxed( &m_ShuttingDown ) )
+        {
+            m_ShutdownSemaphore.Signal(); // Wake main thread which will be waiting on shutdown
+        }
+    }
+}
+
+// IOThreadWrapperFunction
 //------------------------------------------------------------------------------
-/*static*/ uint32_t TCPConnectionPool::ConnectionThreadWrapperFunction( void * data )
+/*static*/ uint32_t TCPConnectionPool::IOThreadWrapperFunction( void * data )
 {
     TCP_CONNECTION_POOL_PROFILE_SET_THREAD_NAME( TCPConnectionPoolProfileHelper::THREAD_CONNECTION );
     PROFILE_FUNCTION;
 
-    ConnectionInfo * ci = (ConnectionInfo *)data;
-    ci->m_TCPConnectionPool->ConnectionThreadFunction( ci );
+    IOThread * ioThread = (IOThread *)data;
+    ioThread->m_Pool->IOThreadFunction( ioThread );
     return 0;
 }
 
-// ConnectionThreadFunction
+// IOThreadFunction
 //------------------------------------------------------------------------------
-void TCPConnectionPool::ConnectionThreadFunction( ConnectionInfo * ci )
+void TCPConnectionPool::IOThreadFunction( IOThread * ioThread )
 {
-    ASSERT( ci );
-    ASSERT( ci->m_Socket != INVALID_SOCKET );
+    #if defined( TCP_CONNECTION_POOL_USE_EPOLL )
+        ioThread->m_EpollFD = epoll_create1( EPOLL_CLOEXEC );
+        if ( ioThread->m_EpollFD == -1 )
+        {
+            // fall back to poll for this thread's connections
+            TCPDEBUG( "epoll_create1() failed. Error: %s\n", LAST_NETWORK_ERROR_STR );
+        }
+        epoll_event events[ 64 ];
+    #endif
+    #if defined( __WINDOWS__ )
+        Array< WSAPOLLFD > pollFDs( 32, true );
+    #else
+        Array< pollfd > pollFDs( 32, true );
+    #endif
+    Array< ConnectionInfo * > polledConnections( 32, true );
 
-    OnConnected( ci ); // Do callback
+    Array< ConnectionInfo * > & connections = ioThread->m_Connections;
 
     // process socket events
-    while ( ci->m_ThreadQuitNotification.Load() == false )
+    while ( ioThread->m_Quit.Load() == false )
     {
-        // timout for select() operations
-        // (modified by select, so we must recreate it)
-        struct timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 10000; // 10 ms
+        IOThreadAdoptConnections( ioThread );
 
-        // create a socket set (with just our socket in it)
-        // (modified by the select() function, so we must recreate it)
-        fd_set readSet;
-        FD_ZERO( &readSet );
-        FDSet( (uint32_t)ci->m_Socket, &readSet );
+        #if defined( TCP_CONNECTION_POOL_USE_EPOLL )
+        if ( ioThread->m_EpollFD != -1 )
+        {
+            // resume reading connections whose backlog has been dispatched
+            int32_t timeoutMS = TCP_CONNECTION_POOL_IO_TIMEOUT_MS;
+            for ( ConnectionInfo * ci : connections )
+            {
+                if ( ci->m_ReadPaused && ci->m_ThreadQuitNotification.Load() == false )
+                {
+                    timeoutMS = TCP_CONNECTION_POOL_PAUSED_TIMEOUT_MS; // check again soon
+                }
+                if ( ci->m_ReadPaused && ( IsReadBlocked( ci ) == false ) )
+                {
+                    epoll_event event;
+                    memset( &event, 0, sizeof( event ) );
+                    event.events = EPOLLIN;
+                    event.data.ptr = ci;
+                    if ( epoll_ctl( ioThread->m_EpollFD, EPOLL_CTL_ADD, ci->m_Socket, &event ) != 0 )
+                    {
+                        TCPDEBUG( "epoll_ctl() failed. Error: %s\n", LAST_NETWORK_ERROR_STR );
+                        ci->m_ThreadQuitNotification.Store( true );
+                        continue;
+                    }
+                    ci->m_ReadPaused = false;
+                }
+            }
 
-        const int num = Select( ci->m_Socket + 1, &readSet, nullptr, nullptr, &timeout );
-        if ( num == 0 )
+            // wait for any connection to become readable
+            const int num = epoll_wait( ioThread->m_EpollFD, events, (int)( sizeof( events ) / sizeof( events[ 0 ] ) ), timeoutMS );
+            for ( int i = 0; i < num; ++i )
+            {
+                ConnectionInfo * ci = static_cast< ConnectionInfo * >( events[ i ].data.ptr );
+                if ( IsReadBlocked( ci ) )
+                {
+                    // stop polling (level triggered) until the backlog is dispatched
+                    // or the connection is closed
+                    VERIFY( epoll_ctl( ioThread->m_EpollFD, EPOLL_CTL_DEL, ci->m_Socket, nullptr ) == 0 );
+                    ci->m_ReadPaused = true;
+                    continue;
+                }
+                if ( HandleRead( ci ) == false )
+                {
+                    ci->m_ThreadQuitNotification.Store( true );
+                }
+            }
+        }
+        else
+        #endif
         {
-            // timeout expired - loop again (checking quit notification)
-            continue;
+            // wait for any connection to become readable
+            pollFDs.Clear();
+            polledConnections.Clear();
+            int32_t timeoutMS = TCP_CONNECTION_POOL_IO_TIMEOUT_MS;
+            for ( ConnectionInfo * ci : connections )
+            {
+                if ( IsReadBlocked( ci ) )
+                {
+                    if ( ci->m_ThreadQuitNotification.Load() == false )
+                    {
+                        timeoutMS = TCP_CONNECTION_POOL_PAUSED_TIMEOUT_MS; // check again soon
+                    }
+                    continue; // until the backlog is dispatched or the connection is closed
+                }
+                pollFDs.EmplaceBack();
+                pollFDs.Top().fd = ci->m_Socket;
+                pollFDs.Top().events = POLLIN;
+                pollFDs.Top().revents = 0;
+                polledConnections.Append( ci );
+            }
+            if ( pollFDs.IsEmpty() )
+            {
+                Thread::Sleep( (uint32_t)timeoutMS ); // Can't poll an empty set on all platforms
+            }
+            else
+            {
+                const int num = Poll( pollFDs.Begin(), (uint32_t)pollFDs.GetSize(), timeoutMS );
+                for ( size_t i = 0; ( i < pollFDs.GetSize() ) && ( num > 0 ); ++i )
+                {
+                    ConnectionInfo * ci = polledConnections[ i ];
+                    if ( ( pollFDs[ i ].revents == 0 ) || ci->m_ThreadQuitNotification.Load() )
+                    {
+                        continue;
+                    }
+                    if ( ( pollFDs[ i ].revents & POLLNVAL ) || ( HandleRead( ci ) == false ) )
+                    {
+                        ci->m_ThreadQuitNotification.Store( true );
+                    }
+                }
+            }
+        }
+
+        // close any connections which were dropped or disconnected, once
+        // all their received messages have been dispatched
+        for ( size_t i = 0; i < connections.GetSize(); )
+        {
+            ConnectionInfo * ci = connections[ i ];
+            if ( ci->m_ThreadQuitNotification.Load() && ( ci->m_NumUndispatched.Load() == 0 ) )
+            {
+                connections.EraseIndex( i );
+                CloseConnection( ioThread, ci );
+                continue;
+            }
+            ++i;
         }
+    }
 
-        if ( ci->m_ThreadQuitNotification.Load() )
+    // connections are all closed before I/O threads are stopped
+    ASSERT( connections.IsEmpty() );
+    ASSERT( ioThread->m_NewConnections.IsEmpty() );
+
+    #if defined( TCP_CONNECTION_POOL_USE_EPOLL )
+        if ( ioThread->m_EpollFD != -1 )
         {
-            break; // don't bother reading any pending data if shutting down
+            close( ioThread->m_EpollFD );
         }
+    #endif
+
+    // thread exit
+    TCPDEBUG( "I/O thread exited\n" );
+}
 
-        // Something happened, work out what it is
-        if ( FD_ISSET( ci->m_Socket, &readSet ) )
+// IOThreadAdoptConnections
+//------------------------------------------------------------------------------
+void TCPConnectionPool::IOThreadAdoptConnections( IOThread * ioThread )
+{
+    Array< ConnectionInfo * > newConnections( 0, true );
+    {
+        MutexHolder mh( ioThread->m_NewConnectionsMutex );
+        if ( ioThread->m_NewConnections.IsEmpty() )
         {
-            if ( HandleRead( ci ) == false )
+            return;
+        }
+        newConnections.Swap( ioThread->m_NewConnections );
+    }
+
+    for ( ConnectionInfo * ci : newConnections )
+    {
+        ASSERT( ci->m_Socket != INVALID_SOCKET );
+
+        OnConnected( ci ); // Do callback
+
+        // start receiving
+        #if defined( TCP_CONNECTION_POOL_USE_EPOLL )
+            if ( ioThread->m_EpollFD != -1 )
             {
-                break;
+                epoll_event event;
+                memset( &event, 0, sizeof( event ) );
+                event.events = EPOLLIN;
+                event.data.ptr = ci;
+                if ( epoll_ctl( ioThread->m_EpollFD, EPOLL_CTL_ADD, ci->m_Socket, &event ) != 0 )
+                {
+                    TCPDEBUG( "epoll_ctl() failed. Error: %s\n", LAST_NETWORK_ERROR_STR );
+                    ci->m_ThreadQuitNotification.Store( true );
+                    ci->m_ReadPaused = true; // Not in epoll set
+                }
             }
+        #endif
+        ioThread->m_Connections.Append( ci );
+    }
+}
+
+// IsReadBlocked
+//  - Reading stops while a connection is closing, or while too many of its
+//    messages are waiting to be dispatched (so slow handlers apply backpressure)
+//------------------------------------------------------------------------------
+bool TCPConnectionPool::IsReadBlocked( const ConnectionInfo * ci ) const
+{
+    return ( ci->m_ThreadQuitNotification.Load() ||
+             ( ci->m_UndispatchedBytes.Load() >= TCP_CONNECTION_POOL_MAX_UNDISPATCHED_BYTES ) );
+}
+
+// QueueReceive
+//  - Called by an I/O thread with a completed message
+//------------------------------------------------------------------------------
+void TCPConnectionPool::QueueReceive( ConnectionInfo * ci, void * data, uint32_t size )
+{
+    ci->m_NumUndispatched.Increment(); // Keeps the connection open until dispatched
+    ci->m_UndispatchedBytes.Add( size );
+
+    {
+        MutexHolder mh( m_DispatchMutex );
+        ConnectionInfo::ReceivedMessage & msg = ci->m_ReceivedMessages.EmplaceBack();
+        msg.m_Data = data;
+        msg.m_Size = size;
+
+        // already queued or being processed? (messages are dispatched in order
+        // and never concurrently for a given connection)
+        if ( ci->m_DispatchQueued )
+        {
+            return;
         }
-        else
+        ci->m_DispatchQueued = true;
+        m_DispatchQueue.Append( ci );
+
+        // start another thread if all are busy
+        if ( ( m_NumIdleDispatchThreads < m_DispatchQueue.GetSize() ) &&
+             ( m_DispatchThreads.GetSize() < TCP_CONNECTION_POOL_MAX_DISPATCH_THREADS ) )
         {
-            PRAGMA_DISABLE_PUSH_CLANG_WINDOWS( "-Wunreachable-code" ) // TOBO:B : Investigate - code will never be executed [-Wunreachable-code]
-            ASSERT( false && "Unexpected" );
-            PRAGMA_DISABLE_POP_CLANG_WINDOWS // -Wunreachable-code
+            Thread * thread = FNEW( Thread );
+            thread->Start( &DispatchThreadWrapperFunction, "TCPDispatch", this );
+            m_DispatchThreads.Append( thread );
+            m_NumIdleDispatchThreads++;
         }
     }
+    m_DispatchSemaphore.Signal();
+}
 
-    OnDisconnected( ci ); // Do callback
+// DispatchThreadWrapperFunction
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TCPConnectionPool::DispatchThreadWrapperFunction( void * data )
+{
+    PROFILE_SET_THREAD_NAME( "TCPDispatch" );
+    PROFILE_FUNCTION;
 
-    // close the socket
-    CloseSocket( ci->m_Socket );
-    ci->m_Socket = INVALID_SOCKET;
+    TCPConnectionPool * pool = (TCPConnectionPool *)data;
+    pool->DispatchThreadFunction();
+    return 0;
+}
 
+// DispatchThreadFunction
+//------------------------------------------------------------------------------
+void TCPConnectionPool::DispatchThreadFunction()
+{
+    for ( ;; )
     {
-        // try to remove from connection list
-        // could validly be removed by another
-        // thread already due to simultaneously
-        // closing a connection while it is dropped
-        MutexHolder mh( m_ConnectionsMutex );
-        ConnectionInfo ** iter = m_Connections.Find( ci );
-        ASSERT( iter );
-        m_Connections.Erase( iter );
-        FDELETE ci;
-        if ( AtomicLoadRelaxed( &m_ShuttingDown ) )
+        m_DispatchSemaphore.Wait();
+
+        // take the next connection with messages waiting
+        ConnectionInfo * ci;
+        ConnectionInfo::ReceivedMessage msg;
         {
-            m_ShutdownSemaphore.Signal(); // Wake main thread which will be waiting on shutdown
+            MutexHolder mh( m_DispatchMutex );
+            if ( m_DispatchQuit )
+            {
+                return;
+            }
+            ASSERT( m_DispatchQueue.IsEmpty() == false );
+            ci = m_DispatchQueue[ 0 ];
+            m_DispatchQueue.PopFront();
+            m_NumIdleDispatchThreads--;
+            msg = ci->m_ReceivedMessages[ 0 ];
+            ci->m_ReceivedMessages.PopFront();
+        }
+
+        // dispatch its messages until there are none left
+        for ( ;; )
+        {
+            bool keepMemory = false;
+            OnReceive( ci, msg.m_Data, msg.m_Size, keepMemory );
+            if ( !keepMemory )
+            {
+                FreeBuffer( msg.m_Data );
+            }
+            ci->m_UndispatchedBytes.Sub( msg.m_Size );
+
+            bool more;
+            {
+                MutexHolder mh( m_DispatchMutex );
+                more = ( ci->m_ReceivedMessages.IsEmpty() == false );
+                if ( more )
+                {
+                    msg = ci->m_ReceivedMessages[ 0 ];
+                    ci->m_ReceivedMessages.PopFront();
+                }
+                else
+                {
+                    ci->m_DispatchQueued = false;
+                    m_NumIdleDispatchThreads++;
+                }
+            }
+
+            // NOTE: The connection can be closed as soon as its last message is
+            // dispatched, so it must not be accessed again unless there are more
+            ci->m_NumUndispatched.Decrement();
+            if ( !more )
+            {
+                break;
+            }
         }
     }
+}
 
-    // thread exit
-    TCPDEBUG( "connection thread exited\n" );
+// ShutdownDispatchThreads
+//------------------------------------------------------------------------------
+void TCPConnectionPool::ShutdownDispatchThreads()
+{
+    Array< Thread * > dispatchThreads( 0, true );
+    {
+        MutexHolder mh( m_DispatchMutex );
+        ASSERT( m_DispatchQueue.IsEmpty() );
+        m_DispatchQuit = true;
+        dispatchThreads.Swap( m_DispatchThreads );
+    }
+    if ( dispatchThreads.IsEmpty() )
+    {
+        return;
+    }
+    m_DispatchSemaphore.Signal( (uint32_t)dispatchThreads.GetSize() );
+    for ( Thread * thread : dispatchThreads )
+    {
+        thread->Join();
+        FDELETE thread;
+    }
 }
 
 // AllowSocketReuse
@@ -57,6 +57,24 @@ private:
     TCPConnectionPool *     m_TCPConnectionPool; // back pointer to parent pool
     mutable void *          m_UserData;
 
+    // Partially received message (only accessed by the servicing I/O thread)
+    uint32_t                m_ReceiveSize;          // Size of message being received
+    uint32_t                m_ReceiveSizeBytes;     // Bytes of m_ReceiveSize received so far
+    uint32_t                m_ReceiveBytes;         // Bytes of message received so far
+    void *                  m_ReceiveBuffer;
+    bool                    m_ReadPaused;           // Removed from epoll set while backlogged
+
+    // Received messages waiting for OnReceive (protected by pool's m_DispatchMutex)
+    struct ReceivedMessage
+    {
+        void *              m_Data;
+        uint32_t            m_Size;
+    };
+    Array< ReceivedMessage > m_ReceivedMessages;
+    bool                    m_DispatchQueued;       // Queued for, or being processed by, a dispatch thread
+    Atomic<uint32_t>        m_NumUndispatched;      // Received messages OnReceive hasn't finished with
+    Atomic<uint64_t>        m_UndispatchedBytes;    // Size of those messages
+
 #ifdef DEBUG
     mutable Thread::ThreadId m_SendSocketInUseThreadId; // sanity check we aren't sending from multiple threads unsafely
 #endif
@@ -84,6 +102,12 @@ public:
                                     uint16_t port,
                                     uint32_t timeout = kDefaultConnectionTimeoutMS,
                                     void * userData = nullptr );
+    // Connect to several hosts concurrently. outConnections contains nullptr for failures.
+    void ConnectMultiple( const Array< uint32_t > & hostIPs,
+                          uint16_t port,
+                          uint32_t timeout,
+                          const Array< void * > & userData,
+                          Array< const ConnectionInfo * > & outConnections );
     void Disconnect( const ConnectionInfo * ci );
     void SetShuttingDown();
 
@@ -91,6 +115,11 @@ public:
     size_t GetNumConnections() const;
 
     // transmit data
+    struct SendBuffer
+    {
+        uint32_t        size;
+        const void *    data;
+    };
     bool Send( const ConnectionInfo * connection,
                const void * data,
                size_t size,
@@ -101,12 +130,20 @@ public:
                const void * payloadData,
                size_t payloadSize,
                uint32_t timeoutMS = kDefaultSendTimeoutMS );
+    // payload gathered from several buffers (sent as one contiguous payload without copying)
+    bool Send( const ConnectionInfo * connection,
+               const void * data,
+               size_t size,
+               const SendBuffer * payloadBuffers,
+               uint32_t numPayloadBuffers,
+               uint32_t timeoutMS = kDefaultSendTimeoutMS );
     bool Broadcast( const void * data, size_t size );
 
     static void GetAddressAsString( uint32_t addr, AString & address );
 
 protected:
-    // network events - NOTE: these happen in another thread! (but never at the same time)
+    // network events - NOTE: these happen in another thread! (but never at the same time for a given connection)
+    //                  OnReceive happens on a dispatch thread, OnConnected/OnDisconnected on an I/O thread
     virtual void OnReceive( const ConnectionInfo *, void * /*data*/, uint32_t /*size*/, bool & /*keepMemory*/ ) {}
     virtual void OnConnected( const ConnectionInfo * ) {}
     virtual void OnDisconnected( const ConnectionInfo * ) {}
@@ -128,26 +165,34 @@ private:
                         void * writeSocketSet,
                         void * exceptionSocketSet,
                         struct timeval * timeOut ) const;
+    int         Poll( void * pollFDs, // TODO: Using void * to avoid including header is ugly
+                      uint32_t numPollFDs,
+                      int32_t timeoutMS ) const;
     TCPSocket   Accept( TCPSocket socket,
                         struct sockaddr * address,
                         int * addressSize ) const;
     TCPSocket   CreateSocket() const;
     void        FDSet( TCPSocket fd, void * set ) const;
+    TCPSocket   BeginConnect( uint32_t hostIP, uint16_t port ) const;
+    bool        GetConnectResult( TCPSocket socket ) const;
 
-    struct SendBuffer
-    {
-        uint32_t        size;
-        const void *    data;
-    };
     bool        SendInternal( const ConnectionInfo * connection, const SendBuffer * buffers, uint32_t numBuffers, uint32_t timeoutMS );
 
     // thread management
+    struct IOThread;
     void                CreateListenThread( TCPSocket socket, uint32_t host, uint16_t port );
     static uint32_t     ListenThreadWrapperFunction( void * data );
     void                ListenThreadFunction( ConnectionInfo * ci );
-    ConnectionInfo *    CreateConnectionThread( TCPSocket socket, uint32_t host, uint16_t port, void * userData = nullptr );
-    static uint32_t     ConnectionThreadWrapperFunction( void * data );
-    void                ConnectionThreadFunction( ConnectionInfo * ci );
+    ConnectionInfo *    CreateConnection( TCPSocket socket, uint32_t host, uint16_t port, void * userData = nullptr );
+    void                CloseConnection( IOThread * ioThread, ConnectionInfo * ci );
+    static uint32_t     IOThreadWrapperFunction( void * data );
+    void                IOThreadFunction( IOThread * ioThread );
+    void                IOThreadAdoptConnections( IOThread * ioThread );
+    bool                IsReadBlocked( const ConnectionInfo * ci ) const;
+    void                QueueReceive( ConnectionInfo * ci, void * data, uint32_t size );
+    static uint32_t     DispatchThreadWrapperFunction( void * data );
+    void                DispatchThreadFunction();
+    void                ShutdownDispatchThreads();
 
     // internal helpers
     void                AllowSocketReuse( TCPSocket socket ) const;
@@ -162,6 +207,16 @@ private:
     // remote connection related info
     mutable Mutex               m_ConnectionsMutex;
     Array< ConnectionInfo * >   m_Connections;
+    Array< IOThread * >         m_IOThreads;    // Service all connections (protected by m_ConnectionsMutex)
+
+    // received messages are passed to OnReceive by dispatch threads, so
+    // slow handlers don't stall the I/O threads
+    Mutex                       m_DispatchMutex;
+    Array< ConnectionInfo * >   m_DispatchQueue;            // Connections with messages to dispatch
+    Array< Thread * >           m_DispatchThreads;
+    uint32_t                    m_NumIdleDispatchThreads;
+    bool                        m_DispatchQuit;
+    Semaphore                   m_DispatchSemaphore;        // Signalled when a connection is queued
 
     bool                        m_ShuttingDown;
     Semaphore                   m_ShutdownSemaphore;
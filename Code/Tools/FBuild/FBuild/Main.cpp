@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/BuildDaemon.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
 #include "Tools/FBuild/FBuildCore/Helpers/CtrlCHandler.h"
 
@@ -43,6 +44,7 @@ enum ReturnCodes
 int WrapperMainProcess( const AString & args, const FBuildOptions & options, SystemMutex & finalProcess );
 int WrapperIntermediateProcess( const FBuildOptions & options );
 int32_t WrapperModeForWSL( const FBuildOptions & options );
+void DisplayTimeTaken( const Timer & t );
 int Main( int argc, char * argv[] );
 
 // Misc
@@ -110,6 +112,20 @@ int Main( int argc, char * argv[] )
     VERIFY( setvbuf( stdout, nullptr, _IONBF, 0 ) == 0 );
     VERIFY( setvbuf( stderr, nullptr, _IONBF, 0 ) == 0 );
 
+    // forward build to daemon if one is running
+    if ( options.m_UseDaemon && ( wrapperMode == FBuildOptions::WRAPPER_MODE_NONE ) )
+    {
+        const BuildDaemon::RequestResult daemonResult = BuildDaemon::SendBuildRequest( options );
+        if ( daemonResult != BuildDaemon::RequestResult::NO_DAEMON )
+        {
+            if ( options.m_ShowTotalTimeTaken )
+            {
+                DisplayTimeTaken( t );
+            }
+            return ( daemonResult == BuildDaemon::RequestResult::BUILD_OK ) ? FBUILD_OK : FBUILD_BUILD_FAILED;
+        }
+    }
+
     // ensure only one FASTBuild instance is running at a time
     SystemMutex mainProcess( options.GetMainProcessMutexName().Get() );
 
@@ -149,6 +165,18 @@ int Main( int argc, char * argv[] )
     ASSERT( ( wrapperMode == FBuildOptions::WRAPPER_MODE_NONE ) ||
             ( wrapperMode == FBuildOptions::WRAPPER_MODE_FINAL_PROCESS ) );
 
+    // stay resident, serving builds requested with -usedaemon
+    if ( options.m_DaemonMode )
+    {
+        bool daemonResult;
+        {
+            BuildDaemon daemon( options );
+            daemonResult = daemon.Run();
+        }
+        ctrlCHandler.DeregisterHandler(); // Ensure this happens before FBuild is destroyed
+        return daemonResult ? FBUILD_OK : FBUILD_ALREADY_RUNNING;
+    }
+
     SharedData * sharedData = nullptr;
     if ( wrapperMode == FBuildOptions::WRAPPER_MODE_FINAL_PROCESS )
     {
@@ -214,6 +242,14 @@ int Main( int argc, char * argv[] )
     {
         result = fBuild.CacheTrim();
     }
+    else if ( options.m_CacheTrain )
+    {
+        result = fBuild.CacheTrain();
+    }
+    else if ( options.m_CacheVerify )
+    {
+        result = fBuild.CacheVerify();
+    }
     else
     {
         result = fBuild.Build( options.m_Targets );
@@ -238,17 +274,7 @@ int Main( int argc, char * argv[] )
     // final line of output - status of build
     if ( options.m_ShowTotalTimeTaken )
     {
-        const float totalBuildTime = t.GetElapsed();
-        const uint32_t minutes = uint32_t( totalBuildTime / 60.0f );
-        const float seconds = ( totalBuildTime - (float)( minutes * 60 ) );
-        if ( minutes > 0 )
-        {
-            FLOG_OUTPUT( "Time: %um %05.3fs\n", minutes, (double)seconds );
-        }
-        else
-        {
-            FLOG_OUTPUT( "Time: %05.3fs\n", (double)seconds );
-        }
+        DisplayTimeTaken( t );
     }
 
     ctrlCHandler.DeregisterHandler(); // Ensure this happens before FBuild is destroyed
@@ -260,6 +286,23 @@ int Main( int argc, char * argv[] )
     return ( result == true ) ? FBUILD_OK : FBUILD_BUILD_FAILED;
 }
 
+// DisplayTimeTaken
+//------------------------------------------------------------------------------
+void DisplayTimeTaken( const Timer & t )
+{
+    const float totalBuildTime = t.GetElapsed();
+    const uint32_t minutes = uint32_t( totalBuildTime / 60.0f );
+    const float seconds = ( totalBuildTime - (float)( minutes * 60 ) );
+    if ( minutes > 0 )
+    {
+        FLOG_OUTPUT( "Time: %um %05.3fs\n", minutes, (double)seconds );
+    }
+    else
+    {
+        FLOG_OUTPUT( "Time: %05.3fs\n", (double)seconds );
+    }
+}
+
 // WrapperMainProcess
 //------------------------------------------------------------------------------
 int WrapperMainProcess( const AString & args, const FBuildOptions & options, SystemMutex & finalProcess )
@@ -10,16 +10,52 @@
 
 // Core
 #include "Core/Containers/UniquePtr.h"
+#include "Core/Env/Env.h"
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/PathUtils.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
 #include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Core/Time/Time.h"
 #include "Core/Time/Timer.h"
 #include "Core/Tracing/Tracing.h"
 
+// system
+#include <string.h> // for memcmp, memcpy
+
+// Defines
+//------------------------------------------------------------------------------
+#define CACHE_ENTRY_IDENTIFIER      "FBCE"
+#define CACHE_ENTRY_VERSION         ( 1 )
+#define CACHE_QUARANTINE_DIR_NAME   "Quarantine"
+#define CACHE_MAX_VERIFY_THREADS    ( 8 )
+
+// CacheEntryHeader
+//  - Stored at the start of each cache file, before the data
+//------------------------------------------------------------------------------
+struct CacheEntryHeader
+{
+    char        m_Identifier[ 4 ];          // "FBCE"
+    uint32_t    m_Version;
+    uint64_t    m_DataSize;
+    uint64_t    m_DataHash;                 // xxHash3 of the data
+};
+static_assert( sizeof( CacheEntryHeader ) == 24, "Unexpected CacheEntryHeader size" );
+
+// Cache::VerifyContext
+//------------------------------------------------------------------------------
+struct Cache::VerifyContext
+{
+    Cache *                             m_Cache = nullptr;
+    const Array< FileIO::FileInfo > *   m_Files = nullptr;
+    volatile uint32_t                   m_NextFile = 0;
+};
+
 // CacheStats
 //------------------------------------------------------------------------------
 class CacheStats
@@ -114,8 +150,14 @@ public:
         return false;
     }
 
-    // write data
-    const bool cacheTmpWriteOk = ( cacheTmpFile.Write( data, dataSize ) == dataSize );
+    // write header and data
+    CacheEntryHeader header;
+    memcpy( header.m_Identifier, CACHE_ENTRY_IDENTIFIER, sizeof( header.m_Identifier ) );
+    header.m_Version = CACHE_ENTRY_VERSION;
+    header.m_DataSize = dataSize;
+    header.m_DataHash = xxHash3::Calc64( data, dataSize );
+    const bool cacheTmpWriteOk = ( cacheTmpFile.Write( &header, sizeof( header ) ) == sizeof( header ) ) &&
+                                 ( cacheTmpFile.Write( data, dataSize ) == dataSize );
     cacheTmpFile.Close();
 
     if ( !cacheTmpWriteOk )
@@ -153,20 +195,13 @@ public:
     AStackString<> fullPath;
     GetFullPathForCacheEntry( cacheId, fullPath );
 
-    FileStream cacheFile;
-    if ( cacheFile.Open( fullPath.Get(), FileStream::READ_ONLY ) )
+    const ReadResult result = ReadEntry( fullPath, data, dataSize );
+    if ( result == READ_CORRUPT )
     {
-        const size_t cacheFileSize = (size_t)cacheFile.GetFileSize();
-        UniquePtr< char > mem( (char *)ALLOC( cacheFileSize ) );
-        if ( cacheFile.Read( mem.Get(), cacheFileSize ) == cacheFileSize )
-        {
-            dataSize = cacheFileSize;
-            data = mem.Release();
-            return true;
-        }
+        // Treat as a miss, so the entry is rebuilt and replaced
+        QuarantineEntry( cacheId, fullPath );
     }
-
-    return false;
+    return ( result == READ_OK );
 }
 
 // FreeMemory
@@ -209,10 +244,15 @@ public:
         perDay[ ageInDays ].m_NumBytes += info.m_Size;
     }
 
+    // Quarantined (corrupt) entries
+    Array< FileIO::FileInfo > quarantineFiles;
+    uint64_t quarantineSize = 0;
+    GetQuarantineFiles( quarantineFiles, quarantineSize );
+
     // Totals
     CacheStats total;
-    total.m_NumBytes = totalSize;
-    total.m_NumFiles = (uint32_t)allFiles.GetSize();
+    total.m_NumBytes = totalSize + quarantineSize;
+    total.m_NumFiles = (uint32_t)( allFiles.GetSize() + quarantineFiles.GetSize() );
 
     // Generate cache info string
     OUTPUT( "================================================================================\n" );
@@ -233,6 +273,7 @@ public:
         }
         OUTPUT( " %2u%c        | %8u | %10" PRIu64 " | %5.1f %s\n", i, ( i == 29 ) ? '+' : ' ', num, size, (double)sizePerc, graphBar.Get() );
     }
+    OUTPUT( " Quarantine | %8u | %10" PRIu64 " |\n", (uint32_t)quarantineFiles.GetSize(), quarantineSize / MEGABYTE );
     OUTPUT( "================================================================================\n" );
     OUTPUT( " Total      | %8u | %10" PRIu64 " |\n", total.m_NumFiles, total.m_NumBytes / MEGABYTE );
     OUTPUT( "================================================================================\n" );
@@ -248,11 +289,19 @@ public:
     Array< FileIO::FileInfo > allFiles( 1000000 );
     uint64_t totalSize = 0;
     GetCacheFiles( showProgress, allFiles, totalSize );
-    OUTPUT( " - Before: %u Files @ %u MiB\n", (uint32_t)allFiles.GetSize(), (uint32_t)( totalSize / MEGABYTE ) );
+
+    // Quarantined (corrupt) entries count towards the size and are trimmed first
+    Array< FileIO::FileInfo > quarantineFiles;
+    uint64_t quarantineSize = 0;
+    GetQuarantineFiles( quarantineFiles, quarantineSize );
+    totalSize += quarantineSize;
+    const uint32_t numFiles = (uint32_t)( allFiles.GetSize() + quarantineFiles.GetSize() );
+    OUTPUT( " - Before: %u Files @ %u MiB\n", numFiles, (uint32_t)( totalSize / MEGABYTE ) );
 
     // Sort by age
     OldestFileTimeSorter sorter;
     allFiles.Sort( sorter );
+    const Array< FileIO::FileInfo > * const filesInTrimOrder[] = { &quarantineFiles, &allFiles };
 
     // Do we need to delete anything?
     OUTPUT( "Trimming to %u MiB:\n", sizeMiB );
@@ -268,32 +317,39 @@ public:
         }
         const uint64_t originalTotalSize = totalSize;
 
-        // Iterate over files, deleting oldest first
-        for ( const FileIO::FileInfo & info : allFiles )
+        // Iterate over files, deleting quarantined, then oldest first
+        for ( const Array< FileIO::FileInfo > * files : filesInTrimOrder )
         {
-            // Try to delete (ok to fail if file is in use)
-            if ( FileIO::FileDelete( info.m_Name.Get() ) )
+            if ( totalSize <= limit )
             {
-                totalSize -= info.m_Size;
-                ++numDeleted;
-
-                // Are we under the limit now?
-                if ( totalSize <= limit )
+                break;
+            }
+            for ( const FileIO::FileInfo & info : *files )
+            {
+                // Try to delete (ok to fail if file is in use)
+                if ( FileIO::FileDelete( info.m_Name.Get() ) )
                 {
-                    break;
-                }
+                    totalSize -= info.m_Size;
+                    ++numDeleted;
 
-                // Progress
-                if ( showProgress )
-                {
-                    // Throttled to avoid perf impact
-                    if ( ( timer.GetElapsed() - lastProgressTime ) > 0.5f )
+                    // Are we under the limit now?
+                    if ( totalSize <= limit )
+                    {
+                        break;
+                    }
+
+                    // Progress
+                    if ( showProgress )
                     {
-                        const uint64_t toDeleteBytes = originalTotalSize - limit;
-                        const uint64_t deletedBytes = originalTotalSize - totalSize;
-                        const float perc = ( (float)deletedBytes / (float)toDeleteBytes ) * 100.0f;
-                        FLog::OutputProgress( timer.GetElapsed(), perc, 0, 0, 0, 0 );
-                        lastProgressTime = timer.GetElapsed();
+                        // Throttled to avoid perf impact
+                        if ( ( timer.GetElapsed() - lastProgressTime ) > 0.5f )
+                        {
+                            const uint64_t toDeleteBytes = originalTotalSize - limit;
+                            const uint64_t deletedBytes = originalTotalSize - totalSize;
+                            const float perc = ( (float)deletedBytes / (float)toDeleteBytes ) * 100.0f;
+                            FLog::OutputProgress( timer.GetElapsed(), perc, 0, 0, 0, 0 );
+                            lastProgressTime = timer.GetElapsed();
+                        }
                     }
                 }
             }
@@ -305,10 +361,244 @@ public:
         }
     }
 
-    OUTPUT( " - After: %u Files @ %u MiB\n", (uint32_t)allFiles.GetSize() - numDeleted, (uint32_t)( totalSize / MEGABYTE ) );
+    OUTPUT( " - After: %u Files @ %u MiB\n", numFiles - numDeleted, (uint32_t)( totalSize / MEGABYTE ) );
     return true;
 }
 
+// GetSampleIds
+//------------------------------------------------------------------------------
+/*virtual*/ bool Cache::GetSampleIds( size_t maxEntries, Array< AString > & outCacheIds )
+{
+    // Get all the files
+    Array< FileIO::FileInfo > allFiles( 1000000 );
+    uint64_t totalSize = 0;
+    GetCacheFiles( false, allFiles, totalSize );
+
+    // Most recent entries are most representative of current builds
+    OldestFileTimeSorter sorter;
+    allFiles.Sort( sorter );
+    for ( size_t i = allFiles.GetSize(); ( i > 0 ) && ( outCacheIds.GetSize() < maxEntries ); --i )
+    {
+        const AString & fileName = allFiles[ i - 1 ].m_Name;
+        if ( fileName.EndsWith( ".tmp" ) )
+        {
+            continue; // Publish in progress
+        }
+        const char * lastSlash = fileName.FindLast( NATIVE_SLASH );
+        outCacheIds.EmplaceBack( lastSlash ? ( lastSlash + 1 ) : fileName.Get() );
+    }
+    return true;
+}
+
+// Verify
+//------------------------------------------------------------------------------
+/*virtual*/ bool Cache::Verify( bool showProgress )
+{
+    // Get all the files
+    Array< FileIO::FileInfo > allFiles( 1000000 );
+    uint64_t totalSize = 0;
+    GetCacheFiles( showProgress, allFiles, totalSize );
+    OUTPUT( " - Verifying: %u Files @ %u MiB\n", (uint32_t)allFiles.GetSize(), (uint32_t)( totalSize / MEGABYTE ) );
+
+    // Only report the cost of this scan
+    CacheVerifyStats stats;
+    GetAndResetVerifyStats( stats );
+
+    const Timer timer;
+    VerifyContext context;
+    context.m_Cache = this;
+    context.m_Files = &allFiles;
+
+    // Calling thread participates (and reports progress)
+    const uint32_t numFiles = (uint32_t)allFiles.GetSize();
+    uint32_t numHelpers = Math::Min( Env::GetNumProcessors(), (uint32_t)CACHE_MAX_VERIFY_THREADS ) - 1;
+    numHelpers = Math::Min( numHelpers, ( numFiles > 1 ) ? ( numFiles - 1 ) : 0u );
+    Thread helpers[ CACHE_MAX_VERIFY_THREADS ];
+    for ( uint32_t i = 0; i < numHelpers; ++i )
+    {
+        helpers[ i ].Start( VerifyThreadFunc, "CacheVerify", &context );
+    }
+    VerifyFiles( context, showProgress );
+    for ( uint32_t i = 0; i < numHelpers; ++i )
+    {
+        helpers[ i ].Join();
+    }
+
+    GetAndResetVerifyStats( stats );
+    OUTPUT( " - Verified: %u Files @ %u MiB in %.3fs (%.3fs checksumming over %u threads)\n",
+            stats.m_NumVerified,
+            (uint32_t)( stats.m_VerifiedBytes / MEGABYTE ),
+            (double)timer.GetElapsed(),
+            ( (double)stats.m_VerifyTimeUS / 1000000.0 ),
+            ( numHelpers + 1 ) );
+    OUTPUT( " - Corrupt: %u Files (moved to '%s%s')\n", stats.m_NumCorrupt, m_CachePath.Get(), CACHE_QUARANTINE_DIR_NAME );
+    return true;
+}
+
+// GetAndResetVerifyStats
+//------------------------------------------------------------------------------
+/*virtual*/ void Cache::GetAndResetVerifyStats( CacheVerifyStats & outStats )
+{
+    MutexHolder mh( m_VerifyStatsMutex );
+    outStats = m_VerifyStats;
+    m_VerifyStats = CacheVerifyStats();
+}
+
+// ReadEntry
+//------------------------------------------------------------------------------
+Cache::ReadResult Cache::ReadEntry( const AString & fullPath, void * & outData, size_t & outDataSize )
+{
+    FileStream cacheFile;
+    if ( cacheFile.Open( fullPath.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return READ_FAILED;
+    }
+
+    // Check header
+    const uint64_t cacheFileSize = cacheFile.GetFileSize();
+    CacheEntryHeader header;
+    if ( cacheFileSize < sizeof( header ) )
+    {
+        return READ_CORRUPT;
+    }
+    if ( cacheFile.Read( &header, sizeof( header ) ) != sizeof( header ) )
+    {
+        return READ_FAILED;
+    }
+    if ( ( memcmp( header.m_Identifier, CACHE_ENTRY_IDENTIFIER, sizeof( header.m_Identifier ) ) != 0 ) ||
+         ( header.m_Version != CACHE_ENTRY_VERSION ) ||
+         ( header.m_DataSize != ( cacheFileSize - sizeof( header ) ) ) )
+    {
+        return READ_CORRUPT;
+    }
+
+    // Read data
+    const size_t dataSize = (size_t)header.m_DataSize;
+    UniquePtr< char > mem( (char *)ALLOC( dataSize ? dataSize : 1 ) );
+    if ( cacheFile.Read( mem.Get(), dataSize ) != dataSize )
+    {
+        return READ_FAILED;
+    }
+
+    // Check data
+    const Timer timer;
+    const bool dataOk = ( xxHash3::Calc64( mem.Get(), dataSize ) == header.m_DataHash );
+    const uint64_t verifyTimeUS = (uint64_t)( timer.GetElapsedMS() * 1000.0f );
+    {
+        MutexHolder mh( m_VerifyStatsMutex );
+        m_VerifyStats.m_NumVerified++;
+        m_VerifyStats.m_VerifiedBytes += dataSize;
+        m_VerifyStats.m_VerifyTimeUS += verifyTimeUS;
+    }
+    if ( dataOk == false )
+    {
+        return READ_CORRUPT;
+    }
+
+    outDataSize = dataSize;
+    outData = mem.Release();
+    return READ_OK;
+}
+
+// QuarantineEntry
+//------------------------------------------------------------------------------
+void Cache::QuarantineEntry( const AString & cacheId, const AString & fullPath )
+{
+    {
+        MutexHolder mh( m_VerifyStatsMutex );
+        m_VerifyStats.m_NumCorrupt++;
+    }
+
+    // Keep corrupt entries for inspection, but out of the way of lookups
+    AStackString<> quarantinePath;
+    quarantinePath.Format( "%s%s%c%s", m_CachePath.Get(), CACHE_QUARANTINE_DIR_NAME, NATIVE_SLASH, cacheId.Get() );
+    if ( FileIO::EnsurePathExistsForFile( quarantinePath ) )
+    {
+        FileIO::FileDelete( quarantinePath.Get() ); // Replace previously quarantined entry, if any
+        if ( FileIO::FileMove( fullPath, quarantinePath ) )
+        {
+            FLOG_WARN( "Corrupt cache entry quarantined: '%s'", quarantinePath.Get() );
+            return;
+        }
+    }
+
+    // Unable to quarantine, so remove it instead
+    if ( FileIO::FileDelete( fullPath.Get() ) )
+    {
+        FLOG_WARN( "Corrupt cache entry deleted: '%s'", fullPath.Get() );
+    }
+}
+
+// VerifyFiles
+//------------------------------------------------------------------------------
+void Cache::VerifyFiles( VerifyContext & context, bool showProgress )
+{
+    // Throttle progress messages to avoid impacting performance significantly
+    const Timer timer;
+    float lastProgressTime = 0.0f;
+    if ( showProgress )
+    {
+        FLog::OutputProgress( 0.0f, 0.0f, 0, 0, 0, 0 );
+    }
+
+    const Array< FileIO::FileInfo > & files = *context.m_Files;
+    for ( ;; )
+    {
+        const uint32_t index = ( AtomicInc( &context.m_NextFile ) - 1 );
+        if ( index >= files.GetSize() )
+        {
+            break;
+        }
+
+        const AString & fileName = files[ index ].m_Name;
+        if ( fileName.EndsWith( ".tmp" ) )
+        {
+            continue; // Publish in progress
+        }
+
+        void * data = nullptr;
+        size_t dataSize = 0;
+        const ReadResult result = ReadEntry( fileName, data, dataSize );
+        if ( result == READ_OK )
+        {
+            FreeMemory( data, dataSize );
+        }
+        else if ( result == READ_CORRUPT )
+        {
+            const char * lastSlash = fileName.FindLast( NATIVE_SLASH );
+            const AStackString<> cacheId( lastSlash ? ( lastSlash + 1 ) : fileName.Get() );
+            QuarantineEntry( cacheId, fileName );
+        }
+
+        // Progress
+        if ( showProgress )
+        {
+            // Throttled to avoid perf impact
+            if ( ( timer.GetElapsed() - lastProgressTime ) > 0.5f )
+            {
+                const float perc = ( (float)index / (float)files.GetSize() ) * 100.0f;
+                FLog::OutputProgress( timer.GetElapsed(), perc, 0, 0, 0, 0 );
+                lastProgressTime = timer.GetElapsed();
+            }
+        }
+    }
+
+    if ( showProgress )
+    {
+        FLog::ClearProgress();
+    }
+}
+
+// VerifyThreadFunc
+//------------------------------------------------------------------------------
+/*static*/ uint32_t Cache::VerifyThreadFunc( void * param )
+{
+    PROFILE_SET_THREAD_NAME( "CacheVerify" );
+    VerifyContext * context = static_cast< VerifyContext * >( param );
+    context->m_Cache->VerifyFiles( *context, false );
+    return 0;
+}
+
 // GetCacheFiles
 //------------------------------------------------------------------------------
 void Cache::GetCacheFiles( bool showProgress,
@@ -365,6 +655,22 @@ void Cache::GetCacheFiles( bool showProgress,
     }
 }
 
+// GetQuarantineFiles
+//------------------------------------------------------------------------------
+void Cache::GetQuarantineFiles( Array< FileIO::FileInfo > & outInfo,
+                                uint64_t & outTotalSize ) const
+{
+    AStackString<> path;
+    path.Format( "%s%s%c", m_CachePath.Get(), CACHE_QUARANTINE_DIR_NAME, NATIVE_SLASH );
+    FileIO::GetFilesEx( path, nullptr, false, &outInfo );
+
+    outTotalSize = 0;
+    for ( const FileIO::FileInfo & info : outInfo )
+    {
+        outTotalSize += info.m_Size;
+    }
+}
+
 // GetFullPathForCacheEntry
 //------------------------------------------------------------------------------
 void Cache::GetFullPathForCacheEntry( const AString & cacheId,
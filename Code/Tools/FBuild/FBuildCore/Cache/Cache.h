@@ -6,9 +6,13 @@
 //------------------------------------------------------------------------------
 #include "ICache.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/Process/Mutex.h"
 #include "Core/Strings/AString.h"
 
 // Cache
+//  - One file per entry. Each file has a header with a checksum of the data,
+//    which is verified on retrieval. Corrupt entries are moved aside
+//    (quarantined) and treated as misses, so they are rebuilt and replaced.
 //------------------------------------------------------------------------------
 class Cache : public ICache
 {
@@ -28,11 +32,30 @@ public:
     virtual void FreeMemory( void * data, size_t dataSize ) override;
     virtual bool OutputInfo( bool showProgress ) override;
     virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual bool GetSampleIds( size_t maxEntries, Array< AString > & outCacheIds ) override;
+    virtual bool Verify( bool showProgress ) override;
+    virtual void GetAndResetVerifyStats( CacheVerifyStats & outStats ) override;
 private:
+    enum ReadResult : uint8_t
+    {
+        READ_OK,
+        READ_FAILED,    // Missing or inaccessible
+        READ_CORRUPT,   // Header or checksum mismatch
+    };
+    struct VerifyContext;
+
+    ReadResult ReadEntry( const AString & fullPath, void * & outData, size_t & outDataSize );
+    void QuarantineEntry( const AString & cacheId, const AString & fullPath );
+    void VerifyFiles( VerifyContext & context, bool showProgress );
+    static uint32_t VerifyThreadFunc( void * param );
+
     void GetCacheFiles( bool showProgress, Array< FileIO::FileInfo > & outInfo, uint64_t & outTotalSize ) const;
+    void GetQuarantineFiles( Array< FileIO::FileInfo > & outInfo, uint64_t & outTotalSize ) const;
     void GetFullPathForCacheEntry( const AString & cacheId, AString & outFullPath ) const;
 
-    AString m_CachePath;
+    AString             m_CachePath;
+    Mutex               m_VerifyStatsMutex;
+    CacheVerifyStats    m_VerifyStats;
 };
 
 //------------------------------------------------------------------------------
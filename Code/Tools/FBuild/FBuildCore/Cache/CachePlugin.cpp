@@ -10,7 +10,10 @@
 
 // Core
 #include "Core/Env/ErrorFormat.h"
+#include "Core/FileIO/MemoryStream.h"
 #include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Semaphore.h"
 #include "Core/Tracing/Tracing.h"
 
 // system
@@ -21,15 +24,97 @@
     #include <dlfcn.h>
 #endif
 
+// Batch contexts
+//------------------------------------------------------------------------------
+namespace
+{
+    // Tracks completion of the items in a batch, which the plugin
+    // may complete from any thread
+    class CachePluginBatchContext
+    {
+    public:
+        explicit CachePluginBatchContext( uint32_t count )
+            : m_Count( count )
+            , m_Remaining( count )
+        {
+        }
+
+        void Complete( uint32_t index )
+        {
+            ASSERT( index < m_Count );
+            (void)index;
+            if ( AtomicDec( &m_Remaining ) == 0 )
+            {
+                m_Semaphore.Signal();
+            }
+        }
+
+        void WaitForCompletion()
+        {
+            m_Semaphore.Wait();
+        }
+
+    private:
+        uint32_t            m_Count;
+        volatile uint32_t   m_Remaining;
+        Semaphore           m_Semaphore;
+    };
+
+    class CachePluginRetrieveContext : public CachePluginBatchContext
+    {
+    public:
+        CachePluginRetrieveContext( uint32_t count, Array< void * > & data, Array< size_t > & dataSize, CacheFreeMemoryFunc freeMemoryFunc )
+            : CachePluginBatchContext( count )
+            , m_Data( data )
+            , m_DataSize( dataSize )
+            , m_FreeMemoryFunc( freeMemoryFunc )
+        {
+        }
+
+        Array< void * > &   m_Data;
+        Array< size_t > &   m_DataSize;
+        CacheFreeMemoryFunc m_FreeMemoryFunc; // Frees data which is not returned
+    };
+
+    class CachePluginResultContext : public CachePluginBatchContext
+    {
+    public:
+        CachePluginResultContext( uint32_t count, Array< bool > & results )
+            : CachePluginBatchContext( count )
+            , m_Results( results )
+        {
+        }
+
+        Array< bool > &     m_Results;
+    };
+
+    void GetCacheIdPointers( const Array< AString > & cacheIds, Array< const char * > & outPointers )
+    {
+        outPointers.SetCapacity( cacheIds.GetSize() );
+        for ( const AString & cacheId : cacheIds )
+        {
+            outPointers.Append( cacheId.Get() );
+        }
+    }
+}
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 /*explicit*/ CachePlugin::CachePlugin( const AString & dllName )
     : m_DLL( nullptr )
     , m_InitFunc( nullptr )
+    , m_InitExFunc( nullptr )
     , m_ShutdownFunc( nullptr )
     , m_PublishFunc( nullptr )
     , m_RetrieveFunc( nullptr )
     , m_FreeMemoryFunc( nullptr )
+    , m_OutputInfoFunc( nullptr )
+    , m_TrimFunc( nullptr )
+    , m_RetrieveBatchFunc( nullptr )
+    , m_PublishBatchFunc( nullptr )
+    , m_ExistsBatchFunc( nullptr )
+    , m_RetrieveStreamFunc( nullptr )
+    , m_OwnedAllocations( 0, true )
 {
     #if defined( __WINDOWS__ )
         m_DLL = ::LoadLibrary( dllName.Get() );
@@ -58,6 +143,12 @@
     m_FreeMemoryFunc= (CacheFreeMemoryFunc) GetFunction( "CacheFreeMemory", "?CacheFreeMemory@@YAXPEAX_K@Z" );
     m_OutputInfoFunc= (CacheOutputInfoFunc) GetFunction( "CacheOutputInfo", "?CacheOutputInfo@@YA_N_N@Z", true ); // Optional
     m_TrimFunc      = (CacheTrimFunc)       GetFunction( "CacheTrim",       "?CacheTrim@@YA_N_NI@Z", true ); // Optional
+
+    // Version 2 (all optional)
+    m_RetrieveBatchFunc = (CacheRetrieveBatchFunc)  GetFunction( "CacheRetrieveBatch",  nullptr, true );
+    m_PublishBatchFunc  = (CachePublishBatchFunc)   GetFunction( "CachePublishBatch",   nullptr, true );
+    m_ExistsBatchFunc   = (CacheExistsBatchFunc)    GetFunction( "CacheExistsBatch",    nullptr, true );
+    m_RetrieveStreamFunc= (CacheRetrieveStreamFunc) GetFunction( "CacheRetrieveStream", nullptr, true );
 }
 
 // DESTRUCTOR
@@ -112,6 +203,50 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
     FLOG_OUTPUT( "%s", buffer.Get() );
 }
 
+// RetrieveCompleteWrapper
+//------------------------------------------------------------------------------
+/*static*/ void STDCALL CachePlugin::RetrieveCompleteWrapper( void * userData, unsigned int index, bool found, void * data, unsigned long long dataSize )
+{
+    CachePluginRetrieveContext * context = static_cast< CachePluginRetrieveContext * >( userData );
+    if ( found && data && ( dataSize > 0 ) )
+    {
+        context->m_Data[ index ] = data;
+        context->m_DataSize[ index ] = (size_t)dataSize;
+    }
+    else if ( data )
+    {
+        // Plugin allocated memory for a miss (or empty result)
+        ( *context->m_FreeMemoryFunc )( data, dataSize );
+    }
+    context->Complete( index ); // NOTE: context may be destroyed after this
+}
+
+// PublishCompleteWrapper
+//------------------------------------------------------------------------------
+/*static*/ void STDCALL CachePlugin::PublishCompleteWrapper( void * userData, unsigned int index, bool stored )
+{
+    CachePluginResultContext * context = static_cast< CachePluginResultContext * >( userData );
+    context->m_Results[ index ] = stored;
+    context->Complete( index ); // NOTE: context may be destroyed after this
+}
+
+// ExistsCompleteWrapper
+//------------------------------------------------------------------------------
+/*static*/ void STDCALL CachePlugin::ExistsCompleteWrapper( void * userData, unsigned int index, bool exists )
+{
+    CachePluginResultContext * context = static_cast< CachePluginResultContext * >( userData );
+    context->m_Results[ index ] = exists;
+    context->Complete( index ); // NOTE: context may be destroyed after this
+}
+
+// StreamWriteWrapper
+//------------------------------------------------------------------------------
+/*static*/ bool STDCALL CachePlugin::StreamWriteWrapper( void * userData, const void * chunk, unsigned long long chunkSize )
+{
+    MemoryStream * stream = static_cast< MemoryStream * >( userData );
+    return ( stream->WriteBuffer( chunk, chunkSize ) == chunkSize );
+}
+
 // Shutdown
 //------------------------------------------------------------------------------
 /*virtual*/ void CachePlugin::Shutdown()
@@ -190,6 +325,24 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
         return false;
     }
 
+    // Streaming retrieval takes precedence
+    if ( m_RetrieveStreamFunc )
+    {
+        MemoryStream stream;
+        if ( ( (*m_RetrieveStreamFunc)( cacheId.Get(), &StreamWriteWrapper, &stream ) == false ) ||
+             ( stream.GetSize() == 0 ) )
+        {
+            return false;
+        }
+
+        // Memory is ours (not the plugin's) so must be freed by us
+        dataSize = stream.GetSize();
+        data = stream.Release();
+        MutexHolder mh( m_OwnedAllocationsMutex );
+        m_OwnedAllocations.Append( data );
+        return true;
+    }
+
     if ( m_RetrieveFunc )
     {
         unsigned long long size;
@@ -209,6 +362,21 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
         return;
     }
 
+    // Was the memory retrieved via streaming?
+    if ( m_RetrieveStreamFunc )
+    {
+        bool owned;
+        {
+            MutexHolder mh( m_OwnedAllocationsMutex );
+            owned = m_OwnedAllocations.FindAndErase( data );
+        }
+        if ( owned )
+        {
+            FREE( data );
+            return;
+        }
+    }
+
     ASSERT( m_FreeMemoryFunc ); // should never get here without being valid
     (*m_FreeMemoryFunc)( data, dataSize );
 }
@@ -251,4 +419,93 @@ void * CachePlugin::GetFunction( const char * name, const char * mangledName, bo
     return false;
 }
 
+// RetrieveBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void CachePlugin::RetrieveBatch( const Array< AString > & cacheIds, Array< void * > & outData, Array< size_t > & outDataSize )
+{
+    // Fall back to retrieving one at a time if not supported
+    if ( ( m_Valid == false ) || ( m_RetrieveBatchFunc == nullptr ) || cacheIds.IsEmpty() )
+    {
+        ICache::RetrieveBatch( cacheIds, outData, outDataSize );
+        return;
+    }
+
+    const uint32_t count = (uint32_t)cacheIds.GetSize();
+    outData.SetSize( count );
+    outDataSize.SetSize( count );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        outData[ i ] = nullptr;
+        outDataSize[ i ] = 0;
+    }
+
+    Array< const char * > ids;
+    GetCacheIdPointers( cacheIds, ids );
+
+    CachePluginRetrieveContext context( count, outData, outDataSize, m_FreeMemoryFunc );
+    (*m_RetrieveBatchFunc)( ids.Begin(), count, &RetrieveCompleteWrapper, &context );
+    context.WaitForCompletion();
+}
+
+// PublishBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void CachePlugin::PublishBatch( const Array< AString > & cacheIds,
+                                            const Array< const void * > & data,
+                                            const Array< size_t > & dataSize,
+                                            Array< bool > & outStored )
+{
+    // Fall back to publishing one at a time if not supported
+    if ( ( m_Valid == false ) || ( m_PublishBatchFunc == nullptr ) || cacheIds.IsEmpty() )
+    {
+        ICache::PublishBatch( cacheIds, data, dataSize, outStored );
+        return;
+    }
+
+    ASSERT( ( data.GetSize() == cacheIds.GetSize() ) && ( dataSize.GetSize() == cacheIds.GetSize() ) );
+    const uint32_t count = (uint32_t)cacheIds.GetSize();
+    outStored.SetSize( count );
+    for ( bool & stored : outStored )
+    {
+        stored = false;
+    }
+
+    Array< const char * > ids;
+    GetCacheIdPointers( cacheIds, ids );
+    Array< unsigned long long > sizes( count, false );
+    for ( const size_t size : dataSize )
+    {
+        sizes.Append( size );
+    }
+
+    CachePluginResultContext context( count, outStored );
+    (*m_PublishBatchFunc)( ids.Begin(), data.Begin(), sizes.Begin(), count, &PublishCompleteWrapper, &context );
+    context.WaitForCompletion();
+}
+
+// ExistsBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void CachePlugin::ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists )
+{
+    // Without plugin support, report everything as absent
+    if ( ( m_Valid == false ) || ( m_ExistsBatchFunc == nullptr ) || cacheIds.IsEmpty() )
+    {
+        ICache::ExistsBatch( cacheIds, outExists );
+        return;
+    }
+
+    const uint32_t count = (uint32_t)cacheIds.GetSize();
+    outExists.SetSize( count );
+    for ( bool & exists : outExists )
+    {
+        exists = false;
+    }
+
+    Array< const char * > ids;
+    GetCacheIdPointers( cacheIds, ids );
+
+    CachePluginResultContext context( count, outExists );
+    (*m_ExistsBatchFunc)( ids.Begin(), count, &ExistsCompleteWrapper, &context );
+    context.WaitForCompletion();
+}
+
 //------------------------------------------------------------------------------
@@ -7,6 +7,9 @@
 #include "ICache.h"
 #include "CachePluginInterface.h"
 
+#include "Core/Containers/Array.h"
+#include "Core/Process/Mutex.h"
+
 // Forward Declarations
 //------------------------------------------------------------------------------
 class AString;
@@ -31,11 +34,23 @@ public:
     virtual void FreeMemory( void * data, size_t dataSize ) override;
     virtual bool OutputInfo( bool showProgress ) override;
     virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual void RetrieveBatch( const Array< AString > & cacheIds, Array< void * > & outData, Array< size_t > & outDataSize ) override;
+    virtual void PublishBatch( const Array< AString > & cacheIds,
+                               const Array< const void * > & data,
+                               const Array< size_t > & dataSize,
+                               Array< bool > & outStored ) override;
+    virtual void ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists ) override;
 private:
     void * GetFunction( const char * friendlyName, const char * mangledName = nullptr, bool optional = false );
 
     static void CacheOutputWrapper( const char * message );
 
+    // Callbacks for version 2 functions
+    static void STDCALL RetrieveCompleteWrapper( void * userData, unsigned int index, bool found, void * data, unsigned long long dataSize );
+    static void STDCALL PublishCompleteWrapper( void * userData, unsigned int index, bool stored );
+    static void STDCALL ExistsCompleteWrapper( void * userData, unsigned int index, bool exists );
+    static bool STDCALL StreamWriteWrapper( void * userData, const void * chunk, unsigned long long chunkSize );
+
     void *              m_DLL;
     bool                m_Valid;
     CacheInitFunc       m_InitFunc;
@@ -46,6 +61,15 @@ private:
     CacheFreeMemoryFunc m_FreeMemoryFunc;
     CacheOutputInfoFunc m_OutputInfoFunc;
     CacheTrimFunc       m_TrimFunc;
+
+    // Version 2 (optional)
+    CacheRetrieveBatchFunc  m_RetrieveBatchFunc;
+    CachePublishBatchFunc   m_PublishBatchFunc;
+    CacheExistsBatchFunc    m_ExistsBatchFunc;
+    CacheRetrieveStreamFunc m_RetrieveStreamFunc;
+
+    Mutex               m_OwnedAllocationsMutex;
+    Array< void * >     m_OwnedAllocations; // Retrieved via streaming, so owned by us rather than the plugin
 };
 
 //------------------------------------------------------------------------------
@@ -93,6 +93,112 @@ using CacheOutputInfoFunc = bool (STDCALL *)( bool showProgress );
 //     sizeMiB      - desired size in MiB
 using CacheTrimFunc = bool (STDCALL *)( bool showProgress, unsigned int sizeMiB );
 
+//------------------------------------------------------------------------------
+// Version 2 Interface
+//------------------------------------------------------------------------------
+// The functions below are all optional. Plugins which don't implement them are
+// called one entry at a time via the functions above.
+//
+// Batch functions allow requests to be overlapped (pipelined over a single
+// connection for example). The completion function must be called exactly once
+// for each item, from any thread, either before or after the batch function
+// returns. FASTBuild keeps all parameters valid until every item has completed.
+
+// CacheRetrieveCompleteFunc
+//------------------------------------------------------------------------------
+// Provided by FASTBuild. Signal completion of an item passed to CacheRetrieveBatch.
+//
+// In: userData - value passed to CacheRetrieveBatch
+//     index    - index of the item within the batch
+//     found    - was the item retrieved
+//     data     - on success, retrieved data (freed later via CacheFreeMemory)
+//     dataSize - on success, size in bytes of retrieved data
+using CacheRetrieveCompleteFunc = void (STDCALL *)( void * userData, unsigned int index, bool found, void * data, unsigned long long dataSize );
+
+// CacheRetrieveBatch (Optional)
+//------------------------------------------------------------------------------
+// Retrieve several previously stored items.
+//
+// In: cacheIds     - string names of cache entries
+//     count        - number of entries
+//     completeFunc - function to call as each item completes
+//     userData     - value to pass to completeFunc
+using CacheRetrieveBatchFunc = void (STDCALL *)( const char * const * cacheIds,
+                                                 unsigned int count,
+                                                 CacheRetrieveCompleteFunc completeFunc,
+                                                 void * userData );
+
+// CachePublishCompleteFunc
+//------------------------------------------------------------------------------
+// Provided by FASTBuild. Signal completion of an item passed to CachePublishBatch.
+//
+// In: userData - value passed to CachePublishBatch
+//     index    - index of the item within the batch
+//     stored   - was the item stored to the cache
+using CachePublishCompleteFunc = void (STDCALL *)( void * userData, unsigned int index, bool stored );
+
+// CachePublishBatch (Optional)
+//------------------------------------------------------------------------------
+// Store several items to the cache.
+//
+// In: cacheIds     - string names of cache entries
+//     data         - data to store for each entry
+//     dataSizes    - size in bytes of data for each entry
+//     count        - number of entries
+//     completeFunc - function to call as each item completes
+//     userData     - value to pass to completeFunc
+using CachePublishBatchFunc = void (STDCALL *)( const char * const * cacheIds,
+                                                const void * const * data,
+                                                const unsigned long long * dataSizes,
+                                                unsigned int count,
+                                                CachePublishCompleteFunc completeFunc,
+                                                void * userData );
+
+// CacheExistsCompleteFunc
+//------------------------------------------------------------------------------
+// Provided by FASTBuild. Signal completion of an item passed to CacheExistsBatch.
+//
+// In: userData - value passed to CacheExistsBatch
+//     index    - index of the item within the batch
+//     exists   - is the item present in the cache
+using CacheExistsCompleteFunc = void (STDCALL *)( void * userData, unsigned int index, bool exists );
+
+// CacheExistsBatch (Optional)
+//------------------------------------------------------------------------------
+// Check for the presence of several items, without retrieving them. Used to
+// avoid storing items which are already present.
+//
+// In: cacheIds     - string names of cache entries
+//     count        - number of entries
+//     completeFunc - function to call as each item completes
+//     userData     - value to pass to completeFunc
+using CacheExistsBatchFunc = void (STDCALL *)( const char * const * cacheIds,
+                                               unsigned int count,
+                                               CacheExistsCompleteFunc completeFunc,
+                                               void * userData );
+
+// CacheStreamWriteFunc
+//------------------------------------------------------------------------------
+// Provided by FASTBuild. Receive the next chunk of an item being retrieved by
+// CacheRetrieveStream. Chunks must be provided in order.
+//
+// In:  userData  - value passed to CacheRetrieveStream
+//      chunk     - data
+//      chunkSize - size in bytes of data
+// Out: bool      - (return) false if the retrieval should be abandoned
+using CacheStreamWriteFunc = bool (STDCALL *)( void * userData, const void * chunk, unsigned long long chunkSize );
+
+// CacheRetrieveStream (Optional)
+//------------------------------------------------------------------------------
+// Retrieve a previously stored item in chunks, so the plugin does not need to
+// buffer the entire item. Takes precedence over CacheRetrieve.
+//
+// In:  cacheId   - string name of cache entry
+//      writeFunc - function to call for each chunk
+//      userData  - value to pass to writeFunc
+// Out: bool      - (return) true if the entire item was retrieved
+using CacheRetrieveStreamFunc = bool (STDCALL *)( const char * cacheId, CacheStreamWriteFunc writeFunc, void * userData );
+
 } //extern "C"
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,483 @@
+// CachePrefetcher - Retrieve cache entries for queued objects in the background
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CachePrefetcher.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
+#include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Env/Env.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CachePrefetcher::CachePrefetcher( ICache * cache, bool waitForPrefetch )
+    : m_Cache( cache )
+    , m_WaitForPrefetch( waitForPrefetch )
+    , m_Exit( false )
+    , m_Pending( 1024, true )
+    , m_Entries( MAX_HELD_ENTRIES, true )
+    , m_Claimed( 1024, true )
+    , m_HeldBytes( 0 )
+    , m_NumBatchesInProgress( 0 )
+    , m_NumWaiters( 0 )
+    , m_NumThreads( 0 )
+{
+    ASSERT( m_Cache );
+
+    // Forming keys is the expensive part (hashing includes or running the compiler), so
+    // use a few threads, leaving most cores to the build itself
+    m_NumThreads = Math::Clamp( Env::GetNumProcessors() / 4, 1u, (uint32_t)MAX_THREADS );
+    for ( uint32_t i = 0; i < m_NumThreads; ++i )
+    {
+        m_Threads[ i ].Start( ThreadFuncStatic, "CachePrefetch", this );
+    }
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CachePrefetcher::~CachePrefetcher()
+{
+    {
+        MutexHolder mh( m_Mutex );
+        m_Exit = true;
+        m_Pending.Clear();
+    }
+    m_WorkSemaphore.Signal( m_NumThreads );
+    for ( uint32_t i = 0; i < m_NumThreads; ++i )
+    {
+        m_Threads[ i ].Join();
+    }
+
+    // Free unconsumed results
+    for ( Entry * entry : m_Entries )
+    {
+        if ( entry->m_Data )
+        {
+            m_Cache->FreeMemory( entry->m_Data, entry->m_DataSize );
+        }
+        FDELETE entry;
+    }
+}
+
+// Queue
+//------------------------------------------------------------------------------
+void CachePrefetcher::Queue( ObjectNode * node )
+{
+    ASSERT( Thread::IsMainThread() );
+
+    if ( node->CanPrefetchFromCache() == false )
+    {
+        return;
+    }
+
+    bool wake;
+    {
+        MutexHolder mh( m_Mutex );
+        if ( node->m_CachePrefetchClaimed )
+        {
+            return; // Already being built (second build pass for example)
+        }
+        wake = m_Pending.IsEmpty();
+        m_Pending.Append( node );
+        m_Stats.m_NumQueued++;
+    }
+    if ( wake )
+    {
+        m_WorkSemaphore.Signal();
+    }
+}
+
+// TakeSourceKey
+//------------------------------------------------------------------------------
+bool CachePrefetcher::TakeSourceKey( ObjectNode * node, const AString & args, uint64_t & outSourceKey, Array< AString > & outIncludes )
+{
+    PROFILE_FUNCTION;
+
+    for ( ;; )
+    {
+        {
+            MutexHolder mh( m_Mutex );
+
+            // Prevent any further prefetching for this node
+            Entry * entry;
+            if ( Claim( node, entry ) )
+            {
+                // The key is set when the entry is registered, so there is no need to
+                // wait for the lookup. The entry is left for Take.
+                if ( ( entry == nullptr ) || ( entry->m_KeyArgs != args ) )
+                {
+                    return false; // Not prefetched, or args differ (response file for example)
+                }
+                outSourceKey = entry->m_SourceKey;
+                outIncludes.Swap( entry->m_Includes );
+                entry->m_KeyArgs.Clear(); // Includes can only be taken once
+                m_Stats.m_NumKeysReused++;
+                return true;
+            }
+        }
+
+        // Prefetching may still start for this node
+        m_BatchSemaphore.Wait();
+    }
+}
+
+// Take
+//------------------------------------------------------------------------------
+bool CachePrefetcher::Take( ObjectNode * node, const AString & cacheId, bool & outFound, void * & outData, size_t & outDataSize )
+{
+    PROFILE_FUNCTION;
+
+    Entry * entry = nullptr;
+    bool wasFull = false;
+    for ( ;; )
+    {
+        bool waitForClaim = false;
+        {
+            MutexHolder mh( m_Mutex );
+
+            // Prevent any further prefetching for this node
+            if ( Claim( node, entry ) == false )
+            {
+                waitForClaim = true; // Prefetching may still start for this node
+            }
+            else if ( entry == nullptr )
+            {
+                return false; // Not prefetched (or not yet started)
+            }
+            else if ( entry->m_Complete )
+            {
+                wasFull = IsFull();
+                m_Entries.FindAndErase( entry );
+                m_HeldBytes -= entry->m_DataSize;
+
+                // Allow prefetching again in future builds (the graph can persist between
+                // builds, in the BuildDaemon for example)
+                node->m_CachePrefetchClaimed = false;
+                if ( entry->m_CacheId == cacheId )
+                {
+                    m_Stats.m_NumUsed++;
+                }
+                else
+                {
+                    m_Stats.m_NumWasted++;
+                }
+                break;
+            }
+            else
+            {
+                m_Stats.m_NumWaits++;
+            }
+        }
+
+        if ( waitForClaim )
+        {
+            m_BatchSemaphore.Wait(); // Claim registered us as a waiter
+        }
+        else
+        {
+            WaitForBatch(); // Lookup is in progress
+        }
+    }
+
+    // Prefetching may have been held back waiting for space
+    if ( wasFull )
+    {
+        m_WorkSemaphore.Signal();
+    }
+
+    bool result = false;
+    if ( entry->m_CacheId == cacheId )
+    {
+        outFound = ( entry->m_Data != nullptr );
+        outData = entry->m_Data;
+        outDataSize = entry->m_DataSize;
+        result = true;
+    }
+    else if ( entry->m_Data )
+    {
+        // Key differs from the one formed in the background (inputs modified
+        // during the build for example), so the result can't be used
+        m_Cache->FreeMemory( entry->m_Data, entry->m_DataSize );
+    }
+    FDELETE entry;
+    return result;
+}
+
+// Flush
+//------------------------------------------------------------------------------
+void CachePrefetcher::Flush()
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( Thread::IsMainThread() );
+
+    // Discard pending work (a new batch will not start once this is empty)
+    {
+        MutexHolder mh( m_Mutex );
+        m_Pending.Clear();
+    }
+
+    // Wait for the batches in progress, if any
+    for ( ;; )
+    {
+        {
+            MutexHolder mh( m_Mutex );
+            if ( m_NumBatchesInProgress == 0 )
+            {
+                break;
+            }
+        }
+        WaitForBatch();
+    }
+
+    // Free unconsumed results and release claimed nodes so they can be
+    // prefetched again in future builds
+    Array< Entry * > entries( 0, true );
+    {
+        MutexHolder mh( m_Mutex );
+        entries.Swap( m_Entries );
+        m_HeldBytes = 0;
+        m_Stats.m_NumWasted += (uint32_t)entries.GetSize();
+        for ( ObjectNode * node : m_Claimed )
+        {
+            node->m_CachePrefetchClaimed = false;
+        }
+        m_Claimed.Clear();
+    }
+    for ( Entry * entry : entries )
+    {
+        if ( entry->m_Data )
+        {
+            m_Cache->FreeMemory( entry->m_Data, entry->m_DataSize );
+        }
+        FDELETE entry;
+    }
+}
+
+// GetAndResetStats
+//------------------------------------------------------------------------------
+void CachePrefetcher::GetAndResetStats( CachePrefetchStats & outStats )
+{
+    MutexHolder mh( m_Mutex );
+    outStats = m_Stats;
+    m_Stats = CachePrefetchStats();
+}
+
+// ThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t CachePrefetcher::ThreadFuncStatic( void * param )
+{
+    PROFILE_SET_THREAD_NAME( "CachePrefetch" );
+
+    static_cast< CachePrefetcher * >( param )->ThreadFunc();
+    return 0;
+}
+
+// ThreadFunc
+//------------------------------------------------------------------------------
+void CachePrefetcher::ThreadFunc()
+{
+    Array< ObjectNode * > nodes( MAX_BATCH_SIZE, false );
+    for ( ;; )
+    {
+        m_WorkSemaphore.Wait();
+
+        // Process as many batches as possible
+        for ( ;; )
+        {
+            {
+                MutexHolder mh( m_Mutex );
+                if ( m_Exit )
+                {
+                    return;
+                }
+
+                // Hold back while too much data is waiting to be consumed
+                if ( IsFull() )
+                {
+                    break;
+                }
+
+                // Take the most recently queued nodes. Older nodes are more likely
+                // to have been picked up by build threads already.
+                const size_t numPending = m_Pending.GetSize();
+                if ( numPending == 0 )
+                {
+                    break;
+                }
+                const size_t num = Math::Min( numPending, (size_t)MAX_BATCH_SIZE );
+                nodes.Append( m_Pending.End() - num, m_Pending.End() );
+                m_Pending.SetSize( numPending - num );
+                m_NumBatchesInProgress++;
+
+                // Have another thread take the next batch
+                if ( m_Pending.IsEmpty() == false )
+                {
+                    m_WorkSemaphore.Signal();
+                }
+            }
+
+            ProcessBatch( nodes );
+            nodes.Clear();
+        }
+    }
+}
+
+// ProcessBatch
+//------------------------------------------------------------------------------
+void CachePrefetcher::ProcessBatch( Array< ObjectNode * > & nodes )
+{
+    PROFILE_FUNCTION;
+
+    // Form keys
+    Array< AString > cacheIds( nodes.GetSize(), false );
+    Array< Entry * > entries( nodes.GetSize(), false );
+    AStackString<> cacheId;
+    AString keyArgs;
+    uint64_t sourceKey;
+    Array< AString > includes;
+    for ( ObjectNode * node : nodes )
+    {
+        {
+            MutexHolder mh( m_Mutex );
+            if ( node->m_CachePrefetchClaimed )
+            {
+                continue; // Build thread already started
+            }
+        }
+
+        includes.Clear(); // LightCache appends
+        if ( node->BuildCacheNameForPrefetch( cacheId, keyArgs, sourceKey, includes ) == false )
+        {
+            continue; // Build thread will try (and report problems)
+        }
+
+        // Register the lookup, unless a build thread has claimed the
+        // node while the key was being formed
+        MutexHolder mh( m_Mutex );
+        if ( node->m_CachePrefetchClaimed )
+        {
+            continue;
+        }
+        Entry * entry = FNEW( Entry );
+        entry->m_Node = node;
+        entry->m_CacheId = cacheId;
+        entry->m_KeyArgs = keyArgs;
+        entry->m_SourceKey = sourceKey;
+        entry->m_Includes.Swap( includes );
+        entry->m_Data = nullptr;
+        entry->m_DataSize = 0;
+        entry->m_Complete = false;
+        m_Entries.Append( entry );
+        entries.Append( entry );
+        cacheIds.Append( cacheId );
+    }
+
+    // Lookup
+    Array< void * > data( cacheIds.GetSize(), true );
+    Array< size_t > dataSizes( cacheIds.GetSize(), true );
+    if ( cacheIds.IsEmpty() == false )
+    {
+        m_Cache->RetrieveBatch( cacheIds, data, dataSizes );
+    }
+
+    // Publish results and wake any waiting build threads
+    MutexHolder mh( m_Mutex );
+    for ( size_t i = 0; i < entries.GetSize(); ++i )
+    {
+        Entry * entry = entries[ i ];
+        entry->m_Data = data[ i ];
+        entry->m_DataSize = data[ i ] ? dataSizes[ i ] : 0;
+        entry->m_Complete = true;
+        m_HeldBytes += entry->m_DataSize;
+        if ( entry->m_Data )
+        {
+            m_Stats.m_NumHits++;
+        }
+    }
+    if ( entries.IsEmpty() == false )
+    {
+        m_Stats.m_NumRequested += (uint32_t)entries.GetSize();
+        m_Stats.m_NumBatches++;
+    }
+    ASSERT( m_NumBatchesInProgress > 0 );
+    m_NumBatchesInProgress--;
+    if ( m_NumWaiters > 0 )
+    {
+        m_BatchSemaphore.Signal( m_NumWaiters );
+        m_NumWaiters = 0;
+    }
+}
+
+// WaitForBatch
+//------------------------------------------------------------------------------
+void CachePrefetcher::WaitForBatch()
+{
+    {
+        MutexHolder mh( m_Mutex );
+        if ( m_NumBatchesInProgress == 0 )
+        {
+            return;
+        }
+        m_NumWaiters++;
+    }
+    m_BatchSemaphore.Wait();
+}
+
+// Claim
+//------------------------------------------------------------------------------
+bool CachePrefetcher::Claim( ObjectNode * node, Entry * & outEntry )
+{
+    outEntry = FindEntry( node );
+
+    // When waiting for prefetching, the node must not be claimed while it is
+    // pending or could be in a batch whose keys are being formed. Pending work
+    // always results in a batch completing (unless held back), which wakes us.
+    if ( m_WaitForPrefetch && ( outEntry == nullptr ) && ( IsFull() == false ) )
+    {
+        if ( m_Pending.Find( node ) || ( m_NumBatchesInProgress > 0 ) )
+        {
+            m_NumWaiters++;
+            return false; // Caller must wait on m_BatchSemaphore
+        }
+    }
+
+    if ( node->m_CachePrefetchClaimed == false )
+    {
+        node->m_CachePrefetchClaimed = true;
+        m_Claimed.Append( node );
+    }
+    return true;
+}
+
+// FindEntry
+//------------------------------------------------------------------------------
+CachePrefetcher::Entry * CachePrefetcher::FindEntry( const ObjectNode * node ) const
+{
+    for ( Entry * entry : m_Entries )
+    {
+        if ( entry->m_Node == node )
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+// IsFull
+//------------------------------------------------------------------------------
+bool CachePrefetcher::IsFull() const
+{
+    return ( m_Entries.GetSize() >= MAX_HELD_ENTRIES ) || ( m_HeldBytes >= MAX_HELD_BYTES );
+}
+
+//------------------------------------------------------------------------------
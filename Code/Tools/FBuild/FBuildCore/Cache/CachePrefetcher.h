@@ -0,0 +1,116 @@
+// CachePrefetcher - Retrieve cache entries for queued objects in the background
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class ICache;
+class ObjectNode;
+
+// CachePrefetchStats
+//------------------------------------------------------------------------------
+class CachePrefetchStats
+{
+public:
+    uint32_t    m_NumQueued             = 0;    // Objects handed to the prefetcher
+    uint32_t    m_NumRequested          = 0;    // Cache keys looked up
+    uint32_t    m_NumBatches            = 0;    // Batched lookups made
+    uint32_t    m_NumHits               = 0;    // Lookups which found an entry
+    uint32_t    m_NumUsed               = 0;    // Results consumed by build threads
+    uint32_t    m_NumKeysReused         = 0;    // Keys formed in the background and reused by build threads
+    uint32_t    m_NumWaits              = 0;    // Build threads which had to wait for a lookup in progress
+    uint32_t    m_NumWasted             = 0;    // Results never consumed
+};
+
+// CachePrefetcher
+//  - Objects are handed over as soon as they are ready to build. Their cache
+//    keys are formed and looked up in batches (see ICache::RetrieveBatch),
+//    so results are available by the time a build thread picks up the job.
+//  - Only objects whose key can be formed without the preprocessor (LightCache
+//    or .UseDependencyCacheKey_Experimental) are prefetched
+//  - Keys are formed on several threads, as this dominates the cost. Build
+//    threads reuse the key (and include list) instead of forming it again.
+//  - Retrieved data is held in memory until consumed, up to a limit
+//------------------------------------------------------------------------------
+class CachePrefetcher
+{
+public:
+    CachePrefetcher( ICache * cache, bool waitForPrefetch );
+    ~CachePrefetcher();
+
+    // Hand over an object which is ready to build (main thread only)
+    void                Queue( ObjectNode * node );
+
+    // Retrieve the source key formed in the background for an object (build threads).
+    // Returns false if not available, or if formed with different args.
+    bool                TakeSourceKey( ObjectNode * node, const AString & args, uint64_t & outSourceKey, Array< AString > & outIncludes );
+
+    // Consume the prefetch result for an object (build threads). Returns false if
+    // the object was not prefetched, in which case the cache should be queried directly.
+    // Otherwise, outFound indicates if the entry exists (freed by caller with ICache::FreeMemory).
+    bool                Take( ObjectNode * node, const AString & cacheId, bool & outFound, void * & outData, size_t & outDataSize );
+
+    // Discard pending work and unconsumed results at the end of a build (main thread only)
+    void                Flush();
+
+    // Retrieve the stats gathered since the last call
+    void                GetAndResetStats( CachePrefetchStats & outStats );
+
+private:
+    enum : uint32_t
+    {
+        MAX_BATCH_SIZE      = 64,
+        MAX_THREADS         = 4,
+        MAX_HELD_ENTRIES    = 1024,
+    };
+    enum : uint64_t
+    {
+        MAX_HELD_BYTES      = ( 256 * 1024 * 1024 ),
+    };
+
+    struct Entry
+    {
+        const ObjectNode *  m_Node;
+        AString             m_CacheId;
+        AString             m_KeyArgs;      // Args used to form the source key
+        uint64_t            m_SourceKey;
+        Array< AString >    m_Includes;
+        void *              m_Data;
+        size_t              m_DataSize;
+        bool                m_Complete;
+    };
+
+    static uint32_t ThreadFuncStatic( void * param );
+    void            ThreadFunc();
+    void            ProcessBatch( Array< ObjectNode * > & nodes );
+    void            WaitForBatch();     // m_Mutex must not be held
+    bool            Claim( ObjectNode * node, Entry * & outEntry ); // m_Mutex must be held
+    Entry *         FindEntry( const ObjectNode * node ) const;
+    bool            IsFull() const;
+
+    ICache *            m_Cache;
+    bool                m_WaitForPrefetch;  // Build threads never bypass prefetching (for tests)
+    bool                m_Exit;
+    Mutex               m_Mutex;            // Protects the members below
+    Array< ObjectNode * > m_Pending;        // Queued but not yet looked up
+    Array< Entry * >    m_Entries;          // Looked up (or being looked up) but not consumed
+    Array< ObjectNode * > m_Claimed;        // Claimed by build threads (released by Flush)
+    uint64_t            m_HeldBytes;
+    uint32_t            m_NumBatchesInProgress;
+    uint32_t            m_NumWaiters;       // Threads waiting on m_BatchSemaphore
+    CachePrefetchStats  m_Stats;
+    Semaphore           m_WorkSemaphore;    // Signalled when nodes are queued or space is freed
+    Semaphore           m_BatchSemaphore;   // Signalled when a batch completes
+    uint32_t            m_NumThreads;
+    Thread              m_Threads[ MAX_THREADS ];
+};
+
+//------------------------------------------------------------------------------
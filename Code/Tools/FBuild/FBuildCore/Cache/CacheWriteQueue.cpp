@@ -0,0 +1,294 @@
+// CacheWriteQueue - Publish to the cache from a background thread
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CacheWriteQueue.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+
+// system
+#include <string.h> // for memcpy
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CacheWriteQueue::CacheWriteQueue( ICache * cache, bool verbose )
+    : m_Cache( cache )
+    , m_Verbose( verbose )
+    , m_Exit( false )
+    , m_FlushRequested( false )
+    , m_Pending( 256, true )
+    , m_BacklogItems( 0 )
+    , m_BacklogBytes( 0 )
+{
+    ASSERT( m_Cache );
+    m_Thread.Start( ThreadFuncStatic, "CacheWrite", this );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CacheWriteQueue::~CacheWriteQueue()
+{
+    Flush();
+
+    {
+        MutexHolder mh( m_Mutex );
+        m_Exit = true;
+    }
+    m_WorkSemaphore.Signal();
+    m_Thread.Join();
+
+    ASSERT( m_Pending.IsEmpty() );
+}
+
+// Enqueue
+//------------------------------------------------------------------------------
+bool CacheWriteQueue::Enqueue( const AString & cacheId, const void * data, size_t dataSize, const AString & description )
+{
+    PROFILE_FUNCTION;
+
+    // Check limits before copying data
+    {
+        MutexHolder mh( m_Mutex );
+        if ( ( m_BacklogItems >= MAX_QUEUED_ITEMS ) ||
+             ( ( m_BacklogItems > 0 ) && ( ( m_BacklogBytes + dataSize ) > MAX_QUEUED_BYTES ) ) )
+        {
+            m_Stats.m_NumRejected++;
+            return false;
+        }
+
+        // Reserve space
+        m_BacklogItems++;
+        m_BacklogBytes += dataSize;
+        m_Stats.m_NumQueued++;
+        if ( m_BacklogItems > m_Stats.m_PeakBacklog )
+        {
+            m_Stats.m_PeakBacklog = m_BacklogItems;
+        }
+        if ( m_BacklogBytes > m_Stats.m_PeakBacklogBytes )
+        {
+            m_Stats.m_PeakBacklogBytes = m_BacklogBytes;
+        }
+    }
+
+    // Caller's buffer may not outlive this call
+    Item * item = FNEW( Item );
+    item->m_CacheId = cacheId;
+    item->m_Description = description;
+    item->m_Data = ALLOC( dataSize ? dataSize : 1 );
+    memcpy( item->m_Data, data, dataSize );
+    item->m_DataSize = dataSize;
+
+    {
+        MutexHolder mh( m_Mutex );
+        m_Pending.Append( item );
+    }
+    m_WorkSemaphore.Signal();
+    return true;
+}
+
+// Flush
+//------------------------------------------------------------------------------
+void CacheWriteQueue::Flush()
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( Thread::IsMainThread() );
+
+    const Timer t;
+    for ( ;; )
+    {
+        {
+            MutexHolder mh( m_Mutex );
+            if ( m_BacklogItems == 0 )
+            {
+                m_FlushRequested = false;
+                m_Stats.m_FlushTimeMS += (uint32_t)t.GetElapsedMS();
+                return;
+            }
+            m_FlushRequested = true;
+        }
+        m_FlushSemaphore.Wait();
+    }
+}
+
+// GetAndResetStats
+//------------------------------------------------------------------------------
+void CacheWriteQueue::GetAndResetStats( CacheWriteStats & outStats )
+{
+    MutexHolder mh( m_Mutex );
+    outStats = m_Stats;
+    m_Stats = CacheWriteStats();
+}
+
+// ThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t CacheWriteQueue::ThreadFuncStatic( void * param )
+{
+    PROFILE_SET_THREAD_NAME( "CacheWrite" );
+
+    static_cast< CacheWriteQueue * >( param )->ThreadFunc();
+    return 0;
+}
+
+// ThreadFunc
+//------------------------------------------------------------------------------
+void CacheWriteQueue::ThreadFunc()
+{
+    Array< Item * > batch( 256, true );
+    Array< Item * > subBatch( MAX_PUBLISH_BATCH, false );
+    for ( ;; )
+    {
+        m_WorkSemaphore.Wait();
+
+        // Take everything queued so far
+        {
+            MutexHolder mh( m_Mutex );
+            if ( m_Pending.IsEmpty() )
+            {
+                if ( m_Exit )
+                {
+                    break;
+                }
+                continue; // Items were taken by a previous pass
+            }
+            batch.Swap( m_Pending );
+        }
+
+        // Publish in limited batches so the backlog shrinks progressively
+        for ( size_t i = 0; i < batch.GetSize(); i += MAX_PUBLISH_BATCH )
+        {
+            const size_t num = Math::Min( batch.GetSize() - i, (size_t)MAX_PUBLISH_BATCH );
+            subBatch.Append( batch.Begin() + i, batch.Begin() + i + num );
+            PublishBatch( subBatch );
+            subBatch.Clear();
+        }
+        batch.Clear();
+    }
+}
+
+// PublishBatch
+//------------------------------------------------------------------------------
+void CacheWriteQueue::PublishBatch( const Array< Item * > & items )
+{
+    PROFILE_FUNCTION;
+
+    const size_t count = items.GetSize();
+    Array< AString > cacheIds( count, false );
+    for ( const Item * item : items )
+    {
+        cacheIds.Append( item->m_CacheId );
+    }
+
+    const Timer t;
+
+    // Skip entries which are already present (built by another machine for example)
+    Array< bool > exists( count, false );
+    m_Cache->ExistsBatch( cacheIds, exists );
+
+    Array< AString > publishIds( count, false );
+    Array< const void * > publishData( count, false );
+    Array< size_t > publishDataSize( count, false );
+    Array< size_t > publishIndices( count, false );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        if ( exists[ i ] )
+        {
+            continue;
+        }
+        publishIds.Append( cacheIds[ i ] );
+        publishData.Append( items[ i ]->m_Data );
+        publishDataSize.Append( items[ i ]->m_DataSize );
+        publishIndices.Append( i );
+    }
+
+    Array< bool > stored( count, false );
+    if ( publishIds.IsEmpty() == false )
+    {
+        m_Cache->PublishBatch( publishIds, publishData, publishDataSize, stored );
+    }
+    const uint32_t publishTime = (uint32_t)t.GetElapsedMS();
+
+    // Results in item order
+    Array< bool > ok( count, false );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        ok.Append( false );
+    }
+    for ( size_t i = 0; i < publishIndices.GetSize(); ++i )
+    {
+        ok[ publishIndices[ i ] ] = stored[ i ];
+    }
+
+    uint32_t numPublished = 0;
+    uint32_t numFailed = 0;
+    uint32_t numAlreadyPresent = 0;
+    uint64_t publishedBytes = 0;
+    uint64_t totalBytes = 0;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        Item * item = items[ i ];
+        const uint32_t queuedTime = (uint32_t)item->m_QueuedTimer.GetElapsedMS();
+        if ( exists[ i ] )
+        {
+            ++numAlreadyPresent;
+            if ( m_Verbose )
+            {
+                FLOG_OUTPUT( "%s\n"
+                             " - Cache Store Skipped (Already Present): %u ms (Queued: %u ms) '%s'\n",
+                             item->m_Description.Get(), publishTime, queuedTime, item->m_CacheId.Get() );
+            }
+        }
+        else if ( ok[ i ] )
+        {
+            ++numPublished;
+            publishedBytes += item->m_DataSize;
+            if ( m_Verbose )
+            {
+                FLOG_OUTPUT( "%s\n"
+                             " - Cache Store: %u ms (Queued: %u ms) (Compressed: %" PRIu64 ") '%s'\n",
+                             item->m_Description.Get(), publishTime, queuedTime, (uint64_t)item->m_DataSize, item->m_CacheId.Get() );
+            }
+        }
+        else
+        {
+            ++numFailed;
+            if ( m_Verbose )
+            {
+                FLOG_OUTPUT( "%s\n"
+                             " - Cache Store Fail: %u ms (Queued: %u ms) '%s'\n",
+                             item->m_Description.Get(), publishTime, queuedTime, item->m_CacheId.Get() );
+            }
+        }
+
+        totalBytes += item->m_DataSize;
+        FREE( item->m_Data );
+        FDELETE item;
+    }
+
+    MutexHolder mh( m_Mutex );
+    m_Stats.m_NumPublished += numPublished;
+    m_Stats.m_NumFailed += numFailed;
+    m_Stats.m_NumAlreadyPresent += numAlreadyPresent;
+    m_Stats.m_PublishedBytes += publishedBytes;
+    m_Stats.m_PublishTimeMS += publishTime;
+
+    ASSERT( m_BacklogItems >= count );
+    m_BacklogItems -= (uint32_t)count;
+    m_BacklogBytes -= totalBytes;
+    if ( ( m_BacklogItems == 0 ) && m_FlushRequested )
+    {
+        m_FlushRequested = false;
+        m_FlushSemaphore.Signal();
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,97 @@
+// CacheWriteQueue - Publish to the cache from a background thread
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
+#include "Core/Strings/AString.h"
+#include "Core/Time/Timer.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class ICache;
+
+// CacheWriteStats
+//------------------------------------------------------------------------------
+class CacheWriteStats
+{
+public:
+    uint32_t    m_NumQueued             = 0;    // Stores handed to the background thread
+    uint32_t    m_NumPublished          = 0;    // Background stores which succeeded
+    uint32_t    m_NumFailed             = 0;    // Background stores which failed
+    uint32_t    m_NumAlreadyPresent     = 0;    // Background stores skipped as the entry already existed
+    uint32_t    m_NumRejected           = 0;    // Stores made synchronously because the queue was full
+    uint64_t    m_PublishedBytes        = 0;
+    uint32_t    m_PublishTimeMS         = 0;    // Time spent publishing on the background thread
+    uint32_t    m_PeakBacklog           = 0;
+    uint64_t    m_PeakBacklogBytes      = 0;
+    uint32_t    m_FlushTimeMS           = 0;    // Time spent waiting for the queue to drain
+};
+
+// CacheWriteQueue
+//  - Worker threads hand over compressed cache entries and continue building
+//    while a background thread publishes them, so slow caches (network shares
+//    for example) don't hold up the build
+//  - Queue size is bounded (count and memory). When full, callers should
+//    publish synchronously instead.
+//  - Items are published in batches (see ICache::PublishBatch), skipping
+//    those the cache reports as already present
+//------------------------------------------------------------------------------
+class CacheWriteQueue
+{
+public:
+    explicit CacheWriteQueue( ICache * cache, bool verbose );
+    ~CacheWriteQueue();
+
+    // Take a copy of the data to publish. Returns false if the queue is full.
+    [[nodiscard]] bool  Enqueue( const AString & cacheId, const void * data, size_t dataSize, const AString & description );
+
+    // Wait for all queued items to be published (main thread only)
+    void                Flush();
+
+    // Retrieve the stats gathered since the last call
+    void                GetAndResetStats( CacheWriteStats & outStats );
+
+private:
+    enum : uint32_t
+    {
+        MAX_QUEUED_ITEMS    = 4096,
+        MAX_PUBLISH_BATCH   = 64,
+    };
+    enum : uint64_t
+    {
+        MAX_QUEUED_BYTES    = ( 256 * 1024 * 1024 ),
+    };
+
+    struct Item
+    {
+        AString     m_CacheId;
+        AString     m_Description;
+        void *      m_Data;
+        size_t      m_DataSize;
+        Timer       m_QueuedTimer;
+    };
+
+    static uint32_t ThreadFuncStatic( void * param );
+    void            ThreadFunc();
+    void            PublishBatch( const Array< Item * > & items );
+
+    ICache *            m_Cache;
+    bool                m_Verbose;
+    bool                m_Exit;
+    bool                m_FlushRequested;
+    Mutex               m_Mutex;            // Protects the members below
+    Array< Item * >     m_Pending;
+    uint32_t            m_BacklogItems;     // Pending and in progress
+    uint64_t            m_BacklogBytes;
+    CacheWriteStats     m_Stats;
+    Semaphore           m_WorkSemaphore;    // Signalled when items are added
+    Semaphore           m_FlushSemaphore;   // Signalled when backlog is cleared during a Flush
+    Thread              m_Thread;
+};
+
+//------------------------------------------------------------------------------
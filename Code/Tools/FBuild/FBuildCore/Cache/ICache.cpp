@@ -5,7 +5,74 @@
 //------------------------------------------------------------------------------
 #include "ICache.h"
 
+#include <Core/Containers/Array.h>
+#include <Core/Env/Assert.h>
 #include <Core/Strings/AString.h>
+#include <Core/Tracing/Tracing.h>
+
+// RetrieveBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void ICache::RetrieveBatch( const Array< AString > & cacheIds, Array< void * > & outData, Array< size_t > & outDataSize )
+{
+    outData.SetSize( cacheIds.GetSize() );
+    outDataSize.SetSize( cacheIds.GetSize() );
+    for ( size_t i = 0; i < cacheIds.GetSize(); ++i )
+    {
+        if ( Retrieve( cacheIds[ i ], outData[ i ], outDataSize[ i ] ) == false )
+        {
+            outData[ i ] = nullptr;
+            outDataSize[ i ] = 0;
+        }
+    }
+}
+
+// PublishBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void ICache::PublishBatch( const Array< AString > & cacheIds,
+                                       const Array< const void * > & data,
+                                       const Array< size_t > & dataSize,
+                                       Array< bool > & outStored )
+{
+    ASSERT( ( data.GetSize() == cacheIds.GetSize() ) && ( dataSize.GetSize() == cacheIds.GetSize() ) );
+    outStored.SetSize( cacheIds.GetSize() );
+    for ( size_t i = 0; i < cacheIds.GetSize(); ++i )
+    {
+        outStored[ i ] = Publish( cacheIds[ i ], data[ i ], dataSize[ i ] );
+    }
+}
+
+// ExistsBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void ICache::ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists )
+{
+    outExists.SetSize( cacheIds.GetSize() );
+    for ( bool & exists : outExists )
+    {
+        exists = false;
+    }
+}
+
+// GetSampleIds
+//------------------------------------------------------------------------------
+/*virtual*/ bool ICache::GetSampleIds( size_t /*maxEntries*/, Array< AString > & /*outCacheIds*/ )
+{
+    return false;
+}
+
+// Verify
+//------------------------------------------------------------------------------
+/*virtual*/ bool ICache::Verify( bool /*showProgress*/ )
+{
+    OUTPUT( "- Verification not supported by this cache\n" );
+    return false;
+}
+
+// GetAndResetVerifyStats
+//------------------------------------------------------------------------------
+/*virtual*/ void ICache::GetAndResetVerifyStats( CacheVerifyStats & outStats )
+{
+    outStats = CacheVerifyStats();
+}
 
 // GetCacheId
 //------------------------------------------------------------------------------
@@ -16,7 +83,7 @@
                                     AString & outCacheId )
 {
     // cache version - bump if cache format is changed
-    const char cacheVersion( 'E' );
+    const char cacheVersion( 'G' );
 
     // format example: 2377DE32AB045A2D_FED872A1_AB62FEAA23498AAC-32A2B04375A2D7DE.7
     outCacheId.Format( "%016" PRIX64 "_%08X_%016" PRIX64 "-%016" PRIX64 ".%c",
@@ -9,6 +9,27 @@
 // Forward Declarations
 //------------------------------------------------------------------------------
 class AString;
+template < class T > class Array;
+
+// CacheVerifyStats
+//------------------------------------------------------------------------------
+class CacheVerifyStats
+{
+public:
+    uint32_t    m_NumVerified       = 0;    // Entries whose checksum was checked
+    uint32_t    m_NumCorrupt        = 0;    // Entries which failed the check (and were discarded)
+    uint64_t    m_VerifiedBytes     = 0;
+    uint64_t    m_VerifyTimeUS      = 0;    // Summed across threads
+
+    bool        IsEmpty() const { return ( m_NumVerified == 0 ); }
+    void        Add( const CacheVerifyStats & other )
+    {
+        m_NumVerified += other.m_NumVerified;
+        m_NumCorrupt += other.m_NumCorrupt;
+        m_VerifiedBytes += other.m_VerifiedBytes;
+        m_VerifyTimeUS += other.m_VerifyTimeUS;
+    }
+};
 
 // Cache
 //------------------------------------------------------------------------------
@@ -31,6 +52,32 @@ public:
     virtual bool OutputInfo( bool showProgress ) = 0;
     virtual bool Trim( bool showProgress, uint32_t sizeMiB ) = 0;
 
+    // Optional: Retrieve several entries at once. Implementations which can overlap
+    // requests should override this. Misses are returned as nullptr/0 and hits
+    // must be released with FreeMemory.
+    virtual void RetrieveBatch( const Array< AString > & cacheIds, Array< void * > & outData, Array< size_t > & outDataSize );
+
+    // Optional: Store several entries at once
+    virtual void PublishBatch( const Array< AString > & cacheIds,
+                               const Array< const void * > & data,
+                               const Array< size_t > & dataSize,
+                               Array< bool > & outStored );
+
+    // Optional: Check which entries are present without retrieving them. Implementations
+    // which can't do this cheaply report all entries as not present.
+    virtual void ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists );
+
+    // Optional: List recently stored entries (used to train compression dictionaries).
+    // Returns false if not supported.
+    virtual bool GetSampleIds( size_t maxEntries, Array< AString > & outCacheIds );
+
+    // Optional: Check the integrity of every entry, discarding any which are corrupt.
+    // Returns false if not supported.
+    virtual bool Verify( bool showProgress );
+
+    // Optional: Retrieve the cost of integrity checks made since the last call
+    virtual void GetAndResetVerifyStats( CacheVerifyStats & outStats );
+
     // Helper functions
     static void GetCacheId( const uint64_t preprocessedSourceKey,
                             const uint32_t commandLineKey,
@@ -8,15 +8,20 @@
 // FBuildCore
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/DirectiveScanner.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ProjectGeneratorBase.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 
 // Core
+#include "Core/Containers/UniquePtr.h"
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
 #include "Core/Math/xxHash.h"
+#include "Core/Process/Atomic.h"
 #include "Core/Process/Mutex.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
@@ -52,9 +57,16 @@ public:
 
     ~IncludedFile();
 
+    void                            CopyFrom( const IncludedFile & other );
+    void                            Save( IOStream & stream ) const;
+    bool                            Load( IOStream & stream );
+
     uint64_t                        m_FileNameHash;
     AString                         m_FileName;
     bool                            m_Exists;
+    bool                            m_Persistable;      // False if problems were found during parsing
+    uint64_t                        m_LastWriteTime;    // Time and size when parsed, to detect
+    uint64_t                        m_FileSize;         //  modifications in later builds
     uint64_t                        m_ContentHash;
     Array< Include >                m_Includes;
     Array< const IncludeDefine * >  m_IncludeDefines;
@@ -123,6 +135,65 @@ public:
         *location = item;
         return *location;
     }
+
+    // Remove the given files, files beneath the given directories, plus files
+    // which didn't exist (they may have been created since). Open addressing
+    // doesn't allow removal in place, so the remaining entries are re-inserted.
+    void Invalidate( const Array< AString > & fileNames, const Array< uint64_t > & fileNameHashes, const Array< AString > & dirPrefixes )
+    {
+        ASSERT( fileNames.GetSize() == fileNameHashes.GetSize() );
+
+        // Mark changed files as missing rather than clearing them immediately, as
+        // clearing breaks probe chains (and a file may be listed more than once)
+        for ( size_t i = 0; i < fileNames.GetSize(); ++i )
+        {
+            IncludedFile ** location = InternalFind( fileNames[ i ], fileNameHashes[ i ] );
+            if ( location && *location )
+            {
+                ( *location )->m_Exists = false;
+            }
+        }
+
+        if ( dirPrefixes.IsEmpty() == false )
+        {
+            for ( IncludedFile * file : m_Buckets )
+            {
+                if ( file == nullptr )
+                {
+                    continue;
+                }
+                for ( const AString & dirPrefix : dirPrefixes )
+                {
+                    if ( PathUtils::PathBeginsWith( file->m_FileName, dirPrefix ) )
+                    {
+                        file->m_Exists = false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        const size_t numElts = m_Elts;
+        for ( IncludedFile * & file : m_Buckets )
+        {
+            if ( file && ( file->m_Exists == false ) )
+            {
+                FDELETE file;
+                file = nullptr;
+                --m_Elts;
+            }
+        }
+
+        if ( m_Elts != numElts )
+        {
+            Grow( m_Buckets.GetSize() );
+        }
+    }
+
+    // Buckets contain nullptr for empty slots
+    const Array< IncludedFile * > & GetBuckets() const { return m_Buckets; }
+    size_t GetSize() const { return m_Elts; }
+
     void Destruct()
     {
         for ( IncludedFile * file : m_Buckets )
@@ -225,6 +296,106 @@ IncludedFile::~IncludedFile()
     }
 }
 
+// CopyFrom
+//------------------------------------------------------------------------------
+void IncludedFile::CopyFrom( const IncludedFile & other )
+{
+    ASSERT( m_IncludeDefines.IsEmpty() );
+
+    m_FileNameHash = other.m_FileNameHash;
+    m_FileName = other.m_FileName;
+    m_Exists = other.m_Exists;
+    m_Persistable = other.m_Persistable;
+    m_LastWriteTime = other.m_LastWriteTime;
+    m_FileSize = other.m_FileSize;
+    m_ContentHash = other.m_ContentHash;
+    m_Includes = other.m_Includes;
+    m_IncludeDefines.SetCapacity( other.m_IncludeDefines.GetSize() );
+    for ( const IncludeDefine * def : other.m_IncludeDefines )
+    {
+        m_IncludeDefines.Append( FNEW( IncludeDefine( def->m_Macro, def->m_Include, def->m_Type ) ) );
+    }
+    m_NonIncludeDefines = other.m_NonIncludeDefines;
+}
+
+// Save
+//------------------------------------------------------------------------------
+void IncludedFile::Save( IOStream & stream ) const
+{
+    stream.Write( m_FileName );
+    stream.Write( m_Exists );
+    stream.Write( m_LastWriteTime );
+    stream.Write( m_FileSize );
+    stream.Write( m_ContentHash );
+    stream.Write( (uint32_t)m_Includes.GetSize() );
+    for ( const Include & include : m_Includes )
+    {
+        stream.Write( include.m_Include );
+        stream.Write( (uint8_t)include.m_Type );
+    }
+    stream.Write( (uint32_t)m_IncludeDefines.GetSize() );
+    for ( const IncludeDefine * def : m_IncludeDefines )
+    {
+        stream.Write( def->m_Macro );
+        stream.Write( def->m_Include );
+        stream.Write( (uint8_t)def->m_Type );
+    }
+    stream.Write( m_NonIncludeDefines );
+}
+
+// Load
+//------------------------------------------------------------------------------
+bool IncludedFile::Load( IOStream & stream )
+{
+    uint32_t numIncludes;
+    if ( ( stream.Read( m_FileName ) == false ) ||
+         ( stream.Read( m_Exists ) == false ) ||
+         ( stream.Read( m_LastWriteTime ) == false ) ||
+         ( stream.Read( m_FileSize ) == false ) ||
+         ( stream.Read( m_ContentHash ) == false ) ||
+         ( stream.Read( numIncludes ) == false ) )
+    {
+        return false;
+    }
+    m_FileNameHash = xxHash3::Calc64( m_FileName );
+    m_Persistable = true;
+
+    AStackString<> include;
+    uint8_t type;
+    m_Includes.SetCapacity( numIncludes );
+    for ( uint32_t i = 0; i < numIncludes; ++i )
+    {
+        if ( ( stream.Read( include ) == false ) ||
+             ( stream.Read( type ) == false ) ||
+             ( type > (uint8_t)IncludeType::MACRO ) )
+        {
+            return false;
+        }
+        m_Includes.EmplaceBack( include, (IncludeType)type );
+    }
+
+    uint32_t numIncludeDefines;
+    if ( stream.Read( numIncludeDefines ) == false )
+    {
+        return false;
+    }
+    AStackString<> macro;
+    m_IncludeDefines.SetCapacity( numIncludeDefines );
+    for ( uint32_t i = 0; i < numIncludeDefines; ++i )
+    {
+        if ( ( stream.Read( macro ) == false ) ||
+             ( stream.Read( include ) == false ) ||
+             ( stream.Read( type ) == false ) ||
+             ( type > (uint8_t)IncludeType::MACRO ) )
+        {
+            return false;
+        }
+        m_IncludeDefines.Append( FNEW( IncludeDefine( macro, include, (IncludeType)type ) ) );
+    }
+
+    return stream.Read( m_NonIncludeDefines );
+}
+
 // IncludedFileBucket
 //------------------------------------------------------------------------------
 class IncludedFileBucket
@@ -250,6 +421,17 @@ public:
 #define LIGHTCACHE_HASH_TO_BUCKET(hash) ( (( hash ) >> ( 64ULL - LIGHTCACHE_NUM_BUCKET_BITS )) & LIGHTCACHE_BUCKET_MASK_BASE )
 static IncludedFileBucket g_AllIncludedFiles[ LIGHTCACHE_NUM_BUCKETS ];
 
+// Files parsed in previous builds. Only modified on the main thread when no
+// build is in progress, so can be read without locking.
+static IncludedFileHashSet g_PersistedFiles;
+static bool g_PersistedFilesLoaded = false;
+static uint32_t g_NumPersistedFilesSaved = 0;           // Number of files in the data when last loaded or saved
+static volatile bool g_PersistentDataChanged = false;   // Were new parse results obtained since then?
+static volatile uint32_t g_NumFilesReused = 0;
+static volatile uint32_t g_NumFilesParsed = 0;
+
+#define LIGHTCACHE_PERSISTENT_DATA_VERSION ( 1 )
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 LightCache::LightCache()
@@ -336,6 +518,33 @@ bool LightCache::Hash( ObjectNode * node,
     return true;
 }
 
+// HashFiles
+//------------------------------------------------------------------------------
+bool LightCache::HashFiles( const Array< AString > & fileNames, uint64_t & outSourceHash )
+{
+    PROFILE_FUNCTION;
+
+    // Hash in the same way as Hash(), re-using previously hashed files
+    Array< uint64_t > hashes( fileNames.GetSize() * 2, false );
+    for ( const AString & fileName : fileNames )
+    {
+        const IncludedFile * file = FileExists( fileName );
+        ASSERT( file );
+        if ( ( file->m_Exists == false ) || ( file->m_ContentHash == 0 ) )
+        {
+            m_Errors.Clear(); // Only report the problem preventing use (not parsing problems)
+            AddError( nullptr, nullptr, "File could not be read: '%s'", fileName.Get() );
+            outSourceHash = 0;
+            return false;
+        }
+        hashes.Append( file->m_FileNameHash ); // Filename can change compilation result
+        hashes.Append( file->m_ContentHash );
+    }
+    outSourceHash = xxHash3::Calc64( hashes.Begin(), hashes.GetSize() * sizeof( uint64_t ) );
+
+    return true;
+}
+
 // ClearCachedFiles
 //------------------------------------------------------------------------------
 /*static*/ void LightCache::ClearCachedFiles()
@@ -344,6 +553,170 @@ bool LightCache::Hash( ObjectNode * node,
     {
         bucket.Destruct();
     }
+    g_PersistedFiles.Destruct();
+    g_PersistedFilesLoaded = false;
+    g_NumPersistedFilesSaved = 0;
+    AtomicStoreRelaxed( &g_PersistentDataChanged, false );
+    AtomicStoreRelaxed( &g_NumFilesReused, 0u );
+    AtomicStoreRelaxed( &g_NumFilesParsed, 0u );
+}
+
+// InvalidateCachedFiles
+//------------------------------------------------------------------------------
+/*static*/ void LightCache::InvalidateCachedFiles( const Array< AString > & changedFiles, const Array< AString > & changedDirs )
+{
+    PROFILE_FUNCTION;
+
+    // Results for files from previous builds are re-validated using the file time
+    // and size when used, so only files seen in this process need to be handled
+    Array< uint64_t > changedFileHashes( changedFiles.GetSize(), true );
+    for ( const AString & fileName : changedFiles )
+    {
+        changedFileHashes.Append( xxHash3::Calc64( fileName ) );
+    }
+    Array< AString > changedDirPrefixes( changedDirs.GetSize(), true );
+    for ( const AString & changedDir : changedDirs )
+    {
+        AString & prefix = changedDirPrefixes.EmplaceBack( changedDir );
+        if ( prefix.EndsWith( NATIVE_SLASH ) == false )
+        {
+            prefix += NATIVE_SLASH;
+        }
+    }
+    for ( IncludedFileBucket & bucket : g_AllIncludedFiles )
+    {
+        MutexHolder mh( bucket.m_Mutex );
+        bucket.m_HashSet.Invalidate( changedFiles, changedFileHashes, changedDirPrefixes );
+    }
+}
+
+// LoadPersistentData
+//------------------------------------------------------------------------------
+/*static*/ bool LightCache::LoadPersistentData( const AString & fileName )
+{
+    PROFILE_FUNCTION;
+
+    // Already loaded?
+    if ( g_PersistedFilesLoaded )
+    {
+        return true;
+    }
+    g_PersistedFilesLoaded = true;
+
+    // Read entire file
+    FileStream f;
+    if ( f.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false; // Not an error - no previous build
+    }
+    const size_t fileSize = (size_t)f.GetFileSize();
+    UniquePtr< char > data( (char *)ALLOC( fileSize ? fileSize : 1 ) );
+    if ( f.Read( data.Get(), fileSize ) != fileSize )
+    {
+        return false;
+    }
+    f.Close();
+
+    // Check header
+    ConstMemoryStream stream( data.Get(), fileSize );
+    char header[ 4 ];
+    uint32_t numFiles;
+    if ( ( stream.Read( header, 4 ) != 4 ) ||
+         ( header[ 0 ] != 'L' ) || ( header[ 1 ] != 'C' ) || ( header[ 2 ] != 'D' ) ||
+         ( header[ 3 ] != LIGHTCACHE_PERSISTENT_DATA_VERSION ) ||
+         ( stream.Read( numFiles ) == false ) )
+    {
+        FLOG_VERBOSE( "LightCache data is incompatible or corrupt: '%s'", fileName.Get() );
+        return false;
+    }
+
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        IncludedFile * file = FNEW( IncludedFile() );
+        if ( file->Load( stream ) == false )
+        {
+            // Discard everything if corrupt
+            FDELETE file;
+            g_PersistedFiles.Destruct();
+            FLOG_VERBOSE( "LightCache data is corrupt: '%s'", fileName.Get() );
+            return false;
+        }
+        g_PersistedFiles.Insert( file );
+    }
+    g_NumPersistedFilesSaved = numFiles;
+
+    FLOG_VERBOSE( "LightCache data loaded: %u files from '%s'", numFiles, fileName.Get() );
+    return true;
+}
+
+// SavePersistentData
+//------------------------------------------------------------------------------
+/*static*/ bool LightCache::SavePersistentData( const AString & fileName )
+{
+    PROFILE_FUNCTION;
+
+    // Files seen in this build. Results from previous builds which were not
+    // needed are dropped, so stale entries don't accumulate.
+    Array< const IncludedFile * > files( 4096, true );
+    for ( const IncludedFileBucket & bucket : g_AllIncludedFiles )
+    {
+        for ( const IncludedFile * file : bucket.m_HashSet.GetBuckets() )
+        {
+            if ( file && file->m_Persistable )
+            {
+                files.Append( file );
+            }
+        }
+    }
+
+    // Keep existing data if nothing was parsed (everything was up-to-date)
+    if ( files.IsEmpty() )
+    {
+        return true;
+    }
+
+    // Nothing changed? Files not parsed in this build were re-used from the
+    // existing data, so if none were dropped, the data would be identical.
+    if ( ( AtomicLoadRelaxed( &g_PersistentDataChanged ) == false ) &&
+         ( files.GetSize() == g_NumPersistedFilesSaved ) )
+    {
+        return true;
+    }
+
+    MemoryStream stream( 4 * 1024 * 1024, 4 * 1024 * 1024 );
+    const char header[ 4 ] = { 'L', 'C', 'D', LIGHTCACHE_PERSISTENT_DATA_VERSION };
+    stream.Write( header, 4 );
+    stream.Write( (uint32_t)files.GetSize() );
+    for ( const IncludedFile * file : files )
+    {
+        file->Save( stream );
+    }
+
+    FileStream f;
+    if ( ( FileIO::EnsurePathExistsForFile( fileName ) == false ) ||
+         ( f.Open( fileName.Get(), FileStream::WRITE_ONLY ) == false ) ||
+         ( f.Write( stream.GetData(), stream.GetSize() ) != stream.GetSize() ) )
+    {
+        FLOG_WARN( "Failed to save LightCache data '%s'", fileName.Get() );
+        return false;
+    }
+    g_NumPersistedFilesSaved = (uint32_t)files.GetSize();
+    AtomicStoreRelaxed( &g_PersistentDataChanged, false );
+    return true;
+}
+
+// GetNumFilesReused
+//------------------------------------------------------------------------------
+/*static*/ uint32_t LightCache::GetNumFilesReused()
+{
+    return AtomicLoadRelaxed( &g_NumFilesReused );
+}
+
+// GetNumFilesParsed
+//------------------------------------------------------------------------------
+/*static*/ uint32_t LightCache::GetNumFilesParsed()
+{
+    return AtomicLoadRelaxed( &g_NumFilesParsed );
 }
 
 // Parse
@@ -368,6 +741,7 @@ void LightCache::Parse( IncludedFile * file, FileStream & f )
     file->m_ContentHash = xxHash3::Calc64( fileContents );
 
     const char * pos = fileContents.Get();
+    const char * const end = fileContents.GetEnd();
     for (;;)
     {
         // skip leading whitespace
@@ -400,11 +774,11 @@ void LightCache::Parse( IncludedFile * file, FileStream & f )
         // block comment?
         if ( ( c == '/' ) && ( pos[ 1 ] == '*' ) )
         {
-            SkipCommentBlock( pos );
+            pos = DirectiveScanner::SkipCommentBlock( pos, end );
         }
 
         // Advance to next line
-        SkipToEndOfLine( pos );
+        pos = DirectiveScanner::FindLineEnd( pos, end );
         SkipLineEnd( pos );
     }
 }
@@ -522,36 +896,6 @@ bool LightCache::ParseDirective_Import( IncludedFile & file, const char * & pos
     return false;
 }
 
-// SkipCommentBlock
-//------------------------------------------------------------------------------
-void LightCache::SkipCommentBlock( const char * & pos )
-{
-    // Skip opening /*
-    ASSERT( ( pos[ 0 ] == '/' ) && ( pos[ 1 ] == '*' ) );
-
-    // Skip to closing*/
-    for (;;)
-    {
-        const char thisChar = *pos;
-
-        // end of data?
-        if ( thisChar == 0 )
-        {
-            break;
-        }
-
-        // end of comment block?
-        if ( ( thisChar == '*' ) && ( pos[ 1 ] == '/' ) )
-        {
-            pos +=2;
-            break;
-        }
-
-        // part of comment
-        ++pos;
-    }
-}
-
 // ParseIncludeString
 //------------------------------------------------------------------------------
 bool LightCache::ParseIncludeString( const char * & pos,
@@ -876,15 +1220,47 @@ const IncludedFile * LightCache::FileExists( const AString & fileName )
     // A newly seen file
     IncludedFile * newFile = FNEW( IncludedFile() );
     const IncludedFile * retval = nullptr;
+
+    // Obtain time and size before reading, so modifications made after this are detected next time
+    FileIO::FileInfo fileInfo;
+    const bool haveFileInfo = FileIO::GetFileInfo( fileName, fileInfo );
+
+    // Re-use results from a previous build if the file is unchanged
+    const IncludedFile * persistedFile = g_PersistedFiles.Find( fileName, fileNameHash );
+    if ( persistedFile &&
+         ( persistedFile->m_Exists == haveFileInfo ) &&
+         ( ( haveFileInfo == false ) ||
+           ( ( persistedFile->m_LastWriteTime == fileInfo.m_LastWriteTime ) && ( persistedFile->m_FileSize == fileInfo.m_Size ) ) ) )
+    {
+        newFile->CopyFrom( *persistedFile );
+        AtomicInc( &g_NumFilesReused );
+        {
+            // Store to shared cache
+            MutexHolder mh( bucket.m_Mutex );
+            retval = bucket.m_HashSet.Insert( newFile );
+        }
+        m_IncludeDefines.Append( retval->m_IncludeDefines );
+        return retval;
+    }
+
     newFile->m_FileNameHash = fileNameHash;
     newFile->m_FileName = fileName;
     newFile->m_Exists = false;
+    newFile->m_Persistable = true;
+    newFile->m_LastWriteTime = haveFileInfo ? fileInfo.m_LastWriteTime : 0;
+    newFile->m_FileSize = haveFileInfo ? fileInfo.m_Size : 0;
     newFile->m_ContentHash = 0;
 
     // Try to open the new file
     FileStream f;
     if ( f.Open( fileName.Get() ) == false )
     {
+        // Unexpected result if we could get the file info (a directory for example)
+        newFile->m_Persistable = ( haveFileInfo == false );
+        if ( newFile->m_Persistable )
+        {
+            AtomicStoreRelaxed( &g_PersistentDataChanged, true );
+        }
         {
             // Store to shared cache
             MutexHolder mh( bucket.m_Mutex );
@@ -895,7 +1271,17 @@ const IncludedFile * LightCache::FileExists( const AString & fileName )
 
     // File exists - parse it
     newFile->m_Exists = true;
+    const uint32_t errorsLength = m_Errors.GetLength();
     Parse( newFile, f );
+    AtomicInc( &g_NumFilesParsed );
+    if ( m_Errors.GetLength() != errorsLength )
+    {
+        newFile->m_Persistable = false; // Re-parse in future builds so errors are reported
+    }
+    else
+    {
+        AtomicStoreRelaxed( &g_PersistentDataChanged, true );
+    }
 
     {
         // Store to shared cache
@@ -17,6 +17,7 @@ class AString;
 class FileStream;
 class IncludedFile;
 class IncludeDefine;
+class IOStream;
 class ObjectNode;
 enum class IncludeType : uint8_t;
 
@@ -33,18 +34,33 @@ public:
                uint64_t & outSourceHash,         // Resulting hash of source code
                Array< AString > & outIncludes ); // Discovered dependencies
 
-    // Get text description of problem(s) if Hash() fails
+    // Hash a known list of files (from compiler dependency output for example)
+    bool HashFiles( const Array< AString > & fileNames, uint64_t & outSourceHash );
+
+    // Get text description of problem(s) if Hash() or HashFiles() fails
     const AString & GetErrors() const { return m_Errors; }
 
     static void ClearCachedFiles();
 
+    // Discard results for modified files, files beneath changed directories (and
+    // files which didn't exist), keeping the rest for the next build. For use when
+    // changes are known (BuildDaemon)
+    static void InvalidateCachedFiles( const Array< AString > & changedFiles, const Array< AString > & changedDirs );
+
+    // Parse results can be saved and re-used for unmodified files in later builds
+    static bool LoadPersistentData( const AString & fileName );
+    static bool SavePersistentData( const AString & fileName );
+
+    // Files re-used from persistent data and files parsed (since ClearCachedFiles)
+    static uint32_t GetNumFilesReused();
+    static uint32_t GetNumFilesParsed();
+
 protected:
     void                    Parse( IncludedFile * file, FileStream & f );
     bool                    ParseDirective( IncludedFile & file, const char * & pos );
     bool                    ParseDirective_Include( IncludedFile & file, const char * & pos );
     bool                    ParseDirective_Define( IncludedFile & file, const char * & pos );
     bool                    ParseDirective_Import( IncludedFile & file, const char * & pos );
-    void                    SkipCommentBlock( const char * & pos );
     bool                    ParseIncludeString( const char * & pos, AString & outIncludePath, IncludeType & outIncludeType );
     bool                    ParseMacroName( const char * & pos, AString & outMacroName );
     void                    ProcessInclude( const AString & include, IncludeType type );
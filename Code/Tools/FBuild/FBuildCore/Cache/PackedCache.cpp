@@ -0,0 +1,1756 @@
+// PackedCache - Cache implementation using pack files and a shared index
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "PackedCache.h"
+
+// FBuild
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
+// Core
+#include "Core/Containers/UniquePtr.h"
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Time.h"
+#include "Core/Time/Timer.h"
+#include "Core/Tracing/Tracing.h"
+
+// system
+#if defined( __WINDOWS__ )
+    #include "Core/Env/WindowsHeader.h"
+#elif defined( __LINUX__ ) || defined( __APPLE__ )
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+#include <stdlib.h> // for strtoul
+#include <string.h> // for memcmp, memset
+
+// Defines
+//------------------------------------------------------------------------------
+#define PACKED_CACHE_LOCK_FILE_NAME     "PackedCache.lock"
+#define PACKED_CACHE_INDEX_VERSION      ( 1 )
+#define PACKED_CACHE_MAX_PACKS          ( 1024 )
+#define PACKED_CACHE_INITIAL_CAPACITY   ( 4096 )                // Index slots (must be a power of 2)
+#define PACKED_CACHE_MAX_PACK_SIZE      ( 256 * MEGABYTE )      // Start a new pack beyond this size
+#define PACKED_CACHE_TRIM_HEADROOM_PERCENT ( 10 )               // EnforceSizeLimit trims this far below the limit
+#define PACKED_CACHE_MAX_PENDING_TOUCHES ( 256 )                // Record usage in the index beyond this many retrievals
+#define PACKED_CACHE_INVALID            ( 0xFFFFFFFF )
+
+#if defined( __WINDOWS__ )
+    #define PACKED_CACHE_INVALID_HANDLE INVALID_HANDLE_VALUE
+#else
+    #define PACKED_CACHE_INVALID_HANDLE ( -1 )
+#endif
+
+// PackedCacheIndexHeader
+//  - Stored at the start of the index file
+//------------------------------------------------------------------------------
+struct PackedCacheIndexHeader
+{
+    char        m_Identifier[ 4 ];          // "FBPC"
+    uint32_t    m_Version;
+    uint32_t    m_Generation;               // Must match the generation in the lock file
+    uint32_t    m_Capacity;                 // Number of entry slots (power of 2)
+    uint32_t    m_UpdateInProgress;         // Set while modifying the index (to detect crashed writers)
+    uint32_t    m_NumEntries;
+    uint32_t    m_NumTombstones;            // Slots of removed entries
+    uint32_t    m_LRUHead;                  // Most recently used entry
+    uint32_t    m_LRUTail;                  // Least recently used entry
+    uint32_t    m_CurrentPack;              // Pack being appended to
+    uint32_t    m_NextPackSerial;
+    uint32_t    m_Padding;
+    uint32_t    m_PackSerials[ PACKED_CACHE_MAX_PACKS ];    // 0 for unused
+    uint64_t    m_PackSizes[ PACKED_CACHE_MAX_PACKS ];      // Bytes in pack file
+    uint64_t    m_PackLiveBytes[ PACKED_CACHE_MAX_PACKS ];  // Bytes of pack referenced by index entries
+};
+
+// PackedCacheIndexEntry
+//------------------------------------------------------------------------------
+struct PackedCacheIndexEntry
+{
+    enum : uint8_t
+    {
+        EMPTY   = 0,
+        USED    = 1,
+        REMOVED = 2,
+    };
+
+    uint64_t    m_KeyHashA;
+    uint64_t    m_KeyHashB;
+    uint64_t    m_Offset;                   // Offset of data within pack
+    uint64_t    m_DataHash;
+    uint64_t    m_LastAccessTime;
+    uint32_t    m_Size;
+    uint32_t    m_LRUPrev;
+    uint32_t    m_LRUNext;
+    uint16_t    m_Pack;
+    uint8_t     m_State;
+    uint8_t     m_Padding1;
+    uint64_t    m_Padding2;
+};
+static_assert( sizeof( PackedCacheIndexEntry ) == 64, "Unexpected PackedCacheIndexEntry size" );
+
+// Entries start on a page boundary after the header
+static const size_t sEntriesOffset = ( ( sizeof( PackedCacheIndexHeader ) + 4095 ) & ~(size_t)4095 );
+
+// Platform helpers
+//------------------------------------------------------------------------------
+namespace
+{
+    #if defined( __WINDOWS__ )
+        typedef HANDLE PlatformFileHandle;
+    #else
+        typedef int PlatformFileHandle;
+    #endif
+
+    PlatformFileHandle OpenLockFile( const AString & fileName )
+    {
+        #if defined( __WINDOWS__ )
+            return ::CreateFile( fileName.Get(),
+                                 GENERIC_READ | GENERIC_WRITE,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr,
+                                 OPEN_ALWAYS,
+                                 FILE_ATTRIBUTE_NORMAL,
+                                 nullptr );
+        #else
+            return open( fileName.Get(), O_RDWR | O_CREAT | O_CLOEXEC, 0666 );
+        #endif
+    }
+
+    bool LockIndexFile( PlatformFileHandle handle, bool exclusive )
+    {
+        #if defined( __WINDOWS__ )
+            // Lock a byte outside of the region used to store data, as Windows
+            // locks are mandatory and would prevent the data from being read
+            OVERLAPPED overlapped;
+            memset( &overlapped, 0, sizeof( overlapped ) );
+            overlapped.OffsetHigh = 1;
+            return ( ::LockFileEx( handle, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &overlapped ) != FALSE );
+        #else
+            for ( ;; )
+            {
+                if ( flock( handle, exclusive ? LOCK_EX : LOCK_SH ) == 0 )
+                {
+                    return true;
+                }
+                if ( errno != EINTR )
+                {
+                    return false;
+                }
+            }
+        #endif
+    }
+
+    void UnlockIndexFile( PlatformFileHandle handle )
+    {
+        #if defined( __WINDOWS__ )
+            OVERLAPPED overlapped;
+            memset( &overlapped, 0, sizeof( overlapped ) );
+            overlapped.OffsetHigh = 1;
+            VERIFY( ::UnlockFileEx( handle, 0, 1, 0, &overlapped ) );
+        #else
+            VERIFY( flock( handle, LOCK_UN ) == 0 );
+        #endif
+    }
+
+    PlatformFileHandle OpenFileForRead( const AString & fileName )
+    {
+        #if defined( __WINDOWS__ )
+            // Allow packs to be appended to and deleted while open
+            return ::CreateFile( fileName.Get(),
+                                 GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr,
+                                 OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL,
+                                 nullptr );
+        #else
+            return open( fileName.Get(), O_RDONLY | O_CLOEXEC );
+        #endif
+    }
+
+    PlatformFileHandle OpenFileForWrite( const AString & fileName )
+    {
+        #if defined( __WINDOWS__ )
+            // Allow packs to be read and appended to by others while open
+            return ::CreateFile( fileName.Get(),
+                                 GENERIC_WRITE,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr,
+                                 OPEN_ALWAYS,
+                                 FILE_ATTRIBUTE_NORMAL,
+                                 nullptr );
+        #else
+            return open( fileName.Get(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666 );
+        #endif
+    }
+
+    bool ReadFileAt( PlatformFileHandle handle, uint64_t offset, void * buffer, uint32_t size )
+    {
+        char * dst = static_cast< char * >( buffer );
+        while ( size > 0 )
+        {
+            #if defined( __WINDOWS__ )
+                OVERLAPPED overlapped;
+                memset( &overlapped, 0, sizeof( overlapped ) );
+                overlapped.Offset = (DWORD)( offset & 0xFFFFFFFF );
+                overlapped.OffsetHigh = (DWORD)( offset >> 32 );
+                DWORD bytesRead = 0;
+                if ( ( ::ReadFile( handle, dst, size, &bytesRead, &overlapped ) == FALSE ) || ( bytesRead == 0 ) )
+                {
+                    return false;
+                }
+            #else
+                const ssize_t bytesRead = pread( handle, dst, size, (off_t)offset );
+                if ( bytesRead < 0 )
+                {
+                    if ( errno == EINTR )
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                if ( bytesRead == 0 )
+                {
+                    return false; // Truncated
+                }
+            #endif
+            dst += bytesRead;
+            offset += (uint64_t)bytesRead;
+            size -= (uint32_t)bytesRead;
+        }
+        return true;
+    }
+
+    bool WriteFileAt( PlatformFileHandle handle, uint64_t offset, const void * buffer, uint32_t size )
+    {
+        const char * src = static_cast< const char * >( buffer );
+        while ( size > 0 )
+        {
+            #if defined( __WINDOWS__ )
+                OVERLAPPED overlapped;
+                memset( &overlapped, 0, sizeof( overlapped ) );
+                overlapped.Offset = (DWORD)( offset & 0xFFFFFFFF );
+                overlapped.OffsetHigh = (DWORD)( offset >> 32 );
+                DWORD bytesWritten = 0;
+                if ( ( ::WriteFile( handle, src, size, &bytesWritten, &overlapped ) == FALSE ) || ( bytesWritten == 0 ) )
+                {
+                    return false;
+                }
+            #else
+                const ssize_t bytesWritten = pwrite( handle, src, size, (off_t)offset );
+                if ( bytesWritten < 0 )
+                {
+                    if ( errno == EINTR )
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                if ( bytesWritten == 0 )
+                {
+                    return false; // Disk full
+                }
+            #endif
+            src += bytesWritten;
+            offset += (uint64_t)bytesWritten;
+            size -= (uint32_t)bytesWritten;
+        }
+        return true;
+    }
+
+    void CloseFile( PlatformFileHandle handle )
+    {
+        #if defined( __WINDOWS__ )
+            ::CloseHandle( handle );
+        #else
+            close( handle );
+        #endif
+    }
+
+    // Map a file for read/write access, shared with other processes.
+    // If createSize is non-zero, the file is created (or replaced) with that size
+    void * MapFile( const AString & fileName, size_t createSize, size_t & outSize )
+    {
+        #if defined( __WINDOWS__ )
+            const HANDLE handle = ::CreateFile( fileName.Get(),
+                                                GENERIC_READ | GENERIC_WRITE,
+                                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                                nullptr,
+                                                createSize ? CREATE_ALWAYS : OPEN_EXISTING,
+                                                FILE_ATTRIBUTE_NORMAL,
+                                                nullptr );
+            if ( handle == INVALID_HANDLE_VALUE )
+            {
+                return nullptr;
+            }
+            size_t size = createSize;
+            if ( size == 0 )
+            {
+                LARGE_INTEGER fileSize;
+                if ( ( ::GetFileSizeEx( handle, &fileSize ) == FALSE ) || ( fileSize.QuadPart == 0 ) )
+                {
+                    ::CloseHandle( handle );
+                    return nullptr;
+                }
+                size = (size_t)fileSize.QuadPart;
+            }
+            // Mapping extends the file if needed
+            const HANDLE mapping = ::CreateFileMapping( handle, nullptr, PAGE_READWRITE, (DWORD)( (uint64_t)size >> 32 ), (DWORD)( size & 0xFFFFFFFF ), nullptr );
+            ::CloseHandle( handle );
+            if ( mapping == nullptr )
+            {
+                return nullptr;
+            }
+            void * memory = ::MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0, 0, size );
+            ::CloseHandle( mapping ); // View keeps mapping alive
+        #else
+            const int handle = open( fileName.Get(), createSize ? ( O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC ) : ( O_RDWR | O_CLOEXEC ), 0666 );
+            if ( handle == -1 )
+            {
+                return nullptr;
+            }
+            size_t size = createSize;
+            if ( size > 0 )
+            {
+                if ( ftruncate( handle, (off_t)size ) != 0 )
+                {
+                    close( handle );
+                    return nullptr;
+                }
+            }
+            else
+            {
+                struct stat st;
+                if ( ( fstat( handle, &st ) != 0 ) || ( st.st_size == 0 ) )
+                {
+                    close( handle );
+                    return nullptr;
+                }
+                size = (size_t)st.st_size;
+            }
+            void * memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0 );
+            close( handle ); // Mapping keeps file alive
+            if ( memory == MAP_FAILED )
+            {
+                memory = nullptr;
+            }
+        #endif
+        outSize = size;
+        return memory;
+    }
+
+    // Extract serial from "PackXXXXXXXX.fpk"
+    uint32_t GetPackSerial( const AString & packFileName )
+    {
+        const char * serialStr = packFileName.FindLast( NATIVE_SLASH );
+        serialStr = serialStr ? ( serialStr + 5 ) : ( packFileName.Get() + 4 );
+        return (uint32_t)strtoul( serialStr, nullptr, 16 );
+    }
+
+    void UnmapFile( void * memory, size_t size )
+    {
+        #if defined( __WINDOWS__ )
+            (void)size;
+            VERIFY( ::UnmapViewOfFile( memory ) );
+        #else
+            VERIFY( munmap( memory, size ) == 0 );
+        #endif
+    }
+}
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+/*explicit*/ PackedCache::PackedCache()
+    : m_LockFile( PACKED_CACHE_INVALID_HANDLE )
+    , m_Index( nullptr )
+    , m_IndexSize( 0 )
+    , m_IndexGeneration( 0 )
+{
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+/*virtual*/ PackedCache::~PackedCache()
+{
+    Shutdown();
+}
+
+// Init
+//------------------------------------------------------------------------------
+/*virtual*/ bool PackedCache::Init( const AString & cachePath,
+                                    const AString & cachePathMountPoint,
+                                    bool /*cacheRead*/,
+                                    bool /*cacheWrite*/,
+                                    bool /*cacheVerbose*/,
+                                    const AString & /*pluginDLLConfig*/ )
+{
+    PROFILE_FUNCTION;
+
+    m_CachePath = cachePath;
+    PathUtils::EnsureTrailingSlash( m_CachePath );
+
+    // Check cache mount point if option is enabled
+    #if defined( __WINDOWS__ )
+        (void)cachePathMountPoint; // Not supported on Windows
+    #else
+        if ( cachePathMountPoint.IsEmpty() == false )
+        {
+            if ( FileIO::GetDirectoryIsMountPoint( cachePathMountPoint ) == false )
+            {
+                FLOG_WARN( "Caching disabled because '%s' is not a mount point", cachePathMountPoint.Get() );
+                return false;
+            }
+        }
+    #endif
+
+    if ( FileIO::EnsurePathExists( m_CachePath ) )
+    {
+        AStackString<> lockFileName( m_CachePath );
+        lockFileName += PACKED_CACHE_LOCK_FILE_NAME;
+        m_LockFile = OpenLockFile( lockFileName );
+        if ( m_LockFile != PACKED_CACHE_INVALID_HANDLE )
+        {
+            // Open (or create) the index
+            MutexHolder mh( m_Mutex );
+            if ( LockIndex() )
+            {
+                UnlockIndex();
+                return true;
+            }
+        }
+    }
+
+    FLOG_WARN( "Cache inaccessible - Caching disabled (Path '%s')", m_CachePath.Get() );
+    return false;
+}
+
+// Shutdown
+//------------------------------------------------------------------------------
+/*virtual*/ void PackedCache::Shutdown()
+{
+    MutexHolder mh( m_Mutex );
+    if ( ( m_PendingTouches.IsEmpty() == false ) && LockIndex() )
+    {
+        UnlockIndex(); // Locking applies the pending touches
+    }
+    m_PendingTouches.Clear();
+    ClosePackReaders();
+    CloseIndex();
+    if ( m_LockFile != PACKED_CACHE_INVALID_HANDLE )
+    {
+        CloseFile( m_LockFile );
+        m_LockFile = PACKED_CACHE_INVALID_HANDLE;
+    }
+}
+
+// Publish
+//------------------------------------------------------------------------------
+/*virtual*/ bool PackedCache::Publish( const AString & cacheId, const void * data, size_t dataSize )
+{
+    PROFILE_FUNCTION;
+
+    if ( dataSize >= PACKED_CACHE_INVALID )
+    {
+        return false; // Too large to index
+    }
+
+    uint64_t keyHashA;
+    uint64_t keyHashB;
+    GetKeyHashes( cacheId, keyHashA, keyHashB );
+    const uint64_t dataHash = xxHash3::Calc64( data, dataSize );
+
+    // Reserve space at the end of a pack
+    uint32_t pack = PACKED_CACHE_INVALID;
+    uint32_t serial = 0;
+    uint64_t offset = 0;
+    FileHandle writer = PACKED_CACHE_INVALID_HANDLE;
+    {
+        MutexHolder mh( m_Mutex );
+        if ( LockIndex() == false )
+        {
+            return false;
+        }
+        m_Index->m_UpdateInProgress = 1;
+        pack = GetPackForWrite( dataSize );
+        if ( pack != PACKED_CACHE_INVALID )
+        {
+            serial = m_Index->m_PackSerials[ pack ];
+            offset = m_Index->m_PackSizes[ pack ];
+            m_Index->m_PackSizes[ pack ] += dataSize;
+
+            // Open while locked so the pack can't be deleted first (see Retrieve)
+            AStackString<> packFileName;
+            GetPackFileName( serial, packFileName );
+            writer = OpenFileForWrite( packFileName );
+        }
+        m_Index->m_UpdateInProgress = 0;
+        UnlockIndex();
+    }
+    if ( writer == PACKED_CACHE_INVALID_HANDLE )
+    {
+        return false;
+    }
+
+    // Write data without holding any locks. If this fails, the reserved space
+    // is unreferenced and will be reclaimed by compaction.
+    const bool writeOk = WriteFileAt( writer, offset, data, (uint32_t)dataSize );
+    CloseFile( writer );
+    if ( writeOk == false )
+    {
+        return false;
+    }
+
+    // Index the data
+    MutexHolder mh( m_Mutex );
+    if ( LockIndex() == false )
+    {
+        return false;
+    }
+    if ( EnsureIndexCapacity() == false )
+    {
+        UnlockIndex();
+        return false;
+    }
+
+    // Was the pack deleted (or the index recovered without our data) while writing?
+    const bool ok = ( ( m_Index->m_PackSerials[ pack ] == serial ) &&
+                      ( ( offset + dataSize ) <= m_Index->m_PackSizes[ pack ] ) );
+    if ( ok )
+    {
+        m_Index->m_UpdateInProgress = 1;
+
+        // Replace existing entry
+        const uint32_t existingSlot = FindEntry( keyHashA, keyHashB );
+        if ( existingSlot != PACKED_CACHE_INVALID )
+        {
+            RemoveEntry( existingSlot );
+        }
+
+        const uint32_t slot = InsertEntry( keyHashA, keyHashB );
+        PackedCacheIndexEntry & entry = GetEntries()[ slot ];
+        entry.m_Offset = offset;
+        entry.m_DataHash = dataHash;
+        entry.m_LastAccessTime = Time::GetCurrentFileTime();
+        entry.m_Size = (uint32_t)dataSize;
+        entry.m_Pack = (uint16_t)pack;
+        LRUPushFront( slot );
+        m_Index->m_PackLiveBytes[ pack ] += dataSize;
+
+        m_Index->m_UpdateInProgress = 0;
+    }
+
+    UnlockIndex();
+    return ok;
+}
+
+// ExistsBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void PackedCache::ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists )
+{
+    PROFILE_FUNCTION;
+
+    outExists.SetSize( cacheIds.GetSize() );
+    for ( bool & exists : outExists )
+    {
+        exists = false;
+    }
+
+    // Lookups are cheap, so check all entries under a single (shared) lock
+    MutexHolder mh( m_Mutex );
+    if ( LockIndex( false ) == false )
+    {
+        return;
+    }
+    for ( size_t i = 0; i < cacheIds.GetSize(); ++i )
+    {
+        uint64_t keyHashA;
+        uint64_t keyHashB;
+        GetKeyHashes( cacheIds[ i ], keyHashA, keyHashB );
+        outExists[ i ] = ( FindEntry( keyHashA, keyHashB ) != PACKED_CACHE_INVALID );
+    }
+    UnlockIndex();
+}
+
+// Retrieve
+//------------------------------------------------------------------------------
+/*virtual*/ bool PackedCache::Retrieve( const AString & cacheId, void * & data, size_t & dataSize )
+{
+    PROFILE_FUNCTION;
+
+    data = nullptr;
+    dataSize = 0;
+
+    uint64_t keyHashA;
+    uint64_t keyHashB;
+    GetKeyHashes( cacheId, keyHashA, keyHashB );
+
+    // Find the entry
+    PackedCacheIndexEntry entry;
+    uint32_t serial;
+    FileHandle handle;
+    {
+        MutexHolder mh( m_Mutex );
+        if ( LockIndex( false ) == false )
+        {
+            return false;
+        }
+        const uint32_t slot = FindEntry( keyHashA, keyHashB );
+        if ( slot == PACKED_CACHE_INVALID )
+        {
+            UnlockIndex();
+            return false;
+        }
+
+        entry = GetEntries()[ slot ];
+        serial = m_Index->m_PackSerials[ entry.m_Pack ];
+
+        // Open while locked so the pack can't be deleted first. Once open, the
+        // data remains readable even if the pack is subsequently deleted.
+        handle = AcquirePackReader( serial );
+        UnlockIndex();
+
+        // Mark as most recently used the next time the index is locked exclusively,
+        // so concurrent retrievals don't serialize on the lock
+        m_PendingTouches.Append( PendingTouch{ keyHashA, keyHashB, Time::GetCurrentFileTime() } );
+        if ( ( m_PendingTouches.GetSize() >= PACKED_CACHE_MAX_PENDING_TOUCHES ) && LockIndex() )
+        {
+            UnlockIndex(); // Locking applies the pending touches
+        }
+    }
+
+    if ( handle == PACKED_CACHE_INVALID_HANDLE )
+    {
+        return false;
+    }
+
+    // Read data without holding any locks (the reader stays open until released)
+    UniquePtr< char > mem( (char *)ALLOC( entry.m_Size ? entry.m_Size : 1 ) );
+    const bool readOk = ReadFileAt( handle, entry.m_Offset, mem.Get(), entry.m_Size );
+    {
+        MutexHolder mh( m_Mutex );
+        ReleasePackReader( serial, handle );
+    }
+    if ( readOk == false )
+    {
+        return false;
+    }
+
+    // Check data
+    const Timer timer;
+    const bool dataOk = ( xxHash3::Calc64( mem.Get(), entry.m_Size ) == entry.m_DataHash );
+    const uint64_t verifyTimeUS = (uint64_t)( timer.GetElapsedMS() * 1000.0f );
+    {
+        MutexHolder mh( m_VerifyStatsMutex );
+        m_VerifyStats.m_NumVerified++;
+        m_VerifyStats.m_NumCorrupt += ( dataOk ? 0u : 1u );
+        m_VerifyStats.m_VerifiedBytes += entry.m_Size;
+        m_VerifyStats.m_VerifyTimeUS += verifyTimeUS;
+    }
+    if ( dataOk )
+    {
+        dataSize = entry.m_Size;
+        data = mem.Release();
+        return true;
+    }
+
+    // Data is corrupt - remove the entry (if it hasn't been replaced in the meantime)
+    FLOG_WARN( "Corrupt cache entry removed: '%s'", cacheId.Get() );
+    MutexHolder mh( m_Mutex );
+    if ( LockIndex() )
+    {
+        const uint32_t slot = FindEntry( keyHashA, keyHashB );
+        if ( ( slot != PACKED_CACHE_INVALID ) &&
+             ( GetEntries()[ slot ].m_Pack == entry.m_Pack ) &&
+             ( GetEntries()[ slot ].m_Offset == entry.m_Offset ) )
+        {
+            m_Index->m_UpdateInProgress = 1;
+            RemoveEntry( slot );
+            m_Index->m_UpdateInProgress = 0;
+        }
+        UnlockIndex();
+    }
+    return false;
+}
+
+// FreeMemory
+//------------------------------------------------------------------------------
+/*virtual*/ void PackedCache::FreeMemory( void * data, size_t /*dataSize*/ )
+{
+    FREE( data );
+}
+
+// GetAndResetVerifyStats
+//------------------------------------------------------------------------------
+/*virtual*/ void PackedCache::GetAndResetVerifyStats( CacheVerifyStats & outStats )
+{
+    MutexHolder mh( m_VerifyStatsMutex );
+    outStats = m_VerifyStats;
+    m_VerifyStats = CacheVerifyStats();
+}
+
+// OutputInfo
+//------------------------------------------------------------------------------
+/*virtual*/ bool PackedCache::OutputInfo( bool /*showProgress*/ )
+{
+    // Count/Size per day (based on last access)
+    const uint32_t NUM_DAYS( 30 );
+    uint32_t perDayFiles[ NUM_DAYS ] = {};
+    uint64_t perDayBytes[ NUM_DAYS ] = {};
+    uint32_t totalFiles = 0;
+    uint64_t totalBytes = 0;
+    uint32_t numPacks = 0;
+    uint64_t packBytes = 0;
+
+    // Everything comes from the index, so there is no need to walk the file system
+    {
+        MutexHolder mh( m_Mutex );
+        if ( LockIndex() == false )
+        {
+            return false;
+        }
+
+        const uint64_t currentTime = Time::GetCurrentFileTime(); // Compare filetimes to now
+        #if defined( __WINDOWS__ )
+            const uint64_t oneDay = ( 24 * 60 * 60 * (uint64_t)10000000 );
+        #else
+            const uint64_t oneDay = ( 24 * 60 * 60 * (uint64_t)1000000000 );
+        #endif
+        const PackedCacheIndexEntry * entries = GetEntries();
+        for ( uint32_t slot = m_Index->m_LRUHead; slot != PACKED_CACHE_INVALID; slot = entries[ slot ].m_LRUNext )
+        {
+            const PackedCacheIndexEntry & entry = entries[ slot ];
+            const uint64_t age = ( currentTime > entry.m_LastAccessTime ) ? ( currentTime - entry.m_LastAccessTime ) : 0;
+            uint32_t ageInDays = (uint32_t)( age / oneDay );
+            if ( ageInDays >= NUM_DAYS )
+            {
+                ageInDays = ( NUM_DAYS - 1 );
+            }
+            perDayFiles[ ageInDays ]++;
+            perDayBytes[ ageInDays ] += entry.m_Size;
+            totalFiles++;
+            totalBytes += entry.m_Size;
+        }
+
+        for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+        {
+            if ( m_Index->m_PackSerials[ i ] )
+            {
+                numPacks++;
+                packBytes += m_Index->m_PackSizes[ i ];
+            }
+        }
+
+        UnlockIndex();
+    }
+
+    // Generate cache info string
+    OUTPUT( "================================================================================\n" );
+    OUTPUT( " Age (Days) | Files    | Size (MiB) | %%\n" );
+    OUTPUT( "================================================================================\n" );
+    for ( uint32_t i = 0; i < NUM_DAYS; ++i )
+    {
+        const uint32_t num = perDayFiles[ i ];
+        const uint64_t size = perDayBytes[ i ] / MEGABYTE;
+        const float sizePerc = ( totalBytes > 0 ) ? 100.0f * ( (float)size / (float)( totalBytes / MEGABYTE ) ) : 0.0f;
+        AStackString<> graphBar;
+        for ( uint32_t j=0; j < (uint32_t)(sizePerc); ++j )
+        {
+            if ( graphBar.GetLength() < 35 )
+            {
+                graphBar += '*';
+            }
+        }
+        OUTPUT( " %2u%c        | %8u | %10" PRIu64 " | %5.1f %s\n", i, ( i == ( NUM_DAYS - 1 ) ) ? '+' : ' ', num, size, (double)sizePerc, graphBar.Get() );
+    }
+    OUTPUT( "================================================================================\n" );
+    OUTPUT( " Total      | %8u | %10" PRIu64 " |\n", totalFiles, totalBytes / MEGABYTE );
+    OUTPUT( "================================================================================\n" );
+    OUTPUT( " Packs      | %8u | %10" PRIu64 " | (%" PRIu64 " MiB unreferenced)\n", numPacks, packBytes / MEGABYTE, ( packBytes - totalBytes ) / MEGABYTE );
+    OUTPUT( "================================================================================\n" );
+
+    return true;
+}
+
+// Trim
+//------------------------------------------------------------------------------
+/*virtual*/ bool PackedCache::Trim( bool /*showProgress*/, uint32_t sizeMiB )
+{
+    return TrimInternal( sizeMiB, sizeMiB, true );
+}
+
+// EnforceSizeLimit
+//------------------------------------------------------------------------------
+bool PackedCache::EnforceSizeLimit( uint32_t sizeMiB )
+{
+    // Trim below the limit, so builds which add a little data don't each
+    // pay for eviction and compaction
+    const uint32_t targetMiB = ( sizeMiB - ( sizeMiB * PACKED_CACHE_TRIM_HEADROOM_PERCENT / 100 ) );
+    return TrimInternal( sizeMiB, targetMiB, false );
+}
+
+// TrimInternal
+//------------------------------------------------------------------------------
+bool PackedCache::TrimInternal( uint32_t sizeMiB, uint32_t targetMiB, bool verbose )
+{
+    ASSERT( targetMiB <= sizeMiB );
+
+    MutexHolder mh( m_Mutex );
+    if ( LockIndex() == false )
+    {
+        return false;
+    }
+
+    uint64_t totalSize = GetTotalPackSize();
+    if ( verbose )
+    {
+        OUTPUT( " - Before: %u Files @ %u MiB\n", m_Index->m_NumEntries, (uint32_t)( totalSize / MEGABYTE ) );
+        OUTPUT( "Trimming to %u MiB:\n", targetMiB );
+    }
+    else if ( totalSize <= ( (uint64_t)sizeMiB * MEGABYTE ) )
+    {
+        UnlockIndex();
+        return true; // Nothing to do
+    }
+    const uint64_t limit = ( (uint64_t)targetMiB * MEGABYTE );
+
+    m_Index->m_UpdateInProgress = 1;
+
+    // Evict least recently used entries until the remaining entries fit
+    uint64_t liveSize = 0;
+    for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+    {
+        liveSize += m_Index->m_PackLiveBytes[ i ];
+    }
+    while ( ( liveSize > limit ) && ( m_Index->m_LRUTail != PACKED_CACHE_INVALID ) )
+    {
+        const uint32_t slot = m_Index->m_LRUTail;
+        liveSize -= GetEntries()[ slot ].m_Size;
+        RemoveEntry( slot );
+    }
+
+    // Remove packs which are no longer referenced (deletion can fail if in use on Windows)
+    for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+    {
+        if ( m_Index->m_PackSerials[ i ] && ( m_Index->m_PackLiveBytes[ i ] == 0 ) )
+        {
+            DeletePack( i );
+        }
+    }
+
+    // Evicted and replaced entries leave unreferenced data in packs. Reclaim it by
+    // compacting the packs with the most unreferenced data until under the limit.
+    bool compacted[ PACKED_CACHE_MAX_PACKS ] = {};
+    for ( totalSize = GetTotalPackSize(); totalSize > limit; totalSize = GetTotalPackSize() )
+    {
+        uint32_t pack = PACKED_CACHE_INVALID;
+        uint64_t mostUnreferenced = 0;
+        for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+        {
+            const uint64_t unreferenced = ( m_Index->m_PackSizes[ i ] - m_Index->m_PackLiveBytes[ i ] );
+            if ( m_Index->m_PackSerials[ i ] && ( compacted[ i ] == false ) && ( unreferenced > mostUnreferenced ) )
+            {
+                pack = i;
+                mostUnreferenced = unreferenced;
+            }
+        }
+        if ( pack == PACKED_CACHE_INVALID )
+        {
+            break; // Nothing more can be reclaimed
+        }
+        compacted[ pack ] = true; // Don't retry packs which can't be compacted
+        CompactPack( pack );
+    }
+
+    m_Index->m_UpdateInProgress = 0;
+
+    if ( verbose )
+    {
+        OUTPUT( " - After: %u Files @ %u MiB\n", m_Index->m_NumEntries, (uint32_t)( totalSize / MEGABYTE ) );
+    }
+
+    UnlockIndex();
+    return true;
+}
+
+// LockIndex
+//------------------------------------------------------------------------------
+bool PackedCache::LockIndex( bool exclusive )
+{
+    if ( m_LockFile == PACKED_CACHE_INVALID_HANDLE )
+    {
+        return false;
+    }
+
+    // Lookups share the lock, unless the index must be (re)opened or recovered
+    if ( exclusive == false )
+    {
+        if ( LockIndexFile( m_LockFile, false ) == false )
+        {
+            return false;
+        }
+        if ( m_Index && ( ReadIndexGeneration() == m_IndexGeneration ) && ( m_Index->m_UpdateInProgress == 0 ) )
+        {
+            return true;
+        }
+        UnlockIndexFile( m_LockFile );
+    }
+
+    if ( LockIndexFile( m_LockFile, true ) == false )
+    {
+        return false;
+    }
+
+    // Has the index been replaced by another process (or not yet been opened)?
+    if ( ( m_Index == nullptr ) || ( ReadIndexGeneration() != m_IndexGeneration ) )
+    {
+        CloseIndex();
+        if ( OpenIndex() == false )
+        {
+            UnlockIndexFile( m_LockFile );
+            return false;
+        }
+    }
+    else if ( m_Index->m_UpdateInProgress )
+    {
+        // Another process terminated while modifying the index
+        if ( RecoverIndex() == false )
+        {
+            UnlockIndexFile( m_LockFile );
+            return false;
+        }
+    }
+
+    ApplyPendingTouches();
+    return true;
+}
+
+// UnlockIndex
+//------------------------------------------------------------------------------
+void PackedCache::UnlockIndex()
+{
+    UnlockIndexFile( m_LockFile );
+}
+
+// ApplyPendingTouches
+//------------------------------------------------------------------------------
+void PackedCache::ApplyPendingTouches()
+{
+    // Mark retrieved entries as most recently used (exclusive lock must be held)
+    if ( m_PendingTouches.IsEmpty() )
+    {
+        return;
+    }
+
+    m_Index->m_UpdateInProgress = 1;
+    for ( const PendingTouch & touch : m_PendingTouches )
+    {
+        const uint32_t slot = FindEntry( touch.m_KeyHashA, touch.m_KeyHashB );
+        if ( slot == PACKED_CACHE_INVALID )
+        {
+            continue; // Evicted in the meantime
+        }
+        LRUUnlink( slot );
+        LRUPushFront( slot );
+        PackedCacheIndexEntry & entry = GetEntries()[ slot ];
+        if ( touch.m_Time > entry.m_LastAccessTime )
+        {
+            entry.m_LastAccessTime = touch.m_Time;
+        }
+    }
+    m_Index->m_UpdateInProgress = 0;
+    m_PendingTouches.Clear();
+}
+
+// ReadIndexGeneration
+//------------------------------------------------------------------------------
+uint32_t PackedCache::ReadIndexGeneration() const
+{
+    // Stored in the lock file. 0 means no index exists.
+    uint32_t generation = 0;
+    if ( ReadFileAt( m_LockFile, 0, &generation, sizeof( generation ) ) == false )
+    {
+        return 0;
+    }
+    return generation;
+}
+
+// WriteIndexGeneration
+//------------------------------------------------------------------------------
+bool PackedCache::WriteIndexGeneration( uint32_t generation ) const
+{
+    return WriteFileAt( m_LockFile, 0, &generation, sizeof( generation ) );
+}
+
+// GetIndexFileName
+//------------------------------------------------------------------------------
+void PackedCache::GetIndexFileName( uint32_t generation, AString & outFileName ) const
+{
+    outFileName.Format( "%sPackedCache.%u.idx", m_CachePath.Get(), generation );
+}
+
+// OpenIndex
+//------------------------------------------------------------------------------
+bool PackedCache::OpenIndex()
+{
+    ASSERT( m_Index == nullptr );
+
+    const uint32_t generation = ReadIndexGeneration();
+    if ( generation == 0 )
+    {
+        return ResetIndex(); // New cache
+    }
+
+    AStackString<> indexFileName;
+    GetIndexFileName( generation, indexFileName );
+    size_t size = 0;
+    PackedCacheIndexHeader * index = static_cast< PackedCacheIndexHeader * >( MapFile( indexFileName, 0, size ) );
+    if ( index == nullptr )
+    {
+        return ResetIndex();
+    }
+
+    // Validate
+    const uint32_t capacity = ( size >= sEntriesOffset ) ? index->m_Capacity : 0;
+    if ( ( size < sEntriesOffset ) ||
+         ( memcmp( index->m_Identifier, "FBPC", 4 ) != 0 ) ||
+         ( index->m_Version != PACKED_CACHE_INDEX_VERSION ) ||
+         ( index->m_Generation != generation ) ||
+         ( capacity == 0 ) || ( ( capacity & ( capacity - 1 ) ) != 0 ) ||
+         ( size != ( sEntriesOffset + ( (size_t)capacity * sizeof( PackedCacheIndexEntry ) ) ) ) )
+    {
+        UnmapFile( index, size );
+        return ResetIndex();
+    }
+
+    m_Index = index;
+    m_IndexSize = size;
+    m_IndexGeneration = generation;
+
+    // Previous writer terminated mid-update?
+    if ( m_Index->m_UpdateInProgress )
+    {
+        return RecoverIndex();
+    }
+    return true;
+}
+
+// CreateIndex
+//------------------------------------------------------------------------------
+bool PackedCache::CreateIndex( uint32_t capacity, const PackedCacheIndexHeader * oldIndex )
+{
+    ASSERT( ( capacity & ( capacity - 1 ) ) == 0 );
+
+    // Index files are never resized in place (other processes may have them
+    // mapped), so a new generation is created instead
+    const uint32_t generation = ( ReadIndexGeneration() + 1 );
+    AStackString<> indexFileName;
+    GetIndexFileName( generation, indexFileName );
+    size_t size = 0;
+    PackedCacheIndexHeader * index = static_cast< PackedCacheIndexHeader * >( MapFile( indexFileName, sEntriesOffset + ( (size_t)capacity * sizeof( PackedCacheIndexEntry ) ), size ) );
+    if ( index == nullptr )
+    {
+        return false;
+    }
+
+    memset( index, 0, size );
+    memcpy( index->m_Identifier, "FBPC", 4 );
+    index->m_Version = PACKED_CACHE_INDEX_VERSION;
+    index->m_Generation = generation;
+    index->m_Capacity = capacity;
+    index->m_LRUHead = PACKED_CACHE_INVALID;
+    index->m_LRUTail = PACKED_CACHE_INVALID;
+    index->m_CurrentPack = PACKED_CACHE_INVALID;
+    index->m_NextPackSerial = 1;
+
+    // Swap to new index
+    PackedCacheIndexHeader * const previousIndex = m_Index;
+    const size_t previousIndexSize = m_IndexSize;
+    const uint32_t previousGeneration = m_IndexGeneration;
+    m_Index = index;
+    m_IndexSize = size;
+    m_IndexGeneration = generation;
+
+    // Transfer contents of old index
+    if ( oldIndex )
+    {
+        index->m_CurrentPack = oldIndex->m_CurrentPack;
+        index->m_NextPackSerial = oldIndex->m_NextPackSerial;
+        memcpy( index->m_PackSerials, oldIndex->m_PackSerials, sizeof( index->m_PackSerials ) );
+        memcpy( index->m_PackSizes, oldIndex->m_PackSizes, sizeof( index->m_PackSizes ) );
+        memcpy( index->m_PackLiveBytes, oldIndex->m_PackLiveBytes, sizeof( index->m_PackLiveBytes ) );
+
+        // Insert from least to most recently used to preserve LRU order
+        const PackedCacheIndexEntry * oldEntries = reinterpret_cast< const PackedCacheIndexEntry * >( reinterpret_cast< const char * >( oldIndex ) + sEntriesOffset );
+        for ( uint32_t oldSlot = oldIndex->m_LRUTail; oldSlot != PACKED_CACHE_INVALID; oldSlot = oldEntries[ oldSlot ].m_LRUPrev )
+        {
+            const PackedCacheIndexEntry & oldEntry = oldEntries[ oldSlot ];
+            const uint32_t slot = InsertEntry( oldEntry.m_KeyHashA, oldEntry.m_KeyHashB );
+            PackedCacheIndexEntry & entry = GetEntries()[ slot ];
+            entry.m_Offset = oldEntry.m_Offset;
+            entry.m_DataHash = oldEntry.m_DataHash;
+            entry.m_LastAccessTime = oldEntry.m_LastAccessTime;
+            entry.m_Size = oldEntry.m_Size;
+            entry.m_Pack = oldEntry.m_Pack;
+            LRUPushFront( slot );
+        }
+    }
+
+    // Publish new index to other processes
+    if ( WriteIndexGeneration( generation ) == false )
+    {
+        UnmapFile( index, size );
+        FileIO::FileDelete( indexFileName.Get() );
+        m_Index = previousIndex;
+        m_IndexSize = previousIndexSize;
+        m_IndexGeneration = previousGeneration;
+        return false;
+    }
+
+    // Free old index (other processes will notice the generation change)
+    if ( previousIndex )
+    {
+        UnmapFile( previousIndex, previousIndexSize );
+    }
+    if ( generation > 1 )
+    {
+        AStackString<> oldIndexFileName;
+        GetIndexFileName( generation - 1, oldIndexFileName );
+        FileIO::FileDelete( oldIndexFileName.Get() ); // Can fail on Windows if mapped elsewhere
+    }
+    return true;
+}
+
+// CloseIndex
+//------------------------------------------------------------------------------
+void PackedCache::CloseIndex()
+{
+    if ( m_Index )
+    {
+        UnmapFile( m_Index, m_IndexSize );
+        m_Index = nullptr;
+        m_IndexSize = 0;
+    }
+}
+
+// ResetIndex
+//------------------------------------------------------------------------------
+bool PackedCache::ResetIndex()
+{
+    // Index is unusable, so discard all packs and start again.
+    uint32_t nextPackSerial = 1;
+    if ( m_Index )
+    {
+        nextPackSerial = m_Index->m_NextPackSerial;
+    }
+    CloseIndex();
+    ClosePackReaders();
+
+    Array< AString > packFiles;
+    FileIO::GetFiles( m_CachePath, AStackString<>( "Pack*.fpk" ), false, &packFiles );
+    for ( const AString & packFile : packFiles )
+    {
+        // Don't re-use serials (other processes may have old packs open)
+        const uint32_t serial = GetPackSerial( packFile );
+        if ( serial >= nextPackSerial )
+        {
+            nextPackSerial = ( serial + 1 );
+        }
+
+        FileIO::FileDelete( packFile.Get() );
+    }
+
+    if ( CreateIndex( PACKED_CACHE_INITIAL_CAPACITY, nullptr ) == false )
+    {
+        return false;
+    }
+    m_Index->m_NextPackSerial = nextPackSerial ? nextPackSerial : 1;
+    return true;
+}
+
+// RecoverIndex
+//------------------------------------------------------------------------------
+bool PackedCache::RecoverIndex()
+{
+    // Another process terminated while modifying the index. Packs are only ever
+    // appended to, so rather than discarding the cache, rebuild the index from the
+    // entries which still reference data within a pack. (Data is checked against
+    // the stored hash on retrieval, so partially written entries are discarded then.)
+    ASSERT( m_Index );
+    FLOG_WARN( "Recovering cache index after interrupted update (Path '%s')", m_CachePath.Get() );
+
+    // Actual pack sizes (the index may not reflect writes which were in progress)
+    uint32_t nextPackSerial = m_Index->m_NextPackSerial;
+    Array< uint32_t > packSerials( PACKED_CACHE_MAX_PACKS );
+    Array< uint64_t > packSizes( PACKED_CACHE_MAX_PACKS );
+    for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+    {
+        uint32_t serial = m_Index->m_PackSerials[ i ];
+        uint64_t size = 0;
+        if ( serial )
+        {
+            AStackString<> packFileName;
+            GetPackFileName( serial, packFileName );
+            FileStream packFile;
+            if ( packFile.Open( packFileName.Get(), FileStream::READ_ONLY ) )
+            {
+                size = packFile.GetFileSize();
+            }
+            else
+            {
+                serial = 0; // Pack is missing
+            }
+        }
+        packSerials.Append( serial );
+        packSizes.Append( size );
+    }
+
+    // Recover entries in LRU order, following the list from the least recently
+    // used entry as far as it remains consistent
+    const PackedCacheIndexEntry * oldEntries = GetEntries();
+    const uint32_t oldCapacity = m_Index->m_Capacity;
+    Array< bool > visited;
+    visited.SetSize( oldCapacity );
+    memset( visited.Begin(), 0, oldCapacity * sizeof( bool ) );
+    Array< uint32_t > linkedSlots;
+    linkedSlots.SetCapacity( m_Index->m_NumEntries );
+    for ( uint32_t slot = m_Index->m_LRUTail; ( slot < oldCapacity ) && ( visited[ slot ] == false ); slot = oldEntries[ slot ].m_LRUPrev )
+    {
+        visited[ slot ] = true;
+        linkedSlots.Append( slot );
+    }
+
+    // Entries which are no longer linked are treated as least recently used
+    Array< PackedCacheIndexEntry > entries;
+    entries.SetCapacity( m_Index->m_NumEntries );
+    for ( uint32_t slot = 0; slot < oldCapacity; ++slot )
+    {
+        if ( ( visited[ slot ] == false ) && ( oldEntries[ slot ].m_State == PackedCacheIndexEntry::USED ) )
+        {
+            entries.Append( oldEntries[ slot ] );
+        }
+    }
+    for ( const uint32_t slot : linkedSlots )
+    {
+        entries.Append( oldEntries[ slot ] );
+    }
+
+    uint64_t capacity = PACKED_CACHE_INITIAL_CAPACITY;
+    while ( ( ( (uint64_t)entries.GetSize() + 1 ) * 2 ) > capacity )
+    {
+        capacity *= 2;
+    }
+    if ( ( capacity > 0x80000000 ) || ( CreateIndex( (uint32_t)capacity, nullptr ) == false ) )
+    {
+        return ResetIndex();
+    }
+
+    m_Index->m_UpdateInProgress = 1;
+    for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+    {
+        m_Index->m_PackSerials[ i ] = packSerials[ i ];
+        m_Index->m_PackSizes[ i ] = packSizes[ i ];
+        if ( packSerials[ i ] >= nextPackSerial )
+        {
+            nextPackSerial = ( packSerials[ i ] + 1 );
+        }
+    }
+
+    for ( const PackedCacheIndexEntry & oldEntry : entries )
+    {
+        if ( ( oldEntry.m_State != PackedCacheIndexEntry::USED ) ||
+             ( oldEntry.m_Pack >= PACKED_CACHE_MAX_PACKS ) ||
+             ( packSerials[ oldEntry.m_Pack ] == 0 ) ||
+             ( ( oldEntry.m_Offset + oldEntry.m_Size ) > packSizes[ oldEntry.m_Pack ] ) )
+        {
+            continue; // Data was never fully written, or pack is gone
+        }
+
+        // Most recently used wins if a key appears more than once
+        const uint32_t existingSlot = FindEntry( oldEntry.m_KeyHashA, oldEntry.m_KeyHashB );
+        if ( existingSlot != PACKED_CACHE_INVALID )
+        {
+            RemoveEntry( existingSlot );
+        }
+        const uint32_t slot = InsertEntry( oldEntry.m_KeyHashA, oldEntry.m_KeyHashB );
+        PackedCacheIndexEntry & entry = GetEntries()[ slot ];
+        entry.m_Offset = oldEntry.m_Offset;
+        entry.m_DataHash = oldEntry.m_DataHash;
+        entry.m_LastAccessTime = oldEntry.m_LastAccessTime;
+        entry.m_Size = oldEntry.m_Size;
+        entry.m_Pack = oldEntry.m_Pack;
+        LRUPushFront( slot );
+        m_Index->m_PackLiveBytes[ entry.m_Pack ] += entry.m_Size;
+    }
+
+    // Remove packs not referenced by the index (deletion can fail if in use on Windows)
+    Array< AString > packFiles;
+    FileIO::GetFiles( m_CachePath, AStackString<>( "Pack*.fpk" ), false, &packFiles );
+    for ( const AString & packFile : packFiles )
+    {
+        const uint32_t serial = GetPackSerial( packFile );
+        if ( packSerials.Find( serial ) == nullptr )
+        {
+            FileIO::FileDelete( packFile.Get() );
+        }
+        if ( serial >= nextPackSerial )
+        {
+            nextPackSerial = ( serial + 1 );
+        }
+    }
+    m_Index->m_NextPackSerial = nextPackSerial ? nextPackSerial : 1;
+    m_Index->m_CurrentPack = PACKED_CACHE_INVALID; // Start a new pack for subsequent writes
+    m_Index->m_UpdateInProgress = 0;
+
+    PrunePackReaders();
+    return true;
+}
+
+// EnsureIndexCapacity
+//------------------------------------------------------------------------------
+bool PackedCache::EnsureIndexCapacity()
+{
+    // Keep load factor (including removed entries) below 3/4 so probe sequences stay short
+    const uint32_t capacity = m_Index->m_Capacity;
+    if ( ( ( (uint64_t)m_Index->m_NumEntries + m_Index->m_NumTombstones + 1 ) * 4 ) <= ( (uint64_t)capacity * 3 ) )
+    {
+        return true;
+    }
+
+    // Rebuild the index, growing if needed (rebuilding also discards removed entries)
+    uint64_t newCapacity = capacity;
+    while ( ( ( (uint64_t)m_Index->m_NumEntries + 1 ) * 2 ) > newCapacity )
+    {
+        newCapacity *= 2;
+    }
+    if ( newCapacity > 0x80000000 )
+    {
+        return false;
+    }
+    return CreateIndex( (uint32_t)newCapacity, m_Index );
+}
+
+// GetEntries
+//------------------------------------------------------------------------------
+PackedCacheIndexEntry * PackedCache::GetEntries() const
+{
+    return reinterpret_cast< PackedCacheIndexEntry * >( reinterpret_cast< char * >( m_Index ) + sEntriesOffset );
+}
+
+// FindEntry
+//------------------------------------------------------------------------------
+uint32_t PackedCache::FindEntry( uint64_t keyHashA, uint64_t keyHashB ) const
+{
+    const PackedCacheIndexEntry * entries = GetEntries();
+    const uint32_t mask = ( m_Index->m_Capacity - 1 );
+    for ( uint32_t slot = (uint32_t)( keyHashA & mask ) ; ; slot = ( ( slot + 1 ) & mask ) )
+    {
+        const PackedCacheIndexEntry & entry = entries[ slot ];
+        if ( entry.m_State == PackedCacheIndexEntry::EMPTY )
+        {
+            return PACKED_CACHE_INVALID;
+        }
+        if ( ( entry.m_State == PackedCacheIndexEntry::USED ) &&
+             ( entry.m_KeyHashA == keyHashA ) &&
+             ( entry.m_KeyHashB == keyHashB ) )
+        {
+            return slot;
+        }
+    }
+}
+
+// InsertEntry
+//------------------------------------------------------------------------------
+uint32_t PackedCache::InsertEntry( uint64_t keyHashA, uint64_t keyHashB )
+{
+    ASSERT( FindEntry( keyHashA, keyHashB ) == PACKED_CACHE_INVALID );
+
+    PackedCacheIndexEntry * entries = GetEntries();
+    const uint32_t mask = ( m_Index->m_Capacity - 1 );
+    uint32_t slot = (uint32_t)( keyHashA & mask );
+    while ( entries[ slot ].m_State == PackedCacheIndexEntry::USED )
+    {
+        slot = ( ( slot + 1 ) & mask );
+    }
+
+    PackedCacheIndexEntry & entry = entries[ slot ];
+    if ( entry.m_State == PackedCacheIndexEntry::REMOVED )
+    {
+        m_Index->m_NumTombstones--;
+    }
+    memset( &entry, 0, sizeof( entry ) );
+    entry.m_KeyHashA = keyHashA;
+    entry.m_KeyHashB = keyHashB;
+    entry.m_LRUPrev = PACKED_CACHE_INVALID;
+    entry.m_LRUNext = PACKED_CACHE_INVALID;
+    entry.m_State = PackedCacheIndexEntry::USED;
+    m_Index->m_NumEntries++;
+    return slot;
+}
+
+// RemoveEntry
+//------------------------------------------------------------------------------
+void PackedCache::RemoveEntry( uint32_t slot )
+{
+    PackedCacheIndexEntry & entry = GetEntries()[ slot ];
+    ASSERT( entry.m_State == PackedCacheIndexEntry::USED );
+
+    LRUUnlink( slot );
+    ASSERT( m_Index->m_PackLiveBytes[ entry.m_Pack ] >= entry.m_Size );
+    m_Index->m_PackLiveBytes[ entry.m_Pack ] -= entry.m_Size;
+
+    // Slot must remain occupied so probe sequences passing through it continue
+    entry.m_State = PackedCacheIndexEntry::REMOVED;
+    m_Index->m_NumEntries--;
+    m_Index->m_NumTombstones++;
+}
+
+// LRUUnlink
+//------------------------------------------------------------------------------
+void PackedCache::LRUUnlink( uint32_t slot )
+{
+    PackedCacheIndexEntry * entries = GetEntries();
+    PackedCacheIndexEntry & entry = entries[ slot ];
+    if ( entry.m_LRUPrev != PACKED_CACHE_INVALID )
+    {
+        entries[ entry.m_LRUPrev ].m_LRUNext = entry.m_LRUNext;
+    }
+    else
+    {
+        m_Index->m_LRUHead = entry.m_LRUNext;
+    }
+    if ( entry.m_LRUNext != PACKED_CACHE_INVALID )
+    {
+        entries[ entry.m_LRUNext ].m_LRUPrev = entry.m_LRUPrev;
+    }
+    else
+    {
+        m_Index->m_LRUTail = entry.m_LRUPrev;
+    }
+    entry.m_LRUPrev = PACKED_CACHE_INVALID;
+    entry.m_LRUNext = PACKED_CACHE_INVALID;
+}
+
+// LRUPushFront
+//------------------------------------------------------------------------------
+void PackedCache::LRUPushFront( uint32_t slot )
+{
+    PackedCacheIndexEntry * entries = GetEntries();
+    PackedCacheIndexEntry & entry = entries[ slot ];
+    entry.m_LRUPrev = PACKED_CACHE_INVALID;
+    entry.m_LRUNext = m_Index->m_LRUHead;
+    if ( m_Index->m_LRUHead != PACKED_CACHE_INVALID )
+    {
+        entries[ m_Index->m_LRUHead ].m_LRUPrev = slot;
+    }
+    else
+    {
+        m_Index->m_LRUTail = slot;
+    }
+    m_Index->m_LRUHead = slot;
+}
+
+// GetPackForWrite
+//------------------------------------------------------------------------------
+uint32_t PackedCache::GetPackForWrite( uint64_t dataSize )
+{
+    // Append to current pack if there is room
+    const uint32_t current = m_Index->m_CurrentPack;
+    if ( current != PACKED_CACHE_INVALID )
+    {
+        const uint64_t currentSize = m_Index->m_PackSizes[ current ];
+        if ( ( currentSize == 0 ) || ( ( currentSize + dataSize ) <= PACKED_CACHE_MAX_PACK_SIZE ) )
+        {
+            return current;
+        }
+    }
+
+    // Start a new pack
+    for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+    {
+        if ( m_Index->m_PackSerials[ i ] == 0 )
+        {
+            uint32_t serial = m_Index->m_NextPackSerial++;
+            if ( serial == 0 ) // Skip 0 on wrap around
+            {
+                serial = m_Index->m_NextPackSerial++;
+            }
+            m_Index->m_PackSerials[ i ] = serial;
+            m_Index->m_PackSizes[ i ] = 0;
+            m_Index->m_PackLiveBytes[ i ] = 0;
+            m_Index->m_CurrentPack = i;
+            return i;
+        }
+    }
+
+    return PACKED_CACHE_INVALID; // Cache is full
+}
+
+// GetTotalPackSize
+//------------------------------------------------------------------------------
+uint64_t PackedCache::GetTotalPackSize() const
+{
+    uint64_t totalSize = 0;
+    for ( uint32_t i = 0; i < PACKED_CACHE_MAX_PACKS; ++i )
+    {
+        totalSize += m_Index->m_PackSizes[ i ];
+    }
+    return totalSize;
+}
+
+// CompactPack
+//------------------------------------------------------------------------------
+bool PackedCache::CompactPack( uint32_t pack )
+{
+    // Don't append to the pack being compacted
+    if ( m_Index->m_CurrentPack == pack )
+    {
+        m_Index->m_CurrentPack = PACKED_CACHE_INVALID;
+    }
+
+    const uint32_t serial = m_Index->m_PackSerials[ pack ];
+    const FileHandle reader = AcquirePackReader( serial );
+    if ( reader == PACKED_CACHE_INVALID_HANDLE )
+    {
+        return false;
+    }
+
+    // Move live entries to the end of the current pack. The old data stays intact
+    // until the pack is deleted, so readers which already located it are unaffected.
+    bool ok = true;
+    Array< char > buffer;
+    FileHandle writer = PACKED_CACHE_INVALID_HANDLE;
+    uint32_t openPack = PACKED_CACHE_INVALID;
+    PackedCacheIndexEntry * entries = GetEntries();
+    const uint32_t capacity = m_Index->m_Capacity;
+    for ( uint32_t slot = 0; ( slot < capacity ) && ( m_Index->m_PackLiveBytes[ pack ] > 0 ); ++slot )
+    {
+        PackedCacheIndexEntry & entry = entries[ slot ];
+        if ( ( entry.m_State != PackedCacheIndexEntry::USED ) || ( entry.m_Pack != pack ) )
+        {
+            continue;
+        }
+
+        buffer.SetSize( entry.m_Size ? entry.m_Size : 1 );
+        if ( ( ReadFileAt( reader, entry.m_Offset, buffer.Begin(), entry.m_Size ) == false ) ||
+             ( xxHash3::Calc64( buffer.Begin(), entry.m_Size ) != entry.m_DataHash ) )
+        {
+            RemoveEntry( slot ); // Corrupt, so no point keeping it
+            continue;
+        }
+
+        const uint32_t targetPack = GetPackForWrite( entry.m_Size );
+        if ( targetPack == PACKED_CACHE_INVALID )
+        {
+            ok = false; // Cache is full
+            break;
+        }
+        if ( targetPack != openPack )
+        {
+            if ( writer != PACKED_CACHE_INVALID_HANDLE )
+            {
+                CloseFile( writer );
+            }
+            AStackString<> packFileName;
+            GetPackFileName( m_Index->m_PackSerials[ targetPack ], packFileName );
+            writer = OpenFileForWrite( packFileName );
+            if ( writer == PACKED_CACHE_INVALID_HANDLE )
+            {
+                ok = false;
+                break;
+            }
+            openPack = targetPack;
+        }
+
+        // Reserve space the same way Publish does, as the pack may be written
+        // concurrently beyond the range reserved here
+        const uint64_t offset = m_Index->m_PackSizes[ targetPack ];
+        m_Index->m_PackSizes[ targetPack ] += entry.m_Size;
+        if ( WriteFileAt( writer, offset, buffer.Begin(), entry.m_Size ) == false )
+        {
+            ok = false;
+            break;
+        }
+
+        m_Index->m_PackLiveBytes[ pack ] -= entry.m_Size;
+        m_Index->m_PackLiveBytes[ targetPack ] += entry.m_Size;
+        entry.m_Pack = (uint16_t)targetPack;
+        entry.m_Offset = offset;
+    }
+    if ( writer != PACKED_CACHE_INVALID_HANDLE )
+    {
+        CloseFile( writer );
+    }
+    ReleasePackReader( serial, reader );
+
+    return ( ok && DeletePack( pack ) );
+}
+
+// DeletePack
+//------------------------------------------------------------------------------
+bool PackedCache::DeletePack( uint32_t pack )
+{
+    ASSERT( m_Index->m_PackLiveBytes[ pack ] == 0 );
+
+    // Close our reader first (deletion of open files can fail on Windows)
+    ClosePackReader( m_Index->m_PackSerials[ pack ] );
+
+    AStackString<> packFileName;
+    GetPackFileName( m_Index->m_PackSerials[ pack ], packFileName );
+    if ( ( FileIO::FileDelete( packFileName.Get() ) == false ) && FileIO::FileExists( packFileName.Get() ) )
+    {
+        return false; // In use (will be retried on next Trim)
+    }
+
+    m_Index->m_PackSerials[ pack ] = 0;
+    m_Index->m_PackSizes[ pack ] = 0;
+    if ( m_Index->m_CurrentPack == pack )
+    {
+        m_Index->m_CurrentPack = PACKED_CACHE_INVALID;
+    }
+    return true;
+}
+
+// ClosePackReaders
+//------------------------------------------------------------------------------
+void PackedCache::ClosePackReaders()
+{
+    for ( size_t i = m_PackReaders.GetSize(); i > 0; --i )
+    {
+        // Readers in use are closed when released
+        PackReader & reader = m_PackReaders[ i - 1 ];
+        reader.m_Closed = true;
+        if ( reader.m_RefCount == 0 )
+        {
+            CloseFile( reader.m_Handle );
+            m_PackReaders.EraseIndex( i - 1 );
+        }
+    }
+}
+
+// ClosePackReader
+//------------------------------------------------------------------------------
+void PackedCache::ClosePackReader( uint32_t serial )
+{
+    for ( PackReader & reader : m_PackReaders )
+    {
+        if ( ( reader.m_Serial == serial ) && ( reader.m_Closed == false ) )
+        {
+            // Readers in use are closed when released
+            reader.m_Closed = true;
+            if ( reader.m_RefCount == 0 )
+            {
+                CloseFile( reader.m_Handle );
+                m_PackReaders.Erase( &reader );
+            }
+            return;
+        }
+    }
+}
+
+// PrunePackReaders
+//------------------------------------------------------------------------------
+void PackedCache::PrunePackReaders()
+{
+    // Close readers of packs deleted by any process (lock must be held)
+    for ( size_t i = m_PackReaders.GetSize(); i > 0; --i )
+    {
+        PackReader & reader = m_PackReaders[ i - 1 ];
+        bool inIndex = false;
+        for ( uint32_t pack = 0; pack < PACKED_CACHE_MAX_PACKS; ++pack )
+        {
+            if ( m_Index->m_PackSerials[ pack ] == reader.m_Serial )
+            {
+                inIndex = true;
+                break;
+            }
+        }
+        if ( inIndex == false )
+        {
+            reader.m_Closed = true;
+            if ( reader.m_RefCount == 0 )
+            {
+                CloseFile( reader.m_Handle );
+                m_PackReaders.EraseIndex( i - 1 );
+            }
+        }
+    }
+}
+
+// AcquirePackReader
+//------------------------------------------------------------------------------
+PackedCache::FileHandle PackedCache::AcquirePackReader( uint32_t serial )
+{
+    // Handles are kept open so each retrieval doesn't need to open a file
+    for ( PackReader & reader : m_PackReaders )
+    {
+        if ( ( reader.m_Serial == serial ) && ( reader.m_Closed == false ) )
+        {
+            reader.m_RefCount++;
+            return reader.m_Handle;
+        }
+    }
+
+    // Opening a new pack is a good time to discard readers of old ones
+    PrunePackReaders();
+
+    AStackString<> packFileName;
+    GetPackFileName( serial, packFileName );
+    const FileHandle handle = OpenFileForRead( packFileName );
+    if ( handle != PACKED_CACHE_INVALID_HANDLE )
+    {
+        m_PackReaders.Append( PackReader{ serial, handle, 1, false } );
+    }
+    return handle;
+}
+
+// ReleasePackReader
+//------------------------------------------------------------------------------
+void PackedCache::ReleasePackReader( uint32_t serial, FileHandle handle )
+{
+    for ( PackReader & reader : m_PackReaders )
+    {
+        if ( ( reader.m_Serial == serial ) && ( reader.m_Handle == handle ) )
+        {
+            ASSERT( reader.m_RefCount > 0 );
+            reader.m_RefCount--;
+            if ( reader.m_Closed && ( reader.m_RefCount == 0 ) )
+            {
+                CloseFile( reader.m_Handle );
+                m_PackReaders.Erase( &reader );
+            }
+            return;
+        }
+    }
+    ASSERT( false ); // Released a reader which wasn't acquired
+}
+
+// GetPackFileName
+//------------------------------------------------------------------------------
+void PackedCache::GetPackFileName( uint32_t serial, AString & outFileName ) const
+{
+    outFileName.Format( "%sPack%08X.fpk", m_CachePath.Get(), serial );
+}
+
+// GetKeyHashes
+//------------------------------------------------------------------------------
+/*static*/ void PackedCache::GetKeyHashes( const AString & cacheId, uint64_t & outKeyHashA, uint64_t & outKeyHashB )
+{
+    // Two independent 64-bit hashes make collisions between cache ids negligible
+    outKeyHashA = xxHash3::Calc64( cacheId );
+    outKeyHashB = xxHash::Calc64( cacheId );
+}
+
+//------------------------------------------------------------------------------
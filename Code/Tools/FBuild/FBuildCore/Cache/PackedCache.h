@@ -0,0 +1,126 @@
+// PackedCache - Cache implementation using pack files and a shared index
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "ICache.h"
+#include "Core/Containers/Array.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+struct PackedCacheIndexEntry;
+struct PackedCacheIndexHeader;
+
+// PackedCache
+//  - Entries are appended to large pack files instead of one file per entry
+//  - A memory mapped hash index (shared by all processes using the cache)
+//    locates entries and tracks usage in LRU order, so lookups don't touch the
+//    file system and trimming only visits evicted entries
+//  - Modifications to the index are serialized by a lock file. Lookups share
+//    the lock and data is read and written without holding it.
+//  - Usage is recorded in the index the next time it is locked exclusively
+//------------------------------------------------------------------------------
+class PackedCache : public ICache
+{
+public:
+    explicit PackedCache();
+    virtual ~PackedCache() override;
+
+    virtual bool Init( const AString & cachePath,
+                       const AString & cachePathMountPoint,
+                       bool cacheRead,
+                       bool cacheWrite,
+                       bool cacheVerbose,
+                       const AString & pluginDLLConfig ) override;
+    virtual void Shutdown() override;
+    virtual bool Publish( const AString & cacheId, const void * data, size_t dataSize ) override;
+    virtual bool Retrieve( const AString & cacheId, void * & data, size_t & dataSize ) override;
+    virtual void FreeMemory( void * data, size_t dataSize ) override;
+    virtual bool OutputInfo( bool showProgress ) override;
+    virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual void ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists ) override;
+    virtual void GetAndResetVerifyStats( CacheVerifyStats & outStats ) override;
+
+    // Trim silently (to a little below the limit), if over the limit
+    bool        EnforceSizeLimit( uint32_t sizeMiB );
+
+private:
+    bool        TrimInternal( uint32_t sizeMiB, uint32_t targetMiB, bool verbose );
+
+    #if defined( __WINDOWS__ )
+        typedef void * FileHandle;
+    #else
+        typedef int FileHandle;
+    #endif
+
+    // Cross-process lock (m_Mutex must be held)
+    bool        LockIndex( bool exclusive = true );
+    void        UnlockIndex();
+    void        ApplyPendingTouches();
+
+    // Index file management (lock must be held)
+    uint32_t    ReadIndexGeneration() const;
+    bool        WriteIndexGeneration( uint32_t generation ) const;
+    void        GetIndexFileName( uint32_t generation, AString & outFileName ) const;
+    bool        OpenIndex();
+    bool        CreateIndex( uint32_t capacity, const PackedCacheIndexHeader * oldIndex );
+    void        CloseIndex();
+    bool        ResetIndex();
+    bool        RecoverIndex();
+    bool        EnsureIndexCapacity();
+
+    // Index entries (lock must be held)
+    PackedCacheIndexEntry * GetEntries() const;
+    uint32_t    FindEntry( uint64_t keyHashA, uint64_t keyHashB ) const;
+    uint32_t    InsertEntry( uint64_t keyHashA, uint64_t keyHashB );
+    void        RemoveEntry( uint32_t slot );
+    void        LRUUnlink( uint32_t slot );
+    void        LRUPushFront( uint32_t slot );
+
+    // Pack files
+    uint32_t    GetPackForWrite( uint64_t dataSize );
+    uint64_t    GetTotalPackSize() const;
+    bool        CompactPack( uint32_t pack );
+    bool        DeletePack( uint32_t pack );
+
+    // Pack readers (m_Mutex must be held)
+    void        ClosePackReaders();
+    void        ClosePackReader( uint32_t serial );
+    void        PrunePackReaders();
+    FileHandle  AcquirePackReader( uint32_t serial );
+    void        ReleasePackReader( uint32_t serial, FileHandle handle );
+    void        GetPackFileName( uint32_t serial, AString & outFileName ) const;
+
+    static void GetKeyHashes( const AString & cacheId, uint64_t & outKeyHashA, uint64_t & outKeyHashB );
+
+    struct PendingTouch
+    {
+        uint64_t    m_KeyHashA;
+        uint64_t    m_KeyHashB;
+        uint64_t    m_Time;
+    };
+
+    struct PackReader
+    {
+        uint32_t    m_Serial;
+        FileHandle  m_Handle;
+        uint32_t    m_RefCount;     // Reads in progress (outside of m_Mutex)
+        bool        m_Closed;       // Close once no longer in use
+    };
+
+    Mutex                       m_Mutex;        // Serialize threads within this process
+    AString                     m_CachePath;
+    FileHandle                  m_LockFile;
+    PackedCacheIndexHeader *    m_Index;        // Mapped index (header followed by entries)
+    size_t                      m_IndexSize;
+    uint32_t                    m_IndexGeneration;  // Index files are replaced (not resized) when they grow
+    Array< PackReader >         m_PackReaders;  // Pack files opened for reading (kept open until the pack is deleted)
+    Array< PendingTouch >       m_PendingTouches;   // Retrieved entries not yet marked as used in the index
+    Mutex                       m_VerifyStatsMutex;
+    CacheVerifyStats            m_VerifyStats;
+};
+
+//------------------------------------------------------------------------------
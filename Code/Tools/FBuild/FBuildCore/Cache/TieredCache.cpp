@@ -0,0 +1,485 @@
+// TieredCache - Local cache in front of a shared cache
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "TieredCache.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/CacheWriteQueue.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Tracing/Tracing.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+TieredCache::TieredCache( ICache * remote, const AString & localPath, uint32_t localSizeMiB, bool writeSync )
+    : m_Remote( remote )
+    , m_LocalPath( localPath )
+    , m_LocalSizeMiB( localSizeMiB )
+    , m_LocalAvailable( false )
+    , m_RemoteAvailable( false )
+    , m_WriteSync( writeSync )
+    , m_LocalWriteQueue( nullptr )
+    , m_RemoteAllocations( 64, true )
+{
+    ASSERT( m_Remote );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+/*virtual*/ TieredCache::~TieredCache()
+{
+    FDELETE m_LocalWriteQueue;
+    FDELETE m_Remote;
+    ASSERT( m_RemoteAllocations.IsEmpty() );
+}
+
+// Init
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Init( const AString & cachePath,
+                                    const AString & cachePathMountPoint,
+                                    bool cacheRead,
+                                    bool cacheWrite,
+                                    bool cacheVerbose,
+                                    const AString & pluginDLLConfig )
+{
+    PROFILE_FUNCTION;
+
+    m_RemoteAvailable = m_Remote->Init( cachePath, cachePathMountPoint, cacheRead, cacheWrite, cacheVerbose, pluginDLLConfig );
+    m_LocalAvailable = m_Local.Init( m_LocalPath, AString::GetEmpty(), true, true, cacheVerbose, AString::GetEmpty() );
+
+    if ( ( m_LocalAvailable == false ) && ( m_RemoteAvailable == false ) )
+    {
+        return false;
+    }
+
+    // Promotion is only needed when both tiers are in use
+    if ( m_LocalAvailable && m_RemoteAvailable && cacheRead && ( m_WriteSync == false ) )
+    {
+        m_LocalWriteQueue = FNEW( CacheWriteQueue( &m_Local, false ) );
+    }
+
+    return true;
+}
+
+// Shutdown
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::Shutdown()
+{
+    PROFILE_FUNCTION;
+
+    // Complete pending promotions
+    FDELETE m_LocalWriteQueue;
+    m_LocalWriteQueue = nullptr;
+
+    if ( m_LocalAvailable )
+    {
+        m_Local.EnforceSizeLimit( m_LocalSizeMiB );
+        m_Local.Shutdown();
+    }
+    if ( m_RemoteAvailable )
+    {
+        m_Remote->Shutdown();
+    }
+}
+
+// Publish
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Publish( const AString & cacheId, const void * data, size_t dataSize )
+{
+    PROFILE_FUNCTION;
+
+    const bool localOK = m_LocalAvailable && m_Local.Publish( cacheId, data, dataSize );
+
+    bool remoteOK = false;
+    if ( m_RemoteAvailable )
+    {
+        remoteOK = m_Remote->Publish( cacheId, data, dataSize );
+
+        MutexHolder mh( m_Mutex );
+        m_Stats.m_NumRemoteStores++;
+        if ( remoteOK == false )
+        {
+            m_Stats.m_NumRemoteFailed++;
+        }
+    }
+
+    return ( localOK || remoteOK );
+}
+
+// PublishBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::PublishBatch( const Array< AString > & cacheIds,
+                                            const Array< const void * > & data,
+                                            const Array< size_t > & dataSize,
+                                            Array< bool > & outStored )
+{
+    PROFILE_FUNCTION;
+
+    // Skip tiers which ExistsBatch found already have the entry. Publishing again
+    // would store a second copy (PackedCache appends to its packs).
+    const size_t count = cacheIds.GetSize();
+    Array< bool > localNeeded( count, false );
+    Array< bool > remoteNeeded( count, false );
+    {
+        MutexHolder mh( m_Mutex );
+        for ( const AString & cacheId : cacheIds )
+        {
+            bool local = true;
+            bool remote = true;
+            for ( size_t i = 0; i < m_KnownPresence.GetSize(); ++i )
+            {
+                const TierPresence & presence = m_KnownPresence[ i ];
+                if ( presence.m_CacheId == cacheId )
+                {
+                    local = ( presence.m_Local == false );
+                    remote = ( presence.m_Remote == false );
+                    m_KnownPresence.EraseIndex( i );
+                    break;
+                }
+            }
+            localNeeded.Append( local );
+            remoteNeeded.Append( remote );
+        }
+    }
+
+    Array< bool > localStored( count, false );
+    Array< bool > remoteStored( count, false );
+    PublishToTier( m_LocalAvailable ? &m_Local : nullptr, cacheIds, data, dataSize, localNeeded, localStored );
+    PublishToTier( m_RemoteAvailable ? m_Remote : nullptr, cacheIds, data, dataSize, remoteNeeded, remoteStored );
+
+    outStored.SetSize( count );
+    uint32_t numRemoteStores = 0;
+    uint32_t numRemoteFailed = 0;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        outStored[ i ] = ( localStored[ i ] || remoteStored[ i ] );
+        if ( m_RemoteAvailable && remoteNeeded[ i ] )
+        {
+            ++numRemoteStores;
+            if ( remoteStored[ i ] == false )
+            {
+                ++numRemoteFailed;
+            }
+        }
+    }
+
+    MutexHolder mh( m_Mutex );
+    m_Stats.m_NumRemoteStores += numRemoteStores;
+    m_Stats.m_NumRemoteFailed += numRemoteFailed;
+}
+
+// ExistsBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists )
+{
+    PROFILE_FUNCTION;
+
+    // Entries only need to be stored if missing from either tier
+    const size_t count = cacheIds.GetSize();
+    Array< bool > localExists( count, false );
+    Array< bool > remoteExists( count, false );
+    if ( m_LocalAvailable )
+    {
+        m_Local.ExistsBatch( cacheIds, localExists );
+    }
+    if ( m_RemoteAvailable )
+    {
+        m_Remote->ExistsBatch( cacheIds, remoteExists );
+    }
+
+    outExists.SetSize( count );
+    MutexHolder mh( m_Mutex );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const bool local = ( m_LocalAvailable == false ) || localExists[ i ];
+        const bool remote = ( m_RemoteAvailable == false ) || remoteExists[ i ];
+        outExists[ i ] = ( local && remote );
+
+        // Remember which tier has the entry, so PublishBatch only stores to the other
+        if ( ( local != remote ) && ( m_KnownPresence.GetSize() < MAX_KNOWN_PRESENCE ) )
+        {
+            TierPresence & presence = m_KnownPresence.EmplaceBack();
+            presence.m_CacheId = cacheIds[ i ];
+            presence.m_Local = local;
+            presence.m_Remote = remote;
+        }
+    }
+}
+
+// Retrieve
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Retrieve( const AString & cacheId, void * & data, size_t & dataSize )
+{
+    PROFILE_FUNCTION;
+
+    if ( m_LocalAvailable && m_Local.Retrieve( cacheId, data, dataSize ) )
+    {
+        MutexHolder mh( m_Mutex );
+        m_Stats.m_NumLocalHits++;
+        return true;
+    }
+
+    if ( m_RemoteAvailable && m_Remote->Retrieve( cacheId, data, dataSize ) )
+    {
+        const bool promoted = Promote( cacheId, data, dataSize );
+
+        MutexHolder mh( m_Mutex );
+        m_RemoteAllocations.Append( data );
+        m_Stats.m_NumRemoteHits++;
+        if ( promoted )
+        {
+            m_Stats.m_NumPromoted++;
+        }
+        return true;
+    }
+
+    MutexHolder mh( m_Mutex );
+    m_Stats.m_NumMisses++;
+    return false;
+}
+
+// RetrieveBatch
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::RetrieveBatch( const Array< AString > & cacheIds, Array< void * > & outData, Array< size_t > & outDataSize )
+{
+    PROFILE_FUNCTION;
+
+    const size_t count = cacheIds.GetSize();
+    outData.SetSize( count );
+    outDataSize.SetSize( count );
+
+    // Try the local tier first, collecting misses
+    Array< AString > remoteIds( count, false );
+    Array< size_t > remoteIndices( count, false );
+    uint32_t numLocalHits = 0;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        if ( m_LocalAvailable && m_Local.Retrieve( cacheIds[ i ], outData[ i ], outDataSize[ i ] ) )
+        {
+            ++numLocalHits;
+            continue;
+        }
+        outData[ i ] = nullptr;
+        outDataSize[ i ] = 0;
+        if ( m_RemoteAvailable )
+        {
+            remoteIds.Append( cacheIds[ i ] );
+            remoteIndices.Append( i );
+        }
+    }
+
+    // Retrieve the misses from the remote tier in a single batch
+    Array< void * > remoteData( remoteIds.GetSize(), true );
+    Array< size_t > remoteDataSize( remoteIds.GetSize(), true );
+    if ( remoteIds.IsEmpty() == false )
+    {
+        m_Remote->RetrieveBatch( remoteIds, remoteData, remoteDataSize );
+    }
+
+    uint32_t numRemoteHits = 0;
+    uint32_t numPromoted = 0;
+    for ( size_t i = 0; i < remoteIds.GetSize(); ++i )
+    {
+        if ( remoteData[ i ] == nullptr )
+        {
+            continue;
+        }
+        const size_t index = remoteIndices[ i ];
+        outData[ index ] = remoteData[ i ];
+        outDataSize[ index ] = remoteDataSize[ i ];
+        ++numRemoteHits;
+
+        if ( Promote( remoteIds[ i ], remoteData[ i ], remoteDataSize[ i ] ) )
+        {
+            ++numPromoted;
+        }
+    }
+
+    MutexHolder mh( m_Mutex );
+    for ( size_t i = 0; i < remoteIds.GetSize(); ++i )
+    {
+        if ( remoteData[ i ] )
+        {
+            m_RemoteAllocations.Append( remoteData[ i ] );
+        }
+    }
+    m_Stats.m_NumLocalHits += numLocalHits;
+    m_Stats.m_NumRemoteHits += numRemoteHits;
+    m_Stats.m_NumPromoted += numPromoted;
+    m_Stats.m_NumMisses += (uint32_t)( count - numLocalHits - numRemoteHits );
+}
+
+// GetSampleIds
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::GetSampleIds( size_t maxEntries, Array< AString > & outCacheIds )
+{
+    // The shared cache is more representative (entries are retrieved via either tier)
+    return m_RemoteAvailable && m_Remote->GetSampleIds( maxEntries, outCacheIds );
+}
+
+// Verify
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Verify( bool showProgress )
+{
+    // Local entries are checked (and discarded if corrupt) whenever they are retrieved
+    if ( m_RemoteAvailable == false )
+    {
+        OUTPUT( "- Shared cache unavailable\n" );
+        return false;
+    }
+    return m_Remote->Verify( showProgress );
+}
+
+// GetAndResetVerifyStats
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::GetAndResetVerifyStats( CacheVerifyStats & outStats )
+{
+    m_Local.GetAndResetVerifyStats( outStats );
+    if ( m_RemoteAvailable )
+    {
+        CacheVerifyStats remoteStats;
+        m_Remote->GetAndResetVerifyStats( remoteStats );
+        outStats.Add( remoteStats );
+    }
+}
+
+// FreeMemory
+//------------------------------------------------------------------------------
+/*virtual*/ void TieredCache::FreeMemory( void * data, size_t dataSize )
+{
+    bool fromRemote;
+    {
+        MutexHolder mh( m_Mutex );
+        fromRemote = m_RemoteAllocations.FindAndErase( data );
+    }
+
+    if ( fromRemote )
+    {
+        m_Remote->FreeMemory( data, dataSize );
+    }
+    else
+    {
+        m_Local.FreeMemory( data, dataSize );
+    }
+}
+
+// OutputInfo
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::OutputInfo( bool showProgress )
+{
+    bool ok = true;
+    if ( m_LocalAvailable )
+    {
+        OUTPUT( "Local Cache: %s\n", m_LocalPath.Get() );
+        ok = m_Local.OutputInfo( showProgress );
+    }
+    if ( m_RemoteAvailable )
+    {
+        OUTPUT( "Remote Cache:\n" );
+        ok = m_Remote->OutputInfo( showProgress ) && ok;
+    }
+    return ok;
+}
+
+// Trim
+//------------------------------------------------------------------------------
+/*virtual*/ bool TieredCache::Trim( bool showProgress, uint32_t sizeMiB )
+{
+    // The local tier is never allowed to exceed its own limit
+    bool ok = true;
+    if ( m_LocalAvailable )
+    {
+        OUTPUT( "Local Cache: %s\n", m_LocalPath.Get() );
+        ok = m_Local.Trim( showProgress, Math::Min( sizeMiB, m_LocalSizeMiB ) );
+    }
+    if ( m_RemoteAvailable )
+    {
+        OUTPUT( "Remote Cache:\n" );
+        ok = m_Remote->Trim( showProgress, sizeMiB ) && ok;
+    }
+    return ok;
+}
+
+// Flush
+//------------------------------------------------------------------------------
+void TieredCache::Flush()
+{
+    PROFILE_FUNCTION;
+
+    if ( m_LocalWriteQueue )
+    {
+        m_LocalWriteQueue->Flush();
+    }
+}
+
+// GetAndResetStats
+//------------------------------------------------------------------------------
+void TieredCache::GetAndResetStats( TieredCacheStats & outStats )
+{
+    MutexHolder mh( m_Mutex );
+    outStats = m_Stats;
+    m_Stats = TieredCacheStats();
+}
+
+// Promote
+//------------------------------------------------------------------------------
+bool TieredCache::Promote( const AString & cacheId, const void * data, size_t dataSize )
+{
+    // Copy a remote hit to the local tier, in the background if possible
+    // (skipped if the queue is full)
+    if ( m_LocalWriteQueue )
+    {
+        return m_LocalWriteQueue->Enqueue( cacheId, data, dataSize, cacheId );
+    }
+    return m_WriteSync && m_LocalAvailable && m_Local.Publish( cacheId, data, dataSize );
+}
+
+// PublishToTier
+//------------------------------------------------------------------------------
+void TieredCache::PublishToTier( ICache * tier,
+                                 const Array< AString > & cacheIds,
+                                 const Array< const void * > & data,
+                                 const Array< size_t > & dataSize,
+                                 const Array< bool > & needed,
+                                 Array< bool > & outStored )
+{
+    // Entries which are not needed are already present
+    const size_t count = cacheIds.GetSize();
+    outStored.SetSize( count );
+    Array< AString > ids( count, false );
+    Array< const void * > idsData( count, false );
+    Array< size_t > idsDataSize( count, false );
+    Array< size_t > indices( count, false );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        outStored[ i ] = ( tier != nullptr ) && ( needed[ i ] == false );
+        if ( tier && needed[ i ] )
+        {
+            ids.Append( cacheIds[ i ] );
+            idsData.Append( data[ i ] );
+            idsDataSize.Append( dataSize[ i ] );
+            indices.Append( i );
+        }
+    }
+    if ( ids.IsEmpty() )
+    {
+        return;
+    }
+
+    // Forward as a batch, so caches which can overlap requests do so
+    Array< bool > stored( ids.GetSize(), false );
+    tier->PublishBatch( ids, idsData, idsDataSize, stored );
+    for ( size_t i = 0; i < indices.GetSize(); ++i )
+    {
+        outStored[ indices[ i ] ] = stored[ i ];
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,107 @@
+// TieredCache - Local cache in front of a shared cache
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "ICache.h"
+#include "PackedCache.h"
+#include "Core/Containers/Array.h"
+#include "Core/Process/Mutex.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class CacheWriteQueue;
+
+// TieredCacheStats
+//------------------------------------------------------------------------------
+class TieredCacheStats
+{
+public:
+    uint32_t    m_NumLocalHits          = 0;
+    uint32_t    m_NumRemoteHits         = 0;
+    uint32_t    m_NumMisses             = 0;
+    uint32_t    m_NumPromoted           = 0;    // Remote hits copied to the local tier
+    uint32_t    m_NumRemoteStores       = 0;    // Stores made to the remote tier
+    uint32_t    m_NumRemoteFailed       = 0;    // Remote stores which failed
+
+    bool        IsEmpty() const { return ( ( m_NumLocalHits + m_NumRemoteHits + m_NumMisses + m_NumRemoteStores ) == 0 ); }
+};
+
+// TieredCache
+//  - A size-bounded local PackedCache (L1) in front of a shared cache (L2),
+//    such as a network share or cache plugin
+//  - Lookups try the local tier first. Remote hits are copied into the local
+//    tier in the background (unless writeSync is set).
+//  - Stores are made to both tiers by the calling thread. Background stores
+//    are handled by the CacheWriteQueue in front of the whole cache, so data
+//    is only copied and queued once.
+//  - ExistsBatch remembers which tier is missing each entry, so the following
+//    PublishBatch only stores to that tier
+//------------------------------------------------------------------------------
+class TieredCache : public ICache
+{
+public:
+    explicit TieredCache( ICache * remote, const AString & localPath, uint32_t localSizeMiB, bool writeSync ); // Takes ownership of remote
+    virtual ~TieredCache() override;
+
+    virtual bool Init( const AString & cachePath,
+                       const AString & cachePathMountPoint,
+                       bool cacheRead,
+                       bool cacheWrite,
+                       bool cacheVerbose,
+                       const AString & pluginDLLConfig ) override;
+    virtual void Shutdown() override;
+    virtual bool Publish( const AString & cacheId, const void * data, size_t dataSize ) override;
+    virtual bool Retrieve( const AString & cacheId, void * & data, size_t & dataSize ) override;
+    virtual void FreeMemory( void * data, size_t dataSize ) override;
+    virtual bool OutputInfo( bool showProgress ) override;
+    virtual bool Trim( bool showProgress, uint32_t sizeMiB ) override;
+    virtual void RetrieveBatch( const Array< AString > & cacheIds, Array< void * > & outData, Array< size_t > & outDataSize ) override;
+    virtual void PublishBatch( const Array< AString > & cacheIds,
+                               const Array< const void * > & data,
+                               const Array< size_t > & dataSize,
+                               Array< bool > & outStored ) override;
+    virtual void ExistsBatch( const Array< AString > & cacheIds, Array< bool > & outExists ) override;
+    virtual bool GetSampleIds( size_t maxEntries, Array< AString > & outCacheIds ) override;
+    virtual bool Verify( bool showProgress ) override;
+    virtual void GetAndResetVerifyStats( CacheVerifyStats & outStats ) override;
+
+    // Wait for background promotions to complete (main thread only)
+    void        Flush();
+
+    // Retrieve the stats gathered since the last call
+    void        GetAndResetStats( TieredCacheStats & outStats );
+
+private:
+    bool                Promote( const AString & cacheId, const void * data, size_t dataSize );
+    void                PublishToTier( ICache * tier,
+                                       const Array< AString > & cacheIds,
+                                       const Array< const void * > & data,
+                                       const Array< size_t > & dataSize,
+                                       const Array< bool > & needed,
+                                       Array< bool > & outStored );
+
+    enum : uint32_t { MAX_KNOWN_PRESENCE = 4096 };
+    struct TierPresence
+    {
+        AString         m_CacheId;
+        bool            m_Local;
+        bool            m_Remote;
+    };
+
+    PackedCache         m_Local;
+    ICache *            m_Remote;
+    AString             m_LocalPath;
+    uint32_t            m_LocalSizeMiB;
+    bool                m_LocalAvailable;
+    bool                m_RemoteAvailable;
+    bool                m_WriteSync;        // Promote remote hits on the calling thread
+    CacheWriteQueue *   m_LocalWriteQueue;  // Promotion of remote hits
+    Mutex               m_Mutex;            // Protects the members below
+    Array< void * >     m_RemoteAllocations;// Retrieved data which must be freed by the remote tier
+    Array< TierPresence > m_KnownPresence;  // Entries found in only one tier by ExistsBatch
+    TieredCacheStats    m_Stats;
+};
+
+//------------------------------------------------------------------------------
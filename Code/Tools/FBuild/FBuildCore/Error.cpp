@@ -739,6 +739,14 @@
     FormatError( iter, 1504u, function, "CSAssembly requires a C# Compiler." );
 }
 
+// Error_1505_DependencyCacheKeyIncompatibleWithCompiler
+//------------------------------------------------------------------------------
+/*static*/ void Error::Error_1505_DependencyCacheKeyIncompatibleWithCompiler( const BFFToken * iter,
+                                                                               const Function * function )
+{
+    FormatError( iter, 1505u, function, "DependencyCacheKey only compatible with GCC and Clang Compilers." );
+}
+
 // Error_1999_UserError
 //------------------------------------------------------------------------------
 /*static*/ void Error::Error_1999_UserError( const BFFToken * iter,
@@ -41,6 +41,16 @@ void CompilerDriverBase::Init( const ObjectNode * objectNode,
     return false;
 }
 
+// ProcessArg_DependenciesOnly
+//------------------------------------------------------------------------------
+/*virtual*/ bool CompilerDriverBase::ProcessArg_DependenciesOnly( const AString & /*token*/,
+                                                                  size_t & /*index*/,
+                                                                  const AString & /*nextToken*/,
+                                                                  Args & /*outFullArgs*/ ) const
+{
+    return false;
+}
+
 // ProcessArg_CompilePreprocessed
 //------------------------------------------------------------------------------
 /*virtual*/ bool CompilerDriverBase::ProcessArg_CompilePreprocessed( const AString & /*token*/,
@@ -127,6 +137,12 @@ void CompilerDriverBase::Init( const ObjectNode * objectNode,
 {
 }
 
+// AddAdditionalArgs_Dependencies
+//------------------------------------------------------------------------------
+/*virtual*/ void CompilerDriverBase::AddAdditionalArgs_Dependencies( Args & /*outFullArgs*/ ) const
+{
+}
+
 // AddAdditionalArgs_Common
 //------------------------------------------------------------------------------
 /*virtual*/ void CompilerDriverBase::AddAdditionalArgs_Common( bool /*isLocal*/,
@@ -35,6 +35,10 @@ public:
                                               size_t & index,
                                               const AString & nextToken,
                                               Args & outFullArgs ) const;
+    virtual bool ProcessArg_DependenciesOnly( const AString & token,
+                                              size_t & index,
+                                              const AString & nextToken,
+                                              Args & outFullArgs ) const;
     virtual bool ProcessArg_CompilePreprocessed( const AString & token,
                                                  size_t & index,
                                                  const AString & nextToken,
@@ -51,6 +55,7 @@ public:
 
     // Add additional args
     virtual void AddAdditionalArgs_Preprocessor( Args & outFullArgs ) const;
+    virtual void AddAdditionalArgs_Dependencies( Args & outFullArgs ) const;
     virtual void AddAdditionalArgs_Common( bool isLocal,
                                            Args & outFullArgs ) const;
 
@@ -66,6 +66,31 @@ CompilerDriver_GCCClang::~CompilerDriver_GCCClang() = default;
     return false;
 }
 
+// ProcessArg_DependenciesOnly
+//------------------------------------------------------------------------------
+/*virtual*/ bool CompilerDriver_GCCClang::ProcessArg_DependenciesOnly( const AString & token,
+                                                                       size_t & index,
+                                                                       const AString & /*nextToken*/,
+                                                                       Args & /*outFullArgs*/ ) const
+{
+    // Remove any user specified dependency output options, so our own
+    // dependency list is written to stdout in the expected format
+    if ( StripToken( "-M", token ) ||
+         StripToken( "-MM", token ) ||
+         StripToken( "-MD", token ) ||
+         StripToken( "-MMD", token ) ||
+         StripToken( "-MG", token ) ||
+         StripToken( "-MP", token ) ||
+         StripTokenWithArg( "-MF", token, index ) ||
+         StripTokenWithArg( "-MT", token, index ) ||
+         StripTokenWithArg( "-MQ", token, index ) )
+    {
+        return true;
+    }
+
+    return false;
+}
+
 // ProcessArg_CompilePreprocessed
 //------------------------------------------------------------------------------
 /*virtual*/ bool CompilerDriver_GCCClang::ProcessArg_CompilePreprocessed( const AString & token,
@@ -169,6 +194,13 @@ CompilerDriver_GCCClang::~CompilerDriver_GCCClang() = default;
     }
 }
 
+// AddAdditionalArgs_Dependencies
+//------------------------------------------------------------------------------
+/*virtual*/ void CompilerDriver_GCCClang::AddAdditionalArgs_Dependencies( Args & outFullArgs ) const
+{
+    outFullArgs += "-M"; // list dependencies (including system headers) instead of preprocessing
+}
+
 // AddAdditionalArgs_Common
 //------------------------------------------------------------------------------
 /*virtual*/ void CompilerDriver_GCCClang::AddAdditionalArgs_Common( bool isLocal,
@@ -26,6 +26,10 @@ public:
                                               size_t & index,
                                               const AString & nextToken,
                                               Args & outFullArgs ) const override;
+    virtual bool ProcessArg_DependenciesOnly( const AString & token,
+                                              size_t & index,
+                                              const AString & nextToken,
+                                              Args & outFullArgs ) const override;
     virtual bool ProcessArg_CompilePreprocessed( const AString & token,
                                                  size_t & index,
                                                  const AString & nextToken,
@@ -36,6 +40,7 @@ public:
                                     Args & outFullArgs ) const override;
 
     virtual void AddAdditionalArgs_Preprocessor( Args & outFullArgs ) const override;
+    virtual void AddAdditionalArgs_Dependencies( Args & outFullArgs ) const override;
     virtual void AddAdditionalArgs_Common( bool isLocal,
                                            Args & outFullArgs ) const override;
 
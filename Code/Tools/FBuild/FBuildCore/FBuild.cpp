@@ -11,13 +11,19 @@
 #include "Cache/ICache.h"
 #include "Cache/Cache.h"
 #include "Cache/CachePlugin.h"
+#include "Cache/CachePrefetcher.h"
+#include "Cache/CacheWriteQueue.h"
 #include "Cache/LightCache.h"
+#include "Cache/PackedCache.h"
+#include "Cache/TieredCache.h"
 #include "Graph/Node.h"
 #include "Graph/NodeGraph.h"
 #include "Graph/NodeProxy.h"
 #include "Graph/SettingsNode.h"
 #include "Helpers/BuildProfiler.h"
 #include "Helpers/CompilationDatabase.h"
+#include "Helpers/CompressionDictionary.h"
+#include "Helpers/Compressor.h"
 #include "Protocol/Client.h"
 #include "Protocol/Protocol.h"
 #include "WorkerPool/JobQueue.h"
@@ -30,6 +36,7 @@
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
+#include "Core/FileIO/PathUtils.h"
 #include "Core/Math/xxHash.h"
 #include "Core/Mem/SmallBlockAllocator.h"
 #include "Core/Process/Atomic.h"
@@ -59,6 +66,10 @@ FBuild::FBuild( const FBuildOptions & options )
     , m_JobQueue( nullptr )
     , m_Client( nullptr )
     , m_Cache( nullptr )
+    , m_CacheWriteQueue( nullptr )
+    , m_CachePrefetcher( nullptr )
+    , m_TieredCache( nullptr )
+    , m_CompressionDictionaries()
     , m_LastProgressOutputTime( 0.0f )
     , m_LastProgressCalcTime( 0.0f )
     , m_SmoothedProgressCurrent( 0.0f )
@@ -110,12 +121,25 @@ FBuild::~FBuild()
     FDELETE m_Client;
     FREE( m_EnvironmentString );
 
+    FDELETE m_CachePrefetcher; // Frees unconsumed results
+    FDELETE m_CacheWriteQueue; // Completes pending writes
+
     if ( m_Cache )
     {
         m_Cache->Shutdown();
         FDELETE m_Cache;
     }
 
+    // Free dictionaries once nothing can be using them
+    for ( CompressionDictionary * dictionary : m_CompressionDictionaries )
+    {
+        if ( dictionary )
+        {
+            CompressionDictionary::Unregister( dictionary );
+            FDELETE dictionary;
+        }
+    }
+
     // restore the old working dir to restore
     ASSERT( !m_OldWorkingDir.IsEmpty() );
     if ( !FileIO::SetCurrentDir( m_OldWorkingDir ) )
@@ -181,18 +205,31 @@ bool FBuild::Initialize( const char * nodeGraphDBFile )
 
     const SettingsNode * settings = m_DependencyGraph->GetSettings();
 
+    LoadCompressionDictionaries( settings );
+
     // if the cache is enabled, make sure the path is set and accessible
-    if ( m_Options.m_UseCacheRead || m_Options.m_UseCacheWrite || m_Options.m_CacheInfo || m_Options.m_CacheTrim )
+    if ( m_Options.m_UseCacheRead || m_Options.m_UseCacheWrite || m_Options.m_CacheInfo || m_Options.m_CacheTrim || m_Options.m_CacheTrain || m_Options.m_CacheVerify )
     {
         if ( !settings->GetCachePluginDLL().IsEmpty() )
         {
             m_Cache = FNEW( CachePlugin( settings->GetCachePluginDLL() ) );
         }
+        else if ( settings->GetCachePacked() )
+        {
+            m_Cache = FNEW( PackedCache() );
+        }
         else
         {
             m_Cache = FNEW( Cache() );
         }
 
+        // Local cache in front of the shared cache?
+        if ( settings->GetCacheLocalPath().IsEmpty() == false )
+        {
+            m_TieredCache = FNEW( TieredCache( m_Cache, settings->GetCacheLocalPath(), settings->GetCacheLocalSizeMiB(), m_Options.m_CacheWriteSync ) );
+            m_Cache = m_TieredCache;
+        }
+
         if ( m_Cache->Init( settings->GetCachePath(),
                             settings->GetCachePathMountPoint(),
                             m_Options.m_UseCacheRead,
@@ -204,6 +241,18 @@ bool FBuild::Initialize( const char * nodeGraphDBFile )
             m_Options.m_UseCacheWrite = false;
             FDELETE m_Cache;
             m_Cache = nullptr;
+            m_TieredCache = nullptr;
+        }
+        else
+        {
+            if ( m_Options.m_UseCacheWrite && ( m_Options.m_CacheWriteSync == false ) )
+            {
+                m_CacheWriteQueue = FNEW( CacheWriteQueue( m_Cache, m_Options.m_CacheVerbose ) );
+            }
+            if ( m_Options.m_UseCacheRead && m_Options.m_CachePrefetch )
+            {
+                m_CachePrefetcher = FNEW( CachePrefetcher( m_Cache, m_Options.m_CachePrefetchWait_Debug ) );
+            }
         }
     }
 
@@ -287,6 +336,9 @@ bool FBuild::Build( const Array< AString > & targets )
     }
     proxy.m_StaticDependencies = deps;
 
+    // discard any build pass state from a previous build
+    m_DependencyGraph->ResetBuildPasses();
+
     // build all targets in one sweep
     const bool result = Build( &proxy );
 
@@ -313,6 +365,13 @@ bool FBuild::SaveDependencyGraph( const char * nodeGraphDBFile ) const
 
     const Timer t;
 
+    // Append changes to the journal instead of rewriting the whole DB if possible
+    if ( m_Options.m_JournalDB && m_DependencyGraph->SaveJournal( nodeGraphDBFile ) )
+    {
+        FLOG_VERBOSE( "Saving DepGraph Journal Complete in %2.3fs", (double)t.GetElapsed() );
+        return true;
+    }
+
     // serialize into memory first
     MemoryStream memoryStream( 32 * 1024 * 1024, 8 * 1024 * 1024 );
     m_DependencyGraph->Save( memoryStream, nodeGraphDBFile );
@@ -348,6 +407,9 @@ bool FBuild::SaveDependencyGraph( const char * nodeGraphDBFile ) const
     }
     fileStream.Close();
 
+    // Subsequent changes can be journaled against this DB
+    m_DependencyGraph->OnSaved( nodeGraphDBFile, memoryStream );
+
     FLOG_VERBOSE( "Saving DepGraph Complete in %2.3fs", (double)t.GetElapsed() );
     return true;
 }
@@ -368,6 +430,11 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
     AtomicStoreRelaxed( &s_StopBuild, false ); // allow multiple runs in same process
     AtomicStoreRelaxed( &s_AbortBuild, false ); // allow multiple runs in same process
 
+    // re-use include parsing results from previous builds (if any)
+    AStackString<> lightCacheDataFile( m_DependencyGraphFile );
+    lightCacheDataFile += ".lightcache";
+    LightCache::LoadPersistentData( lightCacheDataFile );
+
     // create worker threads
     m_JobQueue = FNEW( JobQueue( m_Options.m_NumWorkerThreads ) );
 
@@ -427,7 +494,7 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
 
             if ( !stopping )
             {
-                // do a sweep of the graph to create more jobs
+                // progress nodes unblocked by completed jobs to create more jobs
                 m_DependencyGraph->DoBuildPass( nodeToBuild );
             }
 
@@ -447,6 +514,10 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
                     // free the network distribution system (if there is one)
                     {
                         MutexHolder mh( m_ClientLifetimeMutex );
+                        if ( m_Client )
+                        {
+                            m_Client->GetConnectionStats( m_BuildStats.m_WorkerConnectionStats );
+                        }
                         FDELETE m_Client;
                         m_Client = nullptr;
                     }
@@ -496,6 +567,29 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
         FDELETE m_JobQueue;
         m_JobQueue = nullptr;
 
+        // discard any unused cache lookups
+        if ( m_CachePrefetcher )
+        {
+            m_CachePrefetcher->Flush();
+            m_CachePrefetcher->GetAndResetStats( m_BuildStats.m_CachePrefetchStats );
+        }
+
+        // complete any outstanding cache writes
+        if ( m_CacheWriteQueue )
+        {
+            m_CacheWriteQueue->Flush();
+            m_CacheWriteQueue->GetAndResetStats( m_BuildStats.m_CacheWriteStats );
+        }
+        if ( m_TieredCache )
+        {
+            m_TieredCache->Flush();
+            m_TieredCache->GetAndResetStats( m_BuildStats.m_TieredCacheStats );
+        }
+        if ( m_Cache )
+        {
+            m_Cache->GetAndResetVerifyStats( m_BuildStats.m_CacheVerifyStats );
+        }
+
         FLog::StopBuild();
     }
 
@@ -511,6 +605,7 @@ void FBuild::SaveDependencyGraph( MemoryStream & stream, const char* nodeGraphDB
     if ( m_Options.m_SaveDBOnCompletion )
     {
         SaveDependencyGraph( m_DependencyGraphFile.Get() );
+        LightCache::SavePersistentData( lightCacheDataFile );
     }
 
     // TODO:C Move this into BuildStats
@@ -898,6 +993,253 @@ bool FBuild::CacheTrim() const
     return false;
 }
 
+// CacheVerify
+//------------------------------------------------------------------------------
+bool FBuild::CacheVerify() const
+{
+    OUTPUT( "CacheVerify:\n" );
+    if ( m_Cache )
+    {
+        return m_Cache->Verify( m_Options.m_ShowProgress );
+    }
+
+    OUTPUT( "- Cache not configured\n" );
+    return false;
+}
+
+// CacheTrain
+//------------------------------------------------------------------------------
+bool FBuild::CacheTrain() const
+{
+    OUTPUT( "CacheTrain:\n" );
+
+    const SettingsNode * settings = m_DependencyGraph->GetSettings();
+    if ( settings->GetCompressionDictionaryPath().IsEmpty() )
+    {
+        OUTPUT( "- .CompressionDictionaryPath not set\n" );
+        return false;
+    }
+    AStackString<> path( settings->GetCompressionDictionaryPath() );
+    PathUtils::EnsureTrailingSlash( path );
+
+    // Train each type independently. Having no samples for one of them is
+    // not an error (no distributable objects for example)
+    const bool objectsOK = TrainObjectsDictionary( path );
+    const bool preprocessedOK = TrainPreprocessedDictionary( path );
+    return ( objectsOK && preprocessedOK );
+}
+
+// TrainObjectsDictionary
+//------------------------------------------------------------------------------
+bool FBuild::TrainObjectsDictionary( const AString & path ) const
+{
+    if ( m_Cache == nullptr )
+    {
+        OUTPUT( "- Cache not configured\n" );
+        return false;
+    }
+
+    // Sample recent entries
+    Array< AString > cacheIds;
+    if ( m_Cache->GetSampleIds( MAX_DICTIONARY_SAMPLES, cacheIds ) == false )
+    {
+        OUTPUT( "- Cache does not support listing entries\n" );
+        return false;
+    }
+    Array< const void * > samples( cacheIds.GetSize(), false );
+    Array< size_t > sampleSizes( cacheIds.GetSize(), false );
+    for ( const AString & cacheId : cacheIds )
+    {
+        void * data = nullptr;
+        size_t dataSize = 0;
+        if ( m_Cache->Retrieve( cacheId, data, dataSize ) == false )
+        {
+            continue; // Trimmed since being listed for example
+        }
+
+        // Train on the uncompressed contents
+        Compressor c;
+        if ( Compressor::IsValidData( data, dataSize ) && c.Decompress( data ) )
+        {
+            sampleSizes.Append( c.GetResultSize() );
+            samples.Append( c.ReleaseResult() );
+        }
+        m_Cache->FreeMemory( data, dataSize );
+    }
+
+    const bool result = TrainAndSaveDictionary( CompressionDictionary::OBJECTS, path, samples, sampleSizes );
+
+    for ( const void * sample : samples )
+    {
+        FREE( const_cast< void * >( sample ) );
+    }
+    return result;
+}
+
+// TrainPreprocessedDictionary
+//------------------------------------------------------------------------------
+bool FBuild::TrainPreprocessedDictionary( const AString & path ) const
+{
+    // Preprocessed output is not retained, but is dominated by the contents of
+    // the headers included by most objects, so sample those instead
+    Array< const Node * > headers( 64 * 1024, true );
+    const size_t numNodes = m_DependencyGraph->GetNodeCount();
+    for ( size_t i = 0; i < numNodes; ++i )
+    {
+        const Node * node = m_DependencyGraph->GetNodeByIndex( i );
+        if ( node->GetType() != Node::OBJECT_NODE )
+        {
+            continue;
+        }
+        for ( const Dependency & dep : node->GetDynamicDependencies() )
+        {
+            if ( dep.GetNode()->GetType() == Node::FILE_NODE )
+            {
+                headers.Append( dep.GetNode() );
+            }
+        }
+    }
+
+    // Count uses of each header
+    struct HeaderUses
+    {
+        bool operator < ( const HeaderUses & other ) const { return ( m_Uses > other.m_Uses ); } // Most used first
+        const Node *    m_Node;
+        uint32_t        m_Uses;
+    };
+    headers.Sort();
+    Array< HeaderUses > uses( headers.GetSize(), false );
+    for ( const Node * header : headers )
+    {
+        if ( uses.IsEmpty() || ( uses.Top().m_Node != header ) )
+        {
+            uses.Append( HeaderUses{ header, 0 } );
+        }
+        uses.Top().m_Uses++;
+    }
+    uses.Sort();
+
+    // Read the most commonly included headers
+    Array< const void * > samples( MAX_DICTIONARY_SAMPLES, false );
+    Array< size_t > sampleSizes( MAX_DICTIONARY_SAMPLES, false );
+    for ( const HeaderUses & header : uses )
+    {
+        if ( ( samples.GetSize() == MAX_DICTIONARY_SAMPLES ) || ( header.m_Uses < 2 ) )
+        {
+            break; // Only headers shared between objects are useful
+        }
+        FileStream fs;
+        if ( fs.Open( header.m_Node->GetName().Get(), FileStream::READ_ONLY ) == false )
+        {
+            continue; // Deleted since last build for example
+        }
+        const size_t fileSize = (size_t)fs.GetFileSize();
+        if ( fileSize == 0 )
+        {
+            continue;
+        }
+        void * data = ALLOC( fileSize );
+        if ( fs.ReadBuffer( data, fileSize ) != fileSize )
+        {
+            FREE( data );
+            continue;
+        }
+        samples.Append( data );
+        sampleSizes.Append( fileSize );
+    }
+
+    const bool result = TrainAndSaveDictionary( CompressionDictionary::PREPROCESSED, path, samples, sampleSizes );
+
+    for ( const void * sample : samples )
+    {
+        FREE( const_cast< void * >( sample ) );
+    }
+    return result;
+}
+
+// TrainAndSaveDictionary
+//------------------------------------------------------------------------------
+/*static*/ bool FBuild::TrainAndSaveDictionary( CompressionDictionary::Type type,
+                                                const AString & path,
+                                                const Array< const void * > & samples,
+                                                const Array< size_t > & sampleSizes )
+{
+    const char * typeName = CompressionDictionary::GetTypeName( type );
+    if ( samples.IsEmpty() )
+    {
+        OUTPUT( "- %s: No samples available\n", typeName );
+        return true;
+    }
+
+    CompressionDictionary * dictionary = CompressionDictionary::Train( type, samples, sampleSizes );
+    if ( dictionary == nullptr )
+    {
+        OUTPUT( "- %s: Samples have no common content (%u samples)\n", typeName, (uint32_t)samples.GetSize() );
+        return true;
+    }
+
+    AStackString<> fileName( path );
+    fileName += CompressionDictionary::GetFileName( type );
+    const bool saved = dictionary->Save( fileName );
+    if ( saved )
+    {
+        OUTPUT( "- %s: %u samples -> %u KiB dictionary (id %016" PRIX64 ") : %s\n", typeName,
+                                                                                    (uint32_t)samples.GetSize(),
+                                                                                    (uint32_t)( ( dictionary->GetSize() + 1023 ) / 1024 ),
+                                                                                    dictionary->GetId(),
+                                                                                    fileName.Get() );
+    }
+    else
+    {
+        OUTPUT( "- %s: Failed to write '%s'. Error: %s\n", typeName, fileName.Get(), LAST_ERROR_STR );
+    }
+    FDELETE dictionary;
+    return saved;
+}
+
+// LoadCompressionDictionaries
+//------------------------------------------------------------------------------
+void FBuild::LoadCompressionDictionaries( const SettingsNode * settings )
+{
+    if ( settings->GetCompressionDictionaryPath().IsEmpty() )
+    {
+        return;
+    }
+    AStackString<> path( settings->GetCompressionDictionaryPath() );
+    PathUtils::EnsureTrailingSlash( path );
+
+    for ( uint32_t type = 0; type < CompressionDictionary::NUM_TYPES; ++type )
+    {
+        if ( m_CompressionDictionaries[ type ] )
+        {
+            continue; // Already loaded (daemon)
+        }
+
+        // Dictionaries are optional (not yet trained for example)
+        AStackString<> fileName( path );
+        fileName += CompressionDictionary::GetFileName( (CompressionDictionary::Type)type );
+        CompressionDictionary * dictionary = CompressionDictionary::Load( fileName );
+        if ( dictionary == nullptr )
+        {
+            continue;
+        }
+        if ( dictionary->GetType() != type )
+        {
+            FLOG_WARN( "Ignoring compression dictionary with mismatched type: '%s'", fileName.Get() );
+            FDELETE dictionary;
+            continue;
+        }
+        if ( CompressionDictionary::Register( dictionary ) == false )
+        {
+            FLOG_WARN( "Compression dictionary could not be registered. Ignoring '%s'", fileName.Get() );
+            FDELETE dictionary;
+            continue;
+        }
+        FLOG_VERBOSE( "Loaded compression dictionary (id %016" PRIX64 ") '%s'", dictionary->GetId(), fileName.Get() );
+        m_CompressionDictionaries[ type ] = dictionary;
+    }
+}
+
 // GetNumWorkerConnections
 //------------------------------------------------------------------------------
 uint32_t FBuild::GetNumWorkerConnections() const
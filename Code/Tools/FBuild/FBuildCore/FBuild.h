@@ -8,6 +8,7 @@
 #include "Tools/FBuild/FBuildCore/BFF/BFFUserFunctions.h"
 #include "Tools/FBuild/FBuildCore/FBuildOptions.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+#include "Tools/FBuild/FBuildCore/Helpers/CompressionDictionary.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/WorkerBrokerageClient.h"
 #include "Helpers/FBuildStats.h"
 
@@ -19,6 +20,9 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class CachePrefetcher;
+class CacheWriteQueue;
+class TieredCache;
 class Client;
 class Dependencies;
 class FileStream;
@@ -105,19 +109,36 @@ public:
     static inline volatile bool * GetAbortBuildPointer() { return &s_AbortBuild; }
 
     inline ICache * GetCache() const { return m_Cache; }
+    inline CacheWriteQueue * GetCacheWriteQueue() const { return m_CacheWriteQueue; }
+    inline CachePrefetcher * GetCachePrefetcher() const { return m_CachePrefetcher; }
+    inline const CompressionDictionary * GetCompressionDictionary( CompressionDictionary::Type type ) const { return m_CompressionDictionaries[ type ]; }
 
     static bool GetTempDir( AString & outTempDir );
 
     bool CacheOutputInfo() const;
     bool CacheTrim() const;
+    bool CacheTrain() const;
+    bool CacheVerify() const;
 
     uint32_t GetNumWorkerConnections() const;
 
 protected:
+    friend class BuildDaemon; // Keeps the FBuild resident between builds
+
     bool GetTargets( const Array< AString > & targets, Dependencies & outDeps ) const;
 
     void UpdateBuildStatus( const Node * node );
 
+    void LoadCompressionDictionaries( const SettingsNode * settings );
+    bool TrainObjectsDictionary( const AString & path ) const;
+    bool TrainPreprocessedDictionary( const AString & path ) const;
+    static bool TrainAndSaveDictionary( CompressionDictionary::Type type,
+                                        const AString & path,
+                                        const Array< const void * > & samples,
+                                        const Array< size_t > & sampleSizes );
+
+    enum : uint32_t { MAX_DICTIONARY_SAMPLES = 256 };
+
     static bool s_StopBuild;
     static volatile bool s_AbortBuild;  // -fastcancel - TODO:C merge with StopBuild
 
@@ -128,6 +149,10 @@ protected:
 
     AString m_DependencyGraphFile;
     ICache * m_Cache;
+    CacheWriteQueue * m_CacheWriteQueue; // Background cache publishing (if enabled)
+    CachePrefetcher * m_CachePrefetcher; // Background cache lookups (if enabled)
+    TieredCache * m_TieredCache; // m_Cache, if using a local cache in front of the shared cache
+    CompressionDictionary * m_CompressionDictionaries[ CompressionDictionary::NUM_TYPES ]; // Loaded from .CompressionDictionaryPath (if available)
 
     Timer m_Timer;
     float m_LastProgressOutputTime;
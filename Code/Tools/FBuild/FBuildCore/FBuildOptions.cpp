@@ -131,6 +131,11 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_CacheInfo = true;
                 continue;
             }
+            else if ( thisArg == "-cachetrain" )
+            {
+                m_CacheTrain = true;
+                continue;
+            }
             else if ( thisArg == "-cachetrim" )
             {
                 const int sizeIndex = ( i + 1 );
@@ -148,11 +153,26 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_Args += argv[ sizeIndex ];
                 continue;
             }
+            else if ( thisArg == "-cacheverify" )
+            {
+                m_CacheVerify = true;
+                continue;
+            }
             else if ( thisArg == "-cacheverbose" )
             {
                 m_CacheVerbose = true;
                 continue;
             }
+            else if ( thisArg == "-cacheprefetch" )
+            {
+                m_CachePrefetch = true;
+                continue;
+            }
+            else if ( thisArg == "-cachewritesync" )
+            {
+                m_CacheWriteSync = true;
+                continue;
+            }
             else if ( thisArg == "-cachecompressionlevel" )
             {
                 const int sizeIndex = ( i + 1 );
@@ -229,6 +249,16 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                     continue;
                 }
             #endif
+            else if ( thisArg == "-daemon" )
+            {
+                m_DaemonMode = true;
+                continue;
+            }
+            else if ( thisArg == "-dbjournal" )
+            {
+                m_JournalDB = true;
+                continue;
+            }
             else if ( thisArg == "-dist" )
             {
                 m_AllowDistributed = true;
@@ -404,6 +434,11 @@ FBuildOptions::OptionsResult FBuildOptions::ProcessCommandLine( int argc, char *
                 m_ShowSummary = true;
                 continue;
             }
+            else if ( thisArg == "-usedaemon" )
+            {
+                m_UseDaemon = true;
+                continue;
+            }
             else if ( thisArg == "-verbose" )
             {
                 m_ShowVerbose = true;
@@ -598,6 +633,9 @@ void FBuildOptions::SetWorkingDir( const AString & path )
     m_ProcessMutexName.Format( "Global\\FASTBuild-0x%08x", m_WorkingDirHash );
     m_FinalProcessMutexName.Format( "Global\\FASTBuild_Final-0x%08x", m_WorkingDirHash );
     m_SharedMemoryName.Format( "FASTBuildSharedMemory_%08x", m_WorkingDirHash );
+    m_DaemonMutexName.Format( "Global\\FASTBuild_Daemon-0x%08x", m_WorkingDirHash );
+    m_DaemonClientMutexName.Format( "Global\\FASTBuild_DaemonClient-0x%08x", m_WorkingDirHash );
+    m_DaemonSharedMemoryName.Format( "FASTBuildDaemon_%08x", m_WorkingDirHash );
 }
 
 // DisplayHelp
@@ -617,13 +655,26 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             "                   - ==  0 : disable compression\n"
             "                   - >=  1 : more compression, with 12 being the highest\n"
             " -cacheinfo        Output cache statistics.\n"
+            " -cacheprefetch    Look up cache entries for objects in the background as\n"
+            "                   soon as they are ready to build (LightCache only).\n"
+            " -cachetrain       Train compression dictionaries from the contents of the\n"
+            "                   cache and the most commonly included headers.\n"
+            "                   Requires .CompressionDictionaryPath.\n"
             " -cachetrim <size> Trim the cache to the given size in MiB.\n"
             " -cacheverbose     Emit details about cache interactions.\n"
+            " -cacheverify      Check the integrity of every cache entry, moving corrupt\n"
+            "                   entries aside.\n"
+            " -cachewritesync   Write to the cache from build threads instead of in the\n"
+            "                   background.\n"
             " -clean            Force a clean build.\n"
             " -compdb           Generate JSON compilation database for targets.\n"
             " -config <path>    Explicitly specify the config file to use.\n"
             " -continueafterdbmove\n"
             "       Allow builds after a DB move.\n"
+            " -daemon           Stay resident, watching for file changes and serving\n"
+            "                   builds requested with -usedaemon.\n"
+            " -dbjournal        Save changes to the DB incrementally, rewriting it only\n"
+            "                   periodically.\n"
             " -debug            (Windows) Break at startup, to attach debugger.\n"
             " -dist             Allow distributed compilation.\n"
             " -distverbose      Print detailed info for distributed compilation.\n"
@@ -662,6 +713,7 @@ void FBuildOptions::DisplayHelp( const AString & programName ) const
             " -showtargets      Display primary targets, excluding those marked \"Hidden\".\n"
             " -showalltargets   Display primary targets, including those marked \"Hidden\".\n"
             " -summary          Show a summary at the end of the build.\n"
+            " -usedaemon        Build using a running -daemon (if available).\n"
             " -verbose          Show detailed diagnostic info. (Increases built time)\n"
             " -version          Print version and exit.\n"
             " -vs               VisualStudio mode. Same as -ide.\n"
@@ -54,6 +54,8 @@ public:
     bool        m_StopOnFirstError                  = true;
     bool        m_FastCancel                        = true;
     bool        m_WaitMode                          = false;
+    bool        m_DaemonMode                        = false; // Stay resident, serving -usedaemon builds
+    bool        m_UseDaemon                         = false; // Build via a running -daemon if available
     bool        m_DisplayTargetList                 = false;
     bool        m_ShowHiddenTargets                 = false;
     bool        m_DisplayDependencyDB               = false;
@@ -68,7 +70,12 @@ public:
     bool        m_CacheInfo                         = false;
     bool        m_CacheVerbose                      = false;
     uint32_t    m_CacheTrim                         = 0;
+    bool        m_CacheTrain                        = false; // Train compression dictionaries (see .CompressionDictionaryPath)
+    bool        m_CacheVerify                       = false;
     int16_t     m_CacheCompressionLevel             = -1; // See Compresssor.h
+    bool        m_CacheWriteSync                    = false; // Publish on the producing thread instead of in the background
+    bool        m_CachePrefetch                     = false; // Look up cache entries for queued objects in the background
+    bool        m_CachePrefetchWait_Debug           = false; // Build threads wait for prefetching instead of bypassing it (for tests)
 
     // Distributed Compilation
     bool        m_AllowDistributed                  = false;
@@ -99,6 +106,7 @@ public:
     bool        m_FixupErrorPaths                   = false;
     bool        m_ForceDBMigration_Debug            = false; // Force migration even if bff has not changed (for tests)
     bool        m_ContinueAfterDBMove               = false;
+    bool        m_JournalDB                         = false; // Append changes to a journal instead of rewriting DB
 
     uint32_t    m_NumWorkerThreads                  = 0; // True default detected in constructor
     AString     m_ConfigFile;
@@ -107,6 +115,9 @@ public:
     inline const AString & GetMainProcessMutexName() const      { return m_ProcessMutexName; }
     inline const AString & GetFinalProcessMutexName( ) const    { return m_FinalProcessMutexName; }
     inline const AString & GetSharedMemoryName() const          { return m_SharedMemoryName; }
+    inline const AString & GetDaemonMutexName() const           { return m_DaemonMutexName; }
+    inline const AString & GetDaemonClientMutexName() const     { return m_DaemonClientMutexName; }
+    inline const AString & GetDaemonSharedMemoryName() const    { return m_DaemonSharedMemoryName; }
 
 private:
     void DisplayHelp( const AString & programName ) const;
@@ -117,6 +128,9 @@ private:
     AString     m_ProcessMutexName;
     AString     m_FinalProcessMutexName;
     AString     m_SharedMemoryName;
+    AString     m_DaemonMutexName;
+    AString     m_DaemonClientMutexName;
+    AString     m_DaemonSharedMemoryName;
 };
 
 //------------------------------------------------------------------------------
@@ -32,6 +32,7 @@ REFLECT_NODE_BEGIN( CompilerNode, Node, MetaNone() )
     REFLECT( m_CompilerFamilyString,"CompilerFamily",       MetaOptional() )
     REFLECT_ARRAY( m_Environment,   "Environment",          MetaOptional() )
     REFLECT( m_UseLightCache,       "UseLightCache_Experimental", MetaOptional() )
+    REFLECT( m_UseDependencyCacheKey, "UseDependencyCacheKey_Experimental", MetaOptional() )
     REFLECT( m_UseRelativePaths,    "UseRelativePaths_Experimental", MetaOptional() )
     REFLECT( m_SourceMapping,       "SourceMapping_Experimental", MetaOptional() )
 
@@ -55,6 +56,7 @@ CompilerNode::CompilerNode()
     , m_CompilerFamilyEnum( static_cast< uint8_t >( CUSTOM ) )
     , m_SimpleDistributionMode( false )
     , m_UseLightCache( false )
+    , m_UseDependencyCacheKey( false )
     , m_UseRelativePaths( false )
     , m_EnvironmentString( nullptr )
 {
@@ -140,6 +142,13 @@ CompilerNode::CompilerNode()
         return false;
     }
 
+    // Dependency based cache keys rely on GCC/Clang style -M output
+    if ( m_UseDependencyCacheKey && ( m_CompilerFamilyEnum != GCC ) && ( m_CompilerFamilyEnum != CLANG ) )
+    {
+        Error::Error_1505_DependencyCacheKeyIncompatibleWithCompiler( iter, function );
+        return false;
+    }
+
     m_Manifest.Initialize( m_ExecutableRootPath, m_StaticDependencies, m_CustomEnvironmentVariables );
 
     return true;
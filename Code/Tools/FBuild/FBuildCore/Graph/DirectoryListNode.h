@@ -20,6 +20,7 @@ public:
     virtual ~DirectoryListNode() override;
 
     const AString & GetPath() const { return m_Path; }
+    bool IsRecursive() const { return m_Recursive; }
     const Array< FileIO::FileInfo > & GetFiles() const { return m_Files; }
 
     static inline Node::Type GetTypeS() { return Node::DIRECTORY_LIST_NODE; }
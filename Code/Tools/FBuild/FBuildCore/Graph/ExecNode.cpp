@@ -10,6 +10,7 @@
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/NodeOutputCache.h"
 
 #include "Core/Env/ErrorFormat.h"
 #include "Core/FileIO/FileIO.h"
@@ -35,6 +36,7 @@ REFLECT_NODE_BEGIN( ExecNode, Node, MetaName( "ExecOutput" ) + MetaFile() )
     REFLECT(        m_ExecAlwaysShowOutput,     "ExecAlwaysShowOutput",     MetaOptional() )
     REFLECT(        m_ExecUseStdOutAsOutput,    "ExecUseStdOutAsOutput",    MetaOptional() )
     REFLECT(        m_ExecAlways,               "ExecAlways",               MetaOptional() )
+    REFLECT(        m_ExecAllowCaching,         "ExecAllowCaching",         MetaOptional() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
     REFLECT_ARRAY(  m_Environment,              "Environment",              MetaOptional() )
 
@@ -50,6 +52,7 @@ ExecNode::ExecNode()
     , m_ExecAlwaysShowOutput( false )
     , m_ExecUseStdOutAsOutput( false )
     , m_ExecAlways( false )
+    , m_ExecAllowCaching( false )
     , m_ExecInputPathRecurse( true )
     , m_NumExecInputFiles( 0 )
 {
@@ -183,6 +186,29 @@ ExecNode::~ExecNode()
     AStackString< 4 * KILOBYTE > fullArgs;
     GetFullArgs(fullArgs);
 
+    // Try to retrieve the output from the cache
+    Array< AString > outputFiles;
+    outputFiles.Append( m_Name );
+    NodeOutputCache outputCache( *this, "Run", outputFiles );
+    bool useCache = false;
+    if ( m_ExecAllowCaching && FBuild::Get().GetCache() )
+    {
+        // The output depends on the working dir and how success is determined too
+        AStackString< 4 * KILOBYTE > cacheArgs;
+        cacheArgs.Format( "%s|%s|%i|%u", fullArgs.Get(), m_ExecWorkingDir.Get(), m_ExecReturnCode, (uint32_t)m_ExecUseStdOutAsOutput );
+        for ( const AString & envVar : m_Environment )
+        {
+            cacheArgs += '|';
+            cacheArgs += envVar;
+        }
+        useCache = outputCache.BuildCacheId( GetExecutable()->GetName(), cacheArgs );
+        if ( useCache && outputCache.Retrieve() )
+        {
+            RecordStampFromBuiltFile();
+            return NODE_RESULT_OK_CACHE;
+        }
+    }
+
     const char * environment = Node::GetEnvironmentString( m_Environment, m_EnvironmentString );
 
     EmitCompilationMessage( fullArgs );
@@ -246,6 +272,11 @@ ExecNode::~ExecNode()
         f.Close();
     }
 
+    if ( useCache )
+    {
+        outputCache.Store();
+    }
+
     // record new file time
     RecordStampFromBuiltFile();
 
@@ -25,6 +25,7 @@ public:
 private:
     virtual bool DoDynamicDependencies( NodeGraph & nodeGraph, bool forceClean ) override;
     virtual bool DetermineNeedToBuildStatic() const override;
+    virtual bool AlwaysNeedsChecking() const override { return m_ExecAlways; }
     virtual BuildResult DoBuild( Job * job ) override;
 
     const FileNode * GetExecutable() const { return m_StaticDependencies[0].GetNode()->CastTo< FileNode >(); }
@@ -47,6 +48,7 @@ private:
     bool                m_ExecAlwaysShowOutput;
     bool                m_ExecUseStdOutAsOutput;
     bool                m_ExecAlways;
+    bool                m_ExecAllowCaching;
     bool                m_ExecInputPathRecurse;
     Array< AString >    m_PreBuildDependencyNames;
     Array< AString >    m_Environment;
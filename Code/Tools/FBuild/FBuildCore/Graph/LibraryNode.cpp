@@ -17,6 +17,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/ObjectListNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Args.h"
+#include "Tools/FBuild/FBuildCore/Helpers/NodeOutputCache.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ResponseFile.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 
@@ -35,6 +36,7 @@ REFLECT_NODE_BEGIN( LibraryNode, ObjectListNode, MetaName( "LibrarianOutput" ) +
     REFLECT_ARRAY( m_LibrarianAdditionalInputs, "LibrarianAdditionalInputs",    MetaOptional() + MetaFile() + MetaAllowNonFile( Node::OBJECT_LIST_NODE ) )
     REFLECT( m_LibrarianAllowResponseFile,      "LibrarianAllowResponseFile",   MetaOptional() )
     REFLECT( m_LibrarianForceResponseFile,      "LibrarianForceResponseFile",   MetaOptional() )   
+    REFLECT( m_LibrarianAllowCaching,           "LibrarianAllowCaching",        MetaOptional() )
 
     REFLECT( m_NumLibrarianAdditionalInputs,    "NumLibrarianAdditionalInputs", MetaHidden() )
     REFLECT( m_LibrarianFlags,                  "LibrarianFlags",               MetaHidden() )
@@ -48,6 +50,7 @@ LibraryNode::LibraryNode()
 , m_LibrarianType( "auto" )
 , m_LibrarianAllowResponseFile( false )
 , m_LibrarianForceResponseFile( false )
+, m_LibrarianAllowCaching( false )
 {
     m_Type = LIBRARY_NODE;
     m_LastBuildTimeMs = 10000; // TODO:C Reduce this when dynamic deps are saved
@@ -164,6 +167,20 @@ LibraryNode::~LibraryNode()
         return NODE_RESULT_FAILED; // BuildArgs will have emitted an error
     }
 
+    // Try to retrieve the library from the cache
+    // (response file paths vary, so the raw args are used for the key)
+    Array< AString > outputFiles;
+    outputFiles.Append( m_Name );
+    NodeOutputCache outputCache( *this, "Lib", outputFiles );
+    const bool useCache = m_LibrarianAllowCaching &&
+                          FBuild::Get().GetCache() &&
+                          outputCache.BuildCacheId( m_Librarian, fullArgs.GetRawArgs() );
+    if ( useCache && outputCache.Retrieve() )
+    {
+        RecordStampFromBuiltFile();
+        return NODE_RESULT_OK_CACHE;
+    }
+
     // use the exe launch dir as the working dir
     const char * workingDir = nullptr;
 
@@ -227,6 +244,11 @@ LibraryNode::~LibraryNode()
         }
     }
 
+    if ( useCache )
+    {
+        outputCache.Store();
+    }
+
     // record new file time
     RecordStampFromBuiltFile();
 
@@ -62,6 +62,7 @@ private:
     Array< AString >    m_Environment;
     bool                m_LibrarianAllowResponseFile;
     bool                m_LibrarianForceResponseFile;
+    bool                m_LibrarianAllowCaching;
 
     // Internal State
     uint32_t            m_NumLibrarianAdditionalInputs  = 0;
@@ -22,6 +22,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/LibraryNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ListDependenciesNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+#include "Tools/FBuild/FBuildCore/Graph/NodeMap.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeProxy.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectListNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
@@ -47,7 +48,6 @@
 #include "Core/FileIO/FileIO.h"
 #include "Core/FileIO/IOStream.h"
 #include "Core/FileIO/PathUtils.h"
-#include "Core/Math/CRC32.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/Mutex.h"
 #include "Core/Profile/Profile.h"
@@ -189,6 +189,13 @@ Node::~Node() = default;
     return DetermineNeedToBuild( m_StaticDependencies );
 }
 
+// AlwaysNeedsChecking
+//------------------------------------------------------------------------------
+/*virtual*/ bool Node::AlwaysNeedsChecking() const
+{
+    return ( ( m_ControlFlags & FLAG_ALWAYS_BUILD ) != 0 );
+}
+
 // DetermineNeedToBuildDynamic
 //------------------------------------------------------------------------------
 /*virtual*/ bool Node::DetermineNeedToBuildDynamic() const
@@ -391,6 +398,40 @@ void Node::SetLastBuildTime( uint32_t ms )
         return n;
     }
 
+    LoadState( stream, n );
+    return n;
+}
+
+// LoadInto
+//------------------------------------------------------------------------------
+/*static*/ bool Node::LoadInto( Node * node, ConstMemoryStream & stream )
+{
+    // read type
+    uint8_t nodeType;
+    VERIFY( stream.Read( nodeType ) );
+
+    // Name of node
+    AStackString<> name;
+    VERIFY( stream.Read( name ) );
+
+    // Must be the node which was saved
+    if ( ( nodeType != node->GetType() ) || ( name != node->GetName() ) )
+    {
+        return false;
+    }
+
+    // FileNodes have nothing else saved
+    if ( nodeType != Node::FILE_NODE )
+    {
+        LoadState( stream, node );
+    }
+    return true;
+}
+
+// LoadState
+//------------------------------------------------------------------------------
+/*static*/ void Node::LoadState( ConstMemoryStream & stream, Node * node )
+{
     // Read stamp
     uint64_t stamp;
     VERIFY( stream.Read( stamp ) );
@@ -398,14 +439,13 @@ void Node::SetLastBuildTime( uint32_t ms )
     // Build time
     uint32_t lastTimeToBuild;
     VERIFY( stream.Read( lastTimeToBuild ) );
-    n->SetLastBuildTime( lastTimeToBuild );    
+    node->SetLastBuildTime( lastTimeToBuild );
 
     // Deserialize properties
-    Deserialize( stream, n, *n->GetReflectionInfoV() );
+    Deserialize( stream, node, *node->GetReflectionInfoV() );
 
     // set stamp
-    n->m_Stamp = stamp;
-    return n;
+    node->m_Stamp = stamp;
 }
 
 // LoadDependencies
@@ -759,7 +799,7 @@ void Node::SetLastBuildTime( uint32_t ms )
 void Node::SetName( const AString & name )
 {
     m_Name = name;
-    m_NameCRC = CRC32::CalcLower( name );
+    m_NameHash = NodeMap::CalcNameHash( name );
 }
 
 // ReplaceDummyName
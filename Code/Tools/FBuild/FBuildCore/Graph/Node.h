@@ -102,6 +102,7 @@ public:
         STATS_BUILT_REMOTE  = 0x40, // node was built remotely
         STATS_FAILED        = 0x80, // node needed building, but failed
         STATS_FIRST_BUILD   = 0x100,// node has never been built before
+        STATS_DEPENDENCY_CACHE_KEY = 0x200, // cache key was formed from the compiler's dependency output
     };
 
     enum BuildResult
@@ -127,7 +128,7 @@ public:
     virtual bool Initialize( NodeGraph & nodeGraph, const BFFToken * funcStartIter, const Function * function ) = 0;
     virtual ~Node();
 
-    inline uint32_t        GetNameCRC() const { return m_NameCRC; }
+    inline uint64_t        GetNameHash() const { return m_NameHash; }
     inline Type GetType() const { return m_Type; }
     inline const char * GetTypeName() const { return s_NodeTypeNames[ m_Type ]; }
     inline static const char * GetTypeName( Type t ) { return s_NodeTypeNames[ t ]; }
@@ -152,6 +153,7 @@ public:
 
     static Node *   CreateNode( NodeGraph & nodeGraph, Node::Type nodeType, const AString & name );
     static Node *   Load( NodeGraph & nodeGraph, ConstMemoryStream & stream );
+    static bool     LoadInto( Node * node, ConstMemoryStream & stream ); // Reload existing node (type & name must match)
     static void     LoadDependencies( NodeGraph & nodeGraph, Node * node, ConstMemoryStream & stream );
     static void     Save( IOStream & stream, const Node * node );
     static void     SaveDependencies( IOStream & stream, const Node * node );
@@ -191,6 +193,7 @@ protected:
     friend class JobQueue;
     friend class JobQueueRemote;
     friend class NodeGraph;
+    friend class NodeOutputCache;
     friend class ProjectGeneratorBase; // TODO:C Remove this
     friend class Report;
     friend class VSProjectConfig; // TODO:C Remove this
@@ -210,6 +213,7 @@ protected:
     // each node implements a subset of these as needed
     virtual bool DetermineNeedToBuildStatic() const;
     virtual bool DetermineNeedToBuildDynamic() const;
+    virtual bool AlwaysNeedsChecking() const; // Re-checked every build, even if no inputs changed (see NodeGraph::InvalidateNodes)
     virtual bool DoDynamicDependencies( NodeGraph & nodeGraph, bool forceClean );
     virtual BuildResult DoBuild( Job * job );
     virtual BuildResult DoBuild2( Job * job, bool racingRemoteJob );
@@ -231,6 +235,7 @@ protected:
     static void Serialize( IOStream & stream, const void * base, const ReflectedProperty & property );
     static void Deserialize( ConstMemoryStream & stream, void * base, const ReflectionInfo & ri );
     static void Deserialize( ConstMemoryStream & stream, void * base, const ReflectedProperty & property );
+    static void LoadState( ConstMemoryStream & stream, Node * node );
 
     virtual void Migrate( const Node & oldNode );
 
@@ -254,14 +259,16 @@ protected:
     uint64_t            m_Stamp = 0;                // "Stamp" representing this node for dependency comparissons
     uint8_t             m_ControlFlags;             // Control build behavior special cases - Set by constructor
     bool                m_Hidden = false;           // Hidden from -showtargets?
-    // Note: Unused 2 bytes here
+    bool                m_ChangedSinceSave = false; // Node needs writing to the DB journal (see NodeGraph::SaveJournal)
+    // Note: Unused 1 byte here
     uint32_t            m_RecursiveCost = 0;        // Recursive cost used during task ordering
-    Node *              m_Next = nullptr;           // Node map in-place linked list pointer
-    uint32_t            m_NameCRC;                  // Hash of mName. **Set by constructor**
+    uint64_t            m_NameHash;                 // Hash of m_Name for NodeMap. **Set by constructor**
     uint32_t            m_LastBuildTimeMs = 0;      // Time it took to do last known full build of this node
     uint32_t            m_ProcessingTime = 0;       // Time spent on this node during this build
     uint32_t            m_CachingTime = 0;          // Time spent caching this node
     mutable uint32_t    m_ProgressAccumulator = 0;  // Used to estimate build progress percentage
+    uint32_t            m_NumBlockingDependencies = 0; // Dependencies this node is waiting on in the current build
+    Array< Node * >     m_BlockedNodes;             // Nodes waiting on this node to complete in the current build
 
     Dependencies        m_PreBuildDependencies;
     Dependencies        m_StaticDependencies;
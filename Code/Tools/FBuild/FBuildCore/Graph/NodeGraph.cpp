@@ -45,7 +45,6 @@
 #include "Core/FileIO/FileStream.h"
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
-#include "Core/Math/CRC32.h"
 #include "Core/Math/xxHash.h"
 #include "Core/Mem/Mem.h"
 #include "Core/Process/Thread.h"
@@ -78,18 +77,30 @@ bool NodeGraphHeader::IsValid() const
     return true;
 }
 
+// IsValid (NodeGraphJournalHeader)
+//------------------------------------------------------------------------------
+bool NodeGraphJournalHeader::IsValid() const
+{
+    // Check header token and version are valid
+    return ( m_Identifier[ 0 ] == 'N' ) &&
+           ( m_Identifier[ 1 ] == 'G' ) &&
+           ( m_Identifier[ 2 ] == 'J' ) &&
+           ( m_Version == NodeGraphHeader::NODE_GRAPH_CURRENT_VERSION );
+}
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 NodeGraph::NodeGraph( unsigned nodeMapHashBits )
-: m_NodeMapMaxKey( ( 1u << nodeMapHashBits ) - 1u )
+: m_NodeMap( nodeMapHashBits )
 , m_AllNodes( 1024, true )
 , m_UsedFiles( 16, true )
 , m_Settings( nullptr )
+, m_JournalBaseContentHash( 0 )
+, m_JournalBaseSize( 0 )
+, m_JournalSize( 0 )
+, m_JournalNumNodes( 0 )
+, m_NeedsFullSave( true ) // Until loaded from or saved to a DB
 {
-    ASSERT( nodeMapHashBits > 0 && nodeMapHashBits < 32 );
-    m_NodeMap = FNEW_ARRAY( Node * [ m_NodeMapMaxKey + 1 ] );
-    memset( m_NodeMap, 0, sizeof( Node * ) * ( m_NodeMapMaxKey + 1 ) );
-
     #if defined( ENABLE_FAKE_SYSTEM_FAILURE )
         // Ensure debug flag doesn't linger between test runs
         ASSERT( ObjectNode::GetFakeSystemFailureForNextJob() == false );
@@ -104,8 +115,6 @@ NodeGraph::~NodeGraph()
     {
         FDELETE( node );
     }
-
-    FDELETE_ARRAY( m_NodeMap );
 }
 
 // Initialize
@@ -253,6 +262,12 @@ NodeGraph::LoadResult NodeGraph::Load( const char * nodeGraphDBFile )
     {
         FLOG_ERROR( "Database corrupt (clean build will occur): '%s'", nodeGraphDBFile );
     }
+    else if ( ( res == LoadResult::OK ) || ( res == LoadResult::OK_BFF_NEEDS_REPARSING ) )
+    {
+        // Apply changes saved incrementally since the DB was last written
+        const NodeGraphHeader * header = reinterpret_cast< const NodeGraphHeader * >( memory.Get() );
+        LoadJournal( nodeGraphDBFile, *header, fileSize );
+    }
     return res;
 }
 
@@ -277,6 +292,7 @@ NodeGraph::LoadResult NodeGraph::Load( ConstMemoryStream & stream, const char *
 
     // Take not of whether we need to reparse
     bool bffNeedsReparsing = false;
+    bool usedFilesUpdated = false;
 
     // check if any files used have changed
     for ( size_t i=0; i<usedFiles.GetSize(); ++i )
@@ -311,6 +327,7 @@ NodeGraph::LoadResult NodeGraph::Load( ConstMemoryStream & stream, const char *
         {
             // file didn't change, update stored timestamp to save time on the next run
             usedFiles[ i ].m_TimeStamp = timeStamp;
+            usedFilesUpdated = true;
             continue;
         }
 
@@ -323,6 +340,7 @@ NodeGraph::LoadResult NodeGraph::Load( ConstMemoryStream & stream, const char *
     }
 
     m_UsedFiles = usedFiles;
+    m_NeedsFullSave = usedFilesUpdated; // Updated timestamps are only stored by a full save
 
     // TODO:C The serialization of these settings doesn't really belong here (not part of node graph)
 
@@ -546,6 +564,251 @@ void NodeGraph::Save( MemoryStream & stream, const char* nodeGraphDBFile ) const
     }
 }
 
+// OnSaved
+//------------------------------------------------------------------------------
+void NodeGraph::OnSaved( const char * nodeGraphDBFile, const MemoryStream & stream )
+{
+    // Subsequent changes can be journaled against this DB
+    const NodeGraphHeader * header = static_cast< const NodeGraphHeader * >( stream.GetData() );
+    m_JournalBaseDBFile = nodeGraphDBFile;
+    m_JournalBaseContentHash = header->GetContentHash();
+    m_JournalBaseSize = stream.GetSize();
+    m_JournalSize = 0;
+    m_JournalNumNodes = m_AllNodes.GetSize();
+    m_NeedsFullSave = false;
+
+    // Everything is saved
+    for ( Node * node : m_AllNodes )
+    {
+        node->m_ChangedSinceSave = false;
+    }
+
+    // Any previous journal is now obsolete
+    AStackString<> journalFileName;
+    GetJournalFileName( nodeGraphDBFile, journalFileName );
+    if ( FileIO::FileExists( journalFileName.Get() ) )
+    {
+        FileIO::FileDelete( journalFileName.Get() );
+    }
+}
+
+// SaveJournal
+//------------------------------------------------------------------------------
+bool NodeGraph::SaveJournal( const char * nodeGraphDBFile )
+{
+    PROFILE_FUNCTION;
+
+    // Journal can only be appended to the DB we loaded or last saved, and
+    // can only record changes to existing nodes
+    if ( m_NeedsFullSave ||
+         ( m_JournalBaseDBFile != nodeGraphDBFile ) ||
+         ( m_AllNodes.GetSize() != m_JournalNumNodes ) )
+    {
+        return false;
+    }
+
+    // Dependencies are saved by node index
+    Array< Node * > changedNodes( 1024, true );
+    uint32_t index = 0;
+    for ( Node * node : m_AllNodes )
+    {
+        node->SetBuildPassTag( index++ );
+        if ( node->m_ChangedSinceSave )
+        {
+            changedNodes.Append( node );
+        }
+    }
+
+    // Nothing to do?
+    if ( changedNodes.IsEmpty() )
+    {
+        return true;
+    }
+
+    // Serialize changed nodes, leaving space for the record header
+    MemoryStream record( 64 * 1024, 64 * 1024 );
+    record.Write( (uint32_t)0 ); // Payload size
+    record.Write( (uint64_t)0 ); // Payload hash
+    const size_t recordHeaderSize = record.GetSize();
+    record.Write( (uint32_t)changedNodes.GetSize() );
+    for ( const Node * node : changedNodes )
+    {
+        record.Write( node->GetBuildPassTag() );
+        Node::Save( record, node );
+        Node::SaveDependencies( record, node );
+    }
+
+    // Compact the journal (by doing a full save) once it grows large relative to the DB
+    if ( ( m_JournalSize + record.GetSize() ) > ( m_JournalBaseSize / 2 ) )
+    {
+        return false;
+    }
+
+    // Fill in the record header so torn or corrupt records can be detected on load
+    {
+        char * data = static_cast< char * >( record.GetDataMutable() );
+        const uint32_t payloadSize = (uint32_t)( record.GetSize() - recordHeaderSize );
+        const uint64_t payloadHash = xxHash3::Calc64( data + recordHeaderSize, payloadSize );
+        memcpy( data, &payloadSize, sizeof( payloadSize ) );
+        memcpy( data + sizeof( payloadSize ), &payloadHash, sizeof( payloadHash ) );
+    }
+
+    // Append to the journal, creating it if needed
+    AStackString<> journalFileName;
+    GetJournalFileName( nodeGraphDBFile, journalFileName );
+    const bool newJournal = ( m_JournalSize == 0 );
+    FileStream fs;
+    if ( fs.Open( journalFileName.Get(), newJournal ? FileStream::WRITE_ONLY : ( FileStream::WRITE_ONLY | FileStream::APPEND ) ) == false )
+    {
+        return false;
+    }
+    if ( newJournal )
+    {
+        const NodeGraphJournalHeader header( m_JournalBaseContentHash );
+        if ( fs.WriteBuffer( &header, sizeof( header ) ) != sizeof( header ) )
+        {
+            return false;
+        }
+        m_JournalSize += sizeof( header );
+    }
+    if ( fs.WriteBuffer( record.GetData(), record.GetSize() ) != record.GetSize() )
+    {
+        m_NeedsFullSave = true; // Journal may be partially written
+        return false;
+    }
+    m_JournalSize += record.GetSize();
+
+    for ( Node * node : changedNodes )
+    {
+        node->m_ChangedSinceSave = false;
+    }
+    return true;
+}
+
+// GetJournalFileName
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::GetJournalFileName( const char * nodeGraphDBFile, AString & outJournalFileName )
+{
+    outJournalFileName = nodeGraphDBFile;
+    outJournalFileName += ".journal";
+}
+
+// LoadJournal
+//------------------------------------------------------------------------------
+void NodeGraph::LoadJournal( const char * nodeGraphDBFile, const NodeGraphHeader & header, size_t dbSize )
+{
+    PROFILE_FUNCTION;
+
+    // Subsequent changes can be journaled against this DB
+    m_JournalBaseDBFile = nodeGraphDBFile;
+    m_JournalBaseContentHash = header.GetContentHash();
+    m_JournalBaseSize = dbSize;
+    m_JournalSize = 0;
+    m_JournalNumNodes = m_AllNodes.GetSize();
+
+    AStackString<> journalFileName;
+    GetJournalFileName( nodeGraphDBFile, journalFileName );
+    if ( FileIO::FileExists( journalFileName.Get() ) == false )
+    {
+        return; // No changes since DB was saved
+    }
+
+    FileStream fs;
+    if ( fs.Open( journalFileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        m_NeedsFullSave = true; // Rewrite DB and discard the journal
+        return;
+    }
+    const size_t journalSize = (size_t)fs.GetFileSize();
+    UniquePtr< char > memory( (char *)ALLOC( journalSize ) );
+    if ( fs.ReadBuffer( memory.Get(), journalSize ) != journalSize )
+    {
+        m_NeedsFullSave = true;
+        return;
+    }
+
+    // Journal must have been written against this DB
+    const NodeGraphJournalHeader * journalHeader = reinterpret_cast< const NodeGraphJournalHeader * >( memory.Get() );
+    if ( ( journalSize < sizeof( NodeGraphJournalHeader ) ) ||
+         ( journalHeader->IsValid() == false ) ||
+         ( journalHeader->GetBaseContentHash() != m_JournalBaseContentHash ) )
+    {
+        FLOG_WARN( "Database journal is stale and will be ignored: '%s'", journalFileName.Get() );
+        m_NeedsFullSave = true;
+        return;
+    }
+
+    // Apply each record in order
+    const char * data = memory.Get();
+    size_t pos = sizeof( NodeGraphJournalHeader );
+    const size_t recordHeaderSize = ( sizeof( uint32_t ) + sizeof( uint64_t ) );
+    while ( pos < journalSize )
+    {
+        // Check record is complete and uncorrupted. An interrupted save
+        // can leave a partial record, which we discard (along with anything after it).
+        // Affected nodes will see old dependency stamps and rebuild.
+        uint32_t payloadSize = 0;
+        uint64_t payloadHash = 0;
+        if ( ( journalSize - pos ) >= recordHeaderSize )
+        {
+            memcpy( &payloadSize, data + pos, sizeof( payloadSize ) );
+            memcpy( &payloadHash, data + pos + sizeof( payloadSize ), sizeof( payloadHash ) );
+        }
+        const char * payload = ( data + pos + recordHeaderSize );
+        if ( ( ( journalSize - pos ) < recordHeaderSize ) ||
+             ( ( journalSize - pos - recordHeaderSize ) < payloadSize ) ||
+             ( xxHash3::Calc64( payload, payloadSize ) != payloadHash ) )
+        {
+            FLOG_WARN( "Database journal is incomplete (some targets may rebuild): '%s'", journalFileName.Get() );
+            m_NeedsFullSave = true;
+            return;
+        }
+
+        ConstMemoryStream record( payload, payloadSize );
+        if ( ApplyJournalRecord( record ) == false )
+        {
+            FLOG_WARN( "Database journal does not match database (some targets may rebuild): '%s'", journalFileName.Get() );
+            m_NeedsFullSave = true;
+            return;
+        }
+        pos += ( recordHeaderSize + payloadSize );
+    }
+    m_JournalSize = journalSize;
+}
+
+// ApplyJournalRecord
+//------------------------------------------------------------------------------
+bool NodeGraph::ApplyJournalRecord( ConstMemoryStream & stream )
+{
+    uint32_t numNodes = 0;
+    VERIFY( stream.Read( numNodes ) );
+    for ( uint32_t i = 0; i < numNodes; ++i )
+    {
+        uint32_t index = 0;
+        VERIFY( stream.Read( index ) );
+        if ( index >= m_AllNodes.GetSize() )
+        {
+            return false;
+        }
+
+        // Replace saved state of node
+        Node * node = m_AllNodes[ index ];
+        if ( Node::LoadInto( node, stream ) == false )
+        {
+            return false;
+        }
+        if ( node->GetType() != Node::FILE_NODE )
+        {
+            node->m_PreBuildDependencies.Clear();
+            node->m_StaticDependencies.Clear();
+            node->m_DynamicDependencies.Clear();
+            Node::LoadDependencies( *this, node, stream );
+            node->PostLoad( *this );
+        }
+    }
+    return true;
+}
+
 // SerializeToText
 //------------------------------------------------------------------------------
 void NodeGraph::SerializeToText( const Dependencies & deps, AString & outBuffer ) const
@@ -1098,22 +1361,28 @@ TextFileNode* NodeGraph::CreateTextFileNode( const AString& nodeName )
 //------------------------------------------------------------------------------
 void NodeGraph::AddNode( Node * node )
 {
-    ASSERT( Thread::IsMainThread() );
+    ASSERT( Thread::IsMainThread() ); // m_AllNodes is not locked
 
     ASSERT( node );
 
-    ASSERT( FindNodeInternal( node->GetName() ) == nullptr ); // node name must be unique
-
-    // track in NodeMap
-    const uint32_t crc = CRC32::CalcLower( node->GetName() );
-    const size_t key = ( crc & m_NodeMapMaxKey );
-    node->m_Next = m_NodeMap[ key ];
-    m_NodeMap[ key ] = node;
+    // track in NodeMap (thread-safe, so other threads can look up nodes)
+    VERIFY( m_NodeMap.Insert( node ) ); // node name must be unique
 
     // add to list
     m_AllNodes.Append( node );
 }
 
+// MarkChanged
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::MarkChanged( Node * node )
+{
+    // FileNodes have no saved state which can change
+    if ( node->GetType() != Node::FILE_NODE )
+    {
+        node->m_ChangedSinceSave = true;
+    }
+}
+
 // Build
 //------------------------------------------------------------------------------
 void NodeGraph::DoBuildPass( Node * nodeToBuild )
@@ -1122,43 +1391,61 @@ void NodeGraph::DoBuildPass( Node * nodeToBuild )
 
     s_BuildPassTag++;
 
-    if ( nodeToBuild->GetType() == Node::PROXY_NODE )
+    JobQueue & jobQueue = JobQueue::Get();
+    for ( ;; )
     {
-        const size_t total = nodeToBuild->GetStaticDependencies().GetSize();
-        size_t failedCount = 0;
-        size_t upToDateCount = 0;
-        for ( const Dependency & dep : nodeToBuild->GetStaticDependencies() )
+        // Re-check nodes whose blocking dependencies completed since the last pass
+        ProcessReadyNodes();
+
+        // Only the first pass walks the graph from the root. Nodes which are unable
+        // to progress register themselves with the dependencies blocking them and
+        // are revisited via ProcessReadyNodes once those complete.
+        if ( nodeToBuild->GetType() == Node::PROXY_NODE )
         {
-            Node * n = dep.GetNode();
-            if ( n->GetState() < Node::BUILDING )
+            const size_t total = nodeToBuild->GetStaticDependencies().GetSize();
+            size_t failedCount = 0;
+            size_t upToDateCount = 0;
+            for ( const Dependency & dep : nodeToBuild->GetStaticDependencies() )
             {
-                BuildRecurse( n, 0 );
+                Node * n = dep.GetNode();
+                if ( ( n->GetState() < Node::BUILDING ) && ( n->m_NumBlockingDependencies == 0 ) )
+                {
+                    BuildRecurse( n, 0 );
+                }
+
+                // check result of recursion (which may or may not be complete)
+                if ( n->GetState() == Node::UP_TO_DATE )
+                {
+                    upToDateCount++;
+                }
+                else if ( n->GetState() == Node::FAILED )
+                {
+                    failedCount++;
+                }
             }
 
-            // check result of recursion (which may or may not be complete)
-            if ( n->GetState() == Node::UP_TO_DATE )
+            // only mark as failed or completed when all children have reached their final state
+            if ( ( upToDateCount + failedCount ) == total )
             {
-                upToDateCount++;
+                // finished - mark with overall state
+                nodeToBuild->SetState( failedCount ? Node::FAILED : Node::UP_TO_DATE );
             }
-            else if ( n->GetState() == Node::FAILED )
+        }
+        else
+        {
+            if ( ( nodeToBuild->GetState() < Node::BUILDING ) && ( nodeToBuild->m_NumBlockingDependencies == 0 ) )
             {
-                failedCount++;
+                BuildRecurse( nodeToBuild, 0 );
             }
         }
 
-        // only mark as failed or completed when all children have reached their final state
-        if ( ( upToDateCount + failedCount ) == total )
-        {
-            // finished - mark with overall state
-            nodeToBuild->SetState( failedCount ? Node::FAILED : Node::UP_TO_DATE );
-        }
-    }
-    else
-    {
-        if ( nodeToBuild->GetState() < Node::BUILDING )
+        // FileNodes reached in this pass are stat'd together, rather than each
+        // via its own job. Nodes they unblock can then progress in this pass.
+        if ( jobQueue.HasFileNodesToStat() == false )
         {
-            BuildRecurse( nodeToBuild, 0 );
+            break;
         }
+        jobQueue.StatFileNodeBatch();
     }
 
     // Check for cyclice dependencies discoverable only at runtime
@@ -1168,7 +1455,328 @@ void NodeGraph::DoBuildPass( Node * nodeToBuild )
     }
 
     // Make available all the jobs we discovered in this pass
-    JobQueue::Get().FlushJobBatch();
+    jobQueue.FlushJobBatch();
+}
+
+// ResetBuildPasses
+//------------------------------------------------------------------------------
+void NodeGraph::ResetBuildPasses() const
+{
+    PROFILE_FUNCTION;
+
+    // Discard scheduling state from any previous (possibly aborted) build.
+    // Tags are also reset as a node skipped due to a stale tag would never be
+    // revisited, leaving anything blocked on it stuck.
+    const uint32_t passTag = s_BuildPassTag;
+    for ( Node * node : m_AllNodes )
+    {
+        node->SetBuildPassTag( passTag );
+        node->m_RecursiveCost = 0;
+        node->m_NumBlockingDependencies = 0;
+        node->m_BlockedNodes.Clear();
+    }
+}
+
+// InvalidateNodes
+//------------------------------------------------------------------------------
+bool NodeGraph::InvalidateNodes( const Array< AString > & changedFiles, const Array< AString > & changedDirs )
+{
+    PROFILE_FUNCTION;
+
+    // Anything beneath a changed directory is considered changed
+    Array< AString > changedDirPrefixes( changedDirs.GetSize(), true );
+    for ( const AString & changedDir : changedDirs )
+    {
+        AString & prefix = changedDirPrefixes.EmplaceBack( changedDir );
+        if ( prefix.EndsWith( NATIVE_SLASH ) == false )
+        {
+            prefix += NATIVE_SLASH;
+        }
+    }
+
+    // Changes to files used to generate the graph require the BFF to be re-parsed
+    for ( const UsedFile & usedFile : m_UsedFiles )
+    {
+        for ( const AString & changedFile : changedFiles )
+        {
+            if ( PathUtils::ArePathsEqual( usedFile.m_FileName, changedFile ) )
+            {
+                return false;
+            }
+        }
+        for ( const AString & changedDirPrefix : changedDirPrefixes )
+        {
+            if ( PathUtils::PathBeginsWith( usedFile.m_FileName, changedDirPrefix ) )
+            {
+                return false;
+            }
+        }
+    }
+
+    // Nodes which are UP_TO_DATE only depend on nodes which are UP_TO_DATE, so
+    // nodes in any other state (failed, or interrupted by an aborted build) can
+    // simply be reset. Everything else stays UP_TO_DATE unless affected by a change.
+    Array< Node * > dirtyNodes( 1024, true );
+    Array< const DirectoryListNode * > dirListNodes( 64, true );
+    for ( Node * node : m_AllNodes )
+    {
+        node->m_StatsFlags = 0; // Stats reflect the next build only
+
+        if ( node->GetState() != Node::UP_TO_DATE )
+        {
+            node->SetState( Node::NOT_PROCESSED );
+            continue;
+        }
+
+        const Node::Type type = node->GetType();
+        if ( type == Node::DIRECTORY_LIST_NODE )
+        {
+            dirListNodes.Append( node->CastTo< DirectoryListNode >() );
+            continue;
+        }
+        if ( ( type != Node::FILE_NODE ) &&
+             ( type != Node::ALIAS_NODE ) &&
+             node->AlwaysNeedsChecking() )
+        {
+            dirtyNodes.Append( node );
+            continue;
+        }
+
+        // Nodes for files (inputs or outputs) beneath changed directories
+        for ( const AString & changedDirPrefix : changedDirPrefixes )
+        {
+            if ( PathUtils::PathBeginsWith( node->GetName(), changedDirPrefix ) )
+            {
+                dirtyNodes.Append( node );
+                break;
+            }
+        }
+    }
+
+    // Nodes for the changed files (inputs or outputs)
+    for ( const AString & changedFile : changedFiles )
+    {
+        Node * node = FindNodeInternal( changedFile );
+        if ( node )
+        {
+            dirtyNodes.Append( node );
+        }
+    }
+
+    // Directory listings which could contain the changed files or directories,
+    // or which are beneath a changed directory
+    for ( const DirectoryListNode * dirListNode : dirListNodes )
+    {
+        const AString & path = dirListNode->GetPath();
+        bool dirty = false;
+        for ( const AString & changedDirPrefix : changedDirPrefixes )
+        {
+            if ( PathUtils::PathBeginsWith( path, changedDirPrefix ) )
+            {
+                dirty = true;
+                break;
+            }
+        }
+        const Array< AString > * const allChanges[] = { &changedFiles, &changedDirs };
+        for ( const Array< AString > * changes : allChanges )
+        {
+            for ( size_t i = 0; ( i < changes->GetSize() ) && ( dirty == false ); ++i )
+            {
+                const AString & changed = ( *changes )[ i ];
+                dirty = PathUtils::PathBeginsWith( changed, path ) &&
+                        ( dirListNode->IsRecursive() ||
+                          ( changed.Find( NATIVE_SLASH, changed.Get() + path.GetLength() ) == nullptr ) );
+            }
+        }
+        if ( dirty )
+        {
+            dirtyNodes.Append( const_cast< DirectoryListNode * >( dirListNode ) );
+        }
+    }
+    if ( dirtyNodes.IsEmpty() )
+    {
+        return true; // Nothing changed
+    }
+
+    // Build a map of dependents for each node (indexed via the build pass tag)
+    const uint32_t numNodes = (uint32_t)m_AllNodes.GetSize();
+    Array< uint32_t > firstDependent;
+    firstDependent.SetSize( numNodes + 1 );
+    memset( firstDependent.Begin(), 0, firstDependent.GetSize() * sizeof( uint32_t ) );
+    for ( uint32_t i = 0; i < numNodes; ++i )
+    {
+        m_AllNodes[ i ]->SetBuildPassTag( i );
+    }
+    for ( const Node * node : m_AllNodes )
+    {
+        const Dependencies * const allDeps[] = { &node->m_PreBuildDependencies, &node->m_StaticDependencies, &node->m_DynamicDependencies };
+        for ( const Dependencies * deps : allDeps )
+        {
+            for ( const Dependency & dep : *deps )
+            {
+                firstDependent[ dep.GetNode()->GetBuildPassTag() + 1 ]++;
+            }
+        }
+    }
+    for ( uint32_t i = 0; i < numNodes; ++i )
+    {
+        firstDependent[ i + 1 ] += firstDependent[ i ];
+    }
+    Array< uint32_t > nextDependent( firstDependent );
+    Array< Node * > dependents;
+    dependents.SetSize( firstDependent[ numNodes ] );
+    for ( Node * node : m_AllNodes )
+    {
+        const Dependencies * const allDeps[] = { &node->m_PreBuildDependencies, &node->m_StaticDependencies, &node->m_DynamicDependencies };
+        for ( const Dependencies * deps : allDeps )
+        {
+            for ( const Dependency & dep : *deps )
+            {
+                dependents[ nextDependent[ dep.GetNode()->GetBuildPassTag() ]++ ] = node;
+            }
+        }
+    }
+
+    // Invalidate dirty nodes and everything which depends on them
+    while ( dirtyNodes.IsEmpty() == false )
+    {
+        Node * node = dirtyNodes.Top();
+        dirtyNodes.Pop();
+        if ( node->GetState() != Node::UP_TO_DATE )
+        {
+            continue; // Already invalidated
+        }
+        node->SetState( Node::NOT_PROCESSED );
+
+        const uint32_t index = node->GetBuildPassTag();
+        for ( uint32_t i = firstDependent[ index ]; i < firstDependent[ index + 1 ]; ++i )
+        {
+            if ( dependents[ i ]->GetState() == Node::UP_TO_DATE )
+            {
+                dirtyNodes.Append( dependents[ i ] );
+            }
+        }
+    }
+
+    return true;
+}
+
+// GetDirectoriesToWatch
+//------------------------------------------------------------------------------
+void NodeGraph::GetDirectoriesToWatch( size_t firstNodeIndex, Array< AString > & outDirs, Array< bool > & outRecursive ) const
+{
+    // Directories are returned in the order encountered, skipping only
+    // consecutive duplicates (the caller ignores directories already watched)
+    auto addParentDir = [ & ]( const AString & fileName )
+    {
+        const char * lastSlash = fileName.FindLast( NATIVE_SLASH );
+        if ( lastSlash == nullptr )
+        {
+            return;
+        }
+        const AStackString<> dir( fileName.Get(), lastSlash );
+        if ( outDirs.IsEmpty() || ( outDirs.Top() != dir ) )
+        {
+            outDirs.Append( dir );
+            outRecursive.Append( false );
+        }
+    };
+
+    // Files used to generate the graph
+    if ( firstNodeIndex == 0 )
+    {
+        for ( const UsedFile & usedFile : m_UsedFiles )
+        {
+            addParentDir( usedFile.m_FileName );
+        }
+    }
+
+    // Inputs and outputs of nodes
+    for ( size_t i = firstNodeIndex; i < m_AllNodes.GetSize(); ++i )
+    {
+        const Node * node = m_AllNodes[ i ];
+        if ( node->GetType() == Node::DIRECTORY_LIST_NODE )
+        {
+            const DirectoryListNode * dirListNode = node->CastTo< DirectoryListNode >();
+            outDirs.Append( dirListNode->GetPath() );
+            outRecursive.Append( dirListNode->IsRecursive() );
+        }
+        else if ( node->IsAFile() )
+        {
+            addParentDir( node->GetName() );
+        }
+    }
+}
+
+// OnNodeCompleted
+//------------------------------------------------------------------------------
+/*static*/ void NodeGraph::OnNodeCompleted( Node * node )
+{
+    ASSERT( ( node->GetState() == Node::UP_TO_DATE ) || ( node->GetState() == Node::FAILED ) );
+
+    if ( node->m_BlockedNodes.IsEmpty() )
+    {
+        return;
+    }
+
+    // Take ownership of the list, as failures below can recurse
+    Array< Node * > blockedNodes;
+    blockedNodes.Swap( node->m_BlockedNodes );
+
+    const bool failed = ( node->GetState() == Node::FAILED );
+    const bool stopOnFirstError = FBuild::Get().GetOptions().m_StopOnFirstError;
+
+    for ( Node * blockedNode : blockedNodes )
+    {
+        // Already resolved by another dependency?
+        if ( blockedNode->GetState() >= Node::BUILDING )
+        {
+            continue;
+        }
+
+        ASSERT( blockedNode->m_NumBlockingDependencies > 0 );
+        --blockedNode->m_NumBlockingDependencies;
+
+        if ( failed && stopOnFirstError )
+        {
+            // propogate failure state immediately (as CheckDependencies would)
+            blockedNode->SetState( Node::FAILED );
+            OnNodeCompleted( blockedNode );
+            continue;
+        }
+
+        // All blocking dependencies complete? Node can now progress.
+        if ( blockedNode->m_NumBlockingDependencies == 0 )
+        {
+            JobQueue::Get().AddReadyNode( blockedNode );
+        }
+    }
+}
+
+// ProcessReadyNodes
+//------------------------------------------------------------------------------
+void NodeGraph::ProcessReadyNodes()
+{
+    const uint32_t passTag = s_BuildPassTag;
+
+    // Progressing nodes can complete others, so the list can grow as we go
+    JobQueue & jobQueue = JobQueue::Get();
+    while ( Node * node = jobQueue.GetReadyNode() )
+    {
+        // Node may have been progressed via another node since it became
+        // ready, in which case it is either complete or blocked again
+        if ( ( node->GetState() >= Node::BUILDING ) ||
+             ( node->m_NumBlockingDependencies > 0 ) )
+        {
+            continue;
+        }
+
+        // prevent additional recursions in this pass
+        node->SetBuildPassTag( passTag );
+
+        // Resume with the cost accumulated from the root when first visited
+        BuildRecurse( node, node->m_RecursiveCost - node->GetLastBuildTime() );
+    }
 }
 
 // BuildRecurse
@@ -1180,9 +1788,18 @@ void NodeGraph::BuildRecurse( Node * nodeToBuild, uint32_t cost )
     // already building, or queued to build?
     ASSERT( nodeToBuild->GetState() != Node::BUILDING );
 
+    // can't progress while waiting on dependencies
+    ASSERT( nodeToBuild->m_NumBlockingDependencies == 0 );
+
     // accumulate recursive cost
     cost += nodeToBuild->GetLastBuildTime();
 
+    // ensure deepest traversal cost is kept
+    if ( cost > nodeToBuild->m_RecursiveCost )
+    {
+        nodeToBuild->m_RecursiveCost = cost;
+    }
+
     // check pre-build dependencies
     if ( nodeToBuild->GetState() == Node::NOT_PROCESSED )
     {
@@ -1235,11 +1852,13 @@ void NodeGraph::BuildRecurse( Node * nodeToBuild, uint32_t cost )
                 nodeToBuild->SetStatFlag( Node::STATS_FIRST_BUILD );
             }
             nodeToBuild->m_Stamp = 0;
+            MarkChanged( nodeToBuild );
 
             // Regenerate dynamic dependencies
             if ( nodeToBuild->DoDynamicDependencies( *this, forceClean ) == false )
             {
                 nodeToBuild->SetState( Node::FAILED );
+                OnNodeCompleted( nodeToBuild );
                 return;
             }
 
@@ -1269,6 +1888,7 @@ void NodeGraph::BuildRecurse( Node * nodeToBuild, uint32_t cost )
          nodeToBuild->DetermineNeedToBuildDynamic() )
     {
         nodeToBuild->m_RecursiveCost = cost;
+        MarkChanged( nodeToBuild );
         JobQueue::Get().AddJobToBatch( nodeToBuild );
     }
     else
@@ -1278,6 +1898,7 @@ void NodeGraph::BuildRecurse( Node * nodeToBuild, uint32_t cost )
             FLOG_BUILD_REASON( "Up-To-Date '%s'\n", nodeToBuild->GetName().Get() );
         }
         nodeToBuild->SetState( Node::UP_TO_DATE );
+        OnNodeCompleted( nodeToBuild );
     }
 }
 
@@ -1303,8 +1924,10 @@ bool NodeGraph::CheckDependencies( Node * nodeToBuild, const Dependencies & depe
         // recurse into nodes which have not been processed yet
         if ( state < Node::BUILDING )
         {
-            // early out if already seen
-            if ( n->GetBuildPassTag() != passTag )
+            // early out if already seen, or if blocked on its own dependencies
+            // (it will be revisited when they complete)
+            if ( ( n->GetBuildPassTag() != passTag ) &&
+                 ( n->m_NumBlockingDependencies == 0 ) )
             {
                 // prevent multiple recursions in this pass
                 n->SetBuildPassTag( passTag );
@@ -1321,15 +1944,6 @@ bool NodeGraph::CheckDependencies( Node * nodeToBuild, const Dependencies & depe
             continue;
         }
 
-        if ( state == Node::BUILDING )
-        {
-            // ensure deepest traversal cost is kept
-            if ( cost > nodeToBuild->m_RecursiveCost )
-            {
-                nodeToBuild->m_RecursiveCost = cost;
-            }
-        }
-
         allDependenciesUpToDate = false;
 
         // dependency failed?
@@ -1340,10 +1954,16 @@ bool NodeGraph::CheckDependencies( Node * nodeToBuild, const Dependencies & depe
             {
                 // propogate failure state to this node
                 nodeToBuild->SetState( Node::FAILED );
+                OnNodeCompleted( nodeToBuild );
                 break;
             }
+            continue;
         }
 
+        // wait for the dependency to complete
+        n->m_BlockedNodes.Append( nodeToBuild );
+        ++nodeToBuild->m_NumBlockingDependencies;
+
         // keep trying to progress other nodes...
     }
 
@@ -1354,6 +1974,7 @@ bool NodeGraph::CheckDependencies( Node * nodeToBuild, const Dependencies & depe
             if ( numberNodesFailed > 0 )
             {
                 nodeToBuild->SetState( Node::FAILED );
+                OnNodeCompleted( nodeToBuild );
             }
         }
     }
@@ -1534,24 +2155,7 @@ void NodeGraph::SetBuildPassTagForAllNodes( uint32_t value ) const
 //------------------------------------------------------------------------------
 Node * NodeGraph::FindNodeInternal( const AString & fullPath ) const
 {
-    ASSERT( Thread::IsMainThread() );
-
-    const uint32_t crc = CRC32::CalcLower( fullPath );
-    const size_t key = ( crc & m_NodeMapMaxKey );
-
-    Node * n = m_NodeMap[ key ];
-    while ( n )
-    {
-        if ( n->GetNameCRC() == crc )
-        {
-            if ( n->GetName().CompareI( fullPath ) == 0 )
-            {
-                return n;
-            }
-        }
-        n = n->m_Next;
-    }
-    return nullptr;
+    return m_NodeMap.Find( fullPath );
 }
 
 // FindNearestNodesInternal
@@ -1569,74 +2173,71 @@ void NodeGraph::FindNearestNodesInternal( const AString & fullPath, Array< NodeW
 
     uint32_t worstMinDistance = fullPath.GetLength() + 1;
 
-    for ( size_t i = 0 ; i <= m_NodeMapMaxKey ; i++ )
+    for ( Node * node : m_AllNodes )
     {
-        for ( Node * node = m_NodeMap[i] ; nullptr != node ; node = node->m_Next )
-        {
-            const uint32_t d = LevenshteinDistance::DistanceI( fullPath, node->GetName() );
+        const uint32_t d = LevenshteinDistance::DistanceI( fullPath, node->GetName() );
 
-            if ( d > maxDistance )
-            {
-                continue;
-            }
+        if ( d > maxDistance )
+        {
+            continue;
+        }
 
-            // skips nodes which don't share any character with fullpath
-            if ( fullPath.GetLength() < node->GetName().GetLength() )
+        // skips nodes which don't share any character with fullpath
+        if ( fullPath.GetLength() < node->GetName().GetLength() )
+        {
+            if ( d > node->GetName().GetLength() - fullPath.GetLength() )
             {
-                if ( d > node->GetName().GetLength() - fullPath.GetLength() )
-                {
-                    continue; // completly different <=> d deletions
-                }
+                continue; // completly different <=> d deletions
             }
-            else
+        }
+        else
+        {
+            if ( d > fullPath.GetLength() - node->GetName().GetLength() )
             {
-                if ( d > fullPath.GetLength() - node->GetName().GetLength() )
-                {
-                    continue; // completly different <=> d deletions
-                }
+                continue; // completly different <=> d deletions
             }
+        }
 
-            if ( nodes.IsEmpty() )
+        if ( nodes.IsEmpty() )
+        {
+            nodes.EmplaceBack( node, d );
+            worstMinDistance = nodes.Top().m_Distance;
+        }
+        else if ( d >= worstMinDistance )
+        {
+            ASSERT( nodes.IsEmpty() || nodes.Top().m_Distance == worstMinDistance );
+            if ( false == nodes.IsAtCapacity() )
             {
                 nodes.EmplaceBack( node, d );
-                worstMinDistance = nodes.Top().m_Distance;
+                worstMinDistance = d;
             }
-            else if ( d >= worstMinDistance )
+        }
+        else
+        {
+            ASSERT( nodes.Top().m_Distance > d );
+            const size_t count = nodes.GetSize();
+
+            if ( false == nodes.IsAtCapacity() )
             {
-                ASSERT( nodes.IsEmpty() || nodes.Top().m_Distance == worstMinDistance );
-                if ( false == nodes.IsAtCapacity() )
-                {
-                    nodes.EmplaceBack( node, d );
-                    worstMinDistance = d;
-                }
+                nodes.EmplaceBack();
             }
-            else
-            {
-                ASSERT( nodes.Top().m_Distance > d );
-                const size_t count = nodes.GetSize();
 
-                if ( false == nodes.IsAtCapacity() )
+            size_t pos = count;
+            for ( ; pos > 0 ; pos-- )
+            {
+                if ( nodes[pos - 1].m_Distance <= d )
                 {
-                    nodes.EmplaceBack();
+                    break;
                 }
-
-                size_t pos = count;
-                for ( ; pos > 0 ; pos-- )
+                else if (pos < nodes.GetSize() )
                 {
-                    if ( nodes[pos - 1].m_Distance <= d )
-                    {
-                        break;
-                    }
-                    else if (pos < nodes.GetSize() )
-                    {
-                        nodes[pos] = nodes[pos - 1];
-                    }
+                    nodes[pos] = nodes[pos - 1];
                 }
-
-                ASSERT( pos < count );
-                nodes[pos] = NodeWithDistance( node, d );
-                worstMinDistance = nodes.Top().m_Distance;
             }
+
+            ASSERT( pos < count );
+            nodes[pos] = NodeWithDistance( node, d );
+            worstMinDistance = nodes.Top().m_Distance;
         }
     }
 }
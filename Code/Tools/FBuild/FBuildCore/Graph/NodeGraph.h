@@ -5,6 +5,7 @@
 // Includes
 //------------------------------------------------------------------------------
 #include "Tools/FBuild/FBuildCore/BFF/BFFFileExists.h"
+#include "Tools/FBuild/FBuildCore/Graph/NodeMap.h"
 #include "Tools/FBuild/FBuildCore/Helpers/SLNGenerator.h"
 #include "Tools/FBuild/FBuildCore/Helpers/VSProjectGenerator.h"
 
@@ -63,7 +64,7 @@ public:
     }
     inline ~NodeGraphHeader() = default;
 
-    enum : uint8_t { NODE_GRAPH_CURRENT_VERSION = 170 };
+    enum : uint8_t { NODE_GRAPH_CURRENT_VERSION = 177 };
 
     bool IsValid() const;
     bool IsCompatibleVersion() const { return m_Version == NODE_GRAPH_CURRENT_VERSION; }
@@ -77,6 +78,33 @@ private:
     uint64_t    m_ContentHash;      // Hash of data excluding this header
 };
 
+// NodeGraphJournalHeader
+//  - Header of the journal of changes appended since the DB was last saved in full
+//------------------------------------------------------------------------------
+class NodeGraphJournalHeader
+{
+public:
+    inline explicit NodeGraphJournalHeader( uint64_t baseContentHash = 0 )
+    {
+        m_Identifier[ 0 ] = 'N';
+        m_Identifier[ 1 ] = 'G';
+        m_Identifier[ 2 ] = 'J';
+        m_Version = NodeGraphHeader::NODE_GRAPH_CURRENT_VERSION;
+        m_Padding = 0;
+        m_BaseContentHash = baseContentHash;
+    }
+    inline ~NodeGraphJournalHeader() = default;
+
+    bool IsValid() const;
+
+    uint64_t    GetBaseContentHash() const { return m_BaseContentHash; }
+private:
+    char        m_Identifier[ 3 ];
+    uint8_t     m_Version;
+    uint32_t    m_Padding;          // Unused
+    uint64_t    m_BaseContentHash;  // Content hash of the DB the journal applies to
+};
+
 // NodeGraph
 //------------------------------------------------------------------------------
 class NodeGraph
@@ -99,10 +127,15 @@ public:
 
     LoadResult Load( ConstMemoryStream & stream, const char * nodeGraphDBFile );
     void Save( MemoryStream & stream, const char * nodeGraphDBFile ) const;
+    void OnSaved( const char * nodeGraphDBFile, const MemoryStream & stream );
+
+    // Incremental saving - append changed nodes to a journal instead of rewriting the DB
+    [[nodiscard]] bool SaveJournal( const char * nodeGraphDBFile );    // false if a full Save is needed
+    static void GetJournalFileName( const char * nodeGraphDBFile, AString & outJournalFileName );
     void SerializeToText( const Dependencies & dependencies, AString & outBuffer ) const;
     void SerializeToDotFormat( const Dependencies & deps, const bool fullGraph, AString & outBuffer ) const;
 
-    // access existing nodes
+    // access existing nodes (FindNode/FindNodeExact are thread-safe)
     Node * FindNode( const AString & nodeName ) const;
     Node * FindNodeExact( const AString & nodeName ) const;
     Node * GetNodeByIndex( size_t index ) const;
@@ -137,6 +170,14 @@ public:
     TextFileNode * CreateTextFileNode( const AString & name );
 
     void DoBuildPass( Node * nodeToBuild );
+    void ResetBuildPasses() const;
+    static void OnNodeCompleted( Node * node );
+
+    // Resident graphs (daemon mode) - re-evaluate only nodes affected by changed files
+    // and directories (anything beneath a changed directory is assumed to have changed)
+    [[nodiscard]] bool InvalidateNodes( const Array< AString > & changedFiles,
+                                        const Array< AString > & changedDirs ); // false if BFF must be re-parsed
+    void GetDirectoriesToWatch( size_t firstNodeIndex, Array< AString > & outDirs, Array< bool > & outRecursive ) const;
 
     // Non-build operations that use the BuildPassTag can set it to a known value
     void SetBuildPassTagForAllNodes( uint32_t value ) const;
@@ -155,10 +196,14 @@ private:
 
     bool ParseFromRoot( const char * bffFile );
 
-    void AddNode( Node * node );
+    void AddNode( Node * node ); // Main thread only (FindNode can be called concurrently)
+    static void MarkChanged( Node * node );
+    void LoadJournal( const char * nodeGraphDBFile, const NodeGraphHeader & header, size_t dbSize );
+    bool ApplyJournalRecord( ConstMemoryStream & stream );
 
     void BuildRecurse( Node * nodeToBuild, uint32_t cost );
     bool CheckDependencies( Node * nodeToBuild, const Dependencies & dependencies, uint32_t cost );
+    void ProcessReadyNodes();
     static void UpdateBuildStatusRecurse( const Node * node,
                                           uint32_t & nodesBuiltTime,
                                           uint32_t & totalNodeTime );
@@ -215,9 +260,8 @@ private:
     static bool AreNodesTheSame( const void * baseA, const void * baseB, const ReflectedProperty & property );
     static bool DoDependenciesMatch( const Dependencies & depsA, const Dependencies & depsB );
 
-    Node **         m_NodeMap;
-    uint32_t        m_NodeMapMaxKey; // Always equals to some power of 2 minus 1, can be used as mask.
-    Array< Node * > m_AllNodes;
+    NodeMap         m_NodeMap;
+    Array< Node * > m_AllNodes;         // Unsynchronized, so only modified on the main thread
 
     Timer m_Timer;
 
@@ -233,6 +277,14 @@ private:
 
     const SettingsNode * m_Settings;
 
+    // Incremental saving
+    AString         m_JournalBaseDBFile;        // DB which changes can be journaled against
+    uint64_t        m_JournalBaseContentHash;   // Content hash of that DB
+    uint64_t        m_JournalBaseSize;          // Size of that DB (journal is compacted relative to this)
+    uint64_t        m_JournalSize;              // Size of the journal so far
+    size_t          m_JournalNumNodes;          // Node count when that DB was written
+    bool            m_NeedsFullSave;            // Changes not representable in the journal were made
+
     static uint32_t s_BuildPassTag;
 };
 
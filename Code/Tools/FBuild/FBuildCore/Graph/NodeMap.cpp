@@ -0,0 +1,168 @@
+// NodeMap.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "NodeMap.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+
+// system
+#include <string.h> // for memset
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+NodeMap::NodeMap( uint32_t initialSizeBits )
+{
+    ASSERT( initialSizeBits > 0 && initialSizeBits < 32 );
+
+    // Initial size is spread over all the shards
+    const uint32_t totalSize = ( 1u << initialSizeBits );
+    const uint32_t shardSize = ( totalSize / NUM_SHARDS > MIN_SHARD_SIZE ) ? ( totalSize / NUM_SHARDS ) : MIN_SHARD_SIZE;
+    for ( Shard & shard : m_Shards )
+    {
+        shard.m_Entries = FNEW_ARRAY( Entry[ shardSize ] );
+        memset( shard.m_Entries, 0, sizeof( Entry ) * shardSize );
+        shard.m_Mask = ( shardSize - 1 );
+    }
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+NodeMap::~NodeMap()
+{
+    for ( Shard & shard : m_Shards )
+    {
+        FDELETE_ARRAY( shard.m_Entries );
+    }
+}
+
+// CalcNameHash
+//------------------------------------------------------------------------------
+/*static*/ uint64_t NodeMap::CalcNameHash( const AString & name )
+{
+    // Node names are case-insensitive
+    return xxHash3::Calc64Lower( name );
+}
+
+// Find
+//------------------------------------------------------------------------------
+Node * NodeMap::Find( const AString & name ) const
+{
+    return Find( name, CalcNameHash( name ) );
+}
+
+// Find
+//------------------------------------------------------------------------------
+Node * NodeMap::Find( const AString & name, uint64_t nameHash ) const
+{
+    const Shard & shard = GetShard( nameHash );
+    MutexHolder mh( shard.m_Mutex );
+    return FindInShard( shard, name, nameHash );
+}
+
+// Insert
+//------------------------------------------------------------------------------
+bool NodeMap::Insert( Node * node )
+{
+    ASSERT( node );
+
+    // name hash is calculated when name is set
+    const uint64_t nameHash = node->GetNameHash();
+    Shard & shard = GetShard( nameHash );
+    MutexHolder mh( shard.m_Mutex );
+
+    // node name must be unique
+    if ( FindInShard( shard, node->GetName(), nameHash ) )
+    {
+        return false;
+    }
+
+    // Keep load factor below 3/4 so probe sequences stay short
+    if ( ( ( shard.m_Count + 1 ) * 4 ) > ( ( shard.m_Mask + 1 ) * 3 ) )
+    {
+        Grow( shard );
+    }
+
+    InsertInShard( shard, nameHash, node );
+    shard.m_Count++;
+    return true;
+}
+
+// GetSize
+//------------------------------------------------------------------------------
+size_t NodeMap::GetSize() const
+{
+    size_t size = 0;
+    for ( const Shard & shard : m_Shards )
+    {
+        MutexHolder mh( shard.m_Mutex );
+        size += shard.m_Count;
+    }
+    return size;
+}
+
+// FindInShard
+//------------------------------------------------------------------------------
+/*static*/ Node * NodeMap::FindInShard( const Shard & shard, const AString & name, uint64_t nameHash )
+{
+    for ( uint32_t slot = (uint32_t)( nameHash & shard.m_Mask ) ; ; slot = ( ( slot + 1 ) & shard.m_Mask ) )
+    {
+        const Entry & entry = shard.m_Entries[ slot ];
+        if ( entry.m_Node == nullptr )
+        {
+            return nullptr; // Reached an empty slot
+        }
+        if ( ( entry.m_Hash == nameHash ) && ( entry.m_Node->GetName().CompareI( name ) == 0 ) )
+        {
+            return entry.m_Node;
+        }
+    }
+}
+
+// InsertInShard
+//------------------------------------------------------------------------------
+/*static*/ void NodeMap::InsertInShard( Shard & shard, uint64_t nameHash, Node * node )
+{
+    uint32_t slot = (uint32_t)( nameHash & shard.m_Mask );
+    while ( shard.m_Entries[ slot ].m_Node )
+    {
+        slot = ( ( slot + 1 ) & shard.m_Mask );
+    }
+    shard.m_Entries[ slot ].m_Hash = nameHash;
+    shard.m_Entries[ slot ].m_Node = node;
+}
+
+// Grow
+//------------------------------------------------------------------------------
+/*static*/ void NodeMap::Grow( Shard & shard )
+{
+    const uint32_t oldSize = ( shard.m_Mask + 1 );
+    const uint32_t newSize = ( oldSize * 2 );
+    ASSERT( newSize > oldSize ); // Overflow
+
+    Entry * oldEntries = shard.m_Entries;
+    shard.m_Entries = FNEW_ARRAY( Entry[ newSize ] );
+    memset( shard.m_Entries, 0, sizeof( Entry ) * newSize );
+    shard.m_Mask = ( newSize - 1 );
+
+    // Re-insert existing entries (stored hashes avoid re-hashing names)
+    for ( uint32_t i = 0; i < oldSize; ++i )
+    {
+        const Entry & entry = oldEntries[ i ];
+        if ( entry.m_Node )
+        {
+            InsertInShard( shard, entry.m_Hash, entry.m_Node );
+        }
+    }
+
+    FDELETE_ARRAY( oldEntries );
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,73 @@
+// NodeMap - Name to Node lookup for the NodeGraph
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+#include "Core/Process/Mutex.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+class Node;
+
+// NodeMap
+//  - Case-insensitive map of node names to nodes
+//  - Open addressing (linear probing) tables keyed on a 64-bit name hash, which
+//    grow automatically as nodes are added
+//  - Split into independently locked shards so lookups and insertions are
+//    thread-safe and can occur concurrently with little contention
+//------------------------------------------------------------------------------
+class NodeMap
+{
+public:
+    explicit NodeMap( uint32_t initialSizeBits );
+    ~NodeMap();
+
+    // Hash used to index nodes by name (as stored by Node::SetName)
+    [[nodiscard]] static uint64_t CalcNameHash( const AString & name );
+
+    [[nodiscard]] Node *    Find( const AString & name ) const;
+    [[nodiscard]] Node *    Find( const AString & name, uint64_t nameHash ) const;
+
+    // Returns false if a node with the same name already exists
+    [[nodiscard]] bool      Insert( Node * node );
+
+    [[nodiscard]] size_t    GetSize() const;
+
+private:
+    NodeMap( const NodeMap & ) = delete;
+    NodeMap & operator = ( const NodeMap & ) = delete;
+
+    enum : uint32_t
+    {
+        NUM_SHARD_BITS  = 6,
+        NUM_SHARDS      = ( 1u << NUM_SHARD_BITS ),
+        MIN_SHARD_SIZE  = 16,
+    };
+
+    struct Entry
+    {
+        uint64_t    m_Hash;
+        Node *      m_Node;     // nullptr for empty slots
+    };
+
+    struct Shard
+    {
+        mutable Mutex   m_Mutex;
+        Entry *         m_Entries = nullptr;
+        uint32_t        m_Mask = 0;         // Table size - 1 (size is always a power of 2)
+        uint32_t        m_Count = 0;
+    };
+
+    // Shard is selected from the upper bits of the hash and slot from the lower bits
+    Shard &         GetShard( uint64_t nameHash ) const { return m_Shards[ nameHash >> ( 64 - NUM_SHARD_BITS ) ]; }
+    static Node *   FindInShard( const Shard & shard, const AString & name, uint64_t nameHash );
+    static void     InsertInShard( Shard & shard, uint64_t nameHash, Node * node );
+    static void     Grow( Shard & shard );
+
+    mutable Shard   m_Shards[ NUM_SHARDS ];
+};
+
+//------------------------------------------------------------------------------
@@ -16,6 +16,7 @@
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/UnityNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/Args.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
 #include "Tools/FBuild/FBuildCore/BFF/BFFVariable.h"
 
 // Core
@@ -342,6 +343,38 @@ ObjectListNode::~ObjectListNode() = default;
     return false;
 }
 
+// DynamicObjectInput
+//  - An input file for which an ObjectNode is needed. The expensive parts
+//    (path cleaning, name generation, lookups and node construction) are done
+//    in parallel, then nodes are registered with the NodeGraph serially.
+//------------------------------------------------------------------------------
+struct ObjectListNode::DynamicObjectInput
+{
+    enum class Source : uint8_t
+    {
+        DIRECTORY_LIST,     // File from a DirectoryListNode (FileNode created if missing)
+        UNITY,              // Unity file (FileNode created if missing)
+        UNITY_ISOLATED,     // File isolated from a Unity (FileNode created if missing)
+        OBJECT_LIST,        // File compiled by another ObjectList (FileNode must exist)
+        FILE,               // File used as is
+    };
+
+    DynamicObjectInput( const AString & fileName, const AString & baseDir, Source source )
+        : m_FileName( &fileName )
+        , m_BaseDir( &baseDir )
+        , m_Source( source )
+    {}
+
+    const AString * m_FileName;                     // Input file as listed
+    const AString * m_BaseDir;
+    Source          m_Source;
+    Node *          m_FileNode = nullptr;           // Existing FileNode for input
+    AString         m_InputFileName;                // Cleaned input file name
+    AString         m_ObjectFileName;
+    Node *          m_ObjectNode = nullptr;         // Existing node for object
+    ObjectNode *    m_NewObjectNode = nullptr;      // Object node constructed (not yet registered) if none existed
+};
+
 // GatherDynamicDependencies
 //------------------------------------------------------------------------------
 /*virtual*/ bool ObjectListNode::GatherDynamicDependencies( NodeGraph & nodeGraph, bool forceClean )
@@ -351,136 +384,46 @@ ObjectListNode::~ObjectListNode() = default;
     // clear dynamic deps from previous passes
     m_DynamicDependencies.Clear();
 
-    // Handle converting all static inputs into dynamic onces (i.e. cpp->obj)
+    // Gather inputs from all static inputs (i.e. cpp->obj)
+    Array< DynamicObjectInput > inputs( m_CompilerInputFiles.GetSize(), true );
     for ( size_t i=m_ObjectListInputStartIndex; i<m_ObjectListInputEndIndex; ++i )
     {
-        const Dependency & dep = m_StaticDependencies[ i ];
+        const Node * node = m_StaticDependencies[ i ].GetNode();
 
-        // is this a dir list?
-        if ( dep.GetNode()->GetType() == Node::DIRECTORY_LIST_NODE )
+        if ( node->GetType() == Node::DIRECTORY_LIST_NODE )
         {
-            // get the list of files
-            const DirectoryListNode * dln = dep.GetNode()->CastTo< DirectoryListNode >();
+            const DirectoryListNode * dln = node->CastTo< DirectoryListNode >();
             const Array< FileIO::FileInfo > & files = dln->GetFiles();
-            m_DynamicDependencies.SetCapacity( m_DynamicDependencies.GetSize() + files.GetSize() );
-            for ( Array< FileIO::FileInfo >::Iter fIt = files.Begin();
-                    fIt != files.End();
-                    fIt++ )
+            inputs.SetCapacity( inputs.GetSize() + files.GetSize() );
+            for ( const FileIO::FileInfo & file : files )
             {
-                // Create the file node (or find an existing one)
-                Node * n = nodeGraph.FindNode( fIt->m_Name );
-                if ( n == nullptr )
-                {
-                    n = nodeGraph.CreateFileNode( fIt->m_Name );
-                }
-                else if ( n->IsAFile() == false )
-                {
-                    FLOG_ERROR( "Library() .CompilerInputFile '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
-                    return false;
-                }
-
-                // ignore the precompiled header as a convenience for the user
-                // so they don't have to exclude it explicitly
-                #if defined( __WINDOWS__ )
-                    if ( n->GetName() == m_PrecompiledHeaderCPPFile )
-                    {
-                        continue;
-                    }
-                #endif
-
-                // create the object that will compile the above file
-                if ( CreateDynamicObjectNode( nodeGraph, n->GetName(), dln->GetPath() ) == false )
-                {
-                    return false; // CreateDynamicObjectNode will have emitted error
-                }
+                inputs.EmplaceBack( file.m_Name, dln->GetPath(), DynamicObjectInput::Source::DIRECTORY_LIST );
             }
         }
-        else if ( dep.GetNode()->GetType() == Node::UNITY_NODE )
+        else if ( node->GetType() == Node::UNITY_NODE )
         {
-            // get the dir list from the unity node
-            const UnityNode * un = dep.GetNode()->CastTo< UnityNode >();
-
-            // unity files
-            const Array< AString > & unityFiles = un->GetUnityFileNames();
-            for ( Array< AString >::Iter it = unityFiles.Begin();
-                  it != unityFiles.End();
-                  it++ )
+            const UnityNode * un = node->CastTo< UnityNode >();
+            for ( const AString & unityFile : un->GetUnityFileNames() )
             {
-                Node * n = nodeGraph.FindNode( *it );
-                if ( n == nullptr )
-                {
-                    n = nodeGraph.CreateFileNode( *it );
-                }
-                else if ( n->IsAFile() == false )
-                {
-                    FLOG_ERROR( "Library() .CompilerInputUnity '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
-                    return false;
-                }
-
-                // create the object that will compile the above file
-                if ( CreateDynamicObjectNode( nodeGraph, n->GetName(), AString::GetEmpty(), true ) == false )
-                {
-                    return false; // CreateDynamicObjectNode will have emitted error
-                }
+                inputs.EmplaceBack( unityFile, AString::GetEmpty(), DynamicObjectInput::Source::UNITY );
             }
-
-            // files from unity to build individually
             for ( const UnityIsolatedFile & isolatedFile : un->GetIsolatedFileNames() )
             {
-                Node * n = nodeGraph.FindNode( isolatedFile.GetFileName() );
-                if ( n == nullptr )
-                {
-                    n = nodeGraph.CreateFileNode( isolatedFile.GetFileName() );
-                }
-                else if ( n->IsAFile() == false )
-                {
-                    FLOG_ERROR( "Library() Isolated '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
-                    return false;
-                }
-
-                // create the object that will compile the above file
-                if ( CreateDynamicObjectNode( nodeGraph, n->GetName(), isolatedFile.GetDirListOriginPath(), false, true ) == false )
-                {
-                    return false; // CreateDynamicObjectNode will have emitted error
-                }
+                inputs.EmplaceBack( isolatedFile.GetFileName(), isolatedFile.GetDirListOriginPath(), DynamicObjectInput::Source::UNITY_ISOLATED );
             }
         }
-        else if ( dep.GetNode()->GetType() == Node::OBJECT_LIST_NODE )
+        else if ( node->GetType() == Node::OBJECT_LIST_NODE )
         {
-            // get the list of files from the ObjectListNode
-            const ObjectListNode * objListNode = dep.GetNode()->CastTo< ObjectListNode >();
-            Array< AString > objListFiles;
-            objListNode->GetInputFiles( objListFiles );
-
-            // iterate all the files in the object list
-            for ( const AString & file : objListFiles )
+            // files in the other ObjectList (as per GetInputFiles)
+            const ObjectListNode * objListNode = node->CastTo< ObjectListNode >();
+            for ( const Dependency & dep : objListNode->m_DynamicDependencies )
             {
-                const Node * n = nodeGraph.FindNode( file );
-                if ( n == nullptr )
-                {
-                    FLOG_ERROR( "ObjectListNode: Missing Node '%s'", file.Get() );
-                    return false;
-                }
-                else if ( n->IsAFile() == false )
-                {
-                    FLOG_ERROR( "ObjectListNode: '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
-                    return false;
-                }
-
-                // create the object that will compile the above file
-                if ( CreateDynamicObjectNode( nodeGraph, n->GetName(), objListNode->GetCompilerOutputPath() ) == false )
-                {
-                    return false; // CreateDynamicObjectNode will have emitted error
-                }
+                inputs.EmplaceBack( dep.GetNode()->GetName(), objListNode->GetCompilerOutputPath(), DynamicObjectInput::Source::OBJECT_LIST );
             }
         }
-        else if ( dep.GetNode()->IsAFile() )
+        else if ( node->IsAFile() )
         {
-            // a single file, create the object that will compile it
-            if ( CreateDynamicObjectNode( nodeGraph, dep.GetNode()->GetName(), AString::GetEmpty() ) == false )
-            {
-                return false; // CreateDynamicObjectNode will have emitted error
-            }
+            inputs.EmplaceBack( node->GetName(), AString::GetEmpty(), DynamicObjectInput::Source::FILE );
         }
         else
         {
@@ -491,10 +434,35 @@ ObjectListNode::~ObjectListNode() = default;
     // Depend on objects for loose files
     for ( const AString & file : m_CompilerInputFiles )
     {
-        if ( CreateDynamicObjectNode( nodeGraph, file, AString::GetEmpty() ) == false )
-        {
-            return false; // CreateDynamicObjectNode will have emitted error
-        }
+        inputs.EmplaceBack( file, AString::GetEmpty(), DynamicObjectInput::Source::FILE );
+    }
+
+    // Prepare nodes in parallel
+    PrepareDynamicObjectNodesData data{ this, &nodeGraph, &inputs };
+    const uint32_t numInputs = (uint32_t)inputs.GetSize();
+    if ( JobQueue::IsValid() )
+    {
+        const uint32_t chunkSize = 64; // Enough work to amortize waking workers
+        JobQueue::Get().ParallelFor( numInputs, chunkSize, PrepareDynamicObjectNodes, &data );
+    }
+    else
+    {
+        PrepareDynamicObjectNodes( 0, numInputs, &data );
+    }
+
+    // Register nodes in order
+    m_DynamicDependencies.SetCapacity( inputs.GetSize() + 1 );
+    bool ok = true;
+    for ( DynamicObjectInput & input : inputs )
+    {
+        ok = ok && AddDynamicObjectNode( nodeGraph, input );
+
+        // Free nodes which weren't needed (found existing, or after an error)
+        FDELETE( input.m_NewObjectNode );
+    }
+    if ( ok == false )
+    {
+        return false; // AddDynamicObjectNode will have emitted an error
     }
 
     // If we have a precompiled header, add that to our dynamic deps so that
@@ -511,6 +479,146 @@ ObjectListNode::~ObjectListNode() = default;
     return true;
 }
 
+// PrepareDynamicObjectNodes (Any Thread)
+//------------------------------------------------------------------------------
+/*static*/ void ObjectListNode::PrepareDynamicObjectNodes( uint32_t firstItem, uint32_t numItems, void * userData )
+{
+    const PrepareDynamicObjectNodesData & data = *static_cast< const PrepareDynamicObjectNodesData * >( userData );
+    ObjectListNode & self = *data.m_ObjectListNode;
+    const NodeGraph & nodeGraph = *data.m_NodeGraph;
+
+    for ( uint32_t i = firstItem; i < ( firstItem + numItems ); ++i )
+    {
+        DynamicObjectInput & input = ( *data.m_Inputs )[ i ];
+
+        // Find the input file node, or determine the name it will be created with
+        if ( input.m_Source == DynamicObjectInput::Source::FILE )
+        {
+            input.m_InputFileName = *input.m_FileName;
+        }
+        else
+        {
+            input.m_FileNode = nodeGraph.FindNode( *input.m_FileName );
+            if ( input.m_FileNode )
+            {
+                input.m_InputFileName = input.m_FileNode->GetName();
+            }
+            else if ( input.m_Source == DynamicObjectInput::Source::OBJECT_LIST )
+            {
+                continue; // Error will be reported when registering
+            }
+            else
+            {
+                NodeGraph::CleanPath( *input.m_FileName, input.m_InputFileName );
+            }
+        }
+
+        // Find the object node, or construct one ready to be registered
+        self.GetObjectFileName( input.m_InputFileName, *input.m_BaseDir, input.m_ObjectFileName );
+        input.m_ObjectNode = nodeGraph.FindNode( input.m_ObjectFileName );
+        if ( input.m_ObjectNode == nullptr )
+        {
+            // Handle Unity modification of flags
+            ObjectNode::CompilerFlags flags = self.m_CompilerFlags;
+            if ( input.m_Source == DynamicObjectInput::Source::UNITY )
+            {
+                flags.Set( ObjectNode::CompilerFlags::FLAG_UNITY );
+            }
+            if ( input.m_Source == DynamicObjectInput::Source::UNITY_ISOLATED )
+            {
+                flags.Set( ObjectNode::CompilerFlags::FLAG_ISOLATED_FROM_UNITY );
+            }
+
+            input.m_NewObjectNode = self.ConstructObjectNode( flags, self.m_PreprocessorFlags, self.m_CompilerOptions, self.m_CompilerOptionsDeoptimized, self.m_Preprocessor, self.m_PreprocessorOptions, input.m_ObjectFileName, input.m_InputFileName, AString::GetEmpty() );
+        }
+    }
+}
+
+// AddDynamicObjectNode
+//------------------------------------------------------------------------------
+bool ObjectListNode::AddDynamicObjectNode( NodeGraph & nodeGraph, DynamicObjectInput & input )
+{
+    const bool isUnityNode = ( input.m_Source == DynamicObjectInput::Source::UNITY );
+    const bool isIsolatedFromUnityNode = ( input.m_Source == DynamicObjectInput::Source::UNITY_ISOLATED );
+
+    // Create the file node (or find an existing one)
+    if ( input.m_Source != DynamicObjectInput::Source::FILE )
+    {
+        Node * n = input.m_FileNode;
+        if ( n == nullptr )
+        {
+            if ( input.m_Source == DynamicObjectInput::Source::OBJECT_LIST )
+            {
+                FLOG_ERROR( "ObjectListNode: Missing Node '%s'", input.m_FileName->Get() );
+                return false;
+            }
+
+            // May have been created for an earlier input
+            n = nodeGraph.FindNodeExact( input.m_InputFileName );
+            if ( n == nullptr )
+            {
+                n = nodeGraph.CreateFileNode( input.m_InputFileName, false ); // Already clean
+            }
+        }
+        if ( n->IsAFile() == false )
+        {
+            switch ( input.m_Source )
+            {
+                case DynamicObjectInput::Source::DIRECTORY_LIST:
+                    FLOG_ERROR( "Library() .CompilerInputFile '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
+                    break;
+                case DynamicObjectInput::Source::UNITY:
+                    FLOG_ERROR( "Library() .CompilerInputUnity '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
+                    break;
+                case DynamicObjectInput::Source::UNITY_ISOLATED:
+                    FLOG_ERROR( "Library() Isolated '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
+                    break;
+                default:
+                    FLOG_ERROR( "ObjectListNode: '%s' is not a FileNode (type: %s)", n->GetName().Get(), n->GetTypeName() );
+                    break;
+            }
+            return false;
+        }
+
+        // ignore the precompiled header as a convenience for the user
+        // so they don't have to exclude it explicitly
+        #if defined( __WINDOWS__ )
+            if ( ( input.m_Source == DynamicObjectInput::Source::DIRECTORY_LIST ) &&
+                 ( n->GetName() == m_PrecompiledHeaderCPPFile ) )
+            {
+                return true;
+            }
+        #endif
+
+        // An existing node with a differently cased name can't use the prepared object
+        if ( n->GetName() != input.m_InputFileName )
+        {
+            return CreateDynamicObjectNode( nodeGraph, n->GetName(), *input.m_BaseDir, isUnityNode, isIsolatedFromUnityNode );
+        }
+    }
+
+    // Find the object node (may have been created for an earlier input)
+    Node * on = input.m_ObjectNode ? input.m_ObjectNode : nodeGraph.FindNodeExact( input.m_ObjectFileName );
+    if ( on == nullptr )
+    {
+        ASSERT( input.m_NewObjectNode );
+        ObjectNode * objectNode = input.m_NewObjectNode;
+        input.m_NewObjectNode = nullptr; // Owned by NodeGraph once registered
+        if ( !InitializeObjectNode( nodeGraph, objectNode, nullptr, nullptr ) )
+        {
+            FLOG_ERROR( "Failed to create node '%s'!", input.m_ObjectFileName.Get() );
+            return false;
+        }
+        on = objectNode;
+    }
+    else if ( !CheckDynamicObjectNode( on, input.m_InputFileName, input.m_ObjectFileName ) )
+    {
+        return false; // CheckDynamicObjectNode will have emitted an error
+    }
+    m_DynamicDependencies.Add( on );
+    return true;
+}
+
 // DoDynamicDependencies
 //------------------------------------------------------------------------------
 /*virtual*/ bool ObjectListNode::DoDynamicDependencies( NodeGraph & nodeGraph, bool forceClean )
@@ -732,33 +840,42 @@ bool ObjectListNode::CreateDynamicObjectNode( NodeGraph & nodeGraph,
         }
         on = objectNode;
     }
-    else if ( on->GetType() != Node::OBJECT_NODE )
+    else if ( !CheckDynamicObjectNode( on, inputFileName, objFile ) )
+    {
+        return false; // CheckDynamicObjectNode will have emitted an error
+    }
+    m_DynamicDependencies.Add( on );
+    return true;
+}
+
+// CheckDynamicObjectNode
+//------------------------------------------------------------------------------
+bool ObjectListNode::CheckDynamicObjectNode( const Node * on, const AString & inputFileName, const AString & objFile ) const
+{
+    if ( on->GetType() != Node::OBJECT_NODE )
     {
         FLOG_ERROR( "Node '%s' is not an ObjectNode (type: %s)", on->GetName().Get(), on->GetTypeName() );
         return false;
     }
-    else
+
+    const ObjectNode * other = on->CastTo< ObjectNode >();
+
+    // Check for conflicts
+    const bool conflict = ( inputFileName != other->GetSourceFile()->GetName() ) ||
+                          ( m_Name != other->GetOwnerObjectList() );
+    if ( conflict )
     {
-        const ObjectNode * other = on->CastTo< ObjectNode >();
-
-        // Check for conflicts
-        const bool conflict = ( inputFileName != other->GetSourceFile()->GetName() ) ||
-                              ( m_Name != other->GetOwnerObjectList() );
-        if ( conflict )
-        {
-            FLOG_ERROR( "Conflicting objects found for: %s\n"
-                        " Source A  : %s\n"
-                        " ObjectList: %s\n"
-                        "AND\n"
-                        " Source B  : %s\n"
-                        " ObjectList: %s\n",
-                        objFile.Get(),
-                        inputFileName.Get(), m_Name.Get(),
-                        other->GetSourceFile()->GetName().Get(), other->GetOwnerObjectList().Get() );
-            return false;
-        }
+        FLOG_ERROR( "Conflicting objects found for: %s\n"
+                    " Source A  : %s\n"
+                    " ObjectList: %s\n"
+                    "AND\n"
+                    " Source B  : %s\n"
+                    " ObjectList: %s\n",
+                    objFile.Get(),
+                    inputFileName.Get(), m_Name.Get(),
+                    other->GetSourceFile()->GetName().Get(), other->GetOwnerObjectList().Get() );
+        return false;
     }
-    m_DynamicDependencies.Add( on );
     return true;
 }
 
@@ -777,7 +894,30 @@ ObjectNode * ObjectListNode::CreateObjectNode( NodeGraph & nodeGraph,
                                                const AString & objectInput,
                                                const AString & pchObjectName )
 {
-    ObjectNode * node= nodeGraph.CreateObjectNode( objectName );
+    ObjectNode * node = ConstructObjectNode( flags, preprocessorFlags, compilerOptions, compilerOptionsDeoptimized, preprocessor, preprocessorOptions, objectName, objectInput, pchObjectName );
+    if ( !InitializeObjectNode( nodeGraph, node, iter, function ) )
+    {
+        return nullptr; // InitializeObjectNode will have emitted an error
+    }
+    return node;
+}
+
+// ConstructObjectNode (Any Thread)
+//------------------------------------------------------------------------------
+ObjectNode * ObjectListNode::ConstructObjectNode( const ObjectNode::CompilerFlags flags,
+                                                  const ObjectNode::CompilerFlags preprocessorFlags,
+                                                  const AString & compilerOptions,
+                                                  const AString & compilerOptionsDeoptimized,
+                                                  const AString & preprocessor,
+                                                  const AString & preprocessorOptions,
+                                                  const AString & objectName,
+                                                  const AString & objectInput,
+                                                  const AString & pchObjectName ) const
+{
+    ASSERT( NodeGraph::IsCleanPath( objectName ) );
+
+    ObjectNode * node = FNEW( ObjectNode() );
+    node->SetName( objectName );
     node->m_Compiler = m_Compiler;
     node->m_CompilerOptions = compilerOptions;
     node->m_CompilerOptionsDeoptimized = compilerOptionsDeoptimized;
@@ -805,13 +945,20 @@ ObjectNode * ObjectListNode::CreateObjectNode( NodeGraph & nodeGraph,
     node->m_CompilerFlags = flags;
     node->m_PreprocessorFlags = preprocessorFlags;
     node->m_OwnerObjectList = m_Name;
+    return node;
+}
 
+// InitializeObjectNode
+//------------------------------------------------------------------------------
+/*static*/ bool ObjectListNode::InitializeObjectNode( NodeGraph & nodeGraph, ObjectNode * node, const BFFToken * iter, const Function * function )
+{
+    nodeGraph.RegisterNode( node );
     if ( !node->Initialize( nodeGraph, iter, function ) )
     {
         // TODO:A We have a node in the graph which is in an invalid state
-        return nullptr; // Initialize will have emitted an error
+        return false; // Initialize will have emitted an error
     }
-    return node;
+    return true;
 }
 
 // GetObjExtension
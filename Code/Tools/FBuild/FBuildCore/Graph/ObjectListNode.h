@@ -54,6 +54,16 @@ protected:
     virtual BuildResult DoBuild( Job * job ) override;
 
     // internal helpers
+    struct DynamicObjectInput;
+    struct PrepareDynamicObjectNodesData
+    {
+        ObjectListNode *                m_ObjectListNode;
+        const NodeGraph *               m_NodeGraph;
+        Array< DynamicObjectInput > *   m_Inputs;
+    };
+    static void PrepareDynamicObjectNodes( uint32_t firstItem, uint32_t numItems, void * userData );
+    bool AddDynamicObjectNode( NodeGraph & nodeGraph, DynamicObjectInput & input );
+    bool CheckDynamicObjectNode( const Node * on, const AString & inputFileName, const AString & objFile ) const;
     bool CreateDynamicObjectNode( NodeGraph & nodeGraph,
                                   const AString & inputFileName,
                                   const AString & baseDir,
@@ -71,6 +81,16 @@ protected:
                                    const AString & objectName,
                                    const AString & objectInput,
                                    const AString & pchObjectName );
+    ObjectNode * ConstructObjectNode( const ObjectNode::CompilerFlags flags,
+                                      const ObjectNode::CompilerFlags preprocessorFlags,
+                                      const AString & compilerOptions,
+                                      const AString & compilerOptionsDeoptimized,
+                                      const AString & preprocessor,
+                                      const AString & preprocessorOptions,
+                                      const AString & objectName,
+                                      const AString & objectInput,
+                                      const AString & pchObjectName ) const;
+    static bool InitializeObjectNode( NodeGraph & nodeGraph, ObjectNode * node, const BFFToken * iter, const Function * function );
 
     // Exposed Properties
     AString             m_Compiler;
@@ -6,6 +6,7 @@
 #include "ObjectNode.h"
 
 #include "Tools/FBuild/FBuildCore/BFF/Functions/FunctionObjectList.h"
+#include "Tools/FBuild/FBuildCore/Cache/CacheWriteQueue.h"
 #include "Tools/FBuild/FBuildCore/Cache/ICache.h"
 #include "Tools/FBuild/FBuildCore/ExeDrivers/Compiler/CompilerDriverBase.h"
 #include "Tools/FBuild/FBuildCore/ExeDrivers/Compiler/CompilerDriver_CL.h"
@@ -20,6 +21,7 @@
 #include "Tools/FBuild/FBuildCore/ExeDrivers/Compiler/CompilerDriver_VBCC.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Cache/CachePrefetcher.h"
 #include "Tools/FBuild/FBuildCore/Cache/LightCache.h"
 #include "Tools/FBuild/FBuildCore/Graph/CompilerNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
@@ -417,10 +419,18 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
     }
 
     // Try to use the light cache if enabled
+    bool haveSourceKey = false;
     if ( useCache && GetCompiler()->GetUseLightCache() )
     {
+        // Use the key formed in the background if possible
+        CachePrefetcher * prefetcher = FBuild::Get().GetCachePrefetcher();
         LightCache lc;
-        if ( lc.Hash( this, fullArgs.GetFinalArgs(), m_LightCacheKey, m_Includes ) == false )
+        if ( prefetcher && prefetcher->TakeSourceKey( this, fullArgs.GetFinalArgs(), m_LightCacheKey, m_Includes ) )
+        {
+            SetStatFlag( Node::STATS_LIGHT_CACHE ); // Light compatible
+            haveSourceKey = true;
+        }
+        else if ( lc.Hash( this, fullArgs.GetFinalArgs(), m_LightCacheKey, m_Includes ) == false )
         {
             // Light cache could not be used (can't parse includes)
             if ( FBuild::Get().GetOptions().m_CacheVerbose )
@@ -437,29 +447,45 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
         {
             // LightCache hashing was successful
             SetStatFlag( Node::STATS_LIGHT_CACHE ); // Light compatible
+            haveSourceKey = true;
+        }
+    }
+    else if ( useCache &&
+              GetCompiler()->GetUseDependencyCacheKey() &&
+              ( pass == PASS_PREPROCESSOR_ONLY ) &&
+              ( GetDedicatedPreprocessor() == nullptr ) )
+    {
+        // Try to use the compiler's dependency output (falls back to preprocessing if not possible)
+        if ( BuildDependencyCacheKey( job, useDeoptimization ) )
+        {
+            SetStatFlag( Node::STATS_DEPENDENCY_CACHE_KEY );
+            haveSourceKey = true;
+        }
+    }
 
-            // Try retrieve from cache
-            GetCacheName( job ); // Prepare the cache key (always done here even if write only mode)
-            if ( RetrieveFromCache( job ) )
-            {
-                return NODE_RESULT_OK_CACHE;
-            }
-
-            // Cache miss
-            const bool belowMemoryLimit = ( ( Job::GetTotalLocalDataMemoryUsage() / MEGABYTE ) < FBuild::Get().GetSettings()->GetDistributableJobMemoryLimitMiB() );
-            const bool canDistribute = belowMemoryLimit && m_CompilerFlags.IsDistributable() && m_AllowDistribution && FBuild::Get().GetOptions().m_AllowDistributed;
-            if ( canDistribute == false )
-            {
-                // can't distribute, so generating preprocessed output is useless
-                // so we directly compile from source as one-pass compilation is faster
-                const bool stealingRemoteJob = false; // never queued
-                const bool racingRemoteJob = false; // never queued
-                const bool isFollowingLightCacheMiss = true;
-                return DoBuildWithPreProcessor2( job, useDeoptimization, stealingRemoteJob, racingRemoteJob, isFollowingLightCacheMiss );
-            }
+    if ( haveSourceKey )
+    {
+        // Try retrieve from cache
+        GetCacheName( job ); // Prepare the cache key (always done here even if write only mode)
+        if ( RetrieveFromCache( job ) )
+        {
+            return NODE_RESULT_OK_CACHE;
+        }
 
-            // Fall through to generate preprocessed output for distribution....
+        // Cache miss
+        const bool belowMemoryLimit = ( ( Job::GetTotalLocalDataMemoryUsage() / MEGABYTE ) < FBuild::Get().GetSettings()->GetDistributableJobMemoryLimitMiB() );
+        const bool canDistribute = belowMemoryLimit && m_CompilerFlags.IsDistributable() && m_AllowDistribution && FBuild::Get().GetOptions().m_AllowDistributed;
+        if ( canDistribute == false )
+        {
+            // can't distribute, so generating preprocessed output is useless
+            // so we directly compile from source as one-pass compilation is faster
+            const bool stealingRemoteJob = false; // never queued
+            const bool racingRemoteJob = false; // never queued
+            const bool isFollowingLightCacheMiss = true;
+            return DoBuildWithPreProcessor2( job, useDeoptimization, stealingRemoteJob, racingRemoteJob, isFollowingLightCacheMiss );
         }
+
+        // Fall through to generate preprocessed output for distribution....
     }
 
     if ( pass == PASS_PREPROCESSOR_ONLY )
@@ -510,7 +536,10 @@ Node::BuildResult ObjectNode::DoBuildWithPreProcessor( Job * job, bool useDeopti
     {
         // compress job data
         Compressor c;
-        c.Compress( job->GetData(), job->GetDataSize(), FBuild::Get().GetOptions().m_DistributionCompressionLevel );
+        c.Compress( job->GetData(),
+                    job->GetDataSize(),
+                    FBuild::Get().GetOptions().m_DistributionCompressionLevel,
+                    FBuild::Get().GetCompressionDictionary( CompressionDictionary::PREPROCESSED ) );
         const size_t compressedSize = c.GetResultSize();
         job->OwnData( c.ReleaseResult(), compressedSize, true );
 
@@ -1335,6 +1364,18 @@ const AString & ObjectNode::GetCacheName( Job * job ) const
     // hash the pre-processed input data
     ASSERT( m_LightCacheKey || job->GetData() );
     const uint64_t preprocessedSourceKey = m_LightCacheKey ? m_LightCacheKey : xxHash3::Calc64( job->GetData(), job->GetDataSize() );
+
+    AStackString<> cacheName;
+    BuildCacheName( job, preprocessedSourceKey, cacheName );
+    job->SetCacheName(cacheName);
+
+    return job->GetCacheName();
+}
+
+// BuildCacheName
+//------------------------------------------------------------------------------
+void ObjectNode::BuildCacheName( const Job * job, uint64_t preprocessedSourceKey, AString & outCacheName ) const
+{
     ASSERT( preprocessedSourceKey );
 
     // hash the build "environment"
@@ -1373,11 +1414,7 @@ const AString & ObjectNode::GetCacheName( Job * job ) const
         ASSERT( pchKey != 0 ); // Should not be in here if PCH is not cached
     }
 
-    AStackString<> cacheName;
-    ICache::GetCacheId( preprocessedSourceKey, commandLineKey, toolChainKey, pchKey, cacheName );
-    job->SetCacheName(cacheName);
-
-    return job->GetCacheName();
+    ICache::GetCacheId( preprocessedSourceKey, commandLineKey, toolChainKey, pchKey, outCacheName );
 }
 
 // RetrieveFromCache
@@ -1398,9 +1435,23 @@ bool ObjectNode::RetrieveFromCache( Job * job )
     ICache * cache = FBuild::Get().GetCache();
     ASSERT( cache );
 
+    // Use the result of the lookup made in the background if available
     void * cacheData( nullptr );
     size_t cacheDataSize( 0 );
-    if ( cache->Retrieve( cacheFileName, cacheData, cacheDataSize ) )
+    bool found;
+    CachePrefetcher * prefetcher = FBuild::Get().GetCachePrefetcher();
+    if ( ( prefetcher == nullptr ) ||
+         ( prefetcher->Take( this, cacheFileName, found, cacheData, cacheDataSize ) == false ) )
+    {
+        found = cache->Retrieve( cacheFileName, cacheData, cacheDataSize );
+    }
+    if ( found && Compressor::IsDictionaryMissing( cacheData, cacheDataSize ) )
+    {
+        // Written using a compression dictionary we don't have
+        cache->FreeMemory( cacheData, cacheDataSize );
+        found = false;
+    }
+    if ( found )
     {
         const uint32_t retrieveTime = uint32_t( t.GetElapsedMS() );
 
@@ -1551,7 +1602,10 @@ void ObjectNode::WriteToCache_FromUncompressedData( Job * job,
     const Timer t;
     const uint32_t startCompress( (uint32_t)t.GetElapsedMS() );
     Compressor c;
-    c.Compress(uncompressedData, uncompressedDataSize, FBuild::Get().GetOptions().m_CacheCompressionLevel );
+    c.Compress( uncompressedData,
+                uncompressedDataSize,
+                FBuild::Get().GetOptions().m_CacheCompressionLevel,
+                FBuild::Get().GetCompressionDictionary( CompressionDictionary::OBJECTS ) );
     const uint32_t compressionTime = ( (uint32_t)t.GetElapsedMS() - startCompress );
 
     WriteToCache_FromCompressedData( job,
@@ -1577,6 +1631,45 @@ void ObjectNode::WriteToCache_FromCompressedData( Job * job,
 
     const AString & cacheFileName = GetCacheName(job);
 
+    // Hand off to background publishing, if enabled and not full
+    CacheWriteQueue * writeQueue = FBuild::Get().GetCacheWriteQueue();
+    if ( writeQueue )
+    {
+        const Timer queueTimer;
+        AStackString<> description;
+        description.Format( "Obj: %s", GetName().Get() );
+        if ( writeQueue->Enqueue( cacheFileName, compressedData, (size_t)compressedDataSize, description ) )
+        {
+            // Store is reported optimistically; failures are reported by the queue
+            SetStatFlag( Node::STATS_CACHE_STORE );
+
+            // Dependent objects need to know the PCH key to be able to pull from the cache
+            if ( IsCreatingPCH() && IsMSVC() )
+            {
+                m_PCHCacheKey = xxHash3::Calc64( compressedData, compressedDataSize );
+            }
+
+            const uint32_t cachingTime = uint32_t( queueTimer.GetElapsedMS() );
+            AddCachingTime( cachingTime );
+
+            // Output
+            if ( FBuild::Get().GetOptions().m_CacheVerbose )
+            {
+                const uint64_t uncompressedDataSize = Compressor::GetUncompressedSize( compressedData, compressedDataSize );
+                AStackString<> output;
+                output.Format( "Obj: %s\n"
+                               " - Cache Store Queued: %u ms (Compress: %u ms) (Compressed: %" PRIu64 " - Uncompressed: %" PRIu64 ") '%s'\n",
+                               GetName().Get(), cachingTime, compressionTimeMS, compressedDataSize, uncompressedDataSize, cacheFileName.Get() );
+                if ( m_PCHCacheKey != 0 )
+                {
+                    output.AppendFormat( " - PCH Key: %" PRIx64 "\n", m_PCHCacheKey );
+                }
+                FLOG_OUTPUT( output );
+            }
+            return;
+        }
+    }
+
     // Commit to cache
     const Timer t;
     const uint32_t startPublish( (uint32_t)t.GetElapsedMS() );
@@ -1775,7 +1868,14 @@ bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool us
         const AString & nextToken = ( i < ( numTokens - 1 ) ) ? tokens[ i + 1 ] : AString::GetEmpty();
 
         // Handle Preprocessor args adjustment
-        if ( ( pass == PASS_PREPROCESSOR_ONLY ) && driver->ProcessArg_PreprocessorOnly( token, i, nextToken, fullArgs ) )
+        if ( ( ( pass == PASS_PREPROCESSOR_ONLY ) || ( pass == PASS_DEPENDENCIES_ONLY ) ) &&
+             driver->ProcessArg_PreprocessorOnly( token, i, nextToken, fullArgs ) )
+        {
+            continue;
+        }
+
+        // Handle dependency listing args adjustment
+        if ( ( pass == PASS_DEPENDENCIES_ONLY ) && driver->ProcessArg_DependenciesOnly( token, i, nextToken, fullArgs ) )
         {
             continue;
         }
@@ -1808,6 +1908,10 @@ bool ObjectNode::BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool us
     {
         driver->AddAdditionalArgs_Preprocessor( fullArgs );
     }
+    else if ( pass == PASS_DEPENDENCIES_ONLY )
+    {
+        driver->AddAdditionalArgs_Dependencies( fullArgs );
+    }
     driver->AddAdditionalArgs_Common( job->IsLocal(), fullArgs );
 
     if ( showIncludes )
@@ -1895,6 +1999,113 @@ bool ObjectNode::BuildPreprocessedOutput( const Args & fullArgs, Job * job, bool
     return true;
 }
 
+// BuildDependencyCacheKey
+//------------------------------------------------------------------------------
+bool ObjectNode::BuildDependencyCacheKey( Job * job, bool useDeoptimization )
+{
+    PROFILE_FUNCTION;
+
+    m_LightCacheKey = 0;
+
+    // Problems are not reported here. Preprocessing will be used instead, which
+    // will report any genuine errors.
+
+    // Have the compiler list the dependencies instead of generating preprocessed output
+    Args fullArgs;
+    fullArgs.SetQuiet();
+    const bool showIncludes( false );
+    const bool useSourceMapping( true );
+    const bool finalize( true );
+    if ( !BuildArgs( job, fullArgs, PASS_DEPENDENCIES_ONLY, useDeoptimization, showIncludes, useSourceMapping, finalize ) )
+    {
+        return false;
+    }
+
+    // Use the key formed in the background if possible
+    CachePrefetcher * prefetcher = FBuild::Get().GetCachePrefetcher();
+    if ( prefetcher && prefetcher->TakeSourceKey( this, fullArgs.GetFinalArgs(), m_LightCacheKey, m_Includes ) )
+    {
+        return true;
+    }
+
+    uint64_t sourceKey;
+    Array< AString > includes;
+    if ( GetDependencyCacheKey( fullArgs.GetFinalArgs(), sourceKey, includes ) == false )
+    {
+        return false;
+    }
+
+    m_Includes.Swap( includes );
+    m_LightCacheKey = sourceKey;
+    return true;
+}
+
+// GetDependencyCacheKey
+//------------------------------------------------------------------------------
+bool ObjectNode::GetDependencyCacheKey( const AString & args, uint64_t & outSourceKey, Array< AString > & outIncludes ) const
+{
+    PROFILE_FUNCTION;
+
+    const bool cacheVerbose = FBuild::Get().GetOptions().m_CacheVerbose;
+    Process p( FBuild::GetAbortBuildPointer() );
+    if ( p.Spawn( GetCompiler()->GetExecutable().Get(),
+                  args.Get(),
+                  nullptr, // workingDir
+                  GetCompiler()->GetEnvironmentString() ) == false )
+    {
+        return false;
+    }
+    AString out;
+    AString err;
+    p.ReadAllData( out, err );
+    const int32_t result = p.WaitForExit();
+    if ( p.HasAborted() )
+    {
+        return false;
+    }
+
+    // Anything unusual (including warnings) and we don't trust the output
+    if ( ( result != 0 ) || ( err.IsEmpty() == false ) )
+    {
+        if ( cacheVerbose )
+        {
+            FLOG_OUTPUT( "Dependency cache key cannot be used for '%s'\n"
+                         " - Compiler returned %i\n%s",
+                         GetName().Get(), result, err.Get() );
+        }
+        return false;
+    }
+
+    CIncludeParser parser;
+    if ( parser.ParseGCC_Dependencies( out.Get(), out.GetLength() ) == false )
+    {
+        if ( cacheVerbose )
+        {
+            FLOG_OUTPUT( "Dependency cache key cannot be used for '%s'\n"
+                         " - Unexpected dependency output\n",
+                         GetName().Get() );
+        }
+        return false;
+    }
+
+    // Hash the listed files
+    LightCache lc;
+    if ( lc.HashFiles( parser.GetIncludes(), outSourceKey ) == false )
+    {
+        if ( cacheVerbose )
+        {
+            FLOG_OUTPUT( "Dependency cache key cannot be used for '%s'\n"
+                         "%s",
+                         GetName().Get(), lc.GetErrors().Get() );
+        }
+        return false;
+    }
+
+    outIncludes.Clear();
+    parser.SwapIncludes( outIncludes );
+    return true;
+}
+
 // LoadStaticSourceFileForDistribution
 //------------------------------------------------------------------------------
 bool ObjectNode::LoadStaticSourceFileForDistribution( const Args & fullArgs, Job * job, bool useDeoptimization ) const
@@ -2120,7 +2331,13 @@ bool ObjectNode::WriteTmpFile( Job * job, AString & tmpDirectory, AString & tmpF
     Compressor c; // scoped here so we can access decompression buffer
     if ( job->IsDataCompressed() )
     {
-        VERIFY( c.Decompress( dataToWrite ) );
+        if ( c.Decompress( dataToWrite ) == false )
+        {
+            // Compressed with a dictionary we don't have
+            job->Error( "Failed to decompress job data. Target: '%s'", GetName().Get() );
+            job->OnSystemError();
+            return NODE_RESULT_FAILED;
+        }
         dataToWrite = c.GetResult();
         dataToWriteSize = c.GetResultSize();
     }
@@ -2629,6 +2846,70 @@ bool ObjectNode::ShouldUseCache() const
     return useCache;
 }
 
+// CanPrefetchFromCache
+//------------------------------------------------------------------------------
+bool ObjectNode::CanPrefetchFromCache() const
+{
+    // The key must be formed without running the preprocessor, using either the
+    // LightCache or the compiler's dependency output
+    if ( ( ShouldUseCache() == false ) ||
+         GetCompiler()->SimpleDistributionMode() ||
+         ( GetDedicatedPreprocessor() != nullptr ) ||
+         IsCreatingPCH() )
+    {
+        return false;
+    }
+    return ( GetCompiler()->GetUseLightCache() || GetCompiler()->GetUseDependencyCacheKey() );
+}
+
+// BuildCacheNameForPrefetch
+//------------------------------------------------------------------------------
+bool ObjectNode::BuildCacheNameForPrefetch( AString & outCacheName, AString & outKeyArgs, uint64_t & outSourceKey, Array< AString > & outIncludes )
+{
+    PROFILE_FUNCTION;
+
+    // Form the key the same way DoBuildWithPreProcessor will, without modifying
+    // any state (a build thread may be building this node concurrently)
+    const Job job( this );
+    Args fullArgs;
+    fullArgs.SetQuiet();
+    const bool useLightCache = GetCompiler()->GetUseLightCache();
+    const bool useDeoptimization = ShouldUseDeoptimization();
+    const bool showIncludes( false );
+    const bool useSourceMapping( true );
+    const bool finalize( false ); // Response files are only created by build threads
+    if ( !BuildArgs( &job, fullArgs, useLightCache ? PASS_PREPROCESSOR_ONLY : PASS_DEPENDENCIES_ONLY, useDeoptimization, showIncludes, useSourceMapping, finalize ) )
+    {
+        return false;
+    }
+
+    // Objects needing a response file are left to build threads. Build threads only
+    // use the key if their args match the ones used here.
+    fullArgs.DisableResponseFileWrite();
+    if ( ( fullArgs.Finalize( GetCompiler()->GetExecutable(), GetName(), GetResponseFileMode() ) == false ) ||
+         ( fullArgs.GetFinalArgs() != fullArgs.GetRawArgs() ) )
+    {
+        return false;
+    }
+    outKeyArgs = fullArgs.GetRawArgs();
+
+    if ( useLightCache )
+    {
+        LightCache lc;
+        if ( lc.Hash( this, outKeyArgs, outSourceKey, outIncludes ) == false )
+        {
+            return false; // Build thread will try (and report problems)
+        }
+    }
+    else if ( GetDependencyCacheKey( outKeyArgs, outSourceKey, outIncludes ) == false )
+    {
+        return false;
+    }
+
+    BuildCacheName( &job, outSourceKey, outCacheName );
+    return true;
+}
+
 // GetResponseFileMode
 //------------------------------------------------------------------------------
 ArgsResponseFileMode ObjectNode::GetResponseFileMode() const
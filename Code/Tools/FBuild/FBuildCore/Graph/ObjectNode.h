@@ -201,6 +201,7 @@ private:
     bool ProcessIncludesWithPreProcessor( Job * job );
 
     const AString & GetCacheName( Job * job ) const;
+    void BuildCacheName( const Job * job, uint64_t preprocessedSourceKey, AString & outCacheName ) const;
     bool RetrieveFromCache( Job * job );
     void WriteToCache_FromDisk( Job * job );
     void WriteToCache_FromUncompressedData( Job * job,
@@ -220,10 +221,13 @@ private:
         PASS_COMPILE_PREPROCESSED,
         PASS_COMPILE,
         PASS_PREP_FOR_SIMPLE_DISTRIBUTION,
+        PASS_DEPENDENCIES_ONLY,
     };
     bool BuildArgs( const Job * job, Args & fullArgs, Pass pass, bool useDeoptimization, bool useShowIncludes, bool useSourceMapping, bool finalize, const AString & overrideSrcFile = AString::GetEmpty() ) const;
 
     bool BuildPreprocessedOutput( const Args & fullArgs, Job * job, bool useDeoptimization ) const;
+    bool BuildDependencyCacheKey( Job * job, bool useDeoptimization );
+    bool GetDependencyCacheKey( const AString & args, uint64_t & outSourceKey, Array< AString > & outIncludes ) const;
     bool LoadStaticSourceFileForDistribution( const Args & fullArgs, Job * job, bool useDeoptimization ) const;
     void TransferPreprocessedData( const char * data, size_t dataSize, Job * job ) const;
     bool WriteTmpFile( Job * job, AString & tmpDirectory, AString & tmpFileName ) const;
@@ -233,6 +237,9 @@ private:
     bool ShouldUseDeoptimization() const;
     friend class Client;
     bool ShouldUseCache() const;
+    friend class CachePrefetcher;
+    bool CanPrefetchFromCache() const;
+    bool BuildCacheNameForPrefetch( AString & outCacheName, AString & outKeyArgs, uint64_t & outSourceKey, Array< AString > & outIncludes );
     ArgsResponseFileMode GetResponseFileMode() const;
     bool GetVBCCPreprocessedOutput( ConstMemoryStream & outStream ) const;
 
@@ -296,12 +303,13 @@ private:
     CompilerFlags       m_CompilerFlags;
     CompilerFlags       m_PreprocessorFlags;
     uint64_t            m_PCHCacheKey                       = 0;
-    uint64_t            m_LightCacheKey                     = 0;
+    uint64_t            m_LightCacheKey                     = 0;    // Source key when not hashing preprocessed output (LightCache or dependency output)
     AString             m_OwnerObjectList; // TODO:C This could be a pointer to the node in the future
 
     // Not serialized
     Array< AString >    m_Includes;
     bool                m_Remote                            = false;
+    bool                m_CachePrefetchClaimed              = false;    // Protected by CachePrefetcher
 
 #if defined( ENABLE_FAKE_SYSTEM_FAILURE )
     // Fake system failure for tests
@@ -29,6 +29,10 @@ public:
     const AString &                     GetCachePathMountPoint() const;
     const AString &                     GetCachePluginDLL() const;
     const AString &                     GetCachePluginDLLConfig() const;
+    bool                                GetCachePacked() const { return m_CachePacked; }
+    const AString &                     GetCacheLocalPath() const { return m_CacheLocalPath; }
+    uint32_t                            GetCacheLocalSizeMiB() const { return m_CacheLocalSizeMiB; }
+    const AString &                     GetCompressionDictionaryPath() const { return m_CompressionDictionaryPath; }
     inline const Array< AString > &     GetWorkerList() const { return m_Workers; }
     uint32_t                            GetWorkerConnectionLimit() const { return m_WorkerConnectionLimit; }
     uint32_t                            GetDistributableJobMemoryLimitMiB() const { return m_DistributableJobMemoryLimitMiB; }
@@ -47,6 +51,10 @@ private:
     AString             m_CachePathMountPoint;
     AString             m_CachePluginDLL;
     AString             m_CachePluginDLLConfig;
+    bool                m_CachePacked;
+    AString             m_CacheLocalPath;
+    uint32_t            m_CacheLocalSizeMiB;
+    AString             m_CompressionDictionaryPath;
     Array< AString  >   m_Workers;
     uint32_t            m_WorkerConnectionLimit;
     uint32_t            m_DistributableJobMemoryLimitMiB;
@@ -9,6 +9,7 @@
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/DirectoryListNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/NodeOutputCache.h"
 #include "Tools/FBuild/FBuildCore/BFF/Functions/Function.h"
 
 #include "Core/Env/ErrorFormat.h"
@@ -33,6 +34,7 @@ REFLECT_NODE_BEGIN( TestNode, Node, MetaName( "TestOutput" ) + MetaFile() )
     REFLECT(        m_TestWorkingDir,           "TestWorkingDir",           MetaOptional() + MetaPath() )
     REFLECT(        m_TestTimeOut,              "TestTimeOut",              MetaOptional() + MetaRange( 0, 4 * 60 * 60 ) ) // 4hrs
     REFLECT(        m_TestAlwaysShowOutput,     "TestAlwaysShowOutput",     MetaOptional() )
+    REFLECT(        m_TestAllowCaching,         "TestAllowCaching",         MetaOptional() )
     REFLECT_ARRAY(  m_PreBuildDependencyNames,  "PreBuildDependencies",     MetaOptional() + MetaFile() + MetaAllowNonFile() )
     REFLECT_ARRAY(  m_Environment,              "Environment",              MetaOptional() )
 
@@ -49,6 +51,7 @@ TestNode::TestNode()
     , m_TestWorkingDir()
     , m_TestTimeOut( 0 )
     , m_TestAlwaysShowOutput( false )
+    , m_TestAllowCaching( false )
     , m_TestInputPathRecurse( true )
     , m_NumTestInputFiles( 0 )
     , m_EnvironmentString( nullptr )
@@ -173,6 +176,28 @@ const char * TestNode::GetEnvironmentString() const
     // If the workingDir is empty, use the current dir for the process
     const char * workingDir = m_TestWorkingDir.IsEmpty() ? nullptr : m_TestWorkingDir.Get();
 
+    // Try to retrieve the results of a previous passing run from the cache
+    Array< AString > outputFiles;
+    outputFiles.Append( m_Name );
+    NodeOutputCache outputCache( *this, "Test", outputFiles );
+    bool useCache = false;
+    if ( m_TestAllowCaching && FBuild::Get().GetCache() )
+    {
+        AStackString< 4 * KILOBYTE > cacheArgs;
+        cacheArgs.Format( "%s|%s", m_TestArguments.Get(), m_TestWorkingDir.Get() );
+        for ( const AString & envVar : m_Environment )
+        {
+            cacheArgs += '|';
+            cacheArgs += envVar;
+        }
+        useCache = outputCache.BuildCacheId( GetTestExecutable()->GetName(), cacheArgs );
+        if ( useCache && outputCache.Retrieve() )
+        {
+            RecordStampFromBuiltFile();
+            return NODE_RESULT_OK_CACHE;
+        }
+    }
+
     EmitCompilationMessage( workingDir );
 
     // spawn the process
@@ -244,7 +269,11 @@ const char * TestNode::GetEnvironmentString() const
         return NODE_RESULT_FAILED;
     }
 
-    // test passed
+    // test passed (only passing results are cached, so failures are always re-run)
+    if ( useCache )
+    {
+        outputCache.Store();
+    }
 
     // record new file time
     RecordStampFromBuiltFile();
@@ -42,6 +42,7 @@ private:
     AString             m_TestWorkingDir;
     uint32_t            m_TestTimeOut;
     bool                m_TestAlwaysShowOutput;
+    bool                m_TestAllowCaching;
     bool                m_TestInputPathRecurse;
     Array< AString >    m_PreBuildDependencyNames;
     Array< AString >    m_Environment;
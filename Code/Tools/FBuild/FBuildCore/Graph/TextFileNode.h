@@ -24,6 +24,7 @@ public:
 
 private:
     virtual bool DetermineNeedToBuildStatic() const override;
+    virtual bool AlwaysNeedsChecking() const override { return m_TextFileAlways; }
     virtual BuildResult DoBuild( Job * job ) override;
 
     void EmitCompilationMessage() const;
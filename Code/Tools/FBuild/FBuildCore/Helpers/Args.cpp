@@ -26,6 +26,7 @@ Args::Args()
         , m_Finalized( false )
     #endif
     , m_DisableResponseFileWrite( false )
+    , m_Quiet( false )
 {
 }
 
@@ -126,7 +127,10 @@ bool Args::Finalize( const AString & exe, const AString & nodeNameForError, Args
             case ArgsResponseFileMode::NEVER:
             {
                 // Need response file but not supported
-                FLOG_ERROR( "FBuild: Error: Command Line Limit Exceeded (len: %u, limit: %u) '%s'\n", argLen, argLimit, nodeNameForError.Get() );
+                if ( m_Quiet == false )
+                {
+                    FLOG_ERROR( "FBuild: Error: Command Line Limit Exceeded (len: %u, limit: %u) '%s'\n", argLen, argLimit, nodeNameForError.Get() );
+                }
                 return false;
             }
             case ArgsResponseFileMode::IF_NEEDED:   break; // Create below
@@ -44,6 +44,7 @@ public:
     // Set Response File options
     void SetEscapeSlashesInResponseFile() { ASSERT( !m_Finalized ); m_ResponseFile.SetEscapeSlashes(); }
     void DisableResponseFileWrite() { m_DisableResponseFileWrite = true; } // Used by tests
+    void SetQuiet() { ASSERT( !m_Finalized ); m_Quiet = true; m_ResponseFile.SetQuiet(); } // Caller handles (and reports) failures
 
     // Do final fixups and create response file if needed/supported
     bool Finalize( const AString & exe, const AString & nodeNameForError, ArgsResponseFileMode responseFileMode );
@@ -64,6 +65,7 @@ protected:
         bool                m_Finalized;
     #endif
     bool                    m_DisableResponseFileWrite; // Used by tests
+    bool                    m_Quiet;
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,441 @@
+// BuildDaemon - Keep the dependency graph resident between builds
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "BuildDaemon.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/LightCache.h"
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/SharedMemory.h"
+#include "Core/Process/SystemMutex.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Tracing/Tracing.h"
+
+// system
+#include <memory.h>
+#include <stdio.h>
+
+// Defines
+//------------------------------------------------------------------------------
+#define BUILD_DAEMON_VERSION ( 1 )
+
+// BuildDaemonSharedData
+//------------------------------------------------------------------------------
+struct BuildDaemonSharedData
+{
+    uint32_t            m_Version;
+    volatile uint32_t   m_RequestId;        // Incremented by client to submit a request
+    volatile uint32_t   m_ResponseId;       // Set to m_RequestId by daemon once request is complete
+    volatile uint32_t   m_CancelRequestId;  // Set to m_RequestId by client to abort the build
+    volatile uint32_t   m_Result;           // Non-zero if the build succeeded
+
+    // Build output (ring buffer: written by daemon, read by client)
+    volatile uint32_t   m_OutputWritePos;
+    volatile uint32_t   m_OutputReadPos;
+    enum : uint32_t { kOutputSize = ( 64 * 1024 ) }; // Must be power of 2
+    char                m_Output[ kOutputSize ];
+
+    // Targets for request (null separated, double-null terminated)
+    enum : uint32_t { kRequestSize = ( 32 * 1024 ) };
+    char                m_Request[ kRequestSize ];
+};
+
+// Static Data
+//------------------------------------------------------------------------------
+/*static*/ BuildDaemon * BuildDaemon::s_Instance = nullptr;
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+BuildDaemon::BuildDaemon( const FBuildOptions & options )
+    : m_Options( options )
+    , m_FBuild( nullptr )
+    , m_NumNodesWatched( 0 )
+    , m_SharedData( nullptr )
+    , m_Exiting( false )
+    , m_RequestInProgress( 0 )
+    , m_Cancelled( false )
+    , m_ClientLost( false )
+{
+    ASSERT( s_Instance == nullptr );
+    s_Instance = this;
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+BuildDaemon::~BuildDaemon()
+{
+    FDELETE m_FBuild;
+
+    ASSERT( s_Instance == this );
+    s_Instance = nullptr;
+}
+
+// Run
+//------------------------------------------------------------------------------
+bool BuildDaemon::Run()
+{
+    // Only one daemon per working dir
+    SystemMutex daemonMutex( m_Options.GetDaemonMutexName().Get() );
+    if ( daemonMutex.TryLock() == false )
+    {
+        OUTPUT( "FBuild: Error: A FASTBuild daemon is already running in '%s'.\n", m_Options.GetWorkingDir().Get() );
+        return false;
+    }
+
+    // Create channel for clients
+    SharedMemory sharedMemory;
+    sharedMemory.Create( m_Options.GetDaemonSharedMemoryName().Get(), sizeof( BuildDaemonSharedData ) );
+    m_SharedData = static_cast< BuildDaemonSharedData * >( sharedMemory.GetPtr() );
+    if ( m_SharedData == nullptr )
+    {
+        OUTPUT( "FBuild: Error: Failed to create shared memory for daemon.\n" );
+        return false;
+    }
+    memset( m_SharedData, 0, sizeof( BuildDaemonSharedData ) );
+    AtomicStoreRelease( &m_SharedData->m_Version, (uint32_t)BUILD_DAEMON_VERSION );
+
+    if ( FileWatcher::IsSupported() == false )
+    {
+        FLOG_WARN( "File change notification is unavailable - all files will be checked for every build" );
+    }
+
+    // Load the graph up front, so the first request is fast too
+    m_FBuild = FNEW( FBuild( m_Options ) );
+    if ( m_FBuild->Initialize() )
+    {
+        WatchNewNodes();
+    }
+    else
+    {
+        FDELETE m_FBuild; // Will be re-attempted for each request
+        m_FBuild = nullptr;
+    }
+
+    m_MonitorThread.Start( MonitorThreadFuncStatic, "DaemonMonitor", this );
+
+    OUTPUT( "FBuild: Daemon running in '%s'. Ctrl-C to stop.\n", m_Options.GetWorkingDir().Get() );
+
+    for ( ;; )
+    {
+        // Ctrl-C while idle stops the daemon
+        if ( FBuild::GetStopBuild() )
+        {
+            break;
+        }
+
+        // Wait for a request
+        const uint32_t requestId = AtomicLoadAcquire( &m_SharedData->m_RequestId );
+        if ( requestId == AtomicLoadRelaxed( &m_SharedData->m_ResponseId ) )
+        {
+            Thread::Sleep( 10 );
+            continue;
+        }
+
+        // Extract targets
+        Array< AString > targets;
+        const char * pos = m_SharedData->m_Request;
+        const char * const end = ( m_SharedData->m_Request + BuildDaemonSharedData::kRequestSize );
+        while ( ( pos < end ) && ( *pos != 0 ) )
+        {
+            const AString & target = targets.EmplaceBack( pos );
+            pos += ( target.GetLength() + 1 );
+        }
+
+        // Build, forwarding output to the client
+        AtomicStoreRelaxed( &m_Cancelled, false );
+        AtomicStoreRelaxed( &m_ClientLost, false );
+        AtomicStoreRelease( &m_RequestInProgress, requestId );
+        Tracing::AddCallbackOutput( &OutputCallback );
+
+        const bool result = Build( targets );
+
+        Tracing::RemoveCallbackOutput( &OutputCallback );
+        AtomicStoreRelease( &m_RequestInProgress, (uint32_t)0 );
+
+        // Failed and cancelled builds set the stop flag, but shouldn't stop the daemon
+        AtomicStoreRelaxed( &FBuild::s_StopBuild, false );
+
+        AtomicStoreRelaxed( &m_SharedData->m_Result, result ? 1u : 0u );
+        AtomicStoreRelease( &m_SharedData->m_ResponseId, requestId );
+
+        OUTPUT( "FBuild: Daemon: Request %u %s\n", requestId, result ? "succeeded" : "failed" );
+    }
+
+    AtomicStoreRelaxed( &m_Exiting, true );
+    m_MonitorThread.Join();
+
+    m_SharedData = nullptr;
+    return true;
+}
+
+// SendBuildRequest
+//------------------------------------------------------------------------------
+/*static*/ BuildDaemon::RequestResult BuildDaemon::SendBuildRequest( const FBuildOptions & options )
+{
+    // Is a daemon running?
+    SystemMutex daemonMutex( options.GetDaemonMutexName().Get() );
+    if ( daemonMutex.TryLock() )
+    {
+        return RequestResult::NO_DAEMON;
+    }
+
+    // Only one client at a time
+    SystemMutex clientMutex( options.GetDaemonClientMutexName().Get() );
+    if ( clientMutex.TryLock() == false )
+    {
+        OUTPUT( "FBuild: Waiting for another build using the daemon to complete...\n" );
+        while ( clientMutex.TryLock() == false )
+        {
+            Thread::Sleep( 100 );
+            if ( FBuild::GetStopBuild() )
+            {
+                return RequestResult::BUILD_FAILED;
+            }
+        }
+    }
+
+    SharedMemory sharedMemory;
+    if ( sharedMemory.Open( options.GetDaemonSharedMemoryName().Get(), sizeof( BuildDaemonSharedData ) ) == false )
+    {
+        return RequestResult::NO_DAEMON; // Daemon is still starting up or shutting down
+    }
+    BuildDaemonSharedData * sharedData = static_cast< BuildDaemonSharedData * >( sharedMemory.GetPtr() );
+    if ( AtomicLoadAcquire( &sharedData->m_Version ) != BUILD_DAEMON_VERSION )
+    {
+        return RequestResult::NO_DAEMON; // Incompatible (or still initializing) daemon
+    }
+
+    // Wait for the previous request to complete (if its client terminated, the
+    // daemon will abort it)
+    uint32_t requestId = AtomicLoadAcquire( &sharedData->m_RequestId );
+    while ( AtomicLoadAcquire( &sharedData->m_ResponseId ) != requestId )
+    {
+        if ( daemonMutex.TryLock() )
+        {
+            return RequestResult::DAEMON_LOST;
+        }
+        Thread::Sleep( 10 );
+    }
+
+    // Write targets
+    char * pos = sharedData->m_Request;
+    const char * const end = ( sharedData->m_Request + BuildDaemonSharedData::kRequestSize - 1 ); // leave space for double-null
+    for ( const AString & target : options.m_Targets )
+    {
+        if ( ( pos + target.GetLength() + 1 ) > end )
+        {
+            OUTPUT( "FBuild: Error: Too many targets to send to daemon.\n" );
+            return RequestResult::BUILD_FAILED;
+        }
+        AString::Copy( target.Get(), pos, target.GetLength() ); // Copy includes null terminator
+        pos += ( target.GetLength() + 1 );
+    }
+    *pos = 0;
+
+    // Submit
+    sharedData->m_OutputReadPos = sharedData->m_OutputWritePos; // Discard unread output of a terminated client
+    ++requestId;
+    requestId = ( requestId == 0 ) ? 1 : requestId; // 0 is reserved to mean no request
+    AtomicStoreRelease( &sharedData->m_RequestId, requestId );
+
+    // Forward output until the build completes
+    bool cancelled = false;
+    for ( ;; )
+    {
+        const bool complete = ( AtomicLoadAcquire( &sharedData->m_ResponseId ) == requestId );
+
+        uint32_t readPos = AtomicLoadRelaxed( &sharedData->m_OutputReadPos );
+        const uint32_t writePos = AtomicLoadAcquire( &sharedData->m_OutputWritePos );
+        if ( readPos != writePos )
+        {
+            AStackString< 4096 > buffer;
+            while ( readPos != writePos )
+            {
+                buffer += sharedData->m_Output[ readPos & ( BuildDaemonSharedData::kOutputSize - 1 ) ];
+                ++readPos;
+            }
+            AtomicStoreRelease( &sharedData->m_OutputReadPos, readPos );
+            Tracing::Output( buffer.Get() );
+            continue;
+        }
+
+        if ( complete )
+        {
+            break;
+        }
+
+        if ( daemonMutex.TryLock() )
+        {
+            OUTPUT( "FBuild: Error: Daemon terminated during build.\n" );
+            return RequestResult::DAEMON_LOST;
+        }
+
+        // Forward Ctrl-C
+        if ( ( cancelled == false ) && FBuild::GetStopBuild() )
+        {
+            AtomicStoreRelease( &sharedData->m_CancelRequestId, requestId );
+            cancelled = true;
+        }
+
+        Thread::Sleep( 1 );
+    }
+
+    return AtomicLoadRelaxed( &sharedData->m_Result ) ? RequestResult::BUILD_OK : RequestResult::BUILD_FAILED;
+}
+
+// Build
+//------------------------------------------------------------------------------
+bool BuildDaemon::Build( const Array< AString > & targets )
+{
+    // Determine what changed since the last build
+    // NOTE: Change tracking is only supported on Linux. Elsewhere everything is
+    // always reported as changed, so the graph is reloaded for every build.
+    Array< AString > changedFiles( 1024, true );
+    Array< AString > changedDirs( 64, true );
+    bool allChanged = false;
+    m_FileWatcher.GetChanges( changedFiles, changedDirs, allChanged );
+
+    if ( m_FBuild )
+    {
+        if ( allChanged )
+        {
+            FLOG_VERBOSE( "Daemon: Changes may have been missed - reloading" );
+            FDELETE m_FBuild;
+            m_FBuild = nullptr;
+        }
+        else if ( m_FBuild->m_DependencyGraph->InvalidateNodes( changedFiles, changedDirs ) == false )
+        {
+            FLOG_VERBOSE( "Daemon: BFF changed - reloading" );
+            FDELETE m_FBuild;
+            m_FBuild = nullptr;
+        }
+        else
+        {
+            // Keep parse results for unmodified files
+            LightCache::InvalidateCachedFiles( changedFiles, changedDirs );
+        }
+    }
+
+    // (Re)load graph if needed
+    if ( m_FBuild == nullptr )
+    {
+        m_FBuild = FNEW( FBuild( m_Options ) );
+        m_NumNodesWatched = 0;
+        if ( m_FBuild->Initialize() == false )
+        {
+            FDELETE m_FBuild;
+            m_FBuild = nullptr;
+            return false;
+        }
+    }
+
+    const bool result = m_FBuild->Build( targets );
+
+    // Watch files discovered during the build. Changes made while building to
+    // files in directories which were not yet watched will be missed.
+    WatchNewNodes();
+
+    return result;
+}
+
+// WatchNewNodes
+//------------------------------------------------------------------------------
+void BuildDaemon::WatchNewNodes()
+{
+    const NodeGraph & nodeGraph = *m_FBuild->m_DependencyGraph;
+
+    Array< AString > dirs( 1024, true );
+    Array< bool > recursive( 1024, true );
+    nodeGraph.GetDirectoriesToWatch( m_NumNodesWatched, dirs, recursive );
+    for ( size_t i = 0; i < dirs.GetSize(); ++i )
+    {
+        m_FileWatcher.AddDirectory( dirs[ i ], recursive[ i ] );
+    }
+
+    m_NumNodesWatched = nodeGraph.GetNodeCount();
+}
+
+// MonitorThreadFuncStatic
+//------------------------------------------------------------------------------
+/*static*/ uint32_t BuildDaemon::MonitorThreadFuncStatic( void * param )
+{
+    static_cast< BuildDaemon * >( param )->MonitorThreadFunc();
+    return 0;
+}
+
+// MonitorThreadFunc
+//------------------------------------------------------------------------------
+void BuildDaemon::MonitorThreadFunc()
+{
+    SystemMutex clientMutex( m_Options.GetDaemonClientMutexName().Get() );
+    while ( AtomicLoadRelaxed( &m_Exiting ) == false )
+    {
+        Thread::Sleep( 50 );
+
+        const uint32_t requestId = AtomicLoadAcquire( &m_RequestInProgress );
+        if ( requestId == 0 )
+        {
+            continue;
+        }
+
+        // Client terminated?
+        if ( ( AtomicLoadRelaxed( &m_ClientLost ) == false ) && clientMutex.TryLock() )
+        {
+            clientMutex.Unlock();
+            AtomicStoreRelaxed( &m_ClientLost, true ); // Stop waiting for client to read output
+        }
+
+        // Abort build if client has gone or cancelled
+        const bool cancel = AtomicLoadRelaxed( &m_ClientLost ) ||
+                            ( AtomicLoadAcquire( &m_SharedData->m_CancelRequestId ) == requestId );
+        if ( cancel && ( AtomicLoadRelaxed( &m_Cancelled ) == false ) )
+        {
+            AtomicStoreRelaxed( &m_Cancelled, true );
+            FBuild::AbortBuild();
+        }
+    }
+}
+
+// OutputCallback
+//------------------------------------------------------------------------------
+/*static*/ bool BuildDaemon::OutputCallback( const char * message )
+{
+    s_Instance->WriteOutput( message );
+    return false; // Output only to client
+}
+
+// WriteOutput
+//------------------------------------------------------------------------------
+void BuildDaemon::WriteOutput( const char * message )
+{
+    // NOTE: Tracing serializes calls to output callbacks
+
+    BuildDaemonSharedData * sharedData = m_SharedData;
+    uint32_t writePos = AtomicLoadRelaxed( &sharedData->m_OutputWritePos );
+    for ( const char * pos = message; *pos; ++pos )
+    {
+        // Wait for space, unless nobody is reading
+        while ( ( writePos - AtomicLoadAcquire( &sharedData->m_OutputReadPos ) ) == BuildDaemonSharedData::kOutputSize )
+        {
+            if ( AtomicLoadRelaxed( &m_ClientLost ) )
+            {
+                return;
+            }
+            Thread::Sleep( 1 );
+        }
+
+        sharedData->m_Output[ writePos & ( BuildDaemonSharedData::kOutputSize - 1 ) ] = *pos;
+        ++writePos;
+        AtomicStoreRelease( &sharedData->m_OutputWritePos, writePos );
+    }
+}
+
+//------------------------------------------------------------------------------
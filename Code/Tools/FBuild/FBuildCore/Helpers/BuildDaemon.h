@@ -0,0 +1,69 @@
+// BuildDaemon - Keep the dependency graph resident between builds
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Tools/FBuild/FBuildCore/FBuildOptions.h"
+
+#include "Core/FileIO/FileWatcher.h"
+#include "Core/Process/Thread.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class FBuild;
+struct BuildDaemonSharedData;
+
+// BuildDaemon
+//  - The daemon (-daemon) keeps the NodeGraph loaded and watches the files it
+//    references. Builds requested by clients (-usedaemon) then only re-evaluate
+//    nodes affected by files changed since the previous build.
+//  - Requests and build output are passed via SharedMemory, with SystemMutexes
+//    used to detect the lifetime of each side (as for -wrapper mode).
+//------------------------------------------------------------------------------
+class BuildDaemon
+{
+public:
+    explicit BuildDaemon( const FBuildOptions & options );
+    ~BuildDaemon();
+
+    // Daemon side: serve requests until Ctrl-C is pressed while idle
+    bool Run();
+
+    // Client side: build the targets in the options using a running daemon
+    enum class RequestResult : uint8_t
+    {
+        NO_DAEMON,      // No daemon is running - caller should build normally
+        BUILD_OK,
+        BUILD_FAILED,
+        DAEMON_LOST,    // Daemon terminated during the build
+    };
+    static RequestResult SendBuildRequest( const FBuildOptions & options );
+
+private:
+    bool        Build( const Array< AString > & targets );
+    void        WatchNewNodes();
+
+    static uint32_t MonitorThreadFuncStatic( void * param );
+    void        MonitorThreadFunc();
+
+    static bool OutputCallback( const char * message );
+    void        WriteOutput( const char * message );
+
+    FBuildOptions           m_Options;
+    FBuild *                m_FBuild;
+    FileWatcher             m_FileWatcher;
+    size_t                  m_NumNodesWatched;
+    BuildDaemonSharedData * m_SharedData;
+
+    // Client lifetime is monitored while building
+    Thread                  m_MonitorThread;
+    volatile bool           m_Exiting;
+    volatile uint32_t       m_RequestInProgress;    // Request Id being built (0 if idle)
+    volatile bool           m_Cancelled;            // Client cancelled the build
+    volatile bool           m_ClientLost;           // Client terminated during the build
+
+    static BuildDaemon *    s_Instance;
+};
+
+//------------------------------------------------------------------------------
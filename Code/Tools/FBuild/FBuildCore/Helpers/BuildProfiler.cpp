@@ -78,7 +78,32 @@ void BuildProfiler::RecordRemote( uint32_t workerId,
     MutexHolder mh( m_Mutex );
 
     // Record details of worker the first time we see one
-    //RecordWorkerInfo( workerId, remoteThreadId, workerName );
+    RecordWorkerInfo( workerId, remoteThreadId, workerName );
+
+    // Note the remote compilation event
+    m_Events.EmplaceBack( static_cast<int32_t>(workerId), remoteThreadId, startTime, endTime, stepName, targetName );
+}
+
+// RecordRemoteSlots
+//------------------------------------------------------------------------------
+void BuildProfiler::RecordRemoteSlots( uint32_t workerId,
+                                       const AString & workerName,
+                                       int64_t time,
+                                       uint32_t numJobsInFlight )
+{
+    MutexHolder mh( m_Mutex );
+
+    // Record details of worker the first time we see one
+    RecordWorkerInfo( workerId, 0, workerName );
+
+    m_SlotSamples.EmplaceBack( workerId, time, numJobsInFlight );
+}
+
+// RecordWorkerInfo
+//------------------------------------------------------------------------------
+void BuildProfiler::RecordWorkerInfo( uint32_t workerId, uint32_t remoteThreadId, const AString & workerName )
+{
+    // NOTE: Caller must hold m_Mutex
     if ( workerId >= m_WorkerInfo.GetSize() )
     {
         // Extend the array so it encompasses the new index
@@ -96,10 +121,13 @@ void BuildProfiler::RecordRemote( uint32_t workerId,
         // Update the highest seen thread index
         WorkerInfo & workerInfo = m_WorkerInfo[ workerId ];
         workerInfo.m_MaxThreadId = Math::Max( workerInfo.m_MaxThreadId, remoteThreadId );
-    }
 
-    // Note the remote compilation event
-    m_Events.EmplaceBack( static_cast<int32_t>(workerId), remoteThreadId, startTime, endTime, stepName, targetName );
+        // Name may not have been recorded if worker was skipped over
+        if ( workerInfo.m_WorkerName.IsEmpty() )
+        {
+            workerInfo.m_WorkerName = workerName;
+        }
+    }
 }
 
 // SaveJSON
@@ -195,6 +223,15 @@ bool BuildProfiler::SaveJSON( const FBuildOptions & options,  const char * fileN
         }
     }
 
+    // Serialize remote worker slot usage
+    for ( const SlotSample & sample : m_SlotSamples )
+    {
+        buffer.AppendFormat( "{\"name\":\"Jobs In Flight\",\"ph\":\"C\",\"ts\":%" PRIu64 ",\"pid\":%u,\"args\":{\"Num\":%u}},",
+                             (uint64_t)( (double)sample.m_Time * freqMul ),
+                             sample.m_WorkerId,
+                             sample.m_NumJobsInFlight );
+    }
+
     // Open output file and write the majority of the profiling info
     FileStream f;
     if ( ( f.Open( fileName, FileStream::WRITE_ONLY ) == false ) ||
@@ -48,12 +48,19 @@ public:
                        const char * stepName,
                        const char * targetName );
 
+    // Record number of jobs in flight to a remote worker
+    void RecordRemoteSlots( uint32_t workerId,
+                            const AString & workerName,
+                            int64_t time,
+                            uint32_t numJobsInFlight );
+
     // Write the profiling info in Chrome tracing format
     bool SaveJSON( const FBuildOptions & options, const char * fileName );
 
 protected:
     static uint32_t MetricsThreadWrapper( void * userData );
     void MetricsUpdate();
+    void RecordWorkerInfo( uint32_t workerId, uint32_t remoteThreadId, const AString & workerName );
 
     // Items processed during the build
     class Event
@@ -92,6 +99,21 @@ protected:
         uint16_t            m_NumConnections = 0;
     };
 
+    // Jobs in flight to a remote worker at a point in time
+    class SlotSample
+    {
+    public:
+        SlotSample( uint32_t workerId, int64_t time, uint32_t numJobsInFlight )
+            : m_WorkerId( workerId )
+            , m_NumJobsInFlight( numJobsInFlight )
+            , m_Time( time )
+        {}
+
+        uint32_t            m_WorkerId;
+        uint32_t            m_NumJobsInFlight;
+        int64_t             m_Time;
+    };
+
     // Track information about workers which performed useful work
     class WorkerInfo
     {
@@ -106,6 +128,7 @@ protected:
     Thread                  m_Thread;
     Array<Event>            m_Events;
     Array<Metrics>          m_Metrics;
+    Array<SlotSample>       m_SlotSamples;
     Array<WorkerInfo>       m_WorkerInfo;
 };
 
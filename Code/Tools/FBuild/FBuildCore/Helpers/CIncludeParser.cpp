@@ -6,6 +6,7 @@
 #include "CIncludeParser.h"
 
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/DirectiveScanner.h"
 #include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 
 // Core
@@ -225,29 +226,6 @@ bool CIncludeParser::ParseMSCL_Preprocessed( const char * compilerOutput,
     return true;
 }
 
-// ParseToNextLineStaringWithHash
-//------------------------------------------------------------------------------
-/*static*/ void CIncludeParser::ParseToNextLineStartingWithHash( const char * & pos )
-{
-    for (;;)
-    {
-        pos = strchr( pos, '#' );
-        if ( pos )
-        {
-            // Safe to index -1 because # as first char is handled as a
-            // special case to avoid having it in this critical loop
-            const char prevC = pos[ -1 ];
-            if ( ( prevC  == '\n' ) || ( prevC  == '\r' ) )
-            {
-                return;
-            }
-            ++pos;
-            continue;
-        }
-        return;
-    }
-}
-
 // Parse
 //------------------------------------------------------------------------------
 // TODO:C - restructure function to avoid use of gotos
@@ -257,9 +235,9 @@ bool CIncludeParser::ParseGCC_Preprocessed( const char * compilerOutput,
 {
     // we require null terminated input
     ASSERT( compilerOutput[ compilerOutputSize ] == 0 );
-    (void)compilerOutputSize;
 
     const char * pos = compilerOutput;
+    const char * const end = compilerOutput + compilerOutputSize;
     bool hasFlags = true;
 
     // special case for include on first line
@@ -272,8 +250,10 @@ bool CIncludeParser::ParseGCC_Preprocessed( const char * compilerOutput,
 
     for (;;)
     {
-        ParseToNextLineStartingWithHash( pos );
-        if ( !pos )
+        // Safe to index -1 because # as first char is handled as a
+        // special case to avoid having it in this critical loop
+        pos = DirectiveScanner::FindHashAtLineStart( pos, end );
+        if ( pos == end )
         {
             break;
         }
@@ -366,6 +346,114 @@ void CIncludeParser::SwapIncludes( Array< AString > & includes )
     m_Includes.Swap( includes );
 }
 
+// ParseGCC_Dependencies
+//------------------------------------------------------------------------------
+bool CIncludeParser::ParseGCC_Dependencies( const char * compilerOutput,
+                                            size_t compilerOutputSize )
+{
+    // Parse a single "makefile" rule as output by -M, e.g.:
+    //   file.o: file.cpp /path/to/header.h /path/to/other\ header.h
+    // where long lines are continued with a trailing backslash
+
+    // we require null terminated input
+    ASSERT( compilerOutput[ compilerOutputSize ] == 0 );
+
+    const char * pos = compilerOutput;
+    const char * const end = compilerOutput + compilerOutputSize;
+
+    // skip target (Windows paths can contain colons, so look for a colon followed by whitespace)
+    for ( ;; )
+    {
+        if ( ( pos == end ) || ( *pos == '\r' ) || ( *pos == '\n' ) )
+        {
+            return false; // not a rule
+        }
+        if ( ( pos[ 0 ] == ':' ) && ( ( pos[ 1 ] == ' ' ) || ( pos[ 1 ] == '\t' ) || ( pos[ 1 ] == '\r' ) || ( pos[ 1 ] == '\n' ) || ( pos[ 1 ] == 0 ) ) )
+        {
+            ++pos;
+            break;
+        }
+        ++pos;
+    }
+
+    // prerequisites
+    AStackString< 256 > include;
+    for ( ;; )
+    {
+        // skip whitespace and line continuations
+        for ( ;; )
+        {
+            if ( ( *pos == ' ' ) || ( *pos == '\t' ) )
+            {
+                ++pos;
+                continue;
+            }
+            if ( ( pos[ 0 ] == '\\' ) && ( ( pos[ 1 ] == '\r' ) || ( pos[ 1 ] == '\n' ) ) )
+            {
+                pos += 2;
+                if ( ( pos[ -1 ] == '\r' ) && ( *pos == '\n' ) )
+                {
+                    ++pos;
+                }
+                continue;
+            }
+            break;
+        }
+
+        // end of rule?
+        if ( ( pos == end ) || ( *pos == '\r' ) || ( *pos == '\n' ) )
+        {
+            break;
+        }
+
+        // extract path, handling escaped characters
+        include.Clear();
+        for ( ;; )
+        {
+            const char c = *pos;
+            if ( ( pos == end ) || ( c == ' ' ) || ( c == '\t' ) || ( c == '\r' ) || ( c == '\n' ) )
+            {
+                break;
+            }
+            if ( c == '\\' )
+            {
+                const char next = pos[ 1 ];
+                if ( ( next == '\r' ) || ( next == '\n' ) )
+                {
+                    break; // line continuation
+                }
+                if ( ( next == ' ' ) || ( next == '#' ) )
+                {
+                    include += next;
+                    pos += 2;
+                    continue;
+                }
+            }
+            if ( ( c == '$' ) && ( pos[ 1 ] == '$' ) )
+            {
+                include += '$';
+                pos += 2;
+                continue;
+            }
+            include += c;
+            ++pos;
+        }
+
+        AddInclude( include.Get(), include.GetEnd() );
+    }
+
+    // Anything else (additional rules for example) is unexpected
+    for ( ; pos < end; ++pos )
+    {
+        if ( ( *pos != ' ' ) && ( *pos != '\t' ) && ( *pos != '\r' ) && ( *pos != '\n' ) )
+        {
+            return false;
+        }
+    }
+
+    return ( m_Includes.IsEmpty() == false );
+}
+
 // AddInclude
 //------------------------------------------------------------------------------
 void CIncludeParser::AddInclude( const char * begin, const char * end )
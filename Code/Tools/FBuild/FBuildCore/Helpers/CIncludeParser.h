@@ -19,6 +19,7 @@ public:
     bool ParseMSCL_Output( const char * compilerOutput, size_t compilerOutputSize );
     bool ParseMSCL_Preprocessed( const char * compilerOutput, size_t compilerOutputSize );
     bool ParseGCC_Preprocessed( const char * compilerOutput, size_t compilerOutputSize );
+    bool ParseGCC_Dependencies( const char * compilerOutput, size_t compilerOutputSize );
 
     const Array< AString > & GetIncludes() const { return m_Includes; }
 
@@ -29,8 +30,6 @@ public:
     #endif
 
 private:
-    static void ParseToNextLineStartingWithHash( const char * & pos );
-
     void AddInclude( const char * begin, const char * end );
 
     // temporary data
@@ -0,0 +1,383 @@
+// CompressionDictionary - Trained LZ4 dictionary used by the Compressor
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "CompressionDictionary.h"
+
+// Core
+#include "Core/Env/Assert.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/IOStream.h"
+#include "Core/Math/Conversions.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AString.h"
+
+// system
+#include <memory.h> // for memcmp, memcpy
+
+// Defines
+//------------------------------------------------------------------------------
+#define DICTIONARY_FILE_MAGIC       ( 'F' | ( 'B' << 8 ) | ( 'D' << 16 ) | ( 'C' << 24 ) )
+#define DICTIONARY_FILE_VERSION     ( 1 )
+
+// Training
+//------------------------------------------------------------------------------
+namespace
+{
+    enum : uint32_t
+    {
+        DICTIONARY_SEGMENT_SIZE         = 32,   // Length of content considered for sharing
+        DICTIONARY_SEGMENT_STEP         = 4,    // Spacing of segments within a sample
+        DICTIONARY_MAX_SAMPLED_BYTES    = ( 8 * 1024 * 1024 ), // Bounds training time and memory
+    };
+
+    // A segment of a sample, identified by the hash of its contents
+    struct DictionarySegment
+    {
+        uint64_t    m_Hash;
+        uint32_t    m_Sample;
+        uint32_t    m_Offset;
+
+        bool operator < ( const DictionarySegment & other ) const
+        {
+            if ( m_Hash != other.m_Hash )
+            {
+                return ( m_Hash < other.m_Hash );
+            }
+            if ( m_Sample != other.m_Sample )
+            {
+                return ( m_Sample < other.m_Sample );
+            }
+            return ( m_Offset < other.m_Offset );
+        }
+    };
+
+    // Content found in several samples
+    struct DictionaryCandidate
+    {
+        uint32_t    m_NumSamples;
+        uint32_t    m_Sample;   // First occurrence
+        uint32_t    m_Offset;
+
+        bool operator < ( const DictionaryCandidate & other ) const
+        {
+            // Most widely shared first
+            if ( m_NumSamples != other.m_NumSamples )
+            {
+                return ( m_NumSamples > other.m_NumSamples );
+            }
+            if ( m_Sample != other.m_Sample )
+            {
+                return ( m_Sample < other.m_Sample );
+            }
+            return ( m_Offset < other.m_Offset );
+        }
+    };
+}
+
+// Registry
+//------------------------------------------------------------------------------
+enum : uint32_t { MAX_REGISTERED_DICTIONARIES = 64 };
+static Mutex g_DictionaryRegistryMutex;
+static const CompressionDictionary * g_DictionaryRegistry[ MAX_REGISTERED_DICTIONARIES ];
+static uint32_t g_NumRegisteredDictionaries = 0;
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+CompressionDictionary::CompressionDictionary( Type type, const void * data, size_t dataSize )
+    : m_Type( type )
+    , m_Id( xxHash3::Calc64( data, dataSize ) )
+    , m_Data( ALLOC( dataSize ) )
+    , m_Size( dataSize )
+{
+    ASSERT( type < NUM_TYPES );
+    ASSERT( ( dataSize > 0 ) && ( dataSize <= MAX_SIZE ) );
+    memcpy( m_Data, data, dataSize );
+}
+
+// DESTRUCTOR
+//------------------------------------------------------------------------------
+CompressionDictionary::~CompressionDictionary()
+{
+    FREE( m_Data );
+}
+
+// Write
+//------------------------------------------------------------------------------
+void CompressionDictionary::Write( IOStream & stream ) const
+{
+    stream.Write( (uint32_t)DICTIONARY_FILE_MAGIC );
+    stream.Write( (uint32_t)DICTIONARY_FILE_VERSION );
+    stream.Write( (uint32_t)m_Type );
+    stream.Write( (uint32_t)m_Size );
+    stream.WriteBuffer( m_Data, m_Size );
+}
+
+// Read
+//------------------------------------------------------------------------------
+/*static*/ CompressionDictionary * CompressionDictionary::Read( IOStream & stream )
+{
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t type = 0;
+    uint32_t size = 0;
+    if ( ( stream.Read( magic ) == false ) ||
+         ( magic != DICTIONARY_FILE_MAGIC ) ||
+         ( stream.Read( version ) == false ) ||
+         ( version != DICTIONARY_FILE_VERSION ) ||
+         ( stream.Read( type ) == false ) ||
+         ( type >= NUM_TYPES ) ||
+         ( stream.Read( size ) == false ) ||
+         ( size == 0 ) ||
+         ( size > MAX_SIZE ) )
+    {
+        return nullptr;
+    }
+
+    void * data = ALLOC( size );
+    CompressionDictionary * dictionary = nullptr;
+    if ( stream.ReadBuffer( data, size ) == size )
+    {
+        dictionary = FNEW( CompressionDictionary( (Type)type, data, size ) );
+    }
+    FREE( data );
+    return dictionary;
+}
+
+// Save
+//------------------------------------------------------------------------------
+bool CompressionDictionary::Save( const AString & fileName ) const
+{
+    if ( FileIO::EnsurePathExistsForFile( fileName ) == false )
+    {
+        return false;
+    }
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::WRITE_ONLY ) == false )
+    {
+        return false;
+    }
+    Write( fs );
+    return true;
+}
+
+// Load
+//------------------------------------------------------------------------------
+/*static*/ CompressionDictionary * CompressionDictionary::Load( const AString & fileName )
+{
+    FileStream fs;
+    if ( fs.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return nullptr;
+    }
+    return Read( fs );
+}
+
+// GetFileName
+//------------------------------------------------------------------------------
+/*static*/ const char * CompressionDictionary::GetFileName( Type type )
+{
+    switch ( type )
+    {
+        case OBJECTS:       return "Objects.lz4dict";
+        case PREPROCESSED:  return "Preprocessed.lz4dict";
+        case NUM_TYPES:     break;
+    }
+    ASSERT( false );
+    return "";
+}
+
+// GetTypeName
+//------------------------------------------------------------------------------
+/*static*/ const char * CompressionDictionary::GetTypeName( Type type )
+{
+    switch ( type )
+    {
+        case OBJECTS:       return "Objects";
+        case PREPROCESSED:  return "Preprocessed";
+        case NUM_TYPES:     break;
+    }
+    ASSERT( false );
+    return "";
+}
+
+// Train
+//------------------------------------------------------------------------------
+/*static*/ CompressionDictionary * CompressionDictionary::Train( Type type,
+                                                                 const Array< const void * > & samples,
+                                                                 const Array< size_t > & sampleSizes,
+                                                                 size_t maxSize )
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( samples.GetSize() == sampleSizes.GetSize() );
+    maxSize = Math::Min( maxSize, (size_t)MAX_SIZE );
+
+    // Hash regularly spaced segments of each sample, bounding the
+    // total amount of data considered
+    const uint32_t numSamples = (uint32_t)samples.GetSize();
+    Array< size_t > sampledSizes( numSamples, false );
+    Array< size_t > coverageOffsets( numSamples, false );
+    size_t totalSampledBytes = 0;
+    for ( uint32_t i = 0; i < numSamples; ++i )
+    {
+        const size_t size = Math::Min( sampleSizes[ i ], (size_t)DICTIONARY_MAX_SAMPLED_BYTES - totalSampledBytes );
+        sampledSizes.Append( size );
+        coverageOffsets.Append( totalSampledBytes );
+        totalSampledBytes += size;
+    }
+    Array< DictionarySegment > segments( totalSampledBytes / DICTIONARY_SEGMENT_STEP, false );
+    for ( uint32_t i = 0; i < numSamples; ++i )
+    {
+        const char * data = static_cast< const char * >( samples[ i ] );
+        for ( size_t offset = 0; ( offset + DICTIONARY_SEGMENT_SIZE ) <= sampledSizes[ i ]; offset += DICTIONARY_SEGMENT_STEP )
+        {
+            DictionarySegment & segment = segments.EmplaceBack();
+            segment.m_Hash = xxHash::Calc64( data + offset, DICTIONARY_SEGMENT_SIZE );
+            segment.m_Sample = i;
+            segment.m_Offset = (uint32_t)offset;
+        }
+    }
+
+    // Group identical segments to find those shared between samples
+    segments.Sort();
+    Array< DictionaryCandidate > candidates( 0, true );
+    for ( size_t i = 0; i < segments.GetSize(); )
+    {
+        const DictionarySegment & first = segments[ i ];
+        uint32_t numSamplesSharing = 0;
+        uint32_t lastSample = 0;
+        size_t j = i;
+        for ( ; ( j < segments.GetSize() ) && ( segments[ j ].m_Hash == first.m_Hash ); ++j )
+        {
+            if ( ( numSamplesSharing == 0 ) || ( segments[ j ].m_Sample != lastSample ) )
+            {
+                ++numSamplesSharing;
+                lastSample = segments[ j ].m_Sample;
+            }
+        }
+        if ( numSamplesSharing > 1 )
+        {
+            DictionaryCandidate & candidate = candidates.EmplaceBack();
+            candidate.m_NumSamples = numSamplesSharing;
+            candidate.m_Sample = first.m_Sample;
+            candidate.m_Offset = first.m_Offset;
+        }
+        i = j;
+    }
+    if ( candidates.IsEmpty() )
+    {
+        return nullptr; // Nothing in common
+    }
+
+    // Select the most widely shared content. Overlapping segments are common
+    // (shared content longer than a segment) so track coverage to avoid duplication.
+    candidates.Sort();
+    Array< bool > coverage( totalSampledBytes, false );
+    coverage.SetSize( totalSampledBytes );
+    memset( coverage.Begin(), 0, totalSampledBytes * sizeof( bool ) );
+    size_t dictionarySize = 0;
+    for ( const DictionaryCandidate & candidate : candidates )
+    {
+        bool * covered = coverage.Begin() + coverageOffsets[ candidate.m_Sample ] + candidate.m_Offset;
+        size_t newBytes = 0;
+        for ( size_t k = 0; k < DICTIONARY_SEGMENT_SIZE; ++k )
+        {
+            newBytes += covered[ k ] ? 0 : 1;
+        }
+        if ( ( dictionarySize + newBytes ) > maxSize )
+        {
+            break;
+        }
+        for ( size_t k = 0; k < DICTIONARY_SEGMENT_SIZE; ++k )
+        {
+            covered[ k ] = true;
+        }
+        dictionarySize += newBytes;
+    }
+
+    // Gather the selected content
+    char * buffer = static_cast< char * >( ALLOC( dictionarySize ) );
+    size_t pos = 0;
+    for ( uint32_t i = 0; i < numSamples; ++i )
+    {
+        const char * data = static_cast< const char * >( samples[ i ] );
+        const bool * covered = coverage.Begin() + coverageOffsets[ i ];
+        for ( size_t offset = 0; offset < sampledSizes[ i ]; ++offset )
+        {
+            if ( covered[ offset ] )
+            {
+                buffer[ pos++ ] = data[ offset ];
+            }
+        }
+    }
+    ASSERT( pos == dictionarySize );
+
+    CompressionDictionary * dictionary = FNEW( CompressionDictionary( type, buffer, dictionarySize ) );
+    FREE( buffer );
+    return dictionary;
+}
+
+// Register
+//------------------------------------------------------------------------------
+/*static*/ bool CompressionDictionary::Register( const CompressionDictionary * dictionary )
+{
+    MutexHolder mh( g_DictionaryRegistryMutex );
+    if ( g_NumRegisteredDictionaries == MAX_REGISTERED_DICTIONARIES )
+    {
+        return false; // Registry full
+    }
+
+    // Registering identical dictionaries is fine (Find can return either)
+    for ( uint32_t i = 0; i < g_NumRegisteredDictionaries; ++i )
+    {
+        const CompressionDictionary * existing = g_DictionaryRegistry[ i ];
+        if ( ( existing->GetId() == dictionary->GetId() ) &&
+             ( ( existing->GetSize() != dictionary->GetSize() ) ||
+               ( memcmp( existing->GetData(), dictionary->GetData(), dictionary->GetSize() ) != 0 ) ) )
+        {
+            return false; // Id collision
+        }
+    }
+
+    g_DictionaryRegistry[ g_NumRegisteredDictionaries++ ] = dictionary;
+    return true;
+}
+
+// Unregister
+//------------------------------------------------------------------------------
+/*static*/ void CompressionDictionary::Unregister( const CompressionDictionary * dictionary )
+{
+    MutexHolder mh( g_DictionaryRegistryMutex );
+    for ( uint32_t i = 0; i < g_NumRegisteredDictionaries; ++i )
+    {
+        if ( g_DictionaryRegistry[ i ] == dictionary )
+        {
+            g_DictionaryRegistry[ i ] = g_DictionaryRegistry[ --g_NumRegisteredDictionaries ];
+            return;
+        }
+    }
+    ASSERT( false ); // Not registered
+}
+
+// Find
+//------------------------------------------------------------------------------
+/*static*/ const CompressionDictionary * CompressionDictionary::Find( uint64_t id )
+{
+    MutexHolder mh( g_DictionaryRegistryMutex );
+    for ( uint32_t i = 0; i < g_NumRegisteredDictionaries; ++i )
+    {
+        if ( g_DictionaryRegistry[ i ]->GetId() == id )
+        {
+            return g_DictionaryRegistry[ i ];
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
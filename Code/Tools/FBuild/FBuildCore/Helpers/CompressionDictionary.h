@@ -0,0 +1,75 @@
+// CompressionDictionary - Trained LZ4 dictionary used by the Compressor
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+// Core
+#include "Core/Containers/Array.h"
+#include "Core/Env/Types.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class AString;
+class IOStream;
+
+// CompressionDictionary
+//  - Small inputs (object files, preprocessed translation units) share a lot of
+//    content (headers, debug sections etc.) which LZ4 can't exploit when each
+//    input is compressed in isolation. Priming the compressor with a dictionary
+//    of common content recovers much of that.
+//  - Dictionaries are identified by a 64-bit hash of their full contents.
+//    Compressed data records the id, so a dictionary with the same id must be
+//    registered to decompress it.
+//------------------------------------------------------------------------------
+class CompressionDictionary
+{
+public:
+    enum Type : uint32_t
+    {
+        OBJECTS         = 0,    // Compiler outputs (cache entries and distributed results)
+        PREPROCESSED    = 1,    // Preprocessed source (distributed jobs)
+
+        NUM_TYPES       // leave last
+    };
+    enum : uint32_t { MAX_SIZE = ( 64 * 1024 ) }; // LZ4 only references the last 64 KiB
+
+    explicit CompressionDictionary( Type type, const void * data, size_t dataSize );
+    ~CompressionDictionary();
+
+    Type            GetType() const { return m_Type; }
+    uint64_t        GetId() const   { return m_Id; }
+    const void *    GetData() const { return m_Data; }
+    size_t          GetSize() const { return m_Size; }
+
+    // Serialization (files and network)
+    void                                    Write( IOStream & stream ) const;
+    [[nodiscard]] static CompressionDictionary * Read( IOStream & stream ); // nullptr if invalid
+    bool                                    Save( const AString & fileName ) const;
+    [[nodiscard]] static CompressionDictionary * Load( const AString & fileName ); // nullptr if missing or invalid
+    static const char *                     GetFileName( Type type );
+    static const char *                     GetTypeName( Type type );
+
+    // Build a dictionary from the content most commonly shared between samples.
+    // Returns nullptr if the samples have nothing in common.
+    [[nodiscard]] static CompressionDictionary * Train( Type type,
+                                                        const Array< const void * > & samples,
+                                                        const Array< size_t > & sampleSizes,
+                                                        size_t maxSize = MAX_SIZE );
+
+    // Dictionaries referenced by compressed data must be registered for the
+    // data to be decompressed. The caller retains ownership.
+    // Register fails if too many are registered, or if a dictionary with the same
+    // id but different contents is registered (so data can't decode incorrectly)
+    [[nodiscard]] static bool               Register( const CompressionDictionary * dictionary );
+    static void                             Unregister( const CompressionDictionary * dictionary );
+    [[nodiscard]] static const CompressionDictionary * Find( uint64_t id );
+
+private:
+    Type        m_Type;
+    uint64_t    m_Id;
+    void *      m_Data;
+    size_t      m_Size;
+};
+
+//------------------------------------------------------------------------------
@@ -7,13 +7,20 @@
 
 // FBuildCore
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Helpers/CompressionDictionary.h"
 
 // Core
+#include "Core/Containers/Array.h"
 #include "Core/Containers/UniquePtr.h"
 #include "Core/Env/Assert.h"
+#include "Core/Env/Env.h"
 #include "Core/Env/Types.h"
 #include "Core/Math/Conversions.h"
 #include "Core/Mem/Mem.h"
+#include "Core/Process/Atomic.h"
+#include "Core/Process/Mutex.h"
+#include "Core/Process/Semaphore.h"
+#include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 
 // External
@@ -21,7 +28,258 @@
 #include "lz4hc.h"
 
 #include <memory.h>
+#include <stddef.h> // for offsetof
 
+// Defines
+//------------------------------------------------------------------------------
+#define MAX_CHUNK_HELPER_THREADS ( 3 ) // Shared by all threads (de)compressing concurrently
+
+// ChunkedWork
+//  - Chunks are claimed by the calling thread and any idle helpers from the
+//    shared ChunkHelperPool until all are done
+//------------------------------------------------------------------------------
+namespace
+{
+    class ChunkHelperPool;
+
+    class ChunkedWork
+    {
+    public:
+        typedef bool (*ChunkFunction)( uint32_t chunk, void * userData ); // false on failure
+
+        ChunkedWork( uint32_t numChunks, ChunkFunction func, void * userData )
+            : m_Function( func )
+            , m_UserData( userData )
+            , m_NumChunks( numChunks )
+        {
+        }
+
+        // Returns false if any chunk failed
+        bool Run();
+
+    private:
+        friend class ChunkHelperPool;
+
+        void Process()
+        {
+            for ( ;; )
+            {
+                const uint32_t chunk = ( AtomicInc( &m_NextChunk ) - 1 );
+                if ( ( chunk >= m_NumChunks ) || m_Failed )
+                {
+                    return;
+                }
+                if ( m_Function( chunk, m_UserData ) == false )
+                {
+                    m_Failed = true;
+                }
+            }
+        }
+
+        ChunkFunction       m_Function;
+        void *              m_UserData;
+        uint32_t            m_NumChunks;
+        volatile uint32_t   m_NextChunk = 0;
+        volatile bool       m_Failed = false;
+
+        // Managed by ChunkHelperPool under its mutex
+        ChunkedWork *       m_NextQueued = nullptr;
+        bool                m_Queued = false;
+        bool                m_WaitingForHelpers = false;
+        uint32_t            m_NumHelpers = 0;       // Helpers currently processing chunks
+        Semaphore           m_HelpersFinished;      // Signalled when the last helper finishes
+    };
+
+    // ChunkHelperPool
+    //  - A fixed set of helper threads shared by every (de)compression, so
+    //    concurrent callers don't each spawn their own threads
+    //--------------------------------------------------------------------------
+    class ChunkHelperPool
+    {
+    public:
+        static ChunkHelperPool & Get()
+        {
+            static ChunkHelperPool s_Pool;
+            return s_Pool;
+        }
+
+        void Run( ChunkedWork & work )
+        {
+            // Calling thread participates, so helpers are only needed for additional chunks
+            const uint32_t numHelpers = Math::Min( work.m_NumChunks - 1, m_NumThreads );
+            if ( numHelpers == 0 )
+            {
+                work.Process();
+                return;
+            }
+
+            // Make work available to helpers
+            {
+                MutexHolder mh( m_Mutex );
+                Enqueue( work );
+            }
+            m_WorkSemaphore.Signal( numHelpers );
+
+            work.Process();
+
+            // All chunks are claimed, but helpers may still be finishing some
+            bool wait = false;
+            {
+                MutexHolder mh( m_Mutex );
+                Dequeue( work );
+                if ( work.m_NumHelpers > 0 )
+                {
+                    work.m_WaitingForHelpers = true;
+                    wait = true;
+                }
+            }
+            if ( wait )
+            {
+                work.m_HelpersFinished.Wait();
+            }
+        }
+
+    private:
+        ChunkHelperPool()
+        {
+            const uint32_t numProcessors = Env::GetNumProcessors();
+            m_NumThreads = Math::Min( (uint32_t)MAX_CHUNK_HELPER_THREADS, ( numProcessors > 1 ) ? ( numProcessors - 1 ) : 0u );
+            for ( uint32_t i = 0; i < m_NumThreads; ++i )
+            {
+                m_Threads[ i ].Start( ThreadFunc, "CompressorHelper", this );
+            }
+        }
+
+        ~ChunkHelperPool()
+        {
+            if ( m_NumThreads == 0 )
+            {
+                return;
+            }
+            {
+                MutexHolder mh( m_Mutex );
+                m_Exit = true;
+            }
+            m_WorkSemaphore.Signal( m_NumThreads );
+            for ( uint32_t i = 0; i < m_NumThreads; ++i )
+            {
+                m_Threads[ i ].Join();
+            }
+        }
+
+        static uint32_t ThreadFunc( void * param )
+        {
+            PROFILE_SET_THREAD_NAME( "CompressorHelper" );
+            static_cast< ChunkHelperPool * >( param )->HelperLoop();
+            return 0;
+        }
+
+        void HelperLoop()
+        {
+            for ( ;; )
+            {
+                m_WorkSemaphore.Wait();
+
+                // Join the oldest work with unclaimed chunks (if it hasn't
+                // already been completed by its owner)
+                ChunkedWork * work;
+                {
+                    MutexHolder mh( m_Mutex );
+                    if ( m_Exit )
+                    {
+                        return;
+                    }
+                    work = m_Head;
+                    if ( work == nullptr )
+                    {
+                        continue;
+                    }
+                    work->m_NumHelpers++;
+                }
+
+                work->Process();
+
+                {
+                    MutexHolder mh( m_Mutex );
+                    Dequeue( *work ); // No chunks left to claim
+                    work->m_NumHelpers--;
+                    if ( ( work->m_NumHelpers == 0 ) && work->m_WaitingForHelpers )
+                    {
+                        work->m_HelpersFinished.Signal(); // Owner may free work after this
+                    }
+                }
+            }
+        }
+
+        void Enqueue( ChunkedWork & work )
+        {
+            // NOTE: Caller must hold m_Mutex
+            ChunkedWork ** tail = &m_Head;
+            while ( *tail )
+            {
+                tail = &( *tail )->m_NextQueued;
+            }
+            *tail = &work;
+            work.m_NextQueued = nullptr;
+            work.m_Queued = true;
+        }
+
+        void Dequeue( ChunkedWork & work )
+        {
+            // NOTE: Caller must hold m_Mutex
+            if ( work.m_Queued == false )
+            {
+                return;
+            }
+            ChunkedWork ** it = &m_Head;
+            while ( *it != &work )
+            {
+                it = &( *it )->m_NextQueued;
+            }
+            *it = work.m_NextQueued;
+            work.m_NextQueued = nullptr;
+            work.m_Queued = false;
+        }
+
+        Mutex           m_Mutex;
+        Semaphore       m_WorkSemaphore;
+        ChunkedWork *   m_Head = nullptr;
+        bool            m_Exit = false;
+        uint32_t        m_NumThreads = 0;
+        Thread          m_Threads[ MAX_CHUNK_HELPER_THREADS ];
+    };
+
+    // ChunkedWork::Run
+    //--------------------------------------------------------------------------
+    bool ChunkedWork::Run()
+    {
+        ChunkHelperPool::Get().Run( *this );
+        return ( m_Failed == false );
+    }
+
+    struct ChunkedCompressContext
+    {
+        const char *                    m_Data;
+        size_t                          m_DataSize;
+        char *                          m_Output;       // One slot of m_ChunkBound bytes per chunk
+        int32_t                         m_ChunkBound;
+        int32_t                         m_CompressionLevel;
+        const CompressionDictionary *   m_Dictionary;
+        uint32_t *                      m_ChunkSizes;   // Compressed size (or uncompressed size if stored as-is)
+    };
+
+    struct ChunkedDecompressContext
+    {
+        const char *                    m_Data;
+        const uint32_t *                m_ChunkSizes;
+        const size_t *                  m_ChunkOffsets; // Offset into m_Data of each chunk
+        char *                          m_Output;
+        size_t                          m_OutputSize;
+        const CompressionDictionary *   m_Dictionary;
+    };
+}
+
+// CONSTRUCTOR
 //------------------------------------------------------------------------------
 Compressor::Compressor()
     : m_Result( nullptr )
@@ -41,12 +299,16 @@ Compressor::~Compressor()
 /*static*/ bool Compressor::IsValidData( const void * data, size_t dataSize )
 {
     ASSERT( data );
+    if ( dataSize < sizeof( Header ) )
+    {
+        return false;
+    }
     const Header * header = (const Header *)data;
-    if ( header->m_CompressionType > 1 )
+    if ( header->m_CompressionType > LZ4_CHUNKED )
     {
         return false;
     }
-    if ( ( header->m_CompressedSize + sizeof( Header ) ) != dataSize )
+    if ( ( header->m_CompressedSize + GetHeaderSize( header->m_CompressionType ) ) != dataSize )
     {
         return false;
     }
@@ -69,64 +331,94 @@ Compressor::~Compressor()
     return header->m_UncompressedSize;
 }
 
+// IsDictionaryMissing
+//------------------------------------------------------------------------------
+/*static*/ bool Compressor::IsDictionaryMissing( const void * data, size_t dataSize )
+{
+    if ( IsValidData( data, dataSize ) == false )
+    {
+        return false; // Invalid, rather than missing a dictionary
+    }
+    const uint64_t dictionaryId = GetDictionaryId( data );
+    return ( ( dictionaryId != 0 ) && ( CompressionDictionary::Find( dictionaryId ) == nullptr ) );
+}
+
+// IsBasicFormat
+//------------------------------------------------------------------------------
+/*static*/ bool Compressor::IsBasicFormat( const void * data, size_t dataSize )
+{
+    if ( IsValidData( data, dataSize ) == false )
+    {
+        return false;
+    }
+    const Header * header = (const Header *)data;
+    return ( ( header->m_CompressionType == UNCOMPRESSED ) || ( header->m_CompressionType == LZ4 ) );
+}
+
 // Compress
 //------------------------------------------------------------------------------
-bool Compressor::Compress( const void * data, size_t dataSize, int32_t compressionLevel )
+bool Compressor::Compress( const void * data, size_t dataSize, int32_t compressionLevel, const CompressionDictionary * dictionary )
 {
     PROFILE_FUNCTION;
 
     ASSERT( data );
     ASSERT( m_Result == nullptr );
 
+    // Disable compression?
+    if ( compressionLevel == 0 )
+    {
+        StoreUncompressed( data, dataSize );
+        return false;
+    }
+
+    // Split large inputs so they can be compressed in parallel
+    if ( dataSize >= CHUNKED_THRESHOLD )
+    {
+        return CompressChunked( data, dataSize, compressionLevel, dictionary );
+    }
+
+    return CompressSingleBlock( data, dataSize, compressionLevel, dictionary );
+}
+
+// CompressSingleBlock
+//------------------------------------------------------------------------------
+bool Compressor::CompressSingleBlock( const void * data, size_t dataSize, int32_t compressionLevel, const CompressionDictionary * dictionary )
+{
     // allocate worst case output size for LZ4
     const int worstCaseSize = LZ4_compressBound( (int)dataSize );
     UniquePtr< char > output( (char *)ALLOC( (size_t)worstCaseSize ) );
 
-    int32_t compressedSize;
-
     // do compression
-    if ( compressionLevel > 0 )
-    {
-        // Higher compression, using LZ4HC
-        compressedSize = LZ4_compress_HC( (const char*)data, output.Get(), (int)dataSize, worstCaseSize, compressionLevel );
-    }
-    else if ( compressionLevel < 0 )
-    {
-        // Lower compression, using regular LZ4
-        const int32_t acceleration = ( 0 - compressionLevel );
-        compressedSize = LZ4_compress_fast( (const char*)data, output.Get(), (int)dataSize, worstCaseSize, acceleration );
-    }
-    else
-    {
-        // Disable compression
-        compressedSize = (int32_t)dataSize; // Act as if compression achieved nothing
-    }
+    const int32_t compressedSize = CompressBlock( data, dataSize, output.Get(), worstCaseSize, compressionLevel, dictionary );
 
     // did the compression yield any benefit?
-    const bool compressed = ( compressedSize < (int)dataSize );
-
-    if ( compressed )
-    {
-        // trim memory usage to compressed size
-        m_Result = ALLOC( (uint32_t)compressedSize + sizeof( Header ) );
-        memcpy( (char *)m_Result + sizeof( Header ), output.Get(), (size_t)compressedSize );
-        m_ResultSize = (uint32_t)compressedSize + sizeof( Header );
-    }
-    else
+    const bool compressed = ( compressedSize > 0 ) && ( compressedSize < (int)dataSize );
+    if ( compressed == false )
     {
         // compression failed, so just copy the old data
-        m_Result = ALLOC( dataSize + sizeof( Header ) );
-        memcpy( (char *)m_Result + sizeof( Header ), data, dataSize );
-        m_ResultSize = dataSize + sizeof( Header );
+        StoreUncompressed( data, dataSize );
+        return false;
     }
 
+    // trim memory usage to compressed size
+    const uint32_t compressionType = dictionary ? LZ4_DICTIONARY : LZ4;
+    const size_t headerSize = GetHeaderSize( compressionType );
+    m_Result = ALLOC( (uint32_t)compressedSize + headerSize );
+    memcpy( (char *)m_Result + headerSize, output.Get(), (size_t)compressedSize );
+    m_ResultSize = (uint32_t)compressedSize + headerSize;
+
     // fill out header
     Header * header = (Header*)m_Result;
-    header->m_CompressionType = compressed ? 1u : 0u;   // compression type
+    header->m_CompressionType = compressionType;        // compression type
     header->m_UncompressedSize = (uint32_t)dataSize;    // input size
-    header->m_CompressedSize = compressed ? (uint32_t)compressedSize : (uint32_t)dataSize;    // output size
+    header->m_CompressedSize = (uint32_t)compressedSize;// output size
+    if ( compressionType == LZ4_DICTIONARY )
+    {
+        const uint64_t dictionaryId = dictionary->GetId();
+        memcpy( (char *)m_Result + sizeof( Header ), &dictionaryId, sizeof( uint64_t ) );
+    }
 
-    return compressed;
+    return true;
 }
 
 // Decompress
@@ -141,14 +433,31 @@ bool Compressor::Decompress( const void * data )
     const Header * header = (const Header *)data;
 
     // handle uncompressed case
-    if ( header->m_CompressionType == 0 )
+    if ( header->m_CompressionType == UNCOMPRESSED )
     {
         m_Result = ALLOC( header->m_UncompressedSize );
         memcpy( m_Result, (const char *)data + sizeof( Header ), header->m_UncompressedSize );
         m_ResultSize = header->m_UncompressedSize;
         return true;
     }
-    ASSERT( header->m_CompressionType == 1 );
+
+    // handle chunked case
+    if ( header->m_CompressionType == LZ4_CHUNKED )
+    {
+        return DecompressChunked( data );
+    }
+    ASSERT( ( header->m_CompressionType == LZ4 ) || ( header->m_CompressionType == LZ4_DICTIONARY ) );
+
+    // find dictionary if needed
+    const CompressionDictionary * dictionary = nullptr;
+    if ( header->m_CompressionType == LZ4_DICTIONARY )
+    {
+        dictionary = CompressionDictionary::Find( GetDictionaryId( data ) );
+        if ( dictionary == nullptr )
+        {
+            return false; // Dictionary not available
+        }
+    }
 
     // uncompressed size
     const uint32_t uncompressedSize = header->m_UncompressedSize;
@@ -156,11 +465,257 @@ bool Compressor::Decompress( const void * data )
     m_ResultSize = uncompressedSize;
 
     // skip over header to LZ4 data
-    const char * compressedData = ( (const char *)data + sizeof( Header ) );
+    const char * compressedData = ( (const char *)data + GetHeaderSize( header->m_CompressionType ) );
 
     // decompress
-    const int bytesDecompressed = LZ4_decompress_safe( compressedData, (char *)m_Result, (int)header->m_CompressedSize, (int)uncompressedSize);
-    if ( bytesDecompressed == (int)uncompressedSize )
+    if ( DecompressBlock( compressedData, header->m_CompressedSize, m_Result, uncompressedSize, dictionary ) )
+    {
+        return true;
+    }
+
+    // Data is corrupt
+    FREE( m_Result );
+    m_Result = nullptr;
+    m_ResultSize = 0;
+    return false;
+}
+
+// ConvertToBasicFormat
+//------------------------------------------------------------------------------
+bool Compressor::ConvertToBasicFormat( const void * data )
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( m_Result == nullptr );
+
+    Compressor d;
+    if ( d.Decompress( data ) == false )
+    {
+        return false; // Corrupt, or dictionary not available
+    }
+
+    // Compress as one block (even if large) without a dictionary
+    CompressSingleBlock( d.GetResult(), d.GetResultSize(), -1, nullptr );
+    return true;
+}
+
+// GetHeaderSize
+//------------------------------------------------------------------------------
+/*static*/ size_t Compressor::GetHeaderSize( uint32_t compressionType )
+{
+    switch ( compressionType )
+    {
+        case LZ4_DICTIONARY:    return ( sizeof( Header ) + sizeof( uint64_t ) );
+        case LZ4_CHUNKED:       return ( sizeof( Header ) + sizeof( ChunkedHeader ) ); // Chunk sizes are part of compressed data
+        default:                return sizeof( Header );
+    }
+}
+
+// GetDictionaryId
+//------------------------------------------------------------------------------
+/*static*/ uint64_t Compressor::GetDictionaryId( const void * data )
+{
+    // Ids follow the (12 byte) Header, so may be unaligned
+    uint64_t dictionaryId = 0;
+    const Header * header = (const Header *)data;
+    if ( header->m_CompressionType == LZ4_DICTIONARY )
+    {
+        memcpy( &dictionaryId, (const char *)data + sizeof( Header ), sizeof( uint64_t ) );
+    }
+    else if ( header->m_CompressionType == LZ4_CHUNKED )
+    {
+        memcpy( &dictionaryId, (const char *)data + sizeof( Header ) + offsetof( ChunkedHeader, m_DictionaryId ), sizeof( uint64_t ) );
+    }
+    return dictionaryId;
+}
+
+// CompressBlock
+//------------------------------------------------------------------------------
+/*static*/ int32_t Compressor::CompressBlock( const void * data,
+                                              size_t dataSize,
+                                              char * output,
+                                              int32_t outputCapacity,
+                                              int32_t compressionLevel,
+                                              const CompressionDictionary * dictionary )
+{
+    ASSERT( compressionLevel != 0 );
+
+    if ( ( compressionLevel > 0 ) && dictionary )
+    {
+        // Higher compression, using LZ4HC primed with the dictionary
+        UniquePtr< char > state( (char *)ALLOC( sizeof( LZ4_streamHC_t ) ) );
+        LZ4_streamHC_t * stream = LZ4_initStreamHC( state.Get(), sizeof( LZ4_streamHC_t ) );
+        LZ4_resetStreamHC_fast( stream, compressionLevel );
+        LZ4_loadDictHC( stream, (const char *)dictionary->GetData(), (int)dictionary->GetSize() );
+        return LZ4_compress_HC_continue( stream, (const char*)data, output, (int)dataSize, outputCapacity );
+    }
+    if ( dictionary )
+    {
+        // Lower compression, using regular LZ4 primed with the dictionary
+        const int32_t acceleration = ( 0 - compressionLevel );
+        UniquePtr< char > state( (char *)ALLOC( sizeof( LZ4_stream_t ) ) );
+        LZ4_stream_t * stream = LZ4_initStream( state.Get(), sizeof( LZ4_stream_t ) );
+        LZ4_loadDict( stream, (const char *)dictionary->GetData(), (int)dictionary->GetSize() );
+        return LZ4_compress_fast_continue( stream, (const char*)data, output, (int)dataSize, outputCapacity, acceleration );
+    }
+    if ( compressionLevel > 0 )
+    {
+        // Higher compression, using LZ4HC
+        return LZ4_compress_HC( (const char*)data, output, (int)dataSize, outputCapacity, compressionLevel );
+    }
+
+    // Lower compression, using regular LZ4
+    const int32_t acceleration = ( 0 - compressionLevel );
+    return LZ4_compress_fast( (const char*)data, output, (int)dataSize, outputCapacity, acceleration );
+}
+
+// DecompressBlock
+//------------------------------------------------------------------------------
+/*static*/ bool Compressor::DecompressBlock( const void * data,
+                                             size_t dataSize,
+                                             void * output,
+                                             size_t uncompressedSize,
+                                             const CompressionDictionary * dictionary )
+{
+    const int bytesDecompressed = dictionary ? LZ4_decompress_safe_usingDict( (const char *)data,
+                                                                              (char *)output,
+                                                                              (int)dataSize,
+                                                                              (int)uncompressedSize,
+                                                                              (const char *)dictionary->GetData(),
+                                                                              (int)dictionary->GetSize() )
+                                             : LZ4_decompress_safe( (const char *)data, (char *)output, (int)dataSize, (int)uncompressedSize );
+    return ( bytesDecompressed == (int)uncompressedSize );
+}
+
+// CompressChunked
+//------------------------------------------------------------------------------
+bool Compressor::CompressChunked( const void * data, size_t dataSize, int32_t compressionLevel, const CompressionDictionary * dictionary )
+{
+    PROFILE_FUNCTION;
+
+    // Compress each chunk into its own worst case sized slot
+    const uint32_t numChunks = (uint32_t)( ( dataSize + CHUNK_SIZE - 1 ) / CHUNK_SIZE );
+    const int32_t chunkBound = LZ4_compressBound( (int)CHUNK_SIZE );
+    UniquePtr< char > output( (char *)ALLOC( (size_t)chunkBound * numChunks ) );
+    Array< uint32_t > chunkSizes;
+    chunkSizes.SetSize( numChunks );
+
+    ChunkedCompressContext context;
+    context.m_Data = (const char *)data;
+    context.m_DataSize = dataSize;
+    context.m_Output = output.Get();
+    context.m_ChunkBound = chunkBound;
+    context.m_CompressionLevel = compressionLevel;
+    context.m_Dictionary = dictionary;
+    context.m_ChunkSizes = chunkSizes.Begin();
+
+    ChunkedWork work( numChunks, CompressChunk, &context );
+    VERIFY( work.Run() ); // Compression can't fail
+
+    // did the compression yield any benefit?
+    size_t compressedSize = ( numChunks * sizeof( uint32_t ) ); // Chunk size table
+    for ( const uint32_t chunkSize : chunkSizes )
+    {
+        compressedSize += chunkSize;
+    }
+    if ( compressedSize >= dataSize )
+    {
+        StoreUncompressed( data, dataSize );
+        return false;
+    }
+
+    // Write header, chunk size table and chunks
+    const size_t headerSize = GetHeaderSize( LZ4_CHUNKED );
+    m_Result = ALLOC( headerSize + compressedSize );
+    m_ResultSize = ( headerSize + compressedSize );
+    Header * header = (Header *)m_Result;
+    header->m_CompressionType = LZ4_CHUNKED;
+    header->m_UncompressedSize = (uint32_t)dataSize;
+    header->m_CompressedSize = (uint32_t)compressedSize;
+    ChunkedHeader chunkedHeader;
+    chunkedHeader.m_NumChunks = numChunks;
+    chunkedHeader.m_Padding = 0;
+    chunkedHeader.m_DictionaryId = dictionary ? dictionary->GetId() : 0;
+    memcpy( (char *)m_Result + sizeof( Header ), &chunkedHeader, sizeof( ChunkedHeader ) ); // Unaligned
+    char * pos = ( (char *)m_Result + headerSize );
+    memcpy( pos, chunkSizes.Begin(), numChunks * sizeof( uint32_t ) );
+    pos += ( numChunks * sizeof( uint32_t ) );
+    for ( uint32_t i = 0; i < numChunks; ++i )
+    {
+        const size_t offset = ( (size_t)i * CHUNK_SIZE );
+        const size_t chunkDataSize = Math::Min( (size_t)CHUNK_SIZE, dataSize - offset );
+        const bool compressed = ( chunkSizes[ i ] < chunkDataSize );
+        memcpy( pos,
+                compressed ? ( output.Get() + ( (size_t)i * (size_t)chunkBound ) ) : ( (const char *)data + offset ),
+                chunkSizes[ i ] );
+        pos += chunkSizes[ i ];
+    }
+    ASSERT( pos == ( (char *)m_Result + m_ResultSize ) );
+
+    return true;
+}
+
+// DecompressChunked
+//------------------------------------------------------------------------------
+bool Compressor::DecompressChunked( const void * data )
+{
+    PROFILE_FUNCTION;
+
+    const Header * header = (const Header *)data;
+    ChunkedHeader chunkedHeader;
+    memcpy( &chunkedHeader, (const char *)data + sizeof( Header ), sizeof( ChunkedHeader ) ); // Unaligned
+    const uint32_t uncompressedSize = header->m_UncompressedSize;
+    const uint32_t numChunks = chunkedHeader.m_NumChunks;
+
+    // Validate chunk layout
+    if ( ( numChunks != ( ( (size_t)uncompressedSize + CHUNK_SIZE - 1 ) / CHUNK_SIZE ) ) ||
+         ( ( (size_t)numChunks * sizeof( uint32_t ) ) > header->m_CompressedSize ) )
+    {
+        return false; // Corrupt
+    }
+
+    // find dictionary if needed
+    const CompressionDictionary * dictionary = nullptr;
+    if ( chunkedHeader.m_DictionaryId != 0 )
+    {
+        dictionary = CompressionDictionary::Find( chunkedHeader.m_DictionaryId );
+        if ( dictionary == nullptr )
+        {
+            return false; // Dictionary not available
+        }
+    }
+
+    // Locate each chunk
+    const char * chunkData = ( (const char *)data + GetHeaderSize( LZ4_CHUNKED ) );
+    Array< uint32_t > chunkSizes;
+    chunkSizes.SetSize( numChunks );
+    memcpy( chunkSizes.Begin(), chunkData, numChunks * sizeof( uint32_t ) );
+    Array< size_t > chunkOffsets;
+    chunkOffsets.SetSize( numChunks );
+    size_t offset = ( numChunks * sizeof( uint32_t ) );
+    for ( uint32_t i = 0; i < numChunks; ++i )
+    {
+        chunkOffsets[ i ] = offset;
+        offset += chunkSizes[ i ];
+    }
+    if ( offset != header->m_CompressedSize )
+    {
+        return false; // Corrupt
+    }
+
+    m_Result = ALLOC( uncompressedSize );
+    m_ResultSize = uncompressedSize;
+
+    ChunkedDecompressContext context;
+    context.m_Data = chunkData;
+    context.m_ChunkSizes = chunkSizes.Begin();
+    context.m_ChunkOffsets = chunkOffsets.Begin();
+    context.m_Output = (char *)m_Result;
+    context.m_OutputSize = uncompressedSize;
+    context.m_Dictionary = dictionary;
+
+    ChunkedWork work( numChunks, DecompressChunk, &context );
+    if ( work.Run() )
     {
         return true;
     }
@@ -172,4 +727,59 @@ bool Compressor::Decompress( const void * data )
     return false;
 }
 
+// CompressChunk
+//------------------------------------------------------------------------------
+/*static*/ bool Compressor::CompressChunk( uint32_t chunk, void * userData )
+{
+    const ChunkedCompressContext & ctx = *static_cast< const ChunkedCompressContext * >( userData );
+    const size_t offset = ( (size_t)chunk * CHUNK_SIZE );
+    const size_t chunkDataSize = Math::Min( (size_t)CHUNK_SIZE, ctx.m_DataSize - offset );
+    const int32_t compressedSize = CompressBlock( ctx.m_Data + offset,
+                                                  chunkDataSize,
+                                                  ctx.m_Output + ( (size_t)chunk * (size_t)ctx.m_ChunkBound ),
+                                                  ctx.m_ChunkBound,
+                                                  ctx.m_CompressionLevel,
+                                                  ctx.m_Dictionary );
+
+    // Chunks which don't benefit are stored as-is
+    const bool compressed = ( compressedSize > 0 ) && ( compressedSize < (int32_t)chunkDataSize );
+    ctx.m_ChunkSizes[ chunk ] = compressed ? (uint32_t)compressedSize : (uint32_t)chunkDataSize;
+    return true;
+}
+
+// DecompressChunk
+//------------------------------------------------------------------------------
+/*static*/ bool Compressor::DecompressChunk( uint32_t chunk, void * userData )
+{
+    const ChunkedDecompressContext & ctx = *static_cast< const ChunkedDecompressContext * >( userData );
+    const size_t outputOffset = ( (size_t)chunk * CHUNK_SIZE );
+    const size_t chunkDataSize = Math::Min( (size_t)CHUNK_SIZE, ctx.m_OutputSize - outputOffset );
+    const uint32_t chunkSize = ctx.m_ChunkSizes[ chunk ];
+    if ( chunkSize == chunkDataSize )
+    {
+        // Stored as-is
+        memcpy( ctx.m_Output + outputOffset, ctx.m_Data + ctx.m_ChunkOffsets[ chunk ], chunkDataSize );
+        return true;
+    }
+    return DecompressBlock( ctx.m_Data + ctx.m_ChunkOffsets[ chunk ],
+                            chunkSize,
+                            ctx.m_Output + outputOffset,
+                            chunkDataSize,
+                            ctx.m_Dictionary );
+}
+
+// StoreUncompressed
+//------------------------------------------------------------------------------
+void Compressor::StoreUncompressed( const void * data, size_t dataSize )
+{
+    m_Result = ALLOC( dataSize + sizeof( Header ) );
+    memcpy( (char *)m_Result + sizeof( Header ), data, dataSize );
+    m_ResultSize = dataSize + sizeof( Header );
+
+    Header * header = (Header *)m_Result;
+    header->m_CompressionType = UNCOMPRESSED;
+    header->m_UncompressedSize = (uint32_t)dataSize;
+    header->m_CompressedSize = (uint32_t)dataSize;
+}
+
 //------------------------------------------------------------------------------
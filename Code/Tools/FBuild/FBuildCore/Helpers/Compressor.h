@@ -6,6 +6,10 @@
 //------------------------------------------------------------------------------
 #include "Core/Env/Types.h"
 
+// Forward Declarations
+//------------------------------------------------------------------------------
+class CompressionDictionary;
+
 // Compressor
 //------------------------------------------------------------------------------
 class Compressor
@@ -16,13 +20,19 @@ public:
 
     static bool     IsValidData( const void * data, size_t dataSize );
     static uint32_t GetUncompressedSize( const void * data, size_t dataSize );
+    static bool     IsDictionaryMissing( const void * data, size_t dataSize ); // Valid data needing an unregistered dictionary
+    static bool     IsBasicFormat( const void * data, size_t dataSize ); // Valid data without a dictionary or chunks (understood by all versions)
 
     // compressionLevel:
     //   < 0 : use LZ4, with values directly mapping to "acceleration level"
     //  == 0 : disable compression
     //   > 0 : use LZ4HC, with values direcly mapping to "compression level"
-    bool Compress( const void * data, size_t dataSize, int32_t compressionLevel = -1 ); // -1 = default LZ4 compression level
+    // dictionary:
+    //   Optional. Must be registered wherever the data is decompressed (see CompressionDictionary)
+    // Large inputs are split into chunks which are compressed (and later decompressed) in parallel
+    bool Compress( const void * data, size_t dataSize, int32_t compressionLevel = -1, const CompressionDictionary * dictionary = nullptr ); // -1 = default LZ4 compression level
     bool Decompress( const void * data );
+    bool ConvertToBasicFormat( const void * data ); // Recompress data for versions without dictionary and chunk support
 
     const void *    GetResult() const       { return m_Result; }
     size_t          GetResultSize() const   { return m_ResultSize; }
@@ -30,12 +40,43 @@ public:
     inline void *   ReleaseResult()         { void * r = m_Result; m_Result = nullptr; m_ResultSize = 0; return r; }
 
 private:
+    enum CompressionType : uint32_t
+    {
+        UNCOMPRESSED        = 0,
+        LZ4                 = 1,
+        LZ4_DICTIONARY      = 2,    // Header is followed by the dictionary id
+        LZ4_CHUNKED         = 3,    // Header is followed by a ChunkedHeader and the size of each chunk
+    };
+    enum : uint32_t
+    {
+        CHUNK_SIZE              = ( 1024 * 1024 ),
+        CHUNKED_THRESHOLD       = ( 4 * CHUNK_SIZE ),   // Smaller inputs are compressed as one block
+    };
     struct Header
     {
         uint32_t m_CompressionType;
         uint32_t m_UncompressedSize;
         uint32_t m_CompressedSize;
     };
+    struct ChunkedHeader
+    {
+        uint32_t m_NumChunks;
+        uint32_t m_Padding;
+        uint64_t m_DictionaryId;    // 0 if no dictionary
+    };
+    static size_t   GetHeaderSize( uint32_t compressionType );
+    static uint64_t GetDictionaryId( const void * data );
+
+    static int32_t  CompressBlock( const void * data, size_t dataSize, char * output, int32_t outputCapacity, int32_t compressionLevel, const CompressionDictionary * dictionary );
+    static bool     DecompressBlock( const void * data, size_t dataSize, void * output, size_t uncompressedSize, const CompressionDictionary * dictionary );
+    bool            CompressChunked( const void * data, size_t dataSize, int32_t compressionLevel, const CompressionDictionary * dictionary );
+    bool            CompressSingleBlock( const void * data, size_t dataSize, int32_t compressionLevel, const CompressionDictionary * dictionary );
+    bool            DecompressChunked( const void * data );
+    static bool     CompressChunk( uint32_t chunk, void * userData );
+    static bool     DecompressChunk( uint32_t chunk, void * userData );
+    void            StoreUncompressed( const void * data, size_t dataSize );
+
+
     void * m_Result;
     size_t m_ResultSize;
 };
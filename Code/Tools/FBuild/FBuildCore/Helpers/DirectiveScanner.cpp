@@ -0,0 +1,210 @@
+// DirectiveScanner - Fast searching of source code and preprocessor output
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "DirectiveScanner.h"
+
+// Core
+#include "Core/Env/Assert.h"
+
+// system
+#if defined( __x86_64__ ) || defined( _M_X64 )
+    #define DIRECTIVESCANNER_SSE2 // SSE2 is always available on x64
+    #include <emmintrin.h>
+    #if defined( __WINDOWS__ )
+        #include <intrin.h>
+    #endif
+#endif
+
+// Helpers
+//------------------------------------------------------------------------------
+namespace
+{
+    #if defined( DIRECTIVESCANNER_SSE2 )
+        // A 32 byte block of input, as two SSE registers
+        struct Block32
+        {
+            explicit Block32( const char * pos )
+                : m_Lo( _mm_loadu_si128( reinterpret_cast< const __m128i * >( pos ) ) )
+                , m_Hi( _mm_loadu_si128( reinterpret_cast< const __m128i * >( pos + 16 ) ) )
+            {}
+
+            // Bitmask of bytes equal to c (bit N set for byte N)
+            uint32_t Match( char c ) const
+            {
+                const __m128i cv = _mm_set1_epi8( c );
+                const uint32_t lo = (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( m_Lo, cv ) );
+                const uint32_t hi = (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( m_Hi, cv ) );
+                return ( lo | ( hi << 16 ) );
+            }
+
+            __m128i m_Lo;
+            __m128i m_Hi;
+        };
+
+        // Index of lowest set bit (mask must be non-zero)
+        inline uint32_t LowestBitIndex( uint32_t mask )
+        {
+            ASSERT( mask != 0 );
+            #if defined( __WINDOWS__ )
+                unsigned long index;
+                _BitScanForward( &index, mask );
+                return (uint32_t)index;
+            #else
+                return (uint32_t)__builtin_ctz( mask );
+            #endif
+        }
+    #endif
+
+    inline bool IsLineEnd( char c )
+    {
+        return ( ( c == '\n' ) || ( c == '\r' ) );
+    }
+}
+
+// FindLineEnd
+//------------------------------------------------------------------------------
+/*static*/ const char * DirectiveScanner::FindLineEnd( const char * pos, const char * end )
+{
+    #if defined( DIRECTIVESCANNER_SSE2 )
+        while ( ( end - pos ) >= 32 )
+        {
+            const Block32 block( pos );
+            const uint32_t mask = block.Match( '\n' ) | block.Match( '\r' ) | block.Match( '\0' );
+            if ( mask )
+            {
+                return pos + LowestBitIndex( mask );
+            }
+            pos += 32;
+        }
+    #endif
+
+    // Remainder
+    return FindLineEnd_Scalar( pos, end );
+}
+
+// FindHashAtLineStart
+//------------------------------------------------------------------------------
+/*static*/ const char * DirectiveScanner::FindHashAtLineStart( const char * pos, const char * end )
+{
+    #if defined( DIRECTIVESCANNER_SSE2 )
+        // Line ends are shifted by one to mark line starts, with the last byte
+        // of each block carried into the next
+        uint32_t carry = ( ( pos < end ) && ( *pos == '#' ) && IsLineEnd( pos[ -1 ] ) ) ? 1u : 0u;
+        while ( ( end - pos ) >= 32 )
+        {
+            const Block32 block( pos );
+            const uint32_t lineEnds = block.Match( '\n' ) | block.Match( '\r' );
+            const uint32_t mask = block.Match( '#' ) & ( ( lineEnds << 1 ) | carry );
+            if ( mask )
+            {
+                return pos + LowestBitIndex( mask );
+            }
+            carry = ( lineEnds >> 31 );
+            pos += 32;
+        }
+    #endif
+
+    // Remainder
+    return FindHashAtLineStart_Scalar( pos, end );
+}
+
+// SkipCommentBlock
+//------------------------------------------------------------------------------
+/*static*/ const char * DirectiveScanner::SkipCommentBlock( const char * pos, const char * end )
+{
+    ASSERT( ( ( end - pos ) >= 2 ) && ( pos[ 0 ] == '/' ) && ( pos[ 1 ] == '*' ) );
+
+    #if defined( DIRECTIVESCANNER_SSE2 )
+        while ( ( end - pos ) >= 32 )
+        {
+            const Block32 block( pos );
+            const uint32_t nulls = block.Match( '\0' );
+            uint32_t mask = block.Match( '*' ) | nulls;
+            while ( mask )
+            {
+                const uint32_t index = LowestBitIndex( mask );
+                const char * candidate = pos + index;
+                if ( nulls & ( 1u << index ) )
+                {
+                    return candidate; // end of data
+                }
+                if ( ( ( candidate + 1 ) < end ) && ( candidate[ 1 ] == '/' ) )
+                {
+                    return candidate + 2; // end of comment block
+                }
+                mask &= ( mask - 1 ); // clear lowest bit
+            }
+            pos += 32;
+        }
+    #endif
+
+    // Remainder
+    return SkipCommentBlock_Scalar( pos, end );
+}
+
+// FindLineEnd_Scalar
+//------------------------------------------------------------------------------
+/*static*/ const char * DirectiveScanner::FindLineEnd_Scalar( const char * pos, const char * end )
+{
+    for ( ; pos < end; ++pos )
+    {
+        const char c = *pos;
+        if ( ( c == '\r' ) || ( c == '\n' ) || ( c == '\0' ) )
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+// FindHashAtLineStart_Scalar
+//------------------------------------------------------------------------------
+/*static*/ const char * DirectiveScanner::FindHashAtLineStart_Scalar( const char * pos, const char * end )
+{
+    for ( ; pos < end; ++pos )
+    {
+        if ( ( *pos == '#' ) && IsLineEnd( pos[ -1 ] ) )
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+// SkipCommentBlock_Scalar
+//------------------------------------------------------------------------------
+/*static*/ const char * DirectiveScanner::SkipCommentBlock_Scalar( const char * pos, const char * end )
+{
+    for ( ; pos < end; ++pos )
+    {
+        const char c = *pos;
+
+        // end of data?
+        if ( c == '\0' )
+        {
+            break;
+        }
+
+        // end of comment block?
+        if ( ( c == '*' ) && ( ( pos + 1 ) < end ) && ( pos[ 1 ] == '/' ) )
+        {
+            return pos + 2;
+        }
+    }
+    return pos;
+}
+
+// IsVectorized
+//------------------------------------------------------------------------------
+/*static*/ bool DirectiveScanner::IsVectorized()
+{
+    #if defined( DIRECTIVESCANNER_SSE2 )
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+//------------------------------------------------------------------------------
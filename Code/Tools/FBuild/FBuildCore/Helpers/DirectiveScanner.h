@@ -0,0 +1,38 @@
+// DirectiveScanner - Fast searching of source code and preprocessor output
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Env/Types.h"
+
+// DirectiveScanner
+//  - Finds the characters significant to include parsing (line ends, '#' and
+//    comment ends), checking 32 bytes at a time where SIMD is available
+//  - All functions search [pos, end) and return end if nothing is found. They
+//    never read beyond end.
+//------------------------------------------------------------------------------
+class DirectiveScanner
+{
+public:
+    // Find the next '\r', '\n' or '\0'
+    static const char * FindLineEnd( const char * pos, const char * end );
+
+    // Find the next '#' which is the first character on a line.
+    // NOTE: pos[ -1 ] must be valid if *pos is '#'
+    static const char * FindHashAtLineStart( const char * pos, const char * end );
+
+    // Skip a "/*" comment block, returning the position after the closing "*/"
+    // or the position of a '\0' if one is found first
+    static const char * SkipCommentBlock( const char * pos, const char * end );
+
+    // Reference implementations which check one byte at a time (for testing and benchmarking)
+    static const char * FindLineEnd_Scalar( const char * pos, const char * end );
+    static const char * FindHashAtLineStart_Scalar( const char * pos, const char * end );
+    static const char * SkipCommentBlock_Scalar( const char * pos, const char * end );
+
+    // Is a SIMD implementation being used on this platform?
+    static bool IsVectorized();
+};
+
+//------------------------------------------------------------------------------
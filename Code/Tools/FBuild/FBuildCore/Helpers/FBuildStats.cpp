@@ -52,6 +52,7 @@ FBuildStats::Stats::Stats()
     , m_NumCacheMisses( 0 )
     , m_NumCacheStores( 0 )
     , m_NumLightCache( 0 )
+    , m_NumDependencyCacheKey( 0 )
     , m_ProcessingTimeMS( 0 )
     , m_NumFailed( 0 )
     , m_CachingTimeMS( 0 )
@@ -113,6 +114,7 @@ void FBuildStats::GatherPostBuildStatistics( const NodeGraph & nodeGraph, Node *
         m_Totals.m_NumCacheMisses   += m_PerTypeStats[ i ].m_NumCacheMisses;
         m_Totals.m_NumCacheStores   += m_PerTypeStats[ i ].m_NumCacheStores;
         m_Totals.m_NumLightCache    += m_PerTypeStats[ i ].m_NumLightCache;
+        m_Totals.m_NumDependencyCacheKey += m_PerTypeStats[ i ].m_NumDependencyCacheKey;
         m_Totals.m_CachingTimeMS    += m_PerTypeStats[ i ].m_CachingTimeMS;
     }
 }
@@ -191,6 +193,82 @@ void FBuildStats::OutputSummary() const
         output.AppendFormat( " - Hits       : %u (%2.1f %%)\n", hits, (double)hitPerc );
         output.AppendFormat( " - Misses     : %u\n", misses );
         output.AppendFormat( " - Stores     : %u\n", stores );
+
+        // Local/remote tiers
+        const TieredCacheStats & tierStats = m_TieredCacheStats;
+        if ( tierStats.IsEmpty() == false )
+        {
+            const uint32_t lookups = ( tierStats.m_NumLocalHits + tierStats.m_NumRemoteHits + tierStats.m_NumMisses );
+            const double localPerc = ( lookups > 0 ) ? ( (double)tierStats.m_NumLocalHits / (double)lookups * 100.0 ) : 0.0;
+            const double remotePerc = ( lookups > 0 ) ? ( (double)tierStats.m_NumRemoteHits / (double)lookups * 100.0 ) : 0.0;
+            output.AppendFormat( " - Local Hits : %u (%2.1f %%)\n", tierStats.m_NumLocalHits, localPerc );
+            output.AppendFormat( " - Remote Hits: %u (%2.1f %%) (%u promoted to local)\n", tierStats.m_NumRemoteHits, remotePerc, tierStats.m_NumPromoted );
+            if ( tierStats.m_NumRemoteStores > 0 )
+            {
+                output.AppendFormat( " - Remote Stores: %u (%u failed)\n", tierStats.m_NumRemoteStores, tierStats.m_NumRemoteFailed );
+            }
+        }
+
+        // Integrity checks
+        const CacheVerifyStats & verifyStats = m_CacheVerifyStats;
+        if ( FBuild::Get().GetOptions().m_CacheVerbose && ( verifyStats.IsEmpty() == false ) )
+        {
+            output.AppendFormat( " - Verified   : %u (%.1f MiB, %.3fs) %u corrupt\n",
+                                 verifyStats.m_NumVerified,
+                                 ( (double)verifyStats.m_VerifiedBytes / (double)MEGABYTE ),
+                                 ( (double)verifyStats.m_VerifyTimeUS / 1000000.0 ),
+                                 verifyStats.m_NumCorrupt );
+        }
+
+        const CachePrefetchStats & prefetchStats = m_CachePrefetchStats;
+        if ( prefetchStats.m_NumQueued > 0 )
+        {
+            output.AppendFormat( " - Prefetched : %u (%u hits, %u batches) %u used, %u keys reused, %u waited, %u unused\n",
+                                 prefetchStats.m_NumRequested,
+                                 prefetchStats.m_NumHits,
+                                 prefetchStats.m_NumBatches,
+                                 prefetchStats.m_NumUsed,
+                                 prefetchStats.m_NumKeysReused,
+                                 prefetchStats.m_NumWaits,
+                                 prefetchStats.m_NumWasted );
+        }
+
+        // Background publishing
+        const CacheWriteStats & writeStats = m_CacheWriteStats;
+        if ( ( writeStats.m_NumQueued + writeStats.m_NumRejected ) > 0 )
+        {
+            const double publishedMiB = ( (double)writeStats.m_PublishedBytes / (double)MEGABYTE );
+            const double publishTime = ( (double)writeStats.m_PublishTimeMS / 1000.0 );
+            const double throughput = ( publishTime > 0.0 ) ? ( publishedMiB / publishTime ) : 0.0;
+            output.AppendFormat( " - Background : %u (%u failed, %u already present, %u synchronous) %.1f MiB @ %.1f MiB/s\n",
+                                 writeStats.m_NumQueued,
+                                 writeStats.m_NumFailed,
+                                 writeStats.m_NumAlreadyPresent,
+                                 writeStats.m_NumRejected,
+                                 publishedMiB,
+                                 throughput );
+            output.AppendFormat( " - Backlog    : Peak %u (%.1f MiB), %.3fs wait at end of build\n",
+                                 writeStats.m_PeakBacklog,
+                                 ( (double)writeStats.m_PeakBacklogBytes / (double)MEGABYTE ),
+                                 ( (double)writeStats.m_FlushTimeMS / 1000.0 ) );
+        }
+    }
+
+    const WorkerConnectionStats & connectionStats = m_WorkerConnectionStats;
+    if ( connectionStats.m_NumWorkers > 0 )
+    {
+        output += "Distribution:\n";
+        output.AppendFormat( " - Workers    : %u of %u connected (%u failed attempts)\n",
+                             connectionStats.m_NumConnected,
+                             connectionStats.m_NumWorkers,
+                             connectionStats.m_NumFailedAttempts );
+        if ( connectionStats.m_NumConnected > 0 )
+        {
+            output.AppendFormat( " - Ramp-up    : 1 after %.3fs, %u after %.3fs\n",
+                                 (double)connectionStats.m_TimeToFirstConnection,
+                                 connectionStats.m_NumConnected,
+                                 (double)connectionStats.m_TimeToAllConnections );
+        }
     }
 
     AStackString<> buffer;
@@ -270,6 +348,10 @@ void FBuildStats::GatherPostBuildStatisticsRecurse( Node * node )
         {
             stats.m_NumLightCache++;
         }
+        if ( node->GetStatFlag( Node::STATS_DEPENDENCY_CACHE_KEY ) )
+        {
+            stats.m_NumDependencyCacheKey++;
+        }
     }
 
     // For unit test count check stability we want to exclude "ExtraFiles" on CompilerNodes
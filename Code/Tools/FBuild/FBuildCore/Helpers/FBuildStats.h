@@ -5,6 +5,10 @@
 // Includes
 //------------------------------------------------------------------------------
 #include "Core/Env/Types.h"
+#include "Tools/FBuild/FBuildCore/Cache/CachePrefetcher.h"
+#include "Tools/FBuild/FBuildCore/Cache/CacheWriteQueue.h"
+#include "Tools/FBuild/FBuildCore/Cache/TieredCache.h"
+#include "Tools/FBuild/FBuildCore/Protocol/Client.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 
 // Forward Declarations
@@ -33,6 +37,21 @@ public:
     uint32_t    m_TotalLocalCPUTimeMS;  // Total CPU time on local host
     uint32_t    m_TotalRemoteCPUTimeMS; // Total CPU time on remote workers
 
+    // background cache writes
+    CacheWriteStats m_CacheWriteStats;
+
+    // background cache lookups
+    CachePrefetchStats m_CachePrefetchStats;
+
+    // local/remote cache tiers
+    TieredCacheStats m_TieredCacheStats;
+
+    // cache entry integrity checks
+    CacheVerifyStats m_CacheVerifyStats;
+
+    // connections to distributed workers
+    WorkerConnectionStats m_WorkerConnectionStats;
+
     // after the build it complete, accumulate all the stats
     void GatherPostBuildStatistics( const NodeGraph & nodeGraph, Node * node );
 
@@ -45,6 +64,7 @@ public:
     uint32_t GetCacheMisses() const     { return m_Totals.m_NumCacheMisses; }
     uint32_t GetCacheStores() const     { return m_Totals.m_NumCacheStores; }
     uint32_t GetLightCacheCount() const { return m_Totals.m_NumLightCache; }
+    uint32_t GetDependencyCacheKeyCount() const { return m_Totals.m_NumDependencyCacheKey; }
 
     // get stats per node type
     struct Stats;
@@ -61,6 +81,7 @@ public:
         uint32_t m_NumCacheMisses;
         uint32_t m_NumCacheStores;
         uint32_t m_NumLightCache;
+        uint32_t m_NumDependencyCacheKey;
 
         uint32_t m_ProcessingTimeMS;
         uint32_t m_NumFailed;
@@ -43,18 +43,16 @@ MultiBuffer::~MultiBuffer()
 //------------------------------------------------------------------------------
 bool MultiBuffer::CreateFromFiles( const Array< AString > & fileNames, size_t * outproblemFileIndex )
 {
-    ASSERT( fileNames.GetSize() <= MAX_FILES );
     ASSERT( ( m_ReadStream == nullptr ) && ( m_WriteStream == nullptr ) );
 
-    uint64_t fileSizes[ MAX_FILES ];
-    FileStream fileStreams[ MAX_FILES ];
     const size_t numFiles = fileNames.GetSize();
+    Array< uint64_t > fileSizes( numFiles, false );
 
-    // Open all the files and determine their size
+    // Determine the size of all the files
     uint64_t memSize = sizeof( uint32_t ); // write number of files
     for ( size_t i = 0; i <numFiles; ++i )
     {
-        FileStream& fs = fileStreams[ i ];
+        FileStream fs;
         if ( fs.Open( fileNames[ i ].Get(), FileStream::READ_ONLY ) == false )
         {
             if ( outproblemFileIndex )
@@ -65,7 +63,7 @@ bool MultiBuffer::CreateFromFiles( const Array< AString > & fileNames, size_t *
         }
         const uint64_t fileSize = fs.GetFileSize();
         memSize += ( sizeof( uint64_t ) + fileSize );
-        fileSizes[ i ] = fileSize;
+        fileSizes.Append( fileSize );
     }
 
     // Allocate enough space for the concatenated output
@@ -81,10 +79,13 @@ bool MultiBuffer::CreateFromFiles( const Array< AString > & fileNames, size_t *
     }
 
     // Read data for each file
+    // (files are opened one at a time, so any number of files can be stored)
     for ( size_t i = 0; i <numFiles; ++i )
     {
-        FileStream & fs = fileStreams[ i ];
-        if ( m_WriteStream->WriteBuffer( fs, fileSizes[ i ] ) != fileSizes[ i ] )
+        FileStream fs;
+        if ( ( fs.Open( fileNames[ i ].Get(), FileStream::READ_ONLY ) == false ) ||
+             ( fs.GetFileSize() != fileSizes[ i ] ) || // modified since sizes were taken
+             ( m_WriteStream->WriteBuffer( fs, fileSizes[ i ] ) != fileSizes[ i ] ) )
         {
             if ( outproblemFileIndex )
             {
@@ -99,6 +100,22 @@ bool MultiBuffer::CreateFromFiles( const Array< AString > & fileNames, size_t *
     return true;
 }
 
+// GetNumFiles
+//------------------------------------------------------------------------------
+uint32_t MultiBuffer::GetNumFiles() const
+{
+    ASSERT( m_ReadStream );
+
+    if ( m_ReadStream->GetSize() < sizeof( uint32_t ) )
+    {
+        return 0;
+    }
+    m_ReadStream->Seek( 0 );
+    uint32_t numFiles;
+    m_ReadStream->Read( numFiles );
+    return numFiles;
+}
+
 // ExtractFile
 //------------------------------------------------------------------------------
 bool MultiBuffer::ExtractFile( size_t index, const AString& fileName ) const
@@ -157,13 +174,13 @@ bool MultiBuffer::ExtractFile( size_t index, const AString& fileName ) const
 
 // Compress
 //------------------------------------------------------------------------------
-void MultiBuffer::Compress( int32_t compressionLevel )
+void MultiBuffer::Compress( int32_t compressionLevel, const CompressionDictionary * dictionary )
 {
     ASSERT( m_WriteStream ); // Data needs to be populated
 
     // Compress the data
     Compressor c;
-    c.Compress( m_WriteStream->GetData(), m_WriteStream->GetSize(), compressionLevel );
+    c.Compress( m_WriteStream->GetData(), m_WriteStream->GetSize(), compressionLevel, dictionary );
 
     // Transfer compressed results
     const size_t compressedSize = c.GetResultSize();
@@ -11,6 +11,7 @@
 // Forward Declarations
 //------------------------------------------------------------------------------
 class AString;
+class CompressionDictionary;
 class ConstMemoryStream;
 class MemoryStream;
 
@@ -25,8 +26,9 @@ public:
 
     bool CreateFromFiles( const Array< AString > & fileNames, size_t * outProblemFileIndex = nullptr );
     bool ExtractFile( size_t index, const AString& fileName ) const;
+    uint32_t GetNumFiles() const;
 
-    void Compress( int32_t compressionLevel );
+    void Compress( int32_t compressionLevel, const CompressionDictionary * dictionary = nullptr );
     bool Decompress();
 
     const void *    GetData() const;
@@ -35,8 +37,6 @@ public:
     void *          Release( size_t & outSize );
 
 private:
-    enum : uint32_t { MAX_FILES = 4 };
-
     ConstMemoryStream * m_ReadStream;
     MemoryStream *      m_WriteStream;
 };
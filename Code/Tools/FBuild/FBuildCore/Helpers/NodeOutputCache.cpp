@@ -0,0 +1,325 @@
+// NodeOutputCache - Caching of outputs for nodes other than ObjectNode
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "NodeOutputCache.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/CacheWriteQueue.h"
+#include "Tools/FBuild/FBuildCore/Cache/ICache.h"
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
+#include "Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h"
+
+// Core
+#include "Core/Containers/UniquePtr.h"
+#include "Core/Env/ErrorFormat.h"
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/Math/xxHash.h"
+#include "Core/Mem/Mem.h"
+#include "Core/Profile/Profile.h"
+#include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// CONSTRUCTOR
+//------------------------------------------------------------------------------
+NodeOutputCache::NodeOutputCache( Node & node, const char * messagePrefix, const Array< AString > & outputFiles )
+    : m_Node( node )
+    , m_MessagePrefix( messagePrefix )
+    , m_OutputFiles( outputFiles )
+{
+    ASSERT( m_OutputFiles.IsEmpty() == false );
+}
+
+// BuildCacheId
+//------------------------------------------------------------------------------
+bool NodeOutputCache::BuildCacheId( const AString & executable, const AString & args )
+{
+    PROFILE_FUNCTION;
+
+    // Hash contents of all file inputs. Time stamps can't be used as they
+    // differ between machines (and clean checkouts).
+    Array< uint64_t > inputHashes( 64, true );
+    if ( ( HashInputs( m_Node.GetStaticDependencies(), inputHashes ) == false ) ||
+         ( HashInputs( m_Node.GetDynamicDependencies(), inputHashes ) == false ) )
+    {
+        return false;
+    }
+    const uint64_t inputsKey = inputHashes.IsEmpty() ? 0 : xxHash3::Calc64( inputHashes.Begin(), inputHashes.GetSize() * sizeof( uint64_t ) );
+
+    // Executable
+    uint64_t executableKey;
+    if ( HashFile( executable, executableKey ) == false )
+    {
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            FLOG_OUTPUT( "%s: %s\n"
+                         " - Cache key cannot be formed (failed to read '%s')\n",
+                         m_MessagePrefix, m_Node.GetName().Get(), executable.Get() );
+        }
+        return false;
+    }
+
+    // Arguments
+    const uint32_t argsKey = xxHash::Calc32( args );
+
+    // Node type and outputs (entries are only valid for the same set of outputs)
+    AStackString<> outputs( m_Node.GetTypeName() );
+    for ( const AString & outputFile : m_OutputFiles )
+    {
+        outputs += '|';
+        outputs += outputFile;
+    }
+    const uint64_t outputsKey = xxHash3::Calc64( outputs );
+
+    ICache::GetCacheId( inputsKey, argsKey, executableKey, outputsKey, m_CacheId );
+    return true;
+}
+
+// HashInputs
+//------------------------------------------------------------------------------
+bool NodeOutputCache::HashInputs( const Dependencies & deps, Array< uint64_t > & inputHashes ) const
+{
+    for ( const Dependency & dep : deps )
+    {
+        const Node * input = dep.GetNode();
+
+        // Object lists (i.e. LibrarianAdditionalInputs) contribute the objects they contain
+        if ( input->GetType() == Node::OBJECT_LIST_NODE )
+        {
+            if ( HashInputs( input->GetDynamicDependencies(), inputHashes ) == false )
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if ( input->IsAFile() == false )
+        {
+            continue; // Directory lists etc. (the files they find are dynamic dependencies)
+        }
+        if ( HashInput( input->GetName(), inputHashes ) == false )
+        {
+            return false;
+        }
+
+        // MSVC precompiled headers also have an object which is used in their place
+        if ( input->GetType() == Node::OBJECT_NODE )
+        {
+            const ObjectNode * on = input->CastTo< ObjectNode >();
+            if ( on->IsCreatingPCH() && ( on->IsMSVC() || on->IsClangCl() ) )
+            {
+                if ( HashInput( on->GetPCHObjectName(), inputHashes ) == false )
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// HashInput
+//------------------------------------------------------------------------------
+bool NodeOutputCache::HashInput( const AString & fileName, Array< uint64_t > & inputHashes ) const
+{
+    uint64_t hash;
+    if ( HashFile( fileName, hash ) == false )
+    {
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            FLOG_OUTPUT( "%s: %s\n"
+                         " - Cache key cannot be formed (failed to read '%s')\n",
+                         m_MessagePrefix, m_Node.GetName().Get(), fileName.Get() );
+        }
+        return false;
+    }
+    inputHashes.Append( hash );
+    return true;
+}
+
+// Retrieve
+//------------------------------------------------------------------------------
+bool NodeOutputCache::Retrieve()
+{
+    ASSERT( m_CacheId.IsEmpty() == false );
+
+    if ( FBuild::Get().GetOptions().m_UseCacheRead == false )
+    {
+        return false;
+    }
+
+    PROFILE_FUNCTION;
+
+    const Timer t;
+
+    ICache * cache = FBuild::Get().GetCache();
+    ASSERT( cache );
+
+    void * cacheData( nullptr );
+    size_t cacheDataSize( 0 );
+    bool found = cache->Retrieve( m_CacheId, cacheData, cacheDataSize );
+    if ( found && Compressor::IsDictionaryMissing( cacheData, cacheDataSize ) )
+    {
+        // Written using a compression dictionary we don't have
+        cache->FreeMemory( cacheData, cacheDataSize );
+        found = false;
+    }
+    if ( found == false )
+    {
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            FLOG_OUTPUT( "%s: %s\n"
+                         " - Cache Miss: %u ms '%s'\n",
+                         m_MessagePrefix, m_Node.GetName().Get(), uint32_t( t.GetElapsedMS() ), m_CacheId.Get() );
+        }
+        m_Node.SetStatFlag( Node::STATS_CACHE_MISS );
+        return false;
+    }
+
+    const uint32_t retrieveTime = uint32_t( t.GetElapsedMS() );
+
+    MultiBuffer buffer( cacheData, cacheDataSize );
+    if ( ( buffer.Decompress() == false ) ||
+         ( buffer.GetNumFiles() != m_OutputFiles.GetSize() ) )
+    {
+        cache->FreeMemory( cacheData, cacheDataSize );
+        FLOG_WARN( "Cache returned invalid data\n"
+                   " - File: '%s'\n"
+                   " - Key : %s\n",
+                   m_Node.GetName().Get(), m_CacheId.Get() );
+        return false;
+    }
+
+    // Extract the files
+    const size_t numFiles = m_OutputFiles.GetSize();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        const AString & fileName = m_OutputFiles[ i ];
+        if ( ( Node::EnsurePathExistsForFile( fileName ) == false ) ||
+             ( buffer.ExtractFile( i, fileName ) == false ) )
+        {
+            cache->FreeMemory( cacheData, cacheDataSize );
+            FLOG_ERROR( "Failed to write local file during cache retrieval '%s'", fileName.Get() );
+            return false;
+        }
+
+        if ( FileIO::SetFileLastWriteTimeToNow( fileName ) == false )
+        {
+            cache->FreeMemory( cacheData, cacheDataSize );
+            FLOG_ERROR( "Failed to set timestamp after cache hit. Error: %s Target: '%s'", LAST_ERROR_STR, fileName.Get() );
+            return false;
+        }
+    }
+
+    cache->FreeMemory( cacheData, cacheDataSize );
+
+    // Output
+    if ( FBuild::Get().GetOptions().m_ShowCommandSummary ||
+         FBuild::Get().GetOptions().m_CacheVerbose )
+    {
+        AStackString<> output;
+        output.Format( "%s: %s <CACHE>\n", m_MessagePrefix, m_Node.GetName().Get() );
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            output.AppendFormat( " - Cache Hit: %u ms (Retrieve: %u ms) (Compressed: %zu - Files: %zu) '%s'\n",
+                                 uint32_t( t.GetElapsedMS() ), retrieveTime, cacheDataSize, numFiles, m_CacheId.Get() );
+        }
+        FLOG_OUTPUT( output );
+    }
+
+    m_Node.SetStatFlag( Node::STATS_CACHE_HIT );
+    return true;
+}
+
+// Store
+//------------------------------------------------------------------------------
+void NodeOutputCache::Store()
+{
+    ASSERT( m_CacheId.IsEmpty() == false );
+
+    if ( FBuild::Get().GetOptions().m_UseCacheWrite == false )
+    {
+        return;
+    }
+
+    PROFILE_FUNCTION;
+
+    const Timer t;
+
+    // Load and compress files
+    MultiBuffer buffer;
+    if ( buffer.CreateFromFiles( m_OutputFiles ) == false )
+    {
+        if ( FBuild::Get().GetOptions().m_CacheVerbose )
+        {
+            FLOG_OUTPUT( "%s: %s\n"
+                         " - Cache Store Fail: '%s' (local IO problem)\n",
+                         m_MessagePrefix, m_Node.GetName().Get(), m_CacheId.Get() );
+        }
+        return;
+    }
+    buffer.Compress( FBuild::Get().GetOptions().m_CacheCompressionLevel,
+                     FBuild::Get().GetCompressionDictionary( CompressionDictionary::OBJECTS ) );
+    size_t dataSize;
+    UniquePtr< void > data( buffer.Release( dataSize ) );
+
+    // Hand off to background publishing, if enabled and not full
+    bool stored = false;
+    bool queued = false;
+    CacheWriteQueue * writeQueue = FBuild::Get().GetCacheWriteQueue();
+    if ( writeQueue )
+    {
+        AStackString<> description;
+        description.Format( "%s: %s", m_MessagePrefix, m_Node.GetName().Get() );
+        queued = writeQueue->Enqueue( m_CacheId, data.Get(), dataSize, description );
+        stored = queued;
+    }
+    if ( stored == false )
+    {
+        stored = FBuild::Get().GetCache()->Publish( m_CacheId, data.Get(), dataSize );
+    }
+
+    const uint32_t cachingTime = uint32_t( t.GetElapsedMS() );
+    if ( stored )
+    {
+        m_Node.SetStatFlag( Node::STATS_CACHE_STORE );
+        m_Node.AddCachingTime( cachingTime );
+    }
+
+    // Output
+    if ( FBuild::Get().GetOptions().m_CacheVerbose )
+    {
+        FLOG_OUTPUT( "%s: %s\n"
+                     " - Cache Store%s: %u ms (Compressed: %zu - Files: %zu) '%s'\n",
+                     m_MessagePrefix, m_Node.GetName().Get(),
+                     stored ? ( queued ? " Queued" : "" ) : " Fail",
+                     cachingTime, dataSize, m_OutputFiles.GetSize(), m_CacheId.Get() );
+    }
+}
+
+// HashFile
+//------------------------------------------------------------------------------
+/*static*/ bool NodeOutputCache::HashFile( const AString & fileName, uint64_t & outHash )
+{
+    FileStream f;
+    if ( f.Open( fileName.Get(), FileStream::READ_ONLY ) == false )
+    {
+        return false;
+    }
+    const size_t fileSize = (size_t)f.GetFileSize();
+    UniquePtr< char > mem( (char *)ALLOC( fileSize ? fileSize : 1 ) );
+    if ( f.ReadBuffer( mem.Get(), fileSize ) != fileSize )
+    {
+        return false;
+    }
+    outHash = xxHash3::Calc64( mem.Get(), fileSize );
+    return true;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+// NodeOutputCache - Caching of outputs for nodes other than ObjectNode
+//------------------------------------------------------------------------------
+#pragma once
+
+// Includes
+//------------------------------------------------------------------------------
+#include "Core/Containers/Array.h"
+#include "Core/Strings/AString.h"
+
+// Forward Declarations
+//------------------------------------------------------------------------------
+class Dependencies;
+class Node;
+
+// NodeOutputCache
+//  - Cache entries contain any number of output files (stored via MultiBuffer)
+//  - Keys are formed from the contents of the node's file dependencies, the
+//    contents of the executable and the arguments, so entries can be shared
+//    between machines
+//------------------------------------------------------------------------------
+class NodeOutputCache
+{
+public:
+    explicit NodeOutputCache( Node & node, const char * messagePrefix, const Array< AString > & outputFiles );
+
+    // Form the cache key. Fails if any input can't be read.
+    bool            BuildCacheId( const AString & executable, const AString & args );
+    const AString & GetCacheId() const { return m_CacheId; }
+
+    // Extract all outputs from the cache (-cacheread)
+    bool            Retrieve();
+
+    // Store all outputs to the cache (-cachewrite)
+    void            Store();
+
+    static bool     HashFile( const AString & fileName, uint64_t & outHash );
+
+private:
+    bool            HashInputs( const Dependencies & deps, Array< uint64_t > & inputHashes ) const;
+    bool            HashInput( const AString & fileName, Array< uint64_t > & inputHashes ) const;
+
+    Node &                      m_Node;
+    const char *                m_MessagePrefix;    // For output: "Run", "Lib" etc.
+    const Array< AString > &    m_OutputFiles;
+    AString                     m_CacheId;
+};
+
+//------------------------------------------------------------------------------
@@ -231,7 +231,7 @@ void JSONReport::DoCPUTimeByType(const FBuildStats& stats)
 
 // DoCacheStats
 //------------------------------------------------------------------------------
-void JSONReport::DoCacheStats( const FBuildStats & /*stats*/ )
+void JSONReport::DoCacheStats( const FBuildStats & stats )
 {
     Write( "\"Cache Stats\": {\n" );
 
@@ -286,6 +286,35 @@ void JSONReport::DoCacheStats( const FBuildStats & /*stats*/ )
         // end of summary section
         Write( "\n\t\t}," );
 
+        // local/remote cache tiers
+        const TieredCacheStats & tierStats = stats.m_TieredCacheStats;
+        if ( tierStats.IsEmpty() == false )
+        {
+            const uint32_t lookups = ( tierStats.m_NumLocalHits + tierStats.m_NumRemoteHits + tierStats.m_NumMisses );
+            const float localPerc = ( lookups > 0 ) ? ( (float)tierStats.m_NumLocalHits / (float)lookups ) * 100.0f : 0.0f;
+            const float remotePerc = ( lookups > 0 ) ? ( (float)tierStats.m_NumRemoteHits / (float)lookups ) * 100.0f : 0.0f;
+
+            Write( "\n\t\t\"tiers\": {\n\t\t\t" );
+            Write( "\"Local Hits\": {" );
+            Write( "\n\t\t\t\t" );
+            Write( "\"Count\": %u,", tierStats.m_NumLocalHits );
+            Write( "\n\t\t\t\t" );
+            Write( "\"Percentage\": %.1f", (double)localPerc );
+            Write( "\n\t\t\t" );
+            Write( "},\n\t\t\t" );
+            Write( "\"Remote Hits\": {" );
+            Write( "\n\t\t\t\t" );
+            Write( "\"Count\": %u,", tierStats.m_NumRemoteHits );
+            Write( "\n\t\t\t\t" );
+            Write( "\"Percentage\": %.1f", (double)remotePerc );
+            Write( "\n\t\t\t" );
+            Write( "},\n\t\t\t" );
+            Write( "\"Promoted\": %u,\n\t\t\t", tierStats.m_NumPromoted );
+            Write( "\"Remote Stores\": %u,\n\t\t\t", tierStats.m_NumRemoteStores );
+            Write( "\"Remote Store Failures\": %u", tierStats.m_NumRemoteFailed );
+            Write( "\n\t\t}," );
+        }
+
         // library stats information
         Write( "\n\t\t\"details\": [\n\t\t\t" );
 
@@ -18,6 +18,7 @@
 //------------------------------------------------------------------------------
 ResponseFile::ResponseFile()
     : m_EscapeSlashes( false )
+    , m_Quiet( false )
 {
 }
 
@@ -91,13 +92,16 @@ bool ResponseFile::CreateInternal( const AString & contents )
         // Retry
         if ( !m_File.Open( m_ResponseFilePath.Get(), flags ) )
         {
-            FLOG_ERROR( "Failed to create response file '%s'", m_ResponseFilePath.Get() );
+            if ( m_Quiet == false )
+            {
+                FLOG_ERROR( "Failed to create response file '%s'", m_ResponseFilePath.Get() );
+            }
             return false; // user must handle error
         }
     }
 
     const bool ok = ( m_File.Write( contents.Get(), contents.GetLength() ) == contents.GetLength() );
-    if ( !ok )
+    if ( !ok && ( m_Quiet == false ) )
     {
         FLOG_ERROR( "Failed to write response file '%s'", m_ResponseFilePath.Get() );
     }
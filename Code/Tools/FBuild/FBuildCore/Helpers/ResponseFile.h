@@ -25,12 +25,14 @@ public:
     const AString & GetResponseFilePath() const { return m_ResponseFilePath; }
 
     void SetEscapeSlashes() { m_EscapeSlashes = true; }
+    void SetQuiet() { m_Quiet = true; } // Caller handles (and reports) failures
 private:
     bool CreateInternal( const AString & contents );
 
     FileStream m_File;
     AStackString<> m_ResponseFilePath;
     bool m_EscapeSlashes;
+    bool m_Quiet;
 };
 
 //------------------------------------------------------------------------------
@@ -14,6 +14,8 @@
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/FileIO/PathUtils.h"
 #include "Core/Math/xxHash.h"
+#include "Core/Process/Process.h"
+#include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
@@ -362,30 +364,18 @@ bool ToolManifest::DeserializeFromRemote( IOStream & ms )
         FileIO::SetFileLastWriteTimeToNow( localFile );
 
         // is this file already present?
-        UniquePtr< FileStream, DeleteDeletor > fileStream( FNEW( FileStream ) );
-        FileStream & f = *( fileStream.Get() );
-        if ( f.Open( localFile.Get() ) == false )
+        if ( UseExistingFile( (uint32_t)i, localFile ) )
         {
-            continue; // file not found
+            AddToStore( (uint32_t)i, localFile ); // Make available to other toolchains
+            numFilesAlreadySynchronized++;
+            continue;
         }
-        if ( f.GetFileSize() != m_Files[ i ].GetUncompressedContentSize() )
-        {
-            continue; // file is not complete
-        }
-        UniquePtr< char > mem( (char *)ALLOC( (size_t)f.GetFileSize() ) );
-        if ( f.Read( mem.Get(), (size_t)f.GetFileSize() ) != f.GetFileSize() )
-        {
-            continue; // problem reading file
-        }
-        if ( xxHash::Calc32( mem.Get(), (size_t)f.GetFileSize() ) != m_Files[ i ].GetHash() )
+
+        // is the same content already present for another toolchain?
+        if ( UseStoredFile( (uint32_t)i, localFile ) )
         {
-            continue; // file contents unexpected
+            numFilesAlreadySynchronized++;
         }
-
-        // file present and ok
-        m_Files[ i ].SetFileLock( fileStream.Release() ); // NOTE: keep file open to prevent deletions
-        m_Files[ i ].SetSyncState( ToolManifestFile::SYNCHRONIZED );
-        numFilesAlreadySynchronized++;
     }
 
     // Generate Environment
@@ -630,6 +620,8 @@ bool ToolManifest::ReceiveFileData( uint32_t fileId,
     }
 
     // write to disk
+    // (removing any old file first, as it may share content with the store)
+    FileIO::FileDelete( fileName.Get() );
     FileStream fs;
     if ( !fs.Open( fileName.Get(), FileStream::WRITE_ONLY ) )
     {
@@ -657,6 +649,30 @@ bool ToolManifest::ReceiveFileData( uint32_t fileId,
     f.SetFileLock( fileStream.Release() ); // NOTE: Keep file open to prevent deletion
     f.SetSyncState( ToolManifestFile::SYNCHRONIZED );
 
+    // Make available to other toolchains
+    AddToStore( fileId, fileName );
+
+    // Assemble any files with identical content that were not requested
+    // (see FindSynchronizingDuplicate)
+    const size_t numFiles = m_Files.GetSize();
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        const ToolManifestFile & other = m_Files[ i ];
+        if ( ( other.GetSyncState() != ToolManifestFile::SYNCHRONIZING ) ||
+             ( other.GetHash() != f.GetHash() ) ||
+             ( other.GetUncompressedContentSize() != f.GetUncompressedContentSize() ) )
+        {
+            continue;
+        }
+        AStackString<> otherFileName;
+        GetRemoteFilePath( (uint32_t)i, otherFileName );
+        if ( ( UseDuplicateFile( (uint32_t)i, fileName, otherFileName ) == false ) &&
+             ( UseStoredFile( (uint32_t)i, otherFileName ) == false ) )
+        {
+            return false; // FAILED
+        }
+    }
+
     // is completely synchronized?
     const ToolManifestFile * const end = m_Files.End();
     for ( const ToolManifestFile * it = m_Files.Begin(); it != end; ++it )
@@ -673,6 +689,169 @@ bool ToolManifest::ReceiveFileData( uint32_t fileId,
     return true; // file stored ok
 }
 
+// FindSynchronizingDuplicate
+//------------------------------------------------------------------------------
+bool ToolManifest::FindSynchronizingDuplicate( size_t fileId ) const
+{
+    MutexHolder mh( m_Mutex );
+
+    const ToolManifestFile & f = m_Files[ fileId ];
+    for ( size_t i = 0; i < fileId; ++i )
+    {
+        const ToolManifestFile & other = m_Files[ i ];
+        if ( ( other.GetSyncState() == ToolManifestFile::SYNCHRONIZING ) &&
+             ( other.GetHash() == f.GetHash() ) &&
+             ( other.GetUncompressedContentSize() == f.GetUncompressedContentSize() ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// UseExistingFile
+//------------------------------------------------------------------------------
+bool ToolManifest::UseExistingFile( uint32_t fileId, const AString & localFile )
+{
+    ToolManifestFile & file = m_Files[ fileId ];
+
+    UniquePtr< FileStream, DeleteDeletor > fileStream( FNEW( FileStream ) );
+    FileStream & f = *( fileStream.Get() );
+    if ( f.Open( localFile.Get() ) == false )
+    {
+        return false; // file not found
+    }
+    if ( f.GetFileSize() != file.GetUncompressedContentSize() )
+    {
+        return false; // file is not complete
+    }
+    UniquePtr< char > mem( (char *)ALLOC( (size_t)f.GetFileSize() ) );
+    if ( f.Read( mem.Get(), (size_t)f.GetFileSize() ) != f.GetFileSize() )
+    {
+        return false; // problem reading file
+    }
+    if ( xxHash::Calc32( mem.Get(), (size_t)f.GetFileSize() ) != file.GetHash() )
+    {
+        return false; // file contents unexpected
+    }
+
+    // file present and ok
+    file.SetFileLock( fileStream.Release() ); // NOTE: keep file open to prevent deletions
+    file.SetSyncState( ToolManifestFile::SYNCHRONIZED );
+    return true;
+}
+
+// UseStoredFile
+//------------------------------------------------------------------------------
+bool ToolManifest::UseStoredFile( uint32_t fileId, const AString & localFile )
+{
+    AStackString<> storeFile;
+    GetStoreFilePath( m_Files[ fileId ], storeFile );
+    if ( FileIO::FileExists( storeFile.Get() ) == false )
+    {
+        return false; // content not available
+    }
+
+    // Share the stored content
+    if ( LinkOrCopyFile( storeFile, localFile ) == false )
+    {
+        return false;
+    }
+
+    // Verify the content, in case the store was damaged
+    if ( UseExistingFile( fileId, localFile ) == false )
+    {
+        FileIO::FileDelete( localFile.Get() );
+        FileIO::FileDelete( storeFile.Get() );
+        return false;
+    }
+    return true;
+}
+
+// UseDuplicateFile
+//  - Assemble a file from another file in the same manifest with identical content
+//------------------------------------------------------------------------------
+bool ToolManifest::UseDuplicateFile( uint32_t fileId, const AString & sourceFile, const AString & localFile )
+{
+    if ( LinkOrCopyFile( sourceFile, localFile ) == false )
+    {
+        return false;
+    }
+    if ( UseExistingFile( fileId, localFile ) == false )
+    {
+        FileIO::FileDelete( localFile.Get() );
+        return false;
+    }
+    return true;
+}
+
+// LinkOrCopyFile
+//------------------------------------------------------------------------------
+/*static*/ bool ToolManifest::LinkOrCopyFile( const AString & sourceFile, const AString & localFile )
+{
+    // Remove any incomplete file left from a previous run
+    FileIO::FileDelete( localFile.Get() );
+    if ( FileIO::EnsurePathExistsForFile( localFile ) == false )
+    {
+        return false;
+    }
+
+    // Share the content, or fall back to a local copy (different volume etc.)
+    return ( FileIO::FileHardLink( sourceFile, localFile ) ||
+             FileIO::FileCopy( sourceFile.Get(), localFile.Get() ) );
+}
+
+// AddToStore
+//------------------------------------------------------------------------------
+void ToolManifest::AddToStore( uint32_t fileId, const AString & localFile ) const
+{
+    AStackString<> storeFile;
+    GetStoreFilePath( m_Files[ fileId ], storeFile );
+    if ( FileIO::FileExists( storeFile.Get() ) )
+    {
+        return; // already stored (by this or another toolchain)
+    }
+
+    // Failure is harmless: the content will be transferred again if needed.
+    if ( FileIO::EnsurePathExistsForFile( storeFile ) == false )
+    {
+        return;
+    }
+
+    // Linking is atomic, so other toolchains never see a partial file
+    if ( FileIO::FileHardLink( localFile, storeFile ) )
+    {
+        return;
+    }
+
+    // Linking is not possible (different volume etc.) so store a copy,
+    // via a uniquely named temp file which is atomically renamed into place
+    AStackString<> tmpFile;
+    tmpFile.Format( "%s.%u.%u.tmp", storeFile.Get(), Process::GetCurrentId(), (uint32_t)Thread::GetCurrentThreadId() );
+    if ( FileIO::FileCopy( localFile.Get(), tmpFile.Get() ) &&
+         FileIO::FileMove( tmpFile, storeFile ) )
+    {
+        return;
+    }
+    FileIO::FileDelete( tmpFile.Get() );
+}
+
+// GetStoreFilePath
+//------------------------------------------------------------------------------
+/*static*/ void ToolManifest::GetStoreFilePath( const ToolManifestFile & file, AString & path )
+{
+    // Files are stored by content, so identical files in different toolchains
+    // (or different versions of the same toolchain) are only transferred once
+    VERIFY( FBuild::GetTempDir( path ) );
+    AStackString<> subDir;
+    #if defined( __WINDOWS__ )
+        subDir.Format( ".fbuild.tmp\\worker\\store\\%08x.%08x", file.GetHash(), file.GetUncompressedContentSize() );
+    #else
+        subDir.Format( "_fbuild.tmp/worker/store/%08x.%08x", file.GetHash(), file.GetUncompressedContentSize() );
+    #endif
+    path += subDir;
+}
+
 // GetRelativePath
 //------------------------------------------------------------------------------
 /*static*/ void ToolManifest::GetRelativePath( const AString & root, const AString & otherFile, AString & otherFileRelativePath )
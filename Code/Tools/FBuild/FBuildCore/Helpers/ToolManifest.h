@@ -105,6 +105,7 @@ public:
     const Array< ToolManifestFile > & GetFiles() const { return m_Files; }
 
     void MarkFileAsSynchronizing( size_t fileId ) { ASSERT( m_Files[ fileId ].GetSyncState() == ToolManifestFile::NOT_SYNCHRONIZED ); m_Files[ fileId ].SetSyncState( ToolManifestFile::SYNCHRONIZING ); }
+    bool FindSynchronizingDuplicate( size_t fileId ) const;
     void CancelSynchronizingFiles();
 
     const void *    GetFileData( uint32_t fileId, size_t & dataSize ) const;
@@ -121,6 +122,14 @@ public:
     #endif
 
 private:
+    // content-addressed store of files shared between toolchains on remote workers
+    bool            UseExistingFile( uint32_t fileId, const AString & localFile );
+    bool            UseStoredFile( uint32_t fileId, const AString & localFile );
+    bool            UseDuplicateFile( uint32_t fileId, const AString & sourceFile, const AString & localFile );
+    static bool     LinkOrCopyFile( const AString & sourceFile, const AString & localFile );
+    void            AddToStore( uint32_t fileId, const AString & localFile ) const;
+    static void     GetStoreFilePath( const ToolManifestFile & file, AString & path );
+
     mutable Mutex   m_Mutex;
 
     // Reflected
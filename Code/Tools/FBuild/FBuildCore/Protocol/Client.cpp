@@ -13,6 +13,8 @@
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
+#include "Tools/FBuild/FBuildCore/Helpers/CompressionDictionary.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
 #include <Tools/FBuild/FBuildCore/Helpers/MultiBuffer.h>
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
@@ -21,13 +23,16 @@
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/Math/Random.h"
+#include "Core/Network/Network.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Profile/Profile.h"
 
 // Defines
 //------------------------------------------------------------------------------
 #define CLIENT_STATUS_UPDATE_FREQUENCY_SECONDS ( 0.1f )
-#define CONNECTION_REATTEMPT_DELAY_TIME ( 10.0f )
+#define CONNECTION_TIMEOUT_MS ( 2000 )
+#define CONNECTION_REATTEMPT_DELAY_MIN ( 2.0f )     // doubled after each failure...
+#define CONNECTION_REATTEMPT_DELAY_MAX ( 120.0f )   // ...up to this limit
 #define SYSTEM_ERROR_ATTEMPT_COUNT ( 3 )
 #define DIST_INFO( ... ) do { if ( m_DetailedLogging ) { FLOG_OUTPUT( __VA_ARGS__ ); } } while( false )
 
@@ -71,6 +76,17 @@ Client::~Client()
     ASSERT( ss );
 
     MutexHolder mh( ss->m_Mutex );
+
+    // connection dropped before LookForWorkers could publish it?
+    if ( AtomicLoadRelaxed( &ss->m_Connection ) != connection )
+    {
+        ASSERT( ss->m_Jobs.IsEmpty() );
+        FREE( (void *)( ss->m_CurrentMessage ) );
+        ss->m_CurrentMessage = nullptr;
+        ss->m_DisconnectedBeforeConnected = true;
+        return;
+    }
+
     DIST_INFO( "Disconnected: %s\n", ss->m_RemoteName.Get() );
     if ( ss->m_Jobs.IsEmpty() == false )
     {
@@ -83,6 +99,7 @@ Client::~Client()
             ++it;
         }
         ss->m_Jobs.Clear();
+        RecordJobsInFlight( ss );
     }
 
     // This is usually null here, but might need to be freed if
@@ -174,8 +191,11 @@ void Client::LookForWorkers()
     Random r;
     const size_t startIndex = r.GetRandIndex( (uint32_t)numWorkers );
 
-    // find someone to connect to
-    for ( size_t j=0; j<numWorkers; j++ )
+    // find workers to connect to, up to the connection limit
+    const size_t maxNewConnections = ( m_WorkerConnectionLimit - numConnections );
+    Array< size_t > candidates( maxNewConnections );
+    Array< AString > hostNames( maxNewConnections );
+    for ( size_t j=0; ( j<numWorkers ) && ( candidates.GetSize() < maxNewConnections ); j++ )
     {
         const size_t i( ( j + startIndex ) % numWorkers );
 
@@ -191,42 +211,138 @@ void Client::LookForWorkers()
             continue;
         }
 
-        // lock the server state
-        MutexHolder mhSS( ss.m_Mutex );
-
-        ASSERT( ss.m_Jobs.IsEmpty() );
-
-        if ( ss.m_DelayTimer.GetElapsed() < CONNECTION_REATTEMPT_DELAY_TIME )
+        // unreachable workers are retried with increasing delays
+        if ( ss.m_DelayTimer.GetElapsed() < ss.m_ReconnectDelay )
         {
             continue;
         }
 
         DIST_INFO( "Connecting to: %s\n", m_WorkerList[ i ].Get() );
-        const ConnectionInfo * ci = Connect( m_WorkerList[ i ], m_Port, 2000, &ss ); // 2000ms connection timeout
-        if ( ci == nullptr )
+        candidates.Append( i );
+        hostNames.Append( m_WorkerList[ i ] );
+    }
+
+    if ( candidates.IsEmpty() )
+    {
+        return;
+    }
+
+    // Resolve and connect without holding any locks. The server list is never
+    // resized and only this thread establishes connections, so the candidates
+    // remain valid. Disconnections which occur before the results are
+    // published below are flagged by OnDisconnected.
+    Array< size_t > indices( candidates.GetSize() );
+    Array< uint32_t > hostIPs( candidates.GetSize() );
+    Array< void * > userData( candidates.GetSize() );
+    Array< const ConnectionInfo * > connections;
+    {
+        m_ServerListMutex.Unlock();
+
+        // resolve all names at once
+        Array< uint32_t > resolvedIPs;
+        Network::GetHostIPsFromNames( hostNames, CONNECTION_TIMEOUT_MS, resolvedIPs );
+        for ( size_t k = 0; k < candidates.GetSize(); ++k )
+        {
+            const size_t i = candidates[ k ];
+            ServerState & ss = m_ServerList[ i ];
+            if ( resolvedIPs[ k ] == 0 )
+            {
+                DIST_INFO( " - connection: %s (FAILED)\n", m_WorkerList[ i ].Get() );
+                ss.OnConnectionFailed();
+                m_ServerListMutex.Lock();
+                m_ConnectionStats.m_NumFailedAttempts++;
+                m_ServerListMutex.Unlock();
+                continue;
+            }
+
+            {
+                MutexHolder ssMH( ss.m_Mutex );
+                ASSERT( ss.m_Jobs.IsEmpty() );
+                ss.m_DisconnectedBeforeConnected = false;
+            }
+
+            indices.Append( i );
+            hostIPs.Append( resolvedIPs[ k ] );
+            userData.Append( &ss );
+        }
+
+        // connect to all of them at once
+        if ( indices.IsEmpty() == false )
+        {
+            ConnectMultiple( hostIPs, m_Port, CONNECTION_TIMEOUT_MS, userData, connections );
+        }
+
+        m_ServerListMutex.Lock();
+    }
+
+    // publish the results
+    for ( size_t k = 0; k < indices.GetSize(); ++k )
+    {
+        const size_t i = indices[ k ];
+        ServerState & ss = m_ServerList[ i ];
+        MutexHolder ssMH( ss.m_Mutex );
+        if ( ( connections[ k ] == nullptr ) || ss.m_DisconnectedBeforeConnected )
         {
             DIST_INFO( " - connection: %s (FAILED)\n", m_WorkerList[ i ].Get() );
-            ss.m_DelayTimer.Start(); // reset connection attempt delay
+            ss.OnConnectionFailed();
+            m_ConnectionStats.m_NumFailedAttempts++;
         }
         else
         {
             DIST_INFO( " - connection: %s (OK)\n", m_WorkerList[ i ].Get() );
-            const uint32_t numJobsAvailable = (uint32_t)JobQueue::Get().GetNumDistributableJobsAvailable();
+            OnWorkerConnected( i, connections[ k ] );
+        }
+    }
+}
 
-            ss.m_RemoteName = m_WorkerList[ i ];
-            AtomicStoreRelaxed( &ss.m_Connection, ci ); // success!
-            ss.m_NumJobsAvailable = numJobsAvailable;
+// OnWorkerConnected
+//------------------------------------------------------------------------------
+void Client::OnWorkerConnected( size_t index, const ConnectionInfo * connection )
+{
+    // NOTE: m_ServerListMutex and ServerState::m_Mutex are held by caller
+    ServerState & ss = m_ServerList[ index ];
+    const uint32_t numJobsAvailable = (uint32_t)JobQueue::Get().GetNumDistributableJobsAvailable();
 
-            // send connection msg
-            const Protocol::MsgConnection msg( numJobsAvailable );
-            SendMessageInternal( ci, msg );
-        }
+    ss.m_RemoteName = m_WorkerList[ index ];
+    AtomicStoreRelaxed( &ss.m_Connection, connection ); // success!
+    ss.m_NumJobsAvailable = numJobsAvailable;
+    ss.m_ProtocolVersionMinor = 0; // Until the worker tells us otherwise (see MsgServerInfo)
+    ss.m_ReconnectDelay = 0.0f;
 
-        // limit to one connection attempt per iteration
-        return;
+    // send connection msg
+    const Protocol::MsgConnection msg( numJobsAvailable );
+    SendMessageInternal( connection, msg );
+
+    // track how quickly we reach full distribution width
+    uint32_t numConnections = 0;
+    for ( const ServerState & other : m_ServerList )
+    {
+        if ( AtomicLoadRelaxed( &other.m_Connection ) )
+        {
+            numConnections++;
+        }
+    }
+    if ( numConnections > m_ConnectionStats.m_NumConnected )
+    {
+        const float elapsed = m_StartTimer.GetElapsed();
+        if ( m_ConnectionStats.m_NumConnected == 0 )
+        {
+            m_ConnectionStats.m_TimeToFirstConnection = elapsed;
+        }
+        m_ConnectionStats.m_NumConnected = numConnections;
+        m_ConnectionStats.m_TimeToAllConnections = elapsed;
     }
 }
 
+// GetConnectionStats
+//------------------------------------------------------------------------------
+void Client::GetConnectionStats( WorkerConnectionStats & outStats )
+{
+    MutexHolder mh( m_ServerListMutex );
+    outStats = m_ConnectionStats;
+    outStats.m_NumWorkers = (uint32_t)m_ServerList.GetSize();
+}
+
 // CommunicateJobAvailability
 //------------------------------------------------------------------------------
 void Client::CommunicateJobAvailability()
@@ -332,6 +448,27 @@ void Client::SendMessageInternal( const ConnectionInfo * connection, const Proto
                 (uint32_t)memoryStream.GetSize() );
 }
 
+// SendMessageInternal
+//------------------------------------------------------------------------------
+void Client::SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg, const SendBuffer * payloadBuffers, uint32_t numPayloadBuffers )
+{
+    if ( msg.Send( connection, payloadBuffers, numPayloadBuffers ) )
+    {
+        return;
+    }
+
+    uint32_t payloadSize = 0;
+    for ( uint32_t i = 0; i < numPayloadBuffers; ++i )
+    {
+        payloadSize += payloadBuffers[ i ].size;
+    }
+    DIST_INFO( "Send Failed: %s (Type: %u, Size: %u, Payload: %u)\n",
+                ((ServerState *)connection->GetUserData())->m_RemoteName.Get(),
+                (uint32_t)msg.GetType(),
+                msg.GetSize(),
+                payloadSize );
+}
+
 // OnReceive
 //------------------------------------------------------------------------------
 /*virtual*/ void Client::OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory )
@@ -375,6 +512,12 @@ void Client::SendMessageInternal( const ConnectionInfo * connection, const Proto
             Process( connection, msg );
             break;
         }
+        case Protocol::MSG_REQUEST_JOBS:
+        {
+            const Protocol::MsgRequestJobs * msg = static_cast< const Protocol::MsgRequestJobs * >( imsg );
+            Process( connection, msg );
+            break;
+        }
         case Protocol::MSG_JOB_RESULT:
         {
             const Protocol::MsgJobResult * msg = static_cast< const Protocol::MsgJobResult * >( imsg );
@@ -387,6 +530,12 @@ void Client::SendMessageInternal( const ConnectionInfo * connection, const Proto
             Process( connection, msg, payload, payloadSize );
             break;
         }
+        case Protocol::MSG_JOB_RESULTS:
+        {
+            const Protocol::MsgJobResults * msg = static_cast< const Protocol::MsgJobResults * >( imsg );
+            Process( connection, msg, payload, payloadSize );
+            break;
+        }
         case Protocol::MSG_REQUEST_MANIFEST:
         {
             const Protocol::MsgRequestManifest * msg = static_cast< const Protocol::MsgRequestManifest * >( imsg );
@@ -399,6 +548,12 @@ void Client::SendMessageInternal( const ConnectionInfo * connection, const Proto
             Process( connection, msg );
             break;
         }
+        case Protocol::MSG_SERVER_INFO:
+        {
+            const Protocol::MsgServerInfo * msg = static_cast< const Protocol::MsgServerInfo * >( imsg );
+            Process( connection, msg );
+            break;
+        }
         default:
         {
             // unknown message type
@@ -433,25 +588,140 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
         return;
     }
 
-    Job * job = JobQueue::Get().GetDistributableJobToProcess( true );
+    // Hold the lock from dispatch until the job is sent so the job (whose
+    // data is sent directly, without copying) can't be returned to the
+    // queue by a disconnect in the meantime
+    MutexHolder mh( ss->m_Mutex );
+
+    MemoryStream stream;
+    uint64_t toolId = 0;
+    int16_t resultCompressionLevel = 0;
+    const Job * job = PrepareJobForServer( ss, stream, toolId, resultCompressionLevel );
     if ( job == nullptr )
     {
         PROFILE_SECTION( "NoJob" );
         // tell the client we don't have anything right now
         // (we completed or gave away the job already)
-        MutexHolder mh( ss->m_Mutex );
         const Protocol::MsgNoJobAvailable msg;
         SendMessageInternal( connection, msg );
         return;
     }
 
     // send the job to the client
-    MemoryStream stream;
-    job->Serialize( stream );
+    {
+        PROFILE_SECTION( "SendJob" );
+        Compressor converted;
+        size_t jobDataSize = job->GetDataSize();
+        const void * jobData = GetDataForServer( ss, job->GetData(), jobDataSize, converted );
+        const TCPConnectionPool::SendBuffer buffers[ 2 ] =
+        {
+            { (uint32_t)stream.GetSize(), stream.GetData() },
+            { (uint32_t)jobDataSize, jobData }
+        };
+        const Protocol::MsgJob msg( toolId, resultCompressionLevel );
+        SendMessageInternal( connection, msg, buffers, 2 );
+    }
+}
+
+// Process( MsgRequestJobs )
+//------------------------------------------------------------------------------
+void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequestJobs * msg )
+{
+    PROFILE_SECTION( "MsgRequestJobs" );
+
+    ServerState * ss = (ServerState *)connection->GetUserData();
+    ASSERT( ss );
 
+    // Hold the lock from dispatch until the jobs are sent (see MsgRequestJob)
     MutexHolder mh( ss->m_Mutex );
 
+    // Gather as many jobs as requested (and available) into one payload:
+    // toolId, resultCompressionLevel, size, job header, job data
+    // Only the headers are serialized. The job data is sent directly from each job
+    // (unless converted for the worker, in which case it follows the header).
+    const uint32_t numJobsRequested = msg->GetNumJobs();
+    const uint32_t maxJobs = Math::Min( numJobsRequested, (uint32_t)Protocol::PROTOCOL_MAX_JOBS_PER_BATCH );
+    MemoryStream stream;
+    StackArray< const Job *, Protocol::PROTOCOL_MAX_JOBS_PER_BATCH > jobs;
+    StackArray< uint32_t, Protocol::PROTOCOL_MAX_JOBS_PER_BATCH > headerEnds;
+    StackArray< uint32_t, Protocol::PROTOCOL_MAX_JOBS_PER_BATCH > jobDataSizes; // 0 if serialized with the header
+    if ( ss->m_Denylisted == false ) // no jobs for deny listed workers
+    {
+        MemoryStream jobHeader;
+        while ( jobs.GetSize() < maxJobs )
+        {
+            jobHeader.Reset();
+            uint64_t toolId = 0;
+            int16_t resultCompressionLevel = 0;
+            const Job * job = PrepareJobForServer( ss, jobHeader, toolId, resultCompressionLevel );
+            if ( job == nullptr )
+            {
+                break; // No more jobs available
+            }
+            Compressor converted;
+            size_t jobDataSize = job->GetDataSize();
+            const void * jobData = GetDataForServer( ss, job->GetData(), jobDataSize, converted );
+            stream.Write( toolId );
+            stream.Write( resultCompressionLevel );
+            stream.Write( (uint32_t)( jobHeader.GetSize() + jobDataSize ) );
+            stream.WriteBuffer( jobHeader.GetData(), jobHeader.GetSize() );
+            if ( jobData != job->GetData() )
+            {
+                stream.WriteBuffer( jobData, jobDataSize );
+                jobDataSize = 0;
+            }
+            jobs.Append( job );
+            headerEnds.Append( (uint32_t)stream.GetSize() );
+            jobDataSizes.Append( (uint32_t)jobDataSize );
+        }
+    }
+
+    // Reply even if we have no jobs, so the server can release the requests
+    {
+        PROFILE_SECTION( "SendJobs" );
+        const uint32_t numJobs = (uint32_t)jobs.GetSize();
+        const Protocol::MsgJobs reply( numJobsRequested, numJobs );
+        if ( numJobs > 0 )
+        {
+            // Interleave headers and job data
+            StackArray< TCPConnectionPool::SendBuffer, Protocol::PROTOCOL_MAX_JOBS_PER_BATCH * 2 > buffers;
+            uint32_t headerStart = 0;
+            for ( size_t i = 0; i < jobs.GetSize(); ++i )
+            {
+                const char * headers = static_cast< const char * >( stream.GetData() );
+                buffers.Append( TCPConnectionPool::SendBuffer{ headerEnds[ i ] - headerStart, headers + headerStart } );
+                if ( jobDataSizes[ i ] > 0 )
+                {
+                    buffers.Append( TCPConnectionPool::SendBuffer{ jobDataSizes[ i ], jobs[ i ]->GetData() } );
+                }
+                headerStart = headerEnds[ i ];
+            }
+            SendMessageInternal( connection, reply, buffers.Begin(), (uint32_t)buffers.GetSize() );
+        }
+        else
+        {
+            SendMessageInternal( connection, reply );
+        }
+    }
+}
+
+// PrepareJobForServer
+//------------------------------------------------------------------------------
+const Job * Client::PrepareJobForServer( ServerState * ss, MemoryStream & outJobHeader, uint64_t & outToolId, int16_t & outResultCompressionLevel )
+{
+    // NOTE: Caller must hold ss->m_Mutex until the returned job is sent
+
+    Job * job = JobQueue::Get().GetDistributableJobToProcess( true );
+    if ( job == nullptr )
+    {
+        return nullptr;
+    }
+
+    // serialize the job header for the client
+    job->SerializeHeader( outJobHeader );
+
     ss->m_Jobs.Append( job ); // Track in-flight job
+    RecordJobsInFlight( ss );
 
     // Reset the Available Jobs count for this worker. This ensures that we send
     // another status update message to communicate new jobs becoming available.
@@ -462,8 +732,8 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
     // if tool is explicity specified, get the id of the tool manifest
     const Node * n = job->GetNode()->CastTo< ObjectNode >()->GetCompiler();
     const ToolManifest & manifest = n->CastTo< CompilerNode >()->GetManifest();
-    const uint64_t toolId = manifest.GetToolId();
-    ASSERT( toolId );
+    outToolId = manifest.GetToolId();
+    ASSERT( outToolId );
 
     // output to signify remote start
     if ( FBuild::Get().GetOptions().m_ShowCommandSummary )
@@ -490,11 +760,40 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
     // Take note of the results compression level so we know to expect
     // compressed results
     job->SetResultCompressionLevel( resultCompressionLevel );
+    outResultCompressionLevel = resultCompressionLevel;
+    return job;
+}
 
+// GetDataForServer
+//  - Workers prior to PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES can't
+//    decompress data using a dictionary or chunks, so it is converted for them
+//------------------------------------------------------------------------------
+/*static*/ const void * Client::GetDataForServer( const ServerState * ss, const void * data, size_t & inOutDataSize, Compressor & converted )
+{
+    // NOTE: Caller must hold ss->m_Mutex
+    if ( ( ss->m_ProtocolVersionMinor >= Protocol::PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES ) ||
+         ( Compressor::IsValidData( data, inOutDataSize ) == false ) ||
+         Compressor::IsBasicFormat( data, inOutDataSize ) ||
+         ( converted.ConvertToBasicFormat( data ) == false ) )
     {
-        PROFILE_SECTION( "SendJob" );
-        const Protocol::MsgJob msg( toolId, resultCompressionLevel );
-        SendMessageInternal( connection, msg, stream );
+        return data; // Send as is
+    }
+    inOutDataSize = converted.GetResultSize();
+    return converted.GetResult();
+}
+
+// RecordJobsInFlight
+//------------------------------------------------------------------------------
+void Client::RecordJobsInFlight( const ServerState * ss ) const
+{
+    // NOTE: Caller must hold ss->m_Mutex
+    if ( BuildProfiler::IsValid() )
+    {
+        const uint32_t workerId = static_cast<uint32_t>( ss - m_ServerList.Begin() );
+        BuildProfiler::Get().RecordRemoteSlots( workerId,
+                                                ss->m_RemoteName,
+                                                Timer::GetNow(),
+                                                (uint32_t)ss->m_Jobs.GetSize() );
     }
 }
 
@@ -516,6 +815,34 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobR
     ProcessJobResultCommon( connection, compressed, payload, payloadSize );
 }
 
+// Process( MsgJobResults )
+//------------------------------------------------------------------------------
+void Client::Process( const ConnectionInfo * connection, const Protocol::MsgJobResults * msg, const void * payload, size_t payloadSize )
+{
+    PROFILE_SECTION( "MsgJobResults" );
+
+    // Each result is: isCompressed, size, result data
+    ConstMemoryStream ms( payload, payloadSize );
+    const uint32_t numResults = msg->GetNumResults();
+    for ( uint32_t i = 0; i < numResults; ++i )
+    {
+        bool compressed = false;
+        uint32_t resultSize = 0;
+        if ( ( ms.Read( compressed ) == false ) ||
+             ( ms.Read( resultSize ) == false ) ||
+             ( resultSize > ( payloadSize - ms.Tell() ) ) )
+        {
+            // Results processed so far are valid, but the rest can't be trusted
+            ASSERT( false ); // this indicates a protocol bug
+            Disconnect( connection );
+            return;
+        }
+        const void * result = ( (const char *)payload + ms.Tell() );
+        ProcessJobResultCommon( connection, compressed, result, resultSize );
+        ms.Seek( ms.Tell() + resultSize );
+    }
+}
+
 // ProcessJobResultCommon
 //------------------------------------------------------------------------------
 void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isCompressed, const void * payload, size_t payloadSize )
@@ -560,6 +887,7 @@ void Client::ProcessJobResultCommon( const ConnectionInfo * connection, bool isC
     {
         MutexHolder mh( ss->m_Mutex );
         VERIFY( ss->m_Jobs.FindDerefAndErase( jobId ) );
+        RecordJobsInFlight( ss );
     }
 
     // Has the job been cancelled in the interim?
@@ -884,14 +1212,44 @@ void Client::Process( const ConnectionInfo * connection, const Protocol::MsgRequ
         return;
     }
 
+    MutexHolder mh( static_cast<ServerState *>(connection->GetUserData())->m_Mutex );
+    Compressor converted;
+    data = GetDataForServer( static_cast<ServerState *>(connection->GetUserData()), data, dataSize, converted );
     ConstMemoryStream ms( data, dataSize );
 
     // Send file to worker
     const Protocol::MsgFile resultMsg( toolId, fileId );
-    MutexHolder mh( static_cast<ServerState *>(connection->GetUserData())->m_Mutex );
     SendMessageInternal( connection, resultMsg, ms );
 }
 
+// Process( MsgServerInfo )
+//------------------------------------------------------------------------------
+void Client::Process( const ConnectionInfo * connection, const Protocol::MsgServerInfo * msg )
+{
+    ServerState * ss = (ServerState *)connection->GetUserData();
+    ASSERT( ss );
+
+    MutexHolder mh( ss->m_Mutex );
+    ss->m_ProtocolVersionMinor = msg->GetProtocolVersionMinor();
+
+    // send dictionaries before any jobs which might need them
+    // (this message always precedes job requests)
+    if ( ss->m_ProtocolVersionMinor >= Protocol::PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES )
+    {
+        for ( uint32_t type = 0; type < CompressionDictionary::NUM_TYPES; ++type )
+        {
+            const CompressionDictionary * dictionary = FBuild::Get().GetCompressionDictionary( (CompressionDictionary::Type)type );
+            if ( dictionary )
+            {
+                MemoryStream ms;
+                dictionary->Write( ms );
+                const Protocol::MsgCompressionDictionary dictionaryMsg;
+                SendMessageInternal( connection, dictionaryMsg, ms );
+            }
+        }
+    }
+}
+
 // FindManifest
 //------------------------------------------------------------------------------
 const ToolManifest * Client::FindManifest( const ConnectionInfo * connection, uint64_t toolId ) const
@@ -934,11 +1292,24 @@ bool Client::WriteFileToDisk( const AString & fileName, const MultiBuffer & mult
 Client::ServerState::ServerState()
     : m_Connection( nullptr )
     , m_CurrentMessage( nullptr )
+    , m_ReconnectDelay( 0.0f )
     , m_NumJobsAvailable( 0 )
+    , m_ProtocolVersionMinor( 0 )
     , m_Jobs( 16, true )
     , m_Denylisted( false )
+    , m_DisconnectedBeforeConnected( false )
 {
     m_DelayTimer.Start( 999.0f );
 }
 
+// ServerState::OnConnectionFailed
+//------------------------------------------------------------------------------
+void Client::ServerState::OnConnectionFailed()
+{
+    // back off exponentially from unreachable workers
+    m_ReconnectDelay = ( m_ReconnectDelay > 0.0f ) ? Math::Min( m_ReconnectDelay * 2.0f, CONNECTION_REATTEMPT_DELAY_MAX )
+                                                  : CONNECTION_REATTEMPT_DELAY_MIN;
+    m_DelayTimer.Start(); // reset connection attempt delay
+}
+
 //------------------------------------------------------------------------------
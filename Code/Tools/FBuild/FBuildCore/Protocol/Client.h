@@ -13,6 +13,7 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class Compressor;
 class ConstMemoryStream;
 class Job;
 class MemoryStream;
@@ -22,13 +23,28 @@ namespace Protocol
     class IMessage;
     class MsgJobResult;
     class MsgJobResultCompressed;
+    class MsgJobResults;
     class MsgRequestJob;
+    class MsgRequestJobs;
     class MsgRequestManifest;
     class MsgRequestFile;
+    class MsgServerInfo;
     class MsgServerStatus;
 }
 class ToolManifest;
 
+// WorkerConnectionStats
+//------------------------------------------------------------------------------
+class WorkerConnectionStats
+{
+public:
+    uint32_t    m_NumWorkers                = 0;    // Workers in the pool
+    uint32_t    m_NumConnected              = 0;    // Most workers connected at once
+    uint32_t    m_NumFailedAttempts         = 0;
+    float       m_TimeToFirstConnection     = 0.0f; // Seconds from start of build
+    float       m_TimeToAllConnections      = 0.0f; // Seconds until m_NumConnected were connected
+};
+
 // Client
 //------------------------------------------------------------------------------
 class Client : public TCPConnectionPool
@@ -40,15 +56,20 @@ public:
             bool detailedLogging );
     virtual ~Client() override;
 
+    void GetConnectionStats( WorkerConnectionStats & outStats );
+
 private:
     virtual void OnDisconnected( const ConnectionInfo * connection ) override;
     virtual void OnReceive( const ConnectionInfo * connection, void * data, uint32_t size, bool & keepMemory ) override;
 
     void Process( const ConnectionInfo * connection, const Protocol::MsgRequestJob * msg );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgRequestJobs * msg );
     void Process( const ConnectionInfo * connection, const Protocol::MsgJobResult *, const void * payload, size_t payloadSize );
     void Process( const ConnectionInfo * connection, const Protocol::MsgJobResultCompressed * msg, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgJobResults * msg, const void * payload, size_t payloadSize );
     void Process( const ConnectionInfo * connection, const Protocol::MsgRequestManifest * msg );
     void Process( const ConnectionInfo * connection, const Protocol::MsgRequestFile * msg );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgServerInfo * msg );
 
     void ProcessJobResultCommon( const ConnectionInfo * connection, bool isCompressed, const void * payload, size_t payloadSize );
 
@@ -59,12 +80,14 @@ private:
     void            ThreadFunc();
 
     void            LookForWorkers();
+    void            OnWorkerConnected( size_t index, const ConnectionInfo * connection );
     void            CommunicateJobAvailability();
 
     // More verbose name to avoid conflict with windows.h SendMessage
     void            SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg );
     void            SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg, const MemoryStream & memoryStream );
     void            SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg, const ConstMemoryStream & memoryStream );
+    void            SendMessageInternal( const ConnectionInfo * connection, const Protocol::IMessage & msg, const SendBuffer * payloadBuffers, uint32_t numPayloadBuffers );
 
     Array< AString >    m_WorkerList;   // workers to connect to
     Atomic<bool>        m_ShouldExit;   // signal from main thread
@@ -73,26 +96,38 @@ private:
 
     // state
     Timer               m_StatusUpdateTimer;
+    Timer               m_StartTimer;
 
     struct ServerState
     {
         explicit ServerState();
 
+        void                    OnConnectionFailed();
+
         const ConnectionInfo *  m_Connection;
         AString                 m_RemoteName;
 
         Mutex                   m_Mutex;
         const Protocol::IMessage * m_CurrentMessage;
         Timer                   m_DelayTimer;
+        float                   m_ReconnectDelay;       // seconds to wait since last failed attempt
         uint32_t                m_NumJobsAvailable;     // num jobs we've told this server we have available
+        uint8_t                 m_ProtocolVersionMinor; // from MsgServerInfo (0 for workers which don't send it)
         Array< Job * >          m_Jobs;                 // jobs we've sent to this server
 
         bool                    m_Denylisted;
+        bool                    m_DisconnectedBeforeConnected; // connection dropped before it was published
     };
+
+    const Job *             PrepareJobForServer( ServerState * ss, MemoryStream & outJobHeader, uint64_t & outToolId, int16_t & outResultCompressionLevel );
+    void                    RecordJobsInFlight( const ServerState * ss ) const;
+    static const void *     GetDataForServer( const ServerState * ss, const void * data, size_t & inOutDataSize, Compressor & converted );
+
     Mutex                   m_ServerListMutex;
     Array< ServerState >    m_ServerList;
     uint32_t                m_WorkerConnectionLimit;
     uint16_t                m_Port;
+    WorkerConnectionStats   m_ConnectionStats;      // protected by m_ServerListMutex
 };
 
 //------------------------------------------------------------------------------
@@ -36,6 +36,11 @@
             "RequestFile",
             "File",
             "JobResultCompressed",
+            "CompressionDictionary",
+            "RequestJobs",
+            "Jobs",
+            "JobResults",
+            "ServerInfo",
         };
         static_assert( ( sizeof( msgNames ) / sizeof(const char *) ) == Protocol::NUM_MESSAGES, "msgNames item count doesn't match NUM_MESSAGES" );
 
@@ -87,6 +92,17 @@ bool Protocol::IMessage::Send( const ConnectionInfo * connection, const ConstMem
     return pool.Send( connection, this, m_MsgSize, payload.GetData(), payload.GetSize() );
 }
 
+// IMessage::Send (with payload gathered from several buffers)
+//------------------------------------------------------------------------------
+bool Protocol::IMessage::Send( const ConnectionInfo * connection, const TCPConnectionPool::SendBuffer * payloadBuffers, uint32_t numPayloadBuffers ) const
+{
+    ASSERT( connection );
+    ASSERT( m_HasPayload == true ); // must NOT use Send with payload
+
+    TCPConnectionPool & pool = connection->GetTCPConnectionPool();
+    return pool.Send( connection, this, m_MsgSize, payloadBuffers, numPayloadBuffers );
+}
+
 // IMessage::Broadcast
 //------------------------------------------------------------------------------
 bool Protocol::IMessage::Broadcast( TCPConnectionPool * pool ) const
@@ -148,6 +164,26 @@ Protocol::MsgJob::MsgJob( uint64_t toolId, int16_t resultCompressionLevel )
     ASSERT( toolId );
 }
 
+// MsgRequestJobs
+//------------------------------------------------------------------------------
+Protocol::MsgRequestJobs::MsgRequestJobs( uint32_t numJobs )
+    : Protocol::IMessage( Protocol::MSG_REQUEST_JOBS, sizeof( MsgRequestJobs ), false )
+    , m_NumJobs( numJobs )
+{
+    ASSERT( numJobs > 0 );
+    ASSERT( numJobs <= PROTOCOL_MAX_JOBS_PER_BATCH );
+}
+
+// MsgJobs
+//------------------------------------------------------------------------------
+Protocol::MsgJobs::MsgJobs( uint32_t numJobsRequested, uint32_t numJobs )
+    : Protocol::IMessage( Protocol::MSG_JOBS, sizeof( MsgJobs ), ( numJobs > 0 ) ) // No payload if no jobs
+    , m_NumJobsRequested( numJobsRequested )
+    , m_NumJobs( numJobs )
+{
+    ASSERT( numJobs <= numJobsRequested );
+}
+
 // MsgJobResult
 //------------------------------------------------------------------------------
 Protocol::MsgJobResult::MsgJobResult()
@@ -162,6 +198,15 @@ Protocol::MsgJobResultCompressed::MsgJobResultCompressed()
 {
 }
 
+// MsgJobResults
+//------------------------------------------------------------------------------
+Protocol::MsgJobResults::MsgJobResults( uint32_t numResults )
+    : Protocol::IMessage( Protocol::MSG_JOB_RESULTS, sizeof( MsgJobResults ), true )
+    , m_NumResults( numResults )
+{
+    ASSERT( numResults > 0 );
+}
+
 // MsgRequestManifest
 //------------------------------------------------------------------------------
 Protocol::MsgRequestManifest::MsgRequestManifest( uint64_t toolId )
@@ -198,4 +243,20 @@ Protocol::MsgFile::MsgFile( uint64_t toolId, uint32_t fileId )
 {
 }
 
+// MsgCompressionDictionary
+//------------------------------------------------------------------------------
+Protocol::MsgCompressionDictionary::MsgCompressionDictionary()
+    : Protocol::IMessage( Protocol::MSG_COMPRESSION_DICTIONARY, sizeof( MsgCompressionDictionary ), true )
+{
+}
+
+// MsgServerInfo
+//------------------------------------------------------------------------------
+Protocol::MsgServerInfo::MsgServerInfo()
+    : Protocol::IMessage( Protocol::MSG_SERVER_INFO, sizeof( MsgServerInfo ), false )
+    , m_ProtocolVersionMinor( PROTOCOL_VERSION_MINOR )
+{
+    memset( m_Padding2, 0, sizeof( m_Padding2 ) );
+}
+
 //------------------------------------------------------------------------------
@@ -6,13 +6,12 @@
 //------------------------------------------------------------------------------
 #include "Core/Env/MSVCStaticAnalysis.h"
 #include "Core/Env/Types.h"
+#include "Core/Network/TCPConnectionPool.h"
 
 // Forward Declarations
 //------------------------------------------------------------------------------
-class ConnectionInfo;
 class ConstMemoryStream;
 class MemoryStream;
-class TCPConnectionPool;
 
 // Defines
 //------------------------------------------------------------------------------
@@ -32,7 +31,14 @@ namespace Protocol
 
     // Protocol Version
     enum : uint32_t { PROTOCOL_VERSION_MAJOR = 22 };    // Changes here make workers incompatible
-    enum : uint8_t  { PROTOCOL_VERSION_MINOR = 2 };     // Changes must be forwards and backwards compatible
+    enum : uint8_t  { PROTOCOL_VERSION_MINOR = 4 };     // Changes must be forwards and backwards compatible
+
+    // Minor versions which introduced optional features
+    enum : uint8_t  { PROTOCOL_VERSION_MINOR_BATCHED_JOBS = 3 }; // MSG_REQUEST_JOBS, MSG_JOBS, MSG_JOB_RESULTS
+    enum : uint8_t  { PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES = 4 }; // MSG_SERVER_INFO, MSG_COMPRESSION_DICTIONARY, dictionary and chunked compression
+
+    // Limit on the number of jobs requested or returned in a single batch
+    enum : uint32_t { PROTOCOL_MAX_JOBS_PER_BATCH = 64 };
 
     enum { PROTOCOL_TEST_PORT = PROTOCOL_PORT + 1 }; // Different port for use by tests
 
@@ -57,6 +63,14 @@ namespace Protocol
 
         MSG_JOB_RESULT_COMPRESSED   = 11, // Server -> Client : Return completed job (compressed)
 
+        MSG_COMPRESSION_DICTIONARY  = 12, // Server <- Client : Dictionary used by job data and results
+
+        MSG_REQUEST_JOBS        = 13, // Server -> Client : Ask for several jobs to do
+        MSG_JOBS                = 14, // Server <- Client : Respond with zero or more jobs to do
+        MSG_JOB_RESULTS         = 15, // Server -> Client : Return several completed jobs
+
+        MSG_SERVER_INFO         = 16, // Server -> Client : Capabilities of the worker
+
         NUM_MESSAGES            // leave last
     };
 };
@@ -75,6 +89,7 @@ namespace Protocol
         bool Send( const ConnectionInfo * connection ) const;
         bool Send( const ConnectionInfo * connection, const MemoryStream & payload ) const;
         bool Send( const ConnectionInfo * connection, const ConstMemoryStream & payload ) const;
+        bool Send( const ConnectionInfo * connection, const TCPConnectionPool::SendBuffer * payloadBuffers, uint32_t numPayloadBuffers ) const;
         bool Broadcast( TCPConnectionPool * pool ) const;
 
         inline MessageType  GetType() const { return m_MsgType; }
@@ -161,6 +176,35 @@ namespace Protocol
     };
     static_assert( sizeof( MsgJob ) == sizeof( IMessage ) + 4/*alignment*/ + 8, "MsgJob message has incorrect size" );
 
+    // MsgRequestJobs
+    //------------------------------------------------------------------------------
+    class MsgRequestJobs : public IMessage
+    {
+    public:
+        explicit MsgRequestJobs( uint32_t numJobs );
+
+        inline uint32_t GetNumJobs() const { return m_NumJobs; }
+    private:
+        uint32_t    m_NumJobs;
+    };
+    static_assert( sizeof( MsgRequestJobs ) == sizeof( IMessage ) + 4, "MsgRequestJobs message has incorrect size" );
+
+    // MsgJobs
+    //  - payload contains, for each job: toolId, resultCompressionLevel, size, job data
+    //------------------------------------------------------------------------------
+    class MsgJobs : public IMessage
+    {
+    public:
+        MsgJobs( uint32_t numJobsRequested, uint32_t numJobs );
+
+        inline uint32_t GetNumJobsRequested() const { return m_NumJobsRequested; }
+        inline uint32_t GetNumJobs() const { return m_NumJobs; }
+    private:
+        uint32_t    m_NumJobsRequested; // Echo of MsgRequestJobs count
+        uint32_t    m_NumJobs;          // Jobs in payload (<= m_NumJobsRequested)
+    };
+    static_assert( sizeof( MsgJobs ) == sizeof( IMessage ) + 8, "MsgJobs message has incorrect size" );
+
     // MsgJobResult
     //------------------------------------------------------------------------------
     class MsgJobResult : public IMessage
@@ -179,6 +223,20 @@ namespace Protocol
     };
     static_assert( sizeof( MsgJobResultCompressed ) == sizeof( IMessage ), "MsgJobResultCompressed message has incorrect size" );
 
+    // MsgJobResults
+    //  - payload contains, for each result: isCompressed, size, result data
+    //------------------------------------------------------------------------------
+    class MsgJobResults : public IMessage
+    {
+    public:
+        explicit MsgJobResults( uint32_t numResults );
+
+        inline uint32_t GetNumResults() const { return m_NumResults; }
+    private:
+        uint32_t    m_NumResults;
+    };
+    static_assert( sizeof( MsgJobResults ) == sizeof( IMessage ) + 4, "MsgJobResults message has incorrect size" );
+
     // MsgRequestManifest
     //------------------------------------------------------------------------------
     class MsgRequestManifest : public IMessage
@@ -237,6 +295,30 @@ namespace Protocol
     };
     static_assert( sizeof( MsgFile ) == sizeof( IMessage ) + 12, "MsgFile message has incorrect size" );
 
+    // MsgCompressionDictionary
+    //------------------------------------------------------------------------------
+    class MsgCompressionDictionary : public IMessage
+    {
+    public:
+        MsgCompressionDictionary();
+    };
+    static_assert( sizeof( MsgCompressionDictionary ) == sizeof( IMessage ), "MsgCompressionDictionary message has incorrect size" );
+
+    // MsgServerInfo
+    //  - only sent to clients supporting PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES
+    //------------------------------------------------------------------------------
+    class MsgServerInfo : public IMessage
+    {
+    public:
+        MsgServerInfo();
+
+        uint8_t         GetProtocolVersionMinor() const { return m_ProtocolVersionMinor; }
+    private:
+        uint8_t         m_ProtocolVersionMinor;
+        uint8_t         m_Padding2[ 3 ];
+    };
+    static_assert( sizeof( MsgServerInfo ) == sizeof( IMessage ) + 4, "MsgServerInfo message has incorrect size" );
+
     // MsgServerStatus
     //------------------------------------------------------------------------------
     class MsgServerStatus : public IMessage
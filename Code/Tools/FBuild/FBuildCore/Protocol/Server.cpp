@@ -7,6 +7,8 @@
 #include "Protocol.h"
 
 #include "Tools/FBuild/FBuildCore/FLog.h"
+#include "Tools/FBuild/FBuildCore/Helpers/CompressionDictionary.h"
+#include "Tools/FBuild/FBuildCore/Helpers/Compressor.h"
 #include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
@@ -16,9 +18,13 @@
 #include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/MemoryStream.h"
 #include "Core/Process/Atomic.h"
+#include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
 
+// system
+#include <memory.h> // for memcmp, memcpy, memset
+
 // Defines
 //------------------------------------------------------------------------------
 #if defined( __OSX__ ) || defined( __LINUX__ )
@@ -26,11 +32,23 @@
     #define SERVER_TOOLCHAIN_TIMESTAMP_REFRESH_INTERVAL_SECS (60.0f * 60.0f * 4.0f)
 #endif
 
+// Jobs requested beyond the free slots, so the next jobs are already queued when
+// a slot frees up (hiding the request round trip and job transfer time)
+#define SERVER_JOB_PIPELINE_DEPTH( numCPUs ) ( 1 + ( ( numCPUs ) / 4 ) )
+
+// Static Data
+//------------------------------------------------------------------------------
+#if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+    /*static*/ Atomic<uint32_t> Server::sFakeResultBatchingDelayMS( 0 );
+#endif
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 Server::Server( uint32_t numThreadsInJobQueue )
     : m_ShouldExit( false )
     , m_ClientList( 32, true )
+    , m_Dictionaries( 0, true )
+    , m_ReleasedDictionaries( 0, true )
 {
     m_JobQueueRemote = FNEW( JobQueueRemote( numThreadsInJobQueue ? numThreadsInJobQueue : Env::GetNumProcessors() ) );
 
@@ -53,6 +71,16 @@ Server::~Server()
     {
         FDELETE tool;
     }
+
+    for ( const DictionaryRef & ref : m_Dictionaries )
+    {
+        CompressionDictionary::Unregister( ref.m_Dictionary );
+        FDELETE ref.m_Dictionary;
+    }
+    for ( CompressionDictionary * dictionary : m_ReleasedDictionaries )
+    {
+        FDELETE dictionary;
+    }
 }
 
 // GetHostForJob
@@ -96,6 +124,16 @@ bool Server::IsSynchingTool( AString & statusStr ) const
     return false; // no toolchain is currently synching
 }
 
+// GetBatchStats
+//------------------------------------------------------------------------------
+void Server::GetBatchStats( BatchStats & outRequestJobs, BatchStats & outJobs, BatchStats & outJobResults ) const
+{
+    MutexHolder mh( m_BatchStatsMutex );
+    outRequestJobs = m_RequestJobsStats;
+    outJobs = m_JobsStats;
+    outJobResults = m_JobResultsStats;
+}
+
 // OnConnected
 //------------------------------------------------------------------------------
 /*virtual*/ void Server::OnConnected( const ConnectionInfo * connection )
@@ -120,6 +158,9 @@ bool Server::IsSynchingTool( AString & statusStr ) const
     JobQueueRemote & jqr = JobQueueRemote::Get();
     jqr.CancelJobsWithUserData( cs );
 
+    // Free dictionaries no other client is using
+    ReleaseDictionaries( cs );
+
     // check if any tool chain was being sync'd from this Client
     Array< ToolManifest * > cancelledManifests( 0, true );
     {
@@ -236,6 +277,12 @@ bool Server::IsSynchingTool( AString & statusStr ) const
             Process( connection, msg, payload, payloadSize );
             break;
         }
+        case Protocol::MSG_JOBS:
+        {
+            const Protocol::MsgJobs * msg = static_cast< const Protocol::MsgJobs * >( imsg );
+            Process( connection, msg, payload, payloadSize );
+            break;
+        }
         case Protocol::MSG_MANIFEST:
         {
             const Protocol::MsgManifest * msg = static_cast< const Protocol::MsgManifest * >( imsg );
@@ -248,6 +295,12 @@ bool Server::IsSynchingTool( AString & statusStr ) const
             Process( connection, msg, payload, payloadSize );
             break;
         }
+        case Protocol::MSG_COMPRESSION_DICTIONARY:
+        {
+            const Protocol::MsgCompressionDictionary * msg = static_cast< const Protocol::MsgCompressionDictionary * >( imsg );
+            Process( connection, msg, payload, payloadSize );
+            break;
+        }
         default:
         {
             // unknown message type
@@ -293,6 +346,14 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgConn
     cs->m_NumJobsAvailable.Store( msg->GetNumJobsAvailable() );
     cs->m_ProtocolVersionMinor = msg->GetProtocolVersionMinor();
     cs->m_HostName = msg->GetHostName();
+
+    // Tell clients which can understand it what we support, before any
+    // jobs are requested (which requires cs->m_Mutex)
+    if ( cs->m_ProtocolVersionMinor >= Protocol::PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES )
+    {
+        const Protocol::MsgServerInfo infoMsg;
+        infoMsg.Send( connection );
+    }
 }
 
 // Process( MsgStatus )
@@ -322,91 +383,162 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgNoJo
 void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJob * msg, const void * payload, size_t payloadSize )
 {
     ClientState * cs = (ClientState *)connection->GetUserData();
+
+    ASSERT( cs->m_NumJobsRequested.Load() > 0 );
+    cs->m_NumJobsRequested.Decrement();
+
+    MutexHolder mh( cs->m_Mutex );
+    ReceiveJob( connection, cs, msg->GetToolId(), msg->GetResultCompressionLevel(), payload, payloadSize );
+}
+
+// Process( MsgJobs )
+//------------------------------------------------------------------------------
+void Server::Process( const ConnectionInfo * connection, const Protocol::MsgJobs * msg, const void * payload, size_t payloadSize )
+{
+    ClientState * cs = (ClientState *)connection->GetUserData();
+
+    // A client can't satisfy (or release) more requests than were made
+    const uint32_t numJobs = msg->GetNumJobs();
+    const uint32_t numJobsRequested = msg->GetNumJobsRequested();
+    if ( ( numJobs > numJobsRequested ) ||
+         ( numJobsRequested > cs->m_NumJobsRequested.Load() ) )
     {
-        ASSERT( cs->m_NumJobsRequested.Load() > 0 );
-        cs->m_NumJobsRequested.Decrement();
-        cs->m_NumJobsActive.Increment();
+        ASSERT( false ); // this indicates a protocol bug
+        Disconnect( connection );
+        return;
+    }
+    RecordBatch( m_JobsStats, numJobs );
+
+    if ( numJobs > 0 )
+    {
+        // Validate the framing of all jobs before processing any of them
+        ConstMemoryStream ms( payload, payloadSize );
+        for ( uint32_t i = 0; i < numJobs; ++i )
+        {
+            uint64_t toolId = 0;
+            int16_t resultCompressionLevel = 0;
+            uint32_t jobDataSize = 0;
+            if ( ( ms.Read( toolId ) == false ) ||
+                 ( ms.Read( resultCompressionLevel ) == false ) ||
+                 ( ms.Read( jobDataSize ) == false ) ||
+                 ( toolId == 0 ) ||
+                 ( jobDataSize > ( payloadSize - ms.Tell() ) ) )
+            {
+                ASSERT( false ); // this indicates a protocol bug
+                Disconnect( connection );
+                return;
+            }
+            ms.Seek( ms.Tell() + jobDataSize );
+        }
 
         MutexHolder mh( cs->m_Mutex );
 
-        // deserialize job
-        ConstMemoryStream ms( payload, payloadSize );
-    
-        Job * job = FNEW( Job( ms ) );
-        job->SetUserData( cs );
-        job->SetResultCompressionLevel( msg->GetResultCompressionLevel() );
-    
-        // Get ToolId
-        const uint64_t toolId = msg->GetToolId();
-        ASSERT( toolId );
+        ms.Seek( 0 );
+        for ( uint32_t i = 0; i < numJobs; ++i )
+        {
+            uint64_t toolId = 0;
+            int16_t resultCompressionLevel = 0;
+            uint32_t jobDataSize = 0;
+            VERIFY( ms.Read( toolId ) );
+            VERIFY( ms.Read( resultCompressionLevel ) );
+            VERIFY( ms.Read( jobDataSize ) );
+            const void * jobData = ( (const char *)payload + ms.Tell() );
+            ReceiveJob( connection, cs, toolId, resultCompressionLevel, jobData, jobDataSize );
+            ms.Seek( ms.Tell() + jobDataSize );
+        }
+    }
+
+    // Requests the client could not satisfy are released along with those it did
+    cs->m_NumJobsRequested.Sub( numJobsRequested );
+}
+
+// ReceiveJob
+//------------------------------------------------------------------------------
+void Server::ReceiveJob( const ConnectionInfo * connection,
+                         ClientState * cs,
+                         uint64_t toolId,
+                         int16_t resultCompressionLevel,
+                         const void * jobData,
+                         size_t jobDataSize )
+{
+    // NOTE: Caller must hold cs->m_Mutex
+    cs->m_NumJobsActive.Increment();
+
+    // deserialize job
+    ConstMemoryStream ms( jobData, jobDataSize );
+
+    Job * job = FNEW( Job( ms ) );
+    job->SetUserData( cs );
+    job->SetResultCompressionLevel( resultCompressionLevel );
+    job->SetResultCompressionDictionary( cs->m_ResultDictionary );
+
+    ASSERT( toolId );
 
+    {
+        // Find or create the manifest
+        MutexHolder manifestMH( m_ToolManifestsMutex );
 
+        ToolManifest ** found = m_Tools.FindDeref( toolId );
+        ToolManifest * manifest = found ? *found : nullptr;
+        if ( manifest )
         {
-            // Find or create the manifest
-            MutexHolder manifestMH( m_ToolManifestsMutex );
+            job->SetToolManifest( manifest );
 
-            ToolManifest ** found = m_Tools.FindDeref( toolId );
-            ToolManifest * manifest = found ? *found : nullptr;
-            if ( manifest )
+            // Is tool fully synchronized?
+            if ( manifest->IsSynchronized() )
             {
-                job->SetToolManifest( manifest );
-
-                // Is tool fully synchronized?
-                if ( manifest->IsSynchronized() )
-                {
-                    // we have all the files - we can do the job
-                    JobQueueRemote::Get().QueueJob( job );
-                    return;
-                }
+                // we have all the files - we can do the job
+                JobQueueRemote::Get().QueueJob( job );
+                return;
+            }
 
-                // If we have an associated connection, we're already synchronizing
-                // on that connection and don't need to do anything.
-                // That may be a connection to another client or to the same client
-                const bool isSynchronizing = ( manifest->GetUserData() != nullptr );
-                if ( isSynchronizing )
+            // If we have an associated connection, we're already synchronizing
+            // on that connection and don't need to do anything.
+            // That may be a connection to another client or to the same client
+            const bool isSynchronizing = ( manifest->GetUserData() != nullptr );
+            if ( isSynchronizing )
+            {
+                // We just need to wait for syncrhonization to complete
+            }
+            else
+            {
+                // Take ownership of toolchain
+                manifest->SetUserData( (void *)connection );                    
+                
+                const bool hasManifest = ( manifest->GetFiles().IsEmpty() == false );
+                if ( hasManifest )
                 {
-                    // We just need to wait for syncrhonization to complete
+                    // Missing some files - request any not already being sync'd
+                    RequestMissingFiles( connection, manifest );
                 }
                 else
                 {
-                    // Take ownership of toolchain
-                    manifest->SetUserData( (void *)connection );                    
-                    
-                    const bool hasManifest = ( manifest->GetFiles().IsEmpty() == false );
-                    if ( hasManifest )
-                    {
-                        // Missing some files - request any not already being sync'd
-                        RequestMissingFiles( connection, manifest );
-                    }
-                    else
-                    {
-                        // Manifest was not sync'd. This can happen if disconnection
-                        // occurs before the manifest was received.
-                   
-                        // request manifest
-                        const Protocol::MsgRequestManifest reqMsg( toolId );
-                        reqMsg.Send( connection );
-                    }
+                    // Manifest was not sync'd. This can happen if disconnection
+                    // occurs before the manifest was received.
+               
+                    // request manifest
+                    const Protocol::MsgRequestManifest reqMsg( toolId );
+                    reqMsg.Send( connection );
                 }
             }
-            else
-            {
-                // first time seeing this tool
-
-                // create manifest object
-                manifest = FNEW( ToolManifest( toolId ) );
-                manifest->SetUserData( (void *)connection ); // This connection owns synchronization
-                job->SetToolManifest( manifest );
-                m_Tools.Append( manifest );
+        }
+        else
+        {
+            // first time seeing this tool
 
-                // request manifest of tool chain
-                const Protocol::MsgRequestManifest reqMsg( toolId );
-                reqMsg.Send( connection );
-            }
+            // create manifest object
+            manifest = FNEW( ToolManifest( toolId ) );
+            manifest->SetUserData( (void *)connection ); // This connection owns synchronization
+            job->SetToolManifest( manifest );
+            m_Tools.Append( manifest );
 
-            // can't start job yet - put it on hold
-            cs->m_WaitingJobs.Append( job );
+            // request manifest of tool chain
+            const Protocol::MsgRequestManifest reqMsg( toolId );
+            reqMsg.Send( connection );
         }
+
+        // can't start job yet - put it on hold
+        cs->m_WaitingJobs.Append( job );
     }
 }
 
@@ -534,6 +666,128 @@ void Server::Process( const ConnectionInfo * connection, const Protocol::MsgFile
     CheckWaitingJobs( manifest );
 }
 
+// Process( MsgCompressionDictionary )
+//------------------------------------------------------------------------------
+void Server::Process( const ConnectionInfo * connection, const Protocol::MsgCompressionDictionary *, const void * payload, size_t payloadSize )
+{
+    ClientState * cs = (ClientState *)connection->GetUserData();
+
+    ConstMemoryStream ms( payload, payloadSize );
+    CompressionDictionary * received = CompressionDictionary::Read( ms );
+    if ( received == nullptr )
+    {
+        AStackString<> remoteAddr;
+        TCPConnectionPool::GetAddressAsString( connection->GetRemoteAddress(), remoteAddr );
+        FLOG_WARN( "Disconnecting '%s' (%s) due to corrupt MsgCompressionDictionary\n", remoteAddr.Get(), cs->m_HostName.Get() );
+        Disconnect( connection );
+        return;
+    }
+
+    // Clients using the same dictionary share it (ids are a hash of the full contents,
+    // and Register rejects different contents with the same id)
+    const CompressionDictionary * dictionary = nullptr;
+    {
+        MutexHolder mh( m_DictionariesMutex );
+        DictionaryRef * ref = nullptr;
+        for ( DictionaryRef & existing : m_Dictionaries )
+        {
+            if ( ( existing.m_Dictionary->GetId() == received->GetId() ) &&
+                 ( existing.m_Dictionary->GetSize() == received->GetSize() ) &&
+                 ( memcmp( existing.m_Dictionary->GetData(), received->GetData(), received->GetSize() ) == 0 ) )
+            {
+                ref = &existing;
+                break;
+            }
+        }
+        if ( ref )
+        {
+            FDELETE received;
+            dictionary = ref->m_Dictionary;
+        }
+        else if ( CompressionDictionary::Register( received ) )
+        {
+            m_Dictionaries.Append( DictionaryRef{ received, 0 } );
+            ref = &m_Dictionaries.Top();
+            dictionary = received;
+        }
+        else
+        {
+            // Client will send jobs we can't decompress
+            FDELETE received;
+            AStackString<> remoteAddr;
+            TCPConnectionPool::GetAddressAsString( connection->GetRemoteAddress(), remoteAddr );
+            FLOG_WARN( "Disconnecting '%s' (%s) due to unusable compression dictionary\n", remoteAddr.Get(), cs->m_HostName.Get() );
+            Disconnect( connection );
+            return;
+        }
+
+        MutexHolder mhCS( cs->m_Mutex );
+        if ( cs->m_Dictionaries.Find( dictionary ) == nullptr )
+        {
+            ref->m_RefCount++;
+            cs->m_Dictionaries.Append( dictionary );
+        }
+        if ( dictionary->GetType() == CompressionDictionary::OBJECTS )
+        {
+            cs->m_ResultDictionary = dictionary;
+        }
+    }
+}
+
+// RecordBatch
+//------------------------------------------------------------------------------
+void Server::RecordBatch( BatchStats & stats, uint32_t numJobs )
+{
+    MutexHolder mh( m_BatchStatsMutex );
+    stats.m_NumMessages++;
+    stats.m_NumJobs += numJobs;
+    stats.m_MaxJobsPerMessage = Math::Max( stats.m_MaxJobsPerMessage, numJobs );
+}
+
+// ReleaseDictionaries
+//------------------------------------------------------------------------------
+void Server::ReleaseDictionaries( ClientState * cs )
+{
+    MutexHolder mh( m_DictionariesMutex );
+    for ( const CompressionDictionary * dictionary : cs->m_Dictionaries )
+    {
+        for ( DictionaryRef & ref : m_Dictionaries )
+        {
+            if ( ref.m_Dictionary != dictionary )
+            {
+                continue;
+            }
+            ASSERT( ref.m_RefCount > 0 );
+            if ( --ref.m_RefCount == 0 )
+            {
+                // No new data can reference it, but cancelled jobs which are still
+                // in progress may still compress their results with it
+                CompressionDictionary::Unregister( ref.m_Dictionary );
+                m_ReleasedDictionaries.Append( ref.m_Dictionary );
+                m_Dictionaries.Erase( &ref );
+            }
+            break;
+        }
+    }
+    cs->m_Dictionaries.Clear();
+}
+
+// FreeReleasedDictionaries
+//------------------------------------------------------------------------------
+void Server::FreeReleasedDictionaries()
+{
+    MutexHolder mh( m_DictionariesMutex );
+    for ( size_t i = m_ReleasedDictionaries.GetSize(); i > 0; --i )
+    {
+        CompressionDictionary * dictionary = m_ReleasedDictionaries[ i - 1 ];
+        if ( JobQueueRemote::Get().IsUsingCompressionDictionary( dictionary ) == false )
+        {
+            FDELETE dictionary;
+            m_ReleasedDictionaries.EraseIndex( i - 1 );
+        }
+    }
+}
+
 // CheckWaitingJobs
 //------------------------------------------------------------------------------
 void Server::CheckWaitingJobs( const ToolManifest * manifest )
@@ -595,6 +849,8 @@ void Server::ThreadFunc()
     {
         FinalizeCompletedJobs();
 
+        FreeReleasedDictionaries();
+
         FindNeedyClients();
         
         TouchToolchains();
@@ -620,7 +876,7 @@ void Server::FindNeedyClients()
     {
         return;
     }
-    ++availableJobs; // over request to parallelize building/network transfers
+    availableJobs += SERVER_JOB_PIPELINE_DEPTH( availableJobs ); // over request to parallelize building/network transfers
 
 
     {
@@ -645,15 +901,22 @@ void Server::FindNeedyClients()
         // sort clients to find neediest first
         m_ClientList.SortDeref();
 
+        // Clients supporting batching are sent a single request for several jobs
+        // once the distribution of requests has been decided
+        StackArray< uint32_t, 32 > batchedRequests;
+        batchedRequests.SetSize( m_ClientList.GetSize() );
+        memset( batchedRequests.Begin(), 0, batchedRequests.GetSize() * sizeof( uint32_t ) );
+
         const Protocol::MsgRequestJob msg;
 
         while ( availableJobs > 0 )
         {
             bool anyJobsRequested = false;
 
-            for ( ClientState * cs : m_ClientList )
+            for ( size_t i = 0; i < m_ClientList.GetSize(); ++i )
             {
-                const uint32_t reservedJobs = cs->m_NumJobsRequested.Load();
+                ClientState * cs = m_ClientList[ i ];
+                const uint32_t reservedJobs = cs->m_NumJobsRequested.Load() + batchedRequests[ i ];
 
                 if ( reservedJobs >= cs->m_NumJobsAvailable.Load() )
                 {
@@ -661,6 +924,15 @@ void Server::FindNeedyClients()
                 }
 
                 // request job from this client
+                if ( cs->m_ProtocolVersionMinor >= Protocol::PROTOCOL_VERSION_MINOR_BATCHED_JOBS )
+                {
+                    if ( batchedRequests[ i ] >= Protocol::PROTOCOL_MAX_JOBS_PER_BATCH )
+                    {
+                        continue; // Batch is full
+                    }
+                    batchedRequests[ i ]++; // Sent below
+                }
+                else
                 {
                     // Acquire the lock but don't wait if unavailable
                     TryMutexHolder tryLock( cs->m_Mutex );
@@ -687,6 +959,28 @@ void Server::FindNeedyClients()
                 break;
             }
         }
+
+        // Send batched requests
+        for ( size_t i = 0; i < m_ClientList.GetSize(); ++i )
+        {
+            const uint32_t numJobs = batchedRequests[ i ];
+            if ( numJobs == 0 )
+            {
+                continue;
+            }
+
+            // Acquire the lock but don't wait if unavailable
+            ClientState * cs = m_ClientList[ i ];
+            TryMutexHolder tryLock( cs->m_Mutex );
+            if ( tryLock.IsLocked() == false )
+            {
+                continue; // Skip this worker for now
+            }
+            cs->m_NumJobsRequested.Add( numJobs ); // Must be before Send() to ensure consistent counts
+            const Protocol::MsgRequestJobs batchMsg( numJobs );
+            batchMsg.Send( cs->m_Connection );
+            RecordBatch( m_RequestJobsStats, numJobs );
+        }
     }
 }
 
@@ -696,9 +990,30 @@ void Server::FinalizeCompletedJobs()
 {
     PROFILE_FUNCTION;
 
+    // Gather all the jobs which have completed since we last checked so that
+    // results destined for the same client can be returned together
     JobQueueRemote & jcr = JobQueueRemote::Get();
+    StackArray< Job *, 32 > completedJobs;
     while ( Job * job = jcr.GetCompletedJob() )
     {
+        #if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+            // Give other jobs time to complete (see SetFakeResultBatchingDelay)
+            if ( completedJobs.IsEmpty() && ( sFakeResultBatchingDelayMS.Load() > 0 ) )
+            {
+                Thread::Sleep( sFakeResultBatchingDelayMS.Load() );
+            }
+        #endif
+        completedJobs.Append( job );
+    }
+
+    for ( size_t i = 0; i < completedJobs.GetSize(); ++i )
+    {
+        Job * job = completedJobs[ i ];
+        if ( job == nullptr )
+        {
+            continue; // Already returned as part of an earlier batch
+        }
+
         // get associated connection
         ClientState * cs = (ClientState *)job->GetUserData();
 
@@ -706,23 +1021,80 @@ void Server::FinalizeCompletedJobs()
             MutexHolder mh( m_ClientListMutex );
 
             const bool connectionStillActive = ( m_ClientList.Find( cs ) != nullptr );
-            if ( connectionStillActive )
+            if ( connectionStillActive == false )
             {
-                const Node::State result = job->GetNode()->GetState();
-                ASSERT( ( result == Node::UP_TO_DATE ) || ( result == Node::FAILED ) );
+                // we might get here without finding the connection
+                // (if the connection was lost before we completed)
+            }
+            else if ( cs->m_ProtocolVersionMinor >= Protocol::PROTOCOL_VERSION_MINOR_BATCHED_JOBS )
+            {
+                // Coalesce all completed results for this client:
+                // isCompressed, size, result header, result data
+                // Only the headers are serialized. The result data is sent
+                // directly from each job's buffer.
+                MemoryStream ms;
+                StackArray< Job *, 32 > batchJobs;
+                StackArray< uint32_t, 32 > headerEnds;
+                for ( size_t j = i; j < completedJobs.GetSize(); ++j )
+                {
+                    Job * batchJob = completedJobs[ j ];
+                    if ( ( batchJob == nullptr ) || ( batchJob->GetUserData() != cs ) )
+                    {
+                        continue;
+                    }
+
+                    ConvertResultForClient( cs, batchJob );
+                    ms.Write( batchJob->GetResultCompressionLevel() != 0 );
+                    const size_t sizePos = ms.GetSize();
+                    ms.Write( (uint32_t)0 ); // Patched below
+                    SerializeJobResultHeader( batchJob, ms );
+                    const uint32_t resultSize = (uint32_t)( ms.GetSize() - sizePos - sizeof( uint32_t ) + batchJob->GetDataSize() );
+                    memcpy( static_cast< char * >( ms.GetDataMutable() ) + sizePos, &resultSize, sizeof( uint32_t ) );
+
+                    batchJobs.Append( batchJob );
+                    headerEnds.Append( (uint32_t)ms.GetSize() );
+                    completedJobs[ j ] = nullptr;
+                }
 
+                // Interleave headers and result data
+                StackArray< TCPConnectionPool::SendBuffer, 64 > buffers;
+                uint32_t headerStart = 0;
+                for ( size_t j = 0; j < batchJobs.GetSize(); ++j )
+                {
+                    const char * headers = static_cast< const char * >( ms.GetData() );
+                    buffers.Append( TCPConnectionPool::SendBuffer{ headerEnds[ j ] - headerStart, headers + headerStart } );
+                    buffers.Append( TCPConnectionPool::SendBuffer{ (uint32_t)batchJobs[ j ]->GetDataSize(), batchJobs[ j ]->GetData() } );
+                    headerStart = headerEnds[ j ];
+                }
+
+                {
+                    const uint32_t numResults = (uint32_t)batchJobs.GetSize();
+                    ASSERT( cs->m_NumJobsActive.Load() >= numResults );
+                    cs->m_NumJobsActive.Sub( numResults );
+
+                    MutexHolder mh2( cs->m_Mutex );
+
+                    const Protocol::MsgJobResults msg( numResults );
+                    msg.Send( cs->m_Connection, buffers.Begin(), (uint32_t)buffers.GetSize() );
+                    RecordBatch( m_JobResultsStats, numResults );
+                }
+
+                for ( Job * batchJob : batchJobs )
+                {
+                    FDELETE batchJob;
+                }
+                continue; // job was deleted as part of the batch
+            }
+            else
+            {
+                ConvertResultForClient( cs, job );
                 MemoryStream ms;
-                ms.Write( job->GetJobId() );
-                ms.Write( job->GetNode()->GetName() );
-                ms.Write( result == Node::UP_TO_DATE );
-                ms.Write( job->GetSystemErrorCount() > 0 );
-                ms.Write( job->GetMessages() );
-                ms.Write( job->GetNode()->GetLastBuildTime() );
-                ms.Write( job->GetRemoteThreadIndex() ); // The thread used to build the job to assist with visualization
-
-                // write the data - build result for success, or output+errors for failure
-                ms.Write( (uint32_t)job->GetDataSize() );
-                ms.WriteBuffer( job->GetData(), job->GetDataSize() );
+                SerializeJobResultHeader( job, ms );
+                const TCPConnectionPool::SendBuffer buffers[ 2 ] =
+                {
+                    { (uint32_t)ms.GetSize(), ms.GetData() },
+                    { (uint32_t)job->GetDataSize(), job->GetData() }
+                };
 
                 {
                     ASSERT( cs->m_NumJobsActive.Load() > 0 );
@@ -734,27 +1106,64 @@ void Server::FinalizeCompletedJobs()
                     {
                         // Uncompressed
                         const Protocol::MsgJobResult msg;
-                        msg.Send( cs->m_Connection, ms );
+                        msg.Send( cs->m_Connection, buffers, 2 );
                     }
                     else
                     {
                         // Compressed
                         const Protocol::MsgJobResultCompressed msg;
-                        msg.Send( cs->m_Connection, ms );
+                        msg.Send( cs->m_Connection, buffers, 2 );
                     }
                 }
             }
-            else
-            {
-                // we might get here without finding the connection
-                // (if the connection was lost before we completed)
-            }
         }
 
         FDELETE job;
     }
 }
 
+// ConvertResultForClient
+//  - Clients prior to PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES can't
+//    decompress chunked results
+//------------------------------------------------------------------------------
+/*static*/ void Server::ConvertResultForClient( const ClientState * cs, Job * job )
+{
+    if ( ( cs->m_ProtocolVersionMinor >= Protocol::PROTOCOL_VERSION_MINOR_COMPRESSION_DICTIONARIES ) ||
+         ( job->GetResultCompressionLevel() == 0 ) ||
+         ( Compressor::IsValidData( job->GetData(), job->GetDataSize() ) == false ) ||
+         Compressor::IsBasicFormat( job->GetData(), job->GetDataSize() ) )
+    {
+        return;
+    }
+
+    Compressor c;
+    if ( c.ConvertToBasicFormat( job->GetData() ) )
+    {
+        const size_t convertedSize = c.GetResultSize();
+        job->OwnData( c.ReleaseResult(), convertedSize );
+    }
+}
+
+// SerializeJobResultHeader
+//------------------------------------------------------------------------------
+/*static*/ void Server::SerializeJobResultHeader( const Job * job, MemoryStream & ms )
+{
+    const Node::State result = job->GetNode()->GetState();
+    ASSERT( ( result == Node::UP_TO_DATE ) || ( result == Node::FAILED ) );
+
+    ms.Write( job->GetJobId() );
+    ms.Write( job->GetNode()->GetName() );
+    ms.Write( result == Node::UP_TO_DATE );
+    ms.Write( job->GetSystemErrorCount() > 0 );
+    ms.Write( job->GetMessages() );
+    ms.Write( job->GetNode()->GetLastBuildTime() );
+    ms.Write( job->GetRemoteThreadIndex() ); // The thread used to build the job to assist with visualization
+
+    // size of the data which follows - build result for success, or output+errors for failure
+    // (the data itself is sent directly from the job to avoid a copy)
+    ms.Write( (uint32_t)job->GetDataSize() );
+}
+
 // TouchToolchains
 //------------------------------------------------------------------------------
 void Server::TouchToolchains()
@@ -789,6 +1198,13 @@ void Server::RequestMissingFiles( const ConnectionInfo * connection, ToolManifes
         const ToolManifestFile & f = files[ i ];
         if ( f.GetSyncState() == ToolManifestFile::NOT_SYNCHRONIZED )
         {
+            // identical content already being requested will be used for this file too
+            if ( manifest->FindSynchronizingDuplicate( i ) )
+            {
+                manifest->MarkFileAsSynchronizing( i );
+                continue;
+            }
+
             // request this file
             const Protocol::MsgRequestFile reqFileMsg( manifest->GetToolId(), (uint32_t)i );
             reqFileMsg.Send( connection );
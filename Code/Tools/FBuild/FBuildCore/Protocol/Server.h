@@ -8,20 +8,31 @@
 #include "Core/Process/Atomic.h"
 #include "Core/Time/Timer.h"
 
+// Defines
+//------------------------------------------------------------------------------
+#if defined( DEBUG )
+    // Enabled support for some test functionality
+    #define ENABLE_FAKE_RESULT_BATCHING_DELAY
+#endif
+
 // Forward Declarations
 //------------------------------------------------------------------------------
+class CompressionDictionary;
 class Job;
 class JobQueueRemote;
 namespace Protocol
 {
     class IMessage;
+    class MsgCompressionDictionary;
     class MsgConnection;
     class MsgJob;
+    class MsgJobs;
     class MsgManifest;
     class MsgNoJobAvailable;
     class MsgStatus;
     class MsgFile;
 }
+class MemoryStream;
 class ToolManifest;
 
 // Protocol
@@ -36,6 +47,21 @@ public:
 
     bool IsSynchingTool( AString & statusStr ) const;
 
+    // Number of jobs carried by each kind of batched message
+    struct BatchStats
+    {
+        uint32_t    m_NumMessages = 0;
+        uint32_t    m_NumJobs = 0;
+        uint32_t    m_MaxJobsPerMessage = 0;
+    };
+    void GetBatchStats( BatchStats & outRequestJobs, BatchStats & outJobs, BatchStats & outJobResults ) const;
+
+#if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+    // Delay returning results once one completes, so tests can rely on
+    // results completing close together being returned in one message
+    static void SetFakeResultBatchingDelay( uint32_t delayMS ) { sFakeResultBatchingDelayMS.Store( delayMS ); }
+#endif
+
 private:
     // TCPConnection interface
     virtual void OnConnected( const ConnectionInfo * connection ) override;
@@ -47,8 +73,10 @@ private:
     void Process( const ConnectionInfo * connection, const Protocol::MsgStatus * msg );
     void Process( const ConnectionInfo * connection, const Protocol::MsgNoJobAvailable * msg );
     void Process( const ConnectionInfo * connection, const Protocol::MsgJob * msg, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgJobs * msg, const void * payload, size_t payloadSize );
     void Process( const ConnectionInfo * connection, const Protocol::MsgManifest * msg, const void * payload, size_t payloadSize );
     void Process( const ConnectionInfo * connection, const Protocol::MsgFile * msg, const void * payload, size_t payloadSize );
+    void Process( const ConnectionInfo * connection, const Protocol::MsgCompressionDictionary * msg, const void * payload, size_t payloadSize );
 
     static uint32_t ThreadFuncStatic( void * param );
     void            ThreadFunc();
@@ -82,9 +110,24 @@ private:
 
         Array< Job * >          m_WaitingJobs; // jobs waiting for manifests/toolchains
 
+        const CompressionDictionary * m_ResultDictionary = nullptr; // Used to compress results, if provided by client
+        Array< const CompressionDictionary * > m_Dictionaries; // Sent by client (each holds a reference)
+
         Timer                   m_StatusTimer;
     };
 
+    void            ReceiveJob( const ConnectionInfo * connection,
+                                ClientState * cs,
+                                uint64_t toolId,
+                                int16_t resultCompressionLevel,
+                                const void * jobData,
+                                size_t jobDataSize );
+    static void     ConvertResultForClient( const ClientState * cs, Job * job );
+    static void     SerializeJobResultHeader( const Job * job, MemoryStream & ms );
+    void            RecordBatch( BatchStats & stats, uint32_t numJobs );
+    void            ReleaseDictionaries( ClientState * cs );
+    void            FreeReleasedDictionaries();
+
     JobQueueRemote *        m_JobQueueRemote;
 
     Atomic<bool>            m_ShouldExit;   // signal from main thread
@@ -94,10 +137,28 @@ private:
 
     mutable Mutex           m_ToolManifestsMutex;
     Array< ToolManifest * > m_Tools;
+
+    struct DictionaryRef
+    {
+        CompressionDictionary * m_Dictionary;
+        uint32_t                m_RefCount;     // Connected clients using it
+    };
+    Mutex                   m_DictionariesMutex;
+    Array< DictionaryRef >  m_Dictionaries;     // Received from clients
+    Array< CompressionDictionary * > m_ReleasedDictionaries; // Freed once no jobs are using them
+
+    mutable Mutex           m_BatchStatsMutex;
+    BatchStats              m_RequestJobsStats;     // MSG_REQUEST_JOBS sent
+    BatchStats              m_JobsStats;            // MSG_JOBS received
+    BatchStats              m_JobResultsStats;      // MSG_JOB_RESULTS sent
     
     #if defined( __OSX__ ) || defined( __LINUX__ )
         Timer                   m_TouchToolchainTimer;
     #endif
+
+#if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+    static Atomic<uint32_t> sFakeResultBatchingDelayMS;
+#endif
 };
 
 //------------------------------------------------------------------------------
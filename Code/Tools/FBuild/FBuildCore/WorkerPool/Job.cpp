@@ -155,9 +155,9 @@ void Job::SetMessages( const Array< AString > & messages )
     m_Messages = messages;
 }
 
-// Serialize
+// SerializeHeader
 //------------------------------------------------------------------------------
-void Job::Serialize( IOStream & stream )
+void Job::SerializeHeader( IOStream & stream ) const
 {
     PROFILE_FUNCTION;
 
@@ -174,7 +174,6 @@ void Job::Serialize( IOStream & stream )
     stream.Write( IsDataCompressed() );
 
     stream.Write( m_DataSize );
-    stream.Write( m_Data, m_DataSize );
 }
 
 // Deserialize
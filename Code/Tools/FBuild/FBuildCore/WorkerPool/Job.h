@@ -11,6 +11,7 @@
 // Forward Declarations
 //------------------------------------------------------------------------------
 class BuildProfilerScope;
+class CompressionDictionary;
 class IOStream;
 class Node;
 class ToolManifest;
@@ -64,7 +65,8 @@ public:
     inline uint8_t GetSystemErrorCount() const { return m_SystemErrorCount; }
 
     // serialization for remote distribution
-    void Serialize( IOStream & stream );
+    // (the job data follows the header and is sent directly from GetData())
+    void SerializeHeader( IOStream & stream ) const;
     void Deserialize( IOStream & stream );
 
     void                GetMessagesForLog( AString & buffer ) const;
@@ -77,6 +79,8 @@ public:
 
     void                SetResultCompressionLevel( int16_t compressionLevel )   { m_ResultCompressionLevel = compressionLevel; }
     int16_t             GetResultCompressionLevel() const                       { return m_ResultCompressionLevel; }
+    void                SetResultCompressionDictionary( const CompressionDictionary * dictionary ) { m_ResultCompressionDictionary = dictionary; }
+    const CompressionDictionary * GetResultCompressionDictionary() const        { return m_ResultCompressionDictionary; }
 
     enum DistributionState : uint8_t
     {
@@ -121,6 +125,7 @@ private:
     BuildProfilerScope * m_BuildProfilerScope = nullptr;    // Additional context when profiling a build
     ToolManifest *      m_ToolManifest      = nullptr;
     int16_t             m_ResultCompressionLevel = 0; // Compression level of returned results
+    const CompressionDictionary * m_ResultCompressionDictionary = nullptr; // Dictionary for returned results (owned by Server)
 
     Array< AString >    m_Messages;
 
@@ -7,18 +7,24 @@
 #include "Job.h"
 #include "WorkerThread.h"
 
+#include "Tools/FBuild/FBuildCore/Cache/CachePrefetcher.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/FLog.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
+#include "Tools/FBuild/FBuildCore/Graph/NodeGraph.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Helpers/BuildProfiler.h"
 
 #include "Core/Time/Timer.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/Math/Conversions.h"
 #include "Core/Process/Atomic.h"
 #include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 
+// system
+#include <string.h> // for memset
+
 // JobCostSorter
 //------------------------------------------------------------------------------
 class JobCostSorter
@@ -30,11 +36,105 @@ public:
     }
 };
 
+// JobCostTree CONSTRUCTOR
+//------------------------------------------------------------------------------
+JobCostTree::JobCostTree( uint32_t numLeaves )
+    : m_NumLeaves( 1 )
+    , m_NumLevels( 0 )
+{
+    ASSERT( numLeaves > 0 );
+    while ( m_NumLeaves < numLeaves )
+    {
+        m_NumLeaves *= 2;
+        ++m_NumLevels;
+    }
+    m_Nodes = FNEW_ARRAY( uint32_t[ m_NumLeaves * 2 ] );
+    memset( (void *)m_Nodes, 0, sizeof( uint32_t ) * m_NumLeaves * 2 );
+}
+
+// JobCostTree DESTRUCTOR
+//------------------------------------------------------------------------------
+JobCostTree::~JobCostTree()
+{
+    FDELETE_ARRAY( m_Nodes );
+}
+
+// JobCostTree::Update
+//------------------------------------------------------------------------------
+void JobCostTree::Update( uint32_t leaf, bool hasJobs, uint32_t topCost )
+{
+    ASSERT( leaf < m_NumLeaves );
+    const uint32_t value = hasJobs ? ( Math::Min( topCost, 0xFFFFFFFEu ) + 1 ) : 0;
+    AtomicStoreRelaxed( &m_Nodes[ m_NumLeaves + leaf ], value );
+    Repair( leaf );
+}
+
+// JobCostTree::FindMostExpensive
+//------------------------------------------------------------------------------
+bool JobCostTree::FindMostExpensive( uint32_t preferredLeaf, uint32_t & outLeaf ) const
+{
+    ASSERT( preferredLeaf < m_NumLeaves );
+    const uint32_t preferredIndex = ( m_NumLeaves + preferredLeaf );
+
+    // Descend towards the most expensive child, or the preferred one when equal
+    uint32_t index = 1;
+    for ( uint32_t level = 1; level <= m_NumLevels; ++level )
+    {
+        const uint32_t left = ( index * 2 );
+        const uint32_t leftValue = AtomicLoadRelaxed( &m_Nodes[ left ] );
+        const uint32_t rightValue = AtomicLoadRelaxed( &m_Nodes[ left + 1 ] );
+        if ( leftValue == rightValue )
+        {
+            const uint32_t preferredChild = ( preferredIndex >> ( m_NumLevels - level ) );
+            index = ( preferredChild == ( left + 1 ) ) ? ( left + 1 ) : left;
+        }
+        else
+        {
+            index = ( leftValue > rightValue ) ? left : ( left + 1 );
+        }
+    }
+
+    // Concurrent updates can leave internal nodes briefly out of date, so the
+    // leaf is what determines if jobs were found
+    if ( AtomicLoadRelaxed( &m_Nodes[ index ] ) == 0 )
+    {
+        return false;
+    }
+    outLeaf = ( index - m_NumLeaves );
+    return true;
+}
+
+// JobCostTree::Repair
+//------------------------------------------------------------------------------
+void JobCostTree::Repair( uint32_t leaf )
+{
+    for ( uint32_t index = ( ( m_NumLeaves + leaf ) / 2 ); index > 0; index /= 2 )
+    {
+        const uint32_t leftValue = AtomicLoadRelaxed( &m_Nodes[ index * 2 ] );
+        const uint32_t rightValue = AtomicLoadRelaxed( &m_Nodes[ ( index * 2 ) + 1 ] );
+        AtomicStoreRelaxed( &m_Nodes[ index ], Math::Max( leftValue, rightValue ) );
+    }
+}
+
+// JobCostTree::Rebuild
+//------------------------------------------------------------------------------
+void JobCostTree::Rebuild()
+{
+    for ( uint32_t index = ( m_NumLeaves - 1 ); index > 0; --index )
+    {
+        const uint32_t leftValue = AtomicLoadRelaxed( &m_Nodes[ index * 2 ] );
+        const uint32_t rightValue = AtomicLoadRelaxed( &m_Nodes[ ( index * 2 ) + 1 ] );
+        AtomicStoreRelaxed( &m_Nodes[ index ], Math::Max( leftValue, rightValue ) );
+    }
+}
+
 // JobSubQueue CONSTRUCTOR
 //------------------------------------------------------------------------------
 JobSubQueue::JobSubQueue()
     : m_Count( 0 )
     , m_Jobs( 1024, true )
+    , m_CostTree( nullptr )
+    , m_CostTreeLeaf( 0 )
 {
 }
 
@@ -46,6 +146,15 @@ JobSubQueue::~JobSubQueue()
     ASSERT( AtomicLoadRelaxed( &m_Count ) == 0 );
 }
 
+// SetCostTree
+//------------------------------------------------------------------------------
+void JobSubQueue::SetCostTree( JobCostTree * costTree, uint32_t leaf )
+{
+    ASSERT( m_Jobs.IsEmpty() );
+    m_CostTree = costTree;
+    m_CostTreeLeaf = leaf;
+}
+
 // GetCount
 //------------------------------------------------------------------------------
 uint32_t JobSubQueue::GetCount() const
@@ -55,34 +164,42 @@ uint32_t JobSubQueue::GetCount() const
 
 // JobSubQueue:QueueJobs
 //------------------------------------------------------------------------------
-void JobSubQueue::QueueJobs( Array< Node * > & nodes )
+void JobSubQueue::QueueJobs( const Array< Job * > & jobs, size_t first, size_t stride )
 {
-    // Create wrapper Jobs around Nodes
-    Array< Job * > jobs( nodes.GetSize() );
-    for ( Node * node : nodes )
+    ASSERT( stride > 0 );
+    if ( first >= jobs.GetSize() )
     {
-        Job * job = FNEW( Job( node ) );
-        jobs.Append( job );
+        return;
     }
 
-    // Sort Jobs by cost
-    JobCostSorter sorter;
-    jobs.Sort( sorter );
+    const JobCostSorter sorter;
 
-    // lock to add job
+    // lock to add jobs
     MutexHolder mh( m_Mutex );
-    const bool wasEmpty = m_Jobs.IsEmpty();
-
-    m_Jobs.Append( jobs );
-    AtomicAdd( &m_Count, (uint32_t)jobs.GetSize() );
 
-    if ( wasEmpty )
+    uint32_t numAdded = 0;
+    for ( size_t i = first; i < jobs.GetSize(); i += stride )
     {
-        return; // skip re-sorting
+        // append and sift up
+        size_t index = m_Jobs.GetSize();
+        m_Jobs.Append( jobs[ i ] );
+        while ( index > 0 )
+        {
+            const size_t parent = ( ( index - 1 ) / 2 );
+            if ( sorter( m_Jobs[ parent ], m_Jobs[ index ] ) == false )
+            {
+                break;
+            }
+            Job * tmp = m_Jobs[ parent ];
+            m_Jobs[ parent ] = m_Jobs[ index ];
+            m_Jobs[ index ] = tmp;
+            index = parent;
+        }
+        ++numAdded;
     }
 
-    // sort merged lists
-    m_Jobs.Sort( sorter );
+    UpdateCostTree();
+    AtomicAdd( &m_Count, numAdded );
 }
 
 // RemoveJob
@@ -106,16 +223,71 @@ Job * JobSubQueue::RemoveJob()
 
     VERIFY( AtomicDec( &m_Count ) != static_cast< uint32_t >( -1 ) );
 
-    Job * job = m_Jobs.Top();
+    // take the root, move the last job into its place and sift down
+    Job * job = m_Jobs[ 0 ];
+    m_Jobs[ 0 ] = m_Jobs.Top();
     m_Jobs.Pop();
 
+    const JobCostSorter sorter;
+    const size_t numJobs = m_Jobs.GetSize();
+    size_t index = 0;
+    for ( ;; )
+    {
+        const size_t left = ( index * 2 ) + 1;
+        if ( left >= numJobs )
+        {
+            break;
+        }
+        const size_t right = ( left + 1 );
+        const size_t child = ( ( right < numJobs ) && sorter( m_Jobs[ left ], m_Jobs[ right ] ) ) ? right : left;
+        if ( sorter( m_Jobs[ index ], m_Jobs[ child ] ) == false )
+        {
+            break;
+        }
+        Job * tmp = m_Jobs[ child ];
+        m_Jobs[ child ] = m_Jobs[ index ];
+        m_Jobs[ index ] = tmp;
+        index = child;
+    }
+
+    UpdateCostTree();
+
     return job;
 }
 
+// UpdateCostTree (m_Mutex must be held)
+//------------------------------------------------------------------------------
+void JobSubQueue::UpdateCostTree()
+{
+    if ( m_CostTree )
+    {
+        const uint32_t topCost = m_Jobs.IsEmpty() ? 0 : m_Jobs[ 0 ]->GetNode()->GetRecursiveCost();
+        m_CostTree->Update( m_CostTreeLeaf, ( m_Jobs.IsEmpty() == false ), topCost );
+    }
+}
+
 // CONSTRUCTOR
 //------------------------------------------------------------------------------
 JobQueue::JobQueue( uint32_t numWorkerThreads ) :
+    m_NumIdleWorkers( 0 ),
+    m_LocalJobs_Flushing( 1024, true ),
+    m_LocalJobs_Available( nullptr ),
+    m_LocalJobs_CostTree( Math::Max( numWorkerThreads, 1u ) ),
+    m_NumLocalJobSubQueues( Math::Max( numWorkerThreads, 1u ) ), // main thread consumes when there are no workers
+    m_NumLocalJobsAvailable( 0 ),
+    m_NextLocalJobSubQueue( 0 ),
     m_NumLocalJobsActive( 0 ),
+    m_FileNodes_Staging( 1024, true ),
+    m_FileNodes_Names( 1024, true ),
+    m_FileNodes_Stamps( 1024, true ),
+    m_ParallelFor_Function( nullptr ),
+    m_ParallelFor_UserData( nullptr ),
+    m_ParallelFor_NumItems( 0 ),
+    m_ParallelFor_ChunkSize( 0 ),
+    m_ParallelFor_NumChunks( 0 ),
+    m_ParallelFor_NextChunk( 0 ),
+    m_ParallelFor_NumChunksDone( 0 ),
+    m_ParallelFor_NumHelpers( 0 ),
     m_DistributableJobs_Available( 1024, true ),
     m_DistributableJobs_InProgress( 1024, true ),
     #if defined( __WINDOWS__ )
@@ -133,6 +305,12 @@ JobQueue::JobQueue( uint32_t numWorkerThreads ) :
 
     WorkerThread::InitTmpDir();
 
+    m_LocalJobs_Available = FNEW_ARRAY( JobSubQueue[ m_NumLocalJobSubQueues ] );
+    for ( uint32_t i = 0; i < m_NumLocalJobSubQueues; ++i )
+    {
+        m_LocalJobs_Available[ i ].SetCostTree( &m_LocalJobs_CostTree, i );
+    }
+
     for ( uint32_t i=0; i<numWorkerThreads; ++i )
     {
         // identify each worker with an id starting from 1
@@ -153,12 +331,6 @@ JobQueue::~JobQueue()
     // signal all workers to stop - ok if this has already been done
     SignalStopWorkers();
 
-    // delete incomplete jobs
-    while ( Job * job = m_LocalJobs_Available.RemoveJob() )
-    {
-        FDELETE job;
-    }
-
     // wait for workers to finish - ok if they stopped before this
     const size_t numWorkerThreads = m_Workers.GetSize();
     for ( size_t i=0; i<numWorkerThreads; ++i )
@@ -167,6 +339,16 @@ JobQueue::~JobQueue()
         FDELETE m_Workers[ i ];
     }
 
+    // delete incomplete jobs
+    for ( uint32_t i = 0; i < m_NumLocalJobSubQueues; ++i )
+    {
+        while ( Job * job = m_LocalJobs_Available[ i ].RemoveJob() )
+        {
+            FDELETE job;
+        }
+    }
+    FDELETE_ARRAY m_LocalJobs_Available;
+
     // free locally available distributed jobs
     {
         MutexHolder m( m_DistributedJobsMutex );
@@ -232,7 +414,7 @@ void JobQueue::GetJobStats( uint32_t & numJobs,
 {
     MutexHolder m( m_DistributedJobsMutex );
 
-    numJobs = m_LocalJobs_Available.GetCount();
+    numJobs = AtomicLoadRelaxed( &m_NumLocalJobsAvailable );
     numJobsDist = (uint32_t)m_DistributableJobs_Available.GetSize();
     numJobsActive = AtomicLoadRelaxed( &m_NumLocalJobsActive );
     numJobsDistActive = (uint32_t)m_DistributableJobs_InProgress.GetSize();
@@ -256,9 +438,172 @@ void JobQueue::AddJobToBatch( Node * node )
     // mark as building
     node->SetState( Node::BUILDING );
 
+    // FileNodes only need a stat, which is cheaper to do in a batch than as a Job
+    if ( node->GetType() == Node::FILE_NODE )
+    {
+        m_FileNodes_Staging.Append( node );
+        return;
+    }
+
+    // Start cache lookups so results are available when the job is picked up
+    if ( node->GetType() == Node::OBJECT_NODE )
+    {
+        CachePrefetcher * prefetcher = FBuild::Get().GetCachePrefetcher();
+        if ( prefetcher )
+        {
+            prefetcher->Queue( node->CastTo< ObjectNode >() );
+        }
+    }
+
     m_LocalJobs_Staging.Append( node );
 }
 
+// StatFileNodeBatch (Main Thread)
+//------------------------------------------------------------------------------
+void JobQueue::StatFileNodeBatch()
+{
+    PROFILE_FUNCTION;
+
+    ASSERT( m_FileNodes_Staging.IsEmpty() == false );
+
+    const uint32_t numFiles = (uint32_t)m_FileNodes_Staging.GetSize();
+    m_FileNodes_Names.SetCapacity( numFiles );
+    for ( const Node * node : m_FileNodes_Staging )
+    {
+        m_FileNodes_Names.Append( &node->GetName() );
+    }
+    m_FileNodes_Stamps.SetSize( numFiles );
+
+    ParallelFor( numFiles, kFileNodeChunkSize, StatFileNodeChunk, this );
+
+    // Complete the nodes (as FileNode::DoBuild and FinalizeCompletedJobs would)
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        Node * node = m_FileNodes_Staging[ i ];
+        node->m_Stamp = m_FileNodes_Stamps[ i ];
+        node->SetStatFlag( Node::STATS_BUILT );
+        node->SetState( Node::UP_TO_DATE );
+        NodeGraph::OnNodeCompleted( node );
+    }
+    m_FileNodes_Staging.Clear();
+    m_FileNodes_Names.Clear();
+    m_FileNodes_Stamps.Clear();
+}
+
+// StatFileNodeChunk
+//------------------------------------------------------------------------------
+/*static*/ void JobQueue::StatFileNodeChunk( uint32_t firstItem, uint32_t numItems, void * userData )
+{
+    JobQueue * self = static_cast< JobQueue * >( userData );
+    FileIO::GetFileLastWriteTimes( self->m_FileNodes_Names.Begin() + firstItem, numItems, self->m_FileNodes_Stamps.Begin() + firstItem );
+}
+
+// ParallelFor (Main Thread)
+//------------------------------------------------------------------------------
+void JobQueue::ParallelFor( uint32_t numItems, uint32_t chunkSize, ParallelForFunction func, void * userData )
+{
+    ASSERT( Thread::IsMainThread() );
+    ASSERT( chunkSize > 0 );
+    ASSERT( m_ParallelFor_NumChunks == 0 ); // Not re-entrant
+
+    const uint32_t numChunks = ( numItems + chunkSize - 1 ) / chunkSize;
+    if ( ( numChunks <= 1 ) || m_Workers.IsEmpty() )
+    {
+        // Not worth involving the workers
+        if ( numItems > 0 )
+        {
+            func( 0, numItems, userData );
+        }
+        return;
+    }
+
+    // Make the chunks available and wake idle workers to help
+    m_ParallelFor_Function = func;
+    m_ParallelFor_UserData = userData;
+    m_ParallelFor_NumItems = numItems;
+    m_ParallelFor_ChunkSize = chunkSize;
+    m_ParallelFor_NextChunk = 0;
+    m_ParallelFor_NumChunksDone = 0;
+    AtomicStoreRelease( &m_ParallelFor_NumChunks, numChunks );
+    WakeWorkers( numChunks - 1 );
+
+    // Process chunks until none remain unclaimed
+    for ( ;; )
+    {
+        const uint32_t chunk = ( AtomicInc( &m_ParallelFor_NextChunk ) - 1 );
+        if ( chunk >= numChunks )
+        {
+            break;
+        }
+        ProcessParallelForChunk( chunk );
+        AtomicInc( &m_ParallelFor_NumChunksDone );
+    }
+
+    // Wait for chunks claimed by workers and for workers to stop inspecting
+    // the work before the caller modifies it
+    while ( AtomicLoadAcquire( &m_ParallelFor_NumChunksDone ) < numChunks )
+    {
+        Thread::Sleep( 0 );
+    }
+    AtomicStoreRelease( &m_ParallelFor_NumChunks, 0u );
+    while ( AtomicLoadAcquire( &m_ParallelFor_NumHelpers ) > 0 )
+    {
+        Thread::Sleep( 0 );
+    }
+}
+
+// HelpParallelFor (Worker Thread)
+//------------------------------------------------------------------------------
+bool JobQueue::HelpParallelFor()
+{
+    // Cheap early out for the common case
+    if ( AtomicLoadRelaxed( &m_ParallelFor_NumChunks ) == 0 )
+    {
+        return false;
+    }
+
+    // Register as a helper before checking again, so the main thread won't
+    // modify the work while we use it
+    AtomicInc( &m_ParallelFor_NumHelpers );
+    bool didWork = false;
+    const uint32_t numChunks = AtomicLoadAcquire( &m_ParallelFor_NumChunks );
+    for ( ;; )
+    {
+        const uint32_t chunk = ( numChunks > 0 ) ? ( AtomicInc( &m_ParallelFor_NextChunk ) - 1 ) : 0;
+        if ( chunk >= numChunks )
+        {
+            break;
+        }
+        ProcessParallelForChunk( chunk );
+        AtomicInc( &m_ParallelFor_NumChunksDone );
+        didWork = true;
+    }
+    AtomicDec( &m_ParallelFor_NumHelpers );
+    return didWork;
+}
+
+// ProcessParallelForChunk
+//------------------------------------------------------------------------------
+void JobQueue::ProcessParallelForChunk( uint32_t chunk )
+{
+    const uint32_t first = ( chunk * m_ParallelFor_ChunkSize );
+    const uint32_t count = Math::Min< uint32_t >( m_ParallelFor_ChunkSize, m_ParallelFor_NumItems - first );
+    m_ParallelFor_Function( first, count, m_ParallelFor_UserData );
+}
+
+// GetReadyNode (Main Thread)
+//------------------------------------------------------------------------------
+Node * JobQueue::GetReadyNode()
+{
+    if ( m_ReadyNodes.IsEmpty() )
+    {
+        return nullptr;
+    }
+    Node * node = m_ReadyNodes.Top();
+    m_ReadyNodes.Pop();
+    return node;
+}
+
 // FlushJobBatch (Main Thread)
 //------------------------------------------------------------------------------
 void JobQueue::FlushJobBatch()
@@ -268,10 +613,44 @@ void JobQueue::FlushJobBatch()
         return;
     }
 
-    // Make the jobs available
-    m_LocalJobs_Available.QueueJobs( m_LocalJobs_Staging );
-    m_WorkerThreadSemaphore.Signal( (uint32_t)m_LocalJobs_Staging.GetSize() );
+    // Create wrapper Jobs around Nodes
+    ASSERT( m_LocalJobs_Flushing.IsEmpty() );
+    for ( Node * node : m_LocalJobs_Staging )
+    {
+        m_LocalJobs_Flushing.Append( FNEW( Job( node ) ) );
+    }
     m_LocalJobs_Staging.Clear();
+
+    // Make the jobs available, round-robin across sub queues
+    const uint32_t numJobs = (uint32_t)m_LocalJobs_Flushing.GetSize();
+    const uint32_t numSubQueues = Math::Min( numJobs, m_NumLocalJobSubQueues );
+    for ( uint32_t i = 0; i < numSubQueues; ++i )
+    {
+        const uint32_t subQueue = ( ( m_NextLocalJobSubQueue + i ) % m_NumLocalJobSubQueues );
+        m_LocalJobs_Available[ subQueue ].QueueJobs( m_LocalJobs_Flushing, i, numSubQueues );
+    }
+    m_NextLocalJobSubQueue = ( ( m_NextLocalJobSubQueue + numJobs ) % m_NumLocalJobSubQueues );
+    AtomicAdd( &m_NumLocalJobsAvailable, numJobs );
+    m_LocalJobs_Flushing.Clear();
+
+    WakeWorkers( numJobs );
+}
+
+// WakeWorkers
+//------------------------------------------------------------------------------
+void JobQueue::WakeWorkers( uint32_t numJobs )
+{
+    // Only wake workers which are idle. Busy workers will pick up the work
+    // when they finish their current job.
+    // NOTE: Pairs with WorkerThreadWait. The available count is published (by
+    // a full barrier RMW) before this load, and a worker registers as idle
+    // before loading the available count, so at least one side sees the other.
+    const uint32_t numIdleWorkers = AtomicLoadAcquire( &m_NumIdleWorkers );
+    const uint32_t numToWake = Math::Min( numJobs, numIdleWorkers );
+    if ( numToWake > 0 )
+    {
+        m_WorkerThreadSemaphore.Signal( numToWake );
+    }
 }
 
 // QueueDistributableJob
@@ -300,7 +679,7 @@ void JobQueue::QueueDistributableJob( Job * job )
     ASSERT( m_NumLocalJobsActive > 0 );
     AtomicDec( &m_NumLocalJobsActive ); // job converts from active to pending remote
 
-    m_WorkerThreadSemaphore.Signal();
+    WakeWorkers( 1 );
 }
 
 // GetDistributableJobToProcess
@@ -525,6 +904,7 @@ void JobQueue::FinalizeCompletedJobs( NodeGraph & nodeGraph )
         {
             n->SetState( Node::FAILED );
         }
+        NodeGraph::OnNodeCompleted( n );
 
         // Free normal jobs
         if ( job->GetDistributionState() == Job::DIST_NONE )
@@ -575,6 +955,7 @@ void JobQueue::FinalizeCompletedJobs( NodeGraph & nodeGraph )
     for ( Job * job : m_CompletedJobsFailed2 )
     {
         job->GetNode()->SetState( Node::FAILED );
+        NodeGraph::OnNodeCompleted( job->GetNode() );
 
         // Free normal jobs
         if ( job->GetDistributionState() == Job::DIST_NONE )
@@ -623,18 +1004,55 @@ void JobQueue::WorkerThreadWait( uint32_t maxWaitMS )
 {
     ASSERT( Thread::IsMainThread() == false );
     ASSERT( FBuild::Get().GetOptions().m_NumWorkerThreads > 0 );
-    m_WorkerThreadSemaphore.Wait( maxWaitMS );
+
+    // Register as idle before checking for work, so a flush which misses this
+    // check will see us in the idle count and signal the semaphore
+    AtomicInc( &m_NumIdleWorkers );
+    if ( ( AtomicLoadAcquire( &m_NumLocalJobsAvailable ) == 0 ) &&
+         ( AtomicLoadAcquire( &m_ParallelFor_NumChunks ) == 0 ) )
+    {
+        m_WorkerThreadSemaphore.Wait( maxWaitMS );
+    }
+    AtomicDec( &m_NumIdleWorkers );
 }
 
 // GetJobToProcess (Worker Thread)
 //------------------------------------------------------------------------------
 Job * JobQueue::GetJobToProcess()
 {
-    Job * job = m_LocalJobs_Available.RemoveJob();
-    if ( job )
+    // Prefer the sub queue owned by this thread, so workers with equally
+    // expensive choices prefer different locks
+    const uint32_t ownSubQueue = ( WorkerThread::GetThreadIndex() % m_NumLocalJobSubQueues );
+
+    bool rebuilt = false;
+    while ( AtomicLoadAcquire( &m_NumLocalJobsAvailable ) > 0 )
     {
-        AtomicInc( &m_NumLocalJobsActive );
-        return job;
+        // Find the sub queue with the most expensive job (lock-free)
+        uint32_t subQueue;
+        if ( m_LocalJobs_CostTree.FindMostExpensive( ownSubQueue, subQueue ) == false )
+        {
+            // The tree can be out of date if sub queues were updated concurrently
+            if ( rebuilt )
+            {
+                break; // Jobs are being flushed, but are not visible yet
+            }
+            m_LocalJobs_CostTree.Rebuild();
+            rebuilt = true;
+            continue;
+        }
+
+        Job * job = m_LocalJobs_Available[ subQueue ].RemoveJob();
+        if ( job )
+        {
+            AtomicDec( &m_NumLocalJobsAvailable );
+            AtomicInc( &m_NumLocalJobsActive );
+            return job;
+        }
+
+        // Another worker emptied the sub queue since we checked. Its leaf is
+        // now up to date, so ensure the path to the root reflects that before
+        // searching again.
+        m_LocalJobs_CostTree.Repair( subQueue );
     }
 
     return nullptr;
@@ -18,7 +18,43 @@ class Job;
 class WorkerThread;
 
 
+// JobCostTree
+//  - Tournament tree over the JobSubQueues, where each node holds the highest
+//    job cost below it, so the sub queue with the most expensive job is found
+//    in O(log(sub queues)) instead of by checking every sub queue.
+//  - Updated lock-free by each sub queue (under its own lock) when its most
+//    expensive job changes, so is only a hint which can be briefly out of date.
+//------------------------------------------------------------------------------
+class JobCostTree
+{
+public:
+    explicit JobCostTree( uint32_t numLeaves );
+    ~JobCostTree();
+
+    // Record the state of a sub queue
+    void    Update( uint32_t leaf, bool hasJobs, uint32_t topCost );
+
+    // Find the sub queue with the most expensive job, preferring "preferredLeaf"
+    // when costs are equal. Returns false if no sub queue has jobs.
+    bool    FindMostExpensive( uint32_t preferredLeaf, uint32_t & outLeaf ) const;
+
+    // Re-calculate the path from a leaf to the root, or all internal nodes
+    void    Repair( uint32_t leaf );
+    void    Rebuild();
+
+private:
+    JobCostTree( const JobCostTree & ) = delete;
+    JobCostTree & operator = ( const JobCostTree & ) = delete;
+
+    uint32_t            m_NumLeaves;    // Always a power of 2
+    uint32_t            m_NumLevels;    // log2( m_NumLeaves )
+    volatile uint32_t * m_Nodes;        // Root at 1, leaves from m_NumLeaves (cost + 1, or 0 if no jobs)
+};
+
 // JobSubQueue
+//  - One shard of the locally available jobs. Each shard is a max-heap keyed
+//    on Node::GetRecursiveCost() with its own lock, so workers taking jobs are
+//    spread across shards instead of contending on a single mutex.
 //------------------------------------------------------------------------------
 class JobSubQueue
 {
@@ -26,17 +62,23 @@ public:
     JobSubQueue();
     ~JobSubQueue();
 
+    void SetCostTree( JobCostTree * costTree, uint32_t leaf );
+
     uint32_t GetCount() const;
 
-    // jobs pushed by the main thread
-    void QueueJobs( Array< Node * > & nodes );
+    // jobs pushed by the main thread (every "stride"th job, starting at "first")
+    void QueueJobs( const Array< Job * > & jobs, size_t first, size_t stride );
 
     // jobs consumed by workers
     Job * RemoveJob();
 private:
+    void        UpdateCostTree();
+
     uint32_t    m_Count;    // access the current count
     Mutex       m_Mutex;    // lock to add/remove jobs
-    Array< Job * > m_Jobs;  // Sorted, most expensive at end
+    Array< Job * > m_Jobs;  // Binary max-heap, most expensive at index 0
+    JobCostTree * m_CostTree;   // Tracks the most expensive job across sub queues
+    uint32_t    m_CostTreeLeaf;
 };
 
 // JobQueue
@@ -49,9 +91,18 @@ public:
 
     // main thread calls these
     void AddJobToBatch( Node * node );  // Add new job to the staging queue
-    void FlushJobBatch();               // Sort and flush the staging queue
+    void FlushJobBatch();               // Flush the staging queue
     bool HasJobsToFlush() const { return ( m_LocalJobs_Staging.IsEmpty() == false ); }
+    bool HasFileNodesToStat() const { return ( m_FileNodes_Staging.IsEmpty() == false ); }
+    void StatFileNodeBatch();           // Stat (in parallel) and complete staged FileNodes
+
+    // Process items in chunks, with idle workers helping (Main Thread). The function
+    // is called with ranges of items and must be safe to call from any thread.
+    typedef void (*ParallelForFunction)( uint32_t firstItem, uint32_t numItems, void * userData );
+    void ParallelFor( uint32_t numItems, uint32_t chunkSize, ParallelForFunction func, void * userData );
     void FinalizeCompletedJobs( NodeGraph & nodeGraph );
+    void AddReadyNode( Node * node )    { m_ReadyNodes.Append( node ); } // Node unblocked by completed dependencies
+    Node * GetReadyNode();              // Next unblocked node to progress (or nullptr)
     void MainThreadWait( uint32_t maxWaitMS );
 
     // main thread can be signalled
@@ -72,7 +123,11 @@ private:
     // worker threads call these
     friend class WorkerThread;
     void        WorkerThreadWait( uint32_t maxWaitMS );
+    void        WakeWorkers( uint32_t numJobs );
     Job *       GetJobToProcess();
+    static void StatFileNodeChunk( uint32_t firstItem, uint32_t numItems, void * userData );
+    bool        HelpParallelFor();
+    void        ProcessParallelForChunk( uint32_t chunk );
     Job *       GetDistributableJobToRace();
     static Node::BuildResult DoBuild( Job * job );
     void        FinishedProcessingJob( Job * job, bool result, bool wasARemoteJob );
@@ -92,14 +147,39 @@ private:
 
     // Semaphore to manage work
     Semaphore           m_WorkerThreadSemaphore;
+    uint32_t            m_NumIdleWorkers;   // Workers waiting on the semaphore
+
+    // Nodes unblocked by completed dependencies, waiting to be progressed
+    Array< Node * >     m_ReadyNodes;
 
     // Jobs available for local processing
     Array< Node * >     m_LocalJobs_Staging;
-    JobSubQueue         m_LocalJobs_Available;
+    Array< Job * >      m_LocalJobs_Flushing;   // Re-used when flushing the staging queue
+    JobSubQueue *       m_LocalJobs_Available;  // One sub queue per worker
+    JobCostTree         m_LocalJobs_CostTree;   // Finds the sub queue with the most expensive job
+    uint32_t            m_NumLocalJobSubQueues;
+    uint32_t            m_NumLocalJobsAvailable;// Total across all sub queues
+    uint32_t            m_NextLocalJobSubQueue; // Sub queue to receive the next flushed job
 
     // Jobs in progress locally
     uint32_t            m_NumLocalJobsActive;
 
+    // FileNodes are stat'd in batches instead of via Jobs
+    enum : uint32_t { kFileNodeChunkSize = 256 };
+    Array< Node * >     m_FileNodes_Staging;
+    Array< const AString * > m_FileNodes_Names;
+    Array< uint64_t >   m_FileNodes_Stamps;
+
+    // Work split into chunks (see ParallelFor) which idle workers help with
+    ParallelForFunction m_ParallelFor_Function;
+    void *              m_ParallelFor_UserData;
+    uint32_t            m_ParallelFor_NumItems;
+    uint32_t            m_ParallelFor_ChunkSize;
+    volatile uint32_t   m_ParallelFor_NumChunks;    // Chunks in work being processed (0 if none)
+    volatile uint32_t   m_ParallelFor_NextChunk;    // Next chunk to claim
+    volatile uint32_t   m_ParallelFor_NumChunksDone;
+    volatile uint32_t   m_ParallelFor_NumHelpers;   // Workers inspecting the work
+
     // Jobs available for distributed processing (can also be done locally)
     mutable Mutex       m_DistributedJobsMutex;
     Array< Job * >      m_DistributableJobs_Available;  // Available, not in progress anywhere
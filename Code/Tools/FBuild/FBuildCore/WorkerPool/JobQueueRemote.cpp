@@ -221,6 +221,30 @@ void JobQueueRemote::CancelJobsWithUserData( void * userData )
     }
 }
 
+// IsUsingCompressionDictionary
+//------------------------------------------------------------------------------
+bool JobQueueRemote::IsUsingCompressionDictionary( const CompressionDictionary * dictionary ) const
+{
+    // Jobs move between lists while holding both locks, so check them in the same order
+    MutexHolder m( m_PendingJobsMutex );
+    for ( const Job * job : m_PendingJobs )
+    {
+        if ( job->GetResultCompressionDictionary() == dictionary )
+        {
+            return true;
+        }
+    }
+    MutexHolder mh( m_InFlightJobsMutex );
+    for ( const Job * job : m_InFlightJobs )
+    {
+        if ( job->GetResultCompressionDictionary() == dictionary )
+        {
+            return true;
+        }
+    }
+    return false; // Completed jobs have already been compressed
+}
+
 // GetJobToProcess (Worker Thread)
 //------------------------------------------------------------------------------
 Job * JobQueueRemote::GetJobToProcess()
@@ -458,7 +482,7 @@ void JobQueueRemote::FinishedProcessingJob( Job * job, bool success )
     const int32_t compressionLevel = job->GetResultCompressionLevel();
     if ( compressionLevel != 0 )
     {
-        mb.Compress( compressionLevel );
+        mb.Compress( compressionLevel, job->GetResultCompressionDictionary() );
     }
 
     // transfer data to job
@@ -13,6 +13,7 @@
 
 // Forward Declarations
 //------------------------------------------------------------------------------
+class CompressionDictionary;
 class Node;
 class Job;
 class WorkerThread;
@@ -29,6 +30,7 @@ public:
     void QueueJob( Job * job );
     Job * GetCompletedJob();
     void CancelJobsWithUserData( void * userData );
+    bool IsUsingCompressionDictionary( const CompressionDictionary * dictionary ) const;
 
     // handle shutting down
     void SignalStopWorkers();
@@ -132,15 +132,17 @@ void WorkerThread::WaitForStop()
 
     for (;;)
     {
-        // Wait for work to become available (or quit signal)
-        JobQueue::Get().WorkerThreadWait( 500 );
-
         if ( m_ShouldExit.Load() || FBuild::GetStopBuild() )
         {
             break;
         }
 
-        Update();
+        // Keep working while there is work, waiting only when idle (until
+        // woken by new work or quit signal)
+        if ( Update() == false )
+        {
+            JobQueue::Get().WorkerThreadWait( 500 );
+        }
     }
 
     m_Exited.Store( true );
@@ -158,6 +160,12 @@ void WorkerThread::WaitForStop()
 //------------------------------------------------------------------------------
 /*static*/ bool WorkerThread::Update()
 {
+    // help the main thread with parallel work (stat'ing files etc)
+    if ( JobQueue::IsValid() && JobQueue::Get().HelpParallelFor() )
+    {
+        return true; // did some work
+    }
+
     // try to find some work to do
     Job * job = JobQueue::IsValid() ? JobQueue::Get().GetJobToProcess() : nullptr;
     if ( job != nullptr )
@@ -0,0 +1,6 @@
+#include "generated.h"
+
+int Function1()
+{
+    return GENERATED_VALUE;
+}
@@ -0,0 +1,6 @@
+#include "string.h"
+
+const char * Function2()
+{
+    return "Function2String";
+}
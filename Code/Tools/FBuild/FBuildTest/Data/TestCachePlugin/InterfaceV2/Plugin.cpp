@@ -0,0 +1,287 @@
+// Plugin - Test external cache plugin using the version 2 interface
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include <stdio.h>
+
+// The FASTBuild DLL Interface
+//------------------------------------------------------------------------------
+#if defined(__WINDOWS__)
+#define CACHEPLUGIN_DLL_EXPORT __declspec(dllexport)
+#elif defined(__LINUX__) || defined(__APPLE__)
+#define CACHEPLUGIN_DLL_EXPORT
+#endif
+
+#include "Tools/FBuild/FBuildCore/Cache/CachePluginInterface.h"
+
+// System
+#include <memory.h>
+#include <stdlib.h>
+
+// Globals
+//------------------------------------------------------------------------------
+CacheOutputFunc gOutputFunction = nullptr;
+char gCachePath[ 1024 ] = { 0 };
+
+// Helpers
+//------------------------------------------------------------------------------
+// Entries are stored as one file per cacheId in the cachePath
+static FILE * OpenEntry( const char * cacheId, const char * mode )
+{
+    char path[ 2048 ];
+    snprintf( path, sizeof( path ), "%s/%s", gCachePath, cacheId );
+
+    #if defined( __WINDOWS__ )
+        FILE * f = nullptr;
+        if ( fopen_s( &f, path, mode ) != 0 )
+        {
+            return nullptr;
+        }
+        return f;
+    #else
+        return fopen( path, mode );
+    #endif
+}
+
+static bool WriteEntry( const char * cacheId, const void * data, unsigned long long dataSize )
+{
+    FILE * f = OpenEntry( cacheId, "wb" );
+    if ( f == nullptr )
+    {
+        return false;
+    }
+    const bool ok = ( fwrite( data, 1, (size_t)dataSize, f ) == (size_t)dataSize );
+    fclose( f );
+    return ok;
+}
+
+static bool ReadEntry( const char * cacheId, void * & data, unsigned long long & dataSize )
+{
+    FILE * f = OpenEntry( cacheId, "rb" );
+    if ( f == nullptr )
+    {
+        return false;
+    }
+    fseek( f, 0, SEEK_END );
+    const long size = ftell( f );
+    fseek( f, 0, SEEK_SET );
+    if ( size <= 0 )
+    {
+        fclose( f );
+        return false;
+    }
+    data = malloc( (size_t)size );
+    const bool ok = ( fread( data, 1, (size_t)size, f ) == (size_t)size );
+    fclose( f );
+    if ( ok == false )
+    {
+        free( data );
+        return false;
+    }
+    dataSize = (unsigned long long)size;
+    return true;
+}
+
+// CacheInit
+//------------------------------------------------------------------------------
+extern "C" {
+
+bool STDCALL CacheInitEx( const char * cachePath,
+                          bool /*cacheRead*/,
+                          bool /*cacheWrite*/,
+                          bool /*cacheVerbose*/,
+                          const char * /*userConfig*/,
+                          CacheOutputFunc outputFunc )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    // Store output function
+    gOutputFunction = outputFunc;
+    snprintf( gCachePath, sizeof( gCachePath ), "%s", cachePath );
+
+    (*gOutputFunction)( "CacheInitEx Called" );
+    return true;
+}
+
+// CacheShutdown
+//------------------------------------------------------------------------------
+void STDCALL CacheShutdown()
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheShutdown Called" );
+}
+
+// CachePublish
+//------------------------------------------------------------------------------
+bool STDCALL CachePublish( const char * cacheId, const void * data, unsigned long long dataSize )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CachePublish Called" );
+
+    return WriteEntry( cacheId, data, dataSize );
+}
+
+// CacheRetrieve
+//------------------------------------------------------------------------------
+bool STDCALL CacheRetrieve( const char * cacheId, void * & data, unsigned long long & dataSize )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheRetrieve Called" );
+
+    return ReadEntry( cacheId, data, dataSize );
+}
+
+// CacheFreeMemory
+//------------------------------------------------------------------------------
+void STDCALL CacheFreeMemory( void * data, unsigned long long /*dataSize*/ )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheFreeMemory Called" );
+
+    free( data );
+}
+
+// CacheRetrieveBatch
+//------------------------------------------------------------------------------
+void STDCALL CacheRetrieveBatch( const char * const * cacheIds,
+                                 unsigned int count,
+                                 CacheRetrieveCompleteFunc completeFunc,
+                                 void * userData )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheRetrieveBatch Called" );
+
+    for ( unsigned int i = 0; i < count; ++i )
+    {
+        void * data = nullptr;
+        unsigned long long dataSize = 0;
+        const bool found = ReadEntry( cacheIds[ i ], data, dataSize );
+        (*completeFunc)( userData, i, found, data, dataSize );
+    }
+}
+
+// CachePublishBatch
+//------------------------------------------------------------------------------
+void STDCALL CachePublishBatch( const char * const * cacheIds,
+                                const void * const * data,
+                                const unsigned long long * dataSizes,
+                                unsigned int count,
+                                CachePublishCompleteFunc completeFunc,
+                                void * userData )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CachePublishBatch Called" );
+
+    for ( unsigned int i = 0; i < count; ++i )
+    {
+        const bool stored = WriteEntry( cacheIds[ i ], data[ i ], dataSizes[ i ] );
+        (*completeFunc)( userData, i, stored );
+    }
+}
+
+// CacheExistsBatch
+//------------------------------------------------------------------------------
+void STDCALL CacheExistsBatch( const char * const * cacheIds,
+                               unsigned int count,
+                               CacheExistsCompleteFunc completeFunc,
+                               void * userData )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheExistsBatch Called" );
+
+    for ( unsigned int i = 0; i < count; ++i )
+    {
+        FILE * f = OpenEntry( cacheIds[ i ], "rb" );
+        if ( f )
+        {
+            fclose( f );
+        }
+        (*completeFunc)( userData, i, ( f != nullptr ) );
+    }
+}
+
+// CacheRetrieveStream
+//------------------------------------------------------------------------------
+bool STDCALL CacheRetrieveStream( const char * cacheId, CacheStreamWriteFunc writeFunc, void * userData )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheRetrieveStream Called" );
+
+    FILE * f = OpenEntry( cacheId, "rb" );
+    if ( f == nullptr )
+    {
+        return false;
+    }
+
+    // Deliberately small chunks to exercise reassembly
+    char chunk[ 4096 ];
+    bool ok = true;
+    for ( ;; )
+    {
+        const size_t chunkSize = fread( chunk, 1, sizeof( chunk ), f );
+        if ( chunkSize == 0 )
+        {
+            break;
+        }
+        if ( (*writeFunc)( userData, chunk, chunkSize ) == false )
+        {
+            ok = false;
+            break;
+        }
+    }
+    fclose( f );
+    return ok;
+}
+
+// CacheOutputInfo
+//------------------------------------------------------------------------------
+bool STDCALL CacheOutputInfo( bool /*showProgress*/ )
+{
+    // DLL Export for Windows
+    #if defined( __WINDOWS__ )
+        #pragma comment(linker, "/EXPORT:" __FUNCTION__"=" __FUNCDNAME__)
+    #endif
+
+    (*gOutputFunction)( "CacheOutputInfo Called" );
+    return true; // Success
+}
+
+//------------------------------------------------------------------------------
+
+}// extern "C"
@@ -0,0 +1,5 @@
+
+int Function()
+{
+    return 100;
+}
@@ -0,0 +1,4 @@
+int Function01()
+{
+    return 1;
+}
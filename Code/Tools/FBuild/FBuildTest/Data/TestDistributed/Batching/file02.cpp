@@ -0,0 +1,4 @@
+int Function02()
+{
+    return 2;
+}
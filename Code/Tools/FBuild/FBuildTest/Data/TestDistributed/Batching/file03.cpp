@@ -0,0 +1,4 @@
+int Function03()
+{
+    return 3;
+}
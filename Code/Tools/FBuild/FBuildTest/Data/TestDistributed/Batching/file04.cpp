@@ -0,0 +1,4 @@
+int Function04()
+{
+    return 4;
+}
@@ -0,0 +1,4 @@
+int Function05()
+{
+    return 5;
+}
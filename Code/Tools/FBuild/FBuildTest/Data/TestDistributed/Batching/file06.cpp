@@ -0,0 +1,4 @@
+int Function06()
+{
+    return 6;
+}
@@ -0,0 +1,4 @@
+int Function07()
+{
+    return 7;
+}
@@ -0,0 +1,4 @@
+int Function08()
+{
+    return 8;
+}
@@ -0,0 +1,4 @@
+int Function09()
+{
+    return 9;
+}
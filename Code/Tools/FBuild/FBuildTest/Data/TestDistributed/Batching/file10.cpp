@@ -0,0 +1,4 @@
+int Function10()
+{
+    return 10;
+}
@@ -0,0 +1,4 @@
+int Function11()
+{
+    return 11;
+}
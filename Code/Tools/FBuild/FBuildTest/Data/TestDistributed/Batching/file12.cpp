@@ -0,0 +1,4 @@
+int Function12()
+{
+    return 12;
+}
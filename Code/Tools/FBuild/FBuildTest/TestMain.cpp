@@ -31,6 +31,7 @@ int main( int, char *[] )
     REGISTER_TESTGROUP( TestGraph )
     REGISTER_TESTGROUP( TestIf )
     REGISTER_TESTGROUP( TestIncludeParser )
+    REGISTER_TESTGROUP( TestJobQueue )
     REGISTER_TESTGROUP( TestLibrary )
     REGISTER_TESTGROUP( TestLinker )
     REGISTER_TESTGROUP( TestListDependencies )
@@ -10,6 +10,7 @@
 #include "Tools/FBuild/FBuildCore/FBuildOptions.h"
 #include "Tools/FBuild/FBuildCore/Graph/Node.h"
 
+#include "Core/Process/Atomic.h"
 #include "Core/Process/Mutex.h"
 
 // Forward Declarations
@@ -94,6 +95,11 @@ public:
 
     void SerializeDepGraphToText( const char * nodeName, AString & outBuffer ) const;
 
+    bool InvalidateNodes( const Array< AString > & changedFiles, const Array< AString > & changedDirs = Array< AString >() ) { return m_DependencyGraph->InvalidateNodes( changedFiles, changedDirs ); }
+
+    // Allow a JobQueue to be used outside of Build() after a previous test stopped a build
+    static void ClearStopBuild() { AtomicStoreRelaxed( &s_StopBuild, false ); }
+
     using FBuild::Build;
     virtual bool Build( Node * nodeToBuild ) override;
 };
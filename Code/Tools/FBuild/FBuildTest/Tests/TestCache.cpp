@@ -6,15 +6,28 @@
 #include "FBuildTest.h"
 
 // FBuild
+#include "Tools/FBuild/FBuildCore/Cache/Cache.h"
+#include "Tools/FBuild/FBuildCore/Cache/LightCache.h"
+#include "Tools/FBuild/FBuildCore/Cache/PackedCache.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/CompressionDictionary.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 
 // Core
+#include "Core/Containers/UniquePtr.h"
+#include "Core/Env/Env.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/PathUtils.h"
+#include "Core/Process/Thread.h"
 #include "Core/Profile/Profile.h"
 #include "Core/Strings/AStackString.h"
+#include "Core/Time/Timer.h"
+
+// system
+#include <string.h> // for memcmp
 
 // TestCache
 //------------------------------------------------------------------------------
@@ -24,9 +37,23 @@ private:
     DECLARE_TESTS
 
     void Write() const;
+    void WriteSync() const;
     void Read() const;
     void ReadWrite() const;
     void ConsistentCacheKeysWithDist() const;
+    void Cache_Verify() const;
+    void PackedCache_Basics() const;
+    void PackedCache_WriteRead() const;
+    void PackedCache_TrimCompacts() const;
+    void PackedCache_RecoverInterruptedUpdate() const;
+    void PackedCache_DeferredUsage() const;
+    void PackedCache_ConcurrentPublish() const;
+    void DependencyCacheKey() const;
+    void DependencyCacheKey_Prefetch() const;
+    void TieredCache_WriteRead() const;
+    void CompressionDictionaries() const;
+    void LibraryCaching() const;
+    void NodeOutputCaching() const;
 
     void LightCache_IncludeUsingMacro() const;
     void LightCache_IncludeUsingMacro2() const;
@@ -39,6 +66,8 @@ private:
     void LightCache_ImportDirective() const;
     void LightCache_ForceInclude() const;
     void LightCache_SourceDependencies() const;
+    void LightCache_Persistence() const;
+    void LightCache_Prefetch() const;
 
     // MSVC Static Analysis tests
     const char* const mAnalyzeMSVCBFFPath = "Tools/FBuild/FBuildTest/Data/TestCache/Analyze_MSVC/fbuild.bff";
@@ -55,6 +84,17 @@ private:
 
     // Helpers
     void CheckForDependencies( const FBuildForTest & fBuild, const char * const files[], size_t numFiles ) const;
+    void DeleteCacheFiles( const char * cachePath ) const;
+    uint64_t GetPackBytes( const char * cachePath ) const;
+    void CorruptFile( const AString & fileName, size_t newSize ) const;
+    struct PackedCachePublishThreadData
+    {
+        const char *    m_CachePath;
+        uint32_t        m_ThreadIndex;
+        bool            m_OK;
+    };
+    static uint32_t PackedCachePublishThreadFunc( void * userData );
+    static void GetPackedCacheTestData( uint32_t threadIndex, uint32_t entryIndex, AString & outCacheId, AString & outData );
     void LightCache_IncludeUsingUndefinedMacros( const char * consfigFile,
                                                  bool expectedBuildResult,
                                                  bool expectedLightCacheUsage,
@@ -67,10 +107,26 @@ private:
 //------------------------------------------------------------------------------
 REGISTER_TESTS_BEGIN( TestCache )
     REGISTER_TEST( Write )
+    REGISTER_TEST( WriteSync )
     REGISTER_TEST( Read )
     REGISTER_TEST( ReadWrite )
     REGISTER_TEST( ConsistentCacheKeysWithDist )
+    REGISTER_TEST( Cache_Verify )
+    REGISTER_TEST( PackedCache_Basics )
+    REGISTER_TEST( PackedCache_WriteRead )
+    REGISTER_TEST( PackedCache_TrimCompacts )
+    REGISTER_TEST( PackedCache_RecoverInterruptedUpdate )
+    REGISTER_TEST( PackedCache_DeferredUsage )
+    REGISTER_TEST( PackedCache_ConcurrentPublish )
+    REGISTER_TEST( TieredCache_WriteRead )
+    REGISTER_TEST( CompressionDictionaries )
+    REGISTER_TEST( LibraryCaching )
+    REGISTER_TEST( NodeOutputCaching )
     REGISTER_TEST( ExtraFiles_GCNO )
+    #if !defined( __WINDOWS__ )
+        REGISTER_TEST( DependencyCacheKey ) // GCC/Clang only
+        REGISTER_TEST( DependencyCacheKey_Prefetch )
+    #endif
     #if defined( __WINDOWS__ )
         REGISTER_TEST( ExtraFiles_NativeCodeAnalysisXML )
         REGISTER_TEST( LightCache_IncludeUsingMacro )
@@ -84,6 +140,8 @@ REGISTER_TESTS_BEGIN( TestCache )
         REGISTER_TEST( LightCache_ImportDirective )
         REGISTER_TEST( LightCache_ForceInclude )
         REGISTER_TEST( LightCache_SourceDependencies )
+        REGISTER_TEST( LightCache_Persistence )
+        REGISTER_TEST( LightCache_Prefetch )
         REGISTER_TEST( Analyze_MSVC_WarningsOnly_Write )
         REGISTER_TEST( Analyze_MSVC_WarningsOnly_Read )
 
@@ -119,6 +177,11 @@ void TestCache::Write() const
         TEST_ASSERT( objStats.m_NumCacheStores == objStats.m_NumProcessed );
         TEST_ASSERT( objStats.m_NumBuilt == objStats.m_NumProcessed );
 
+        // Ensure writes were made in the background, and completed by the end of the build
+        const CacheWriteStats & writeStats = fBuild.GetStats().m_CacheWriteStats;
+        TEST_ASSERT( writeStats.m_NumQueued == objStats.m_NumCacheStores );
+        TEST_ASSERT( writeStats.m_NumPublished == objStats.m_NumCacheStores );
+
         numDepsA = fBuild.GetRecursiveDependencyCount( "ObjectList" );
         TEST_ASSERT( numDepsA > 0 );
     }
@@ -152,6 +215,27 @@ void TestCache::Write() const
     #endif
 }
 
+// WriteSync
+//------------------------------------------------------------------------------
+void TestCache::WriteSync() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/cache.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_UseCacheWrite = true;
+    options.m_CacheWriteSync = true;
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+    // Ensure cache was written to, without using the background queue
+    const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+    TEST_ASSERT( objStats.m_NumCacheStores == objStats.m_NumProcessed );
+    TEST_ASSERT( fBuild.GetStats().m_CacheWriteStats.m_NumQueued == 0 );
+}
+
 // Read
 //------------------------------------------------------------------------------
 void TestCache::Read() const
@@ -881,6 +965,152 @@ void TestCache::LightCache_SourceDependencies() const
     TEST_ASSERT( GetRecordedOutput().Find( "LightCache is incompatible with -sourceDependencies" ) );
 }
 
+// LightCache_Prefetch
+//------------------------------------------------------------------------------
+void TestCache::LightCache_Prefetch() const
+{
+    FBuildTestOptions options;
+    options.m_CacheVerbose = true;
+    options.m_ForceCleanBuild = true;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/LightCache_IncludeHierarchy/fbuild.bff";
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == 2 );
+    }
+
+    // Read with prefetching
+    {
+        options.m_UseCacheRead = true;
+        options.m_UseCacheWrite = false;
+        options.m_CachePrefetch = true;
+        options.m_CachePrefetchWait_Debug = true; // Don't let build threads get there first
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        TEST_ASSERT( fBuild.GetStats().GetLightCacheCount() == objStats.m_NumCacheHits );
+
+        // Everything was prefetched, and keys and results were consumed
+        const CachePrefetchStats & prefetchStats = fBuild.GetStats().m_CachePrefetchStats;
+        TEST_ASSERT( prefetchStats.m_NumQueued == 2 );
+        TEST_ASSERT( prefetchStats.m_NumRequested == 2 );
+        TEST_ASSERT( prefetchStats.m_NumHits == 2 );
+        TEST_ASSERT( prefetchStats.m_NumUsed == 2 );
+        TEST_ASSERT( prefetchStats.m_NumKeysReused == 2 );
+        TEST_ASSERT( prefetchStats.m_NumWasted == 0 );
+    }
+}
+
+// LightCache_Persistence
+//------------------------------------------------------------------------------
+void TestCache::LightCache_Persistence() const
+{
+    FBuildTestOptions options;
+    options.m_CacheVerbose = true;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/LightCache_IncludeHierarchy/fbuild.bff";
+
+    const char * const expectedFiles[] = { "Folder1/file.cpp", "Folder1/file.h", "Folder2/file.cpp", "Folder2/file.h", "common.h" };
+    const char * const dataFile = "../tmp/Test/Cache/LightCache_Persistence/fbuild.fdb.lightcache";
+    EnsureFileDoesNotExist( dataFile );
+
+    // Write, saving parse results
+    {
+        options.m_UseCacheRead = false;
+        options.m_UseCacheWrite = true;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == 2 );
+        TEST_ASSERT( LightCache::GetNumFilesReused() == 0 );
+        TEST_ASSERT( LightCache::GetNumFilesParsed() == 5 );
+
+        TEST_ASSERT( LightCache::SavePersistentData( AStackString<>( dataFile ) ) );
+        EnsureFileExists( dataFile );
+    }
+
+    // Detect re-writing of the data by changing the time
+    const uint64_t dataFileTime = ( FileIO::GetFileLastWriteTime( AStackString<>( dataFile ) ) - 1000000000 );
+    TEST_ASSERT( FileIO::SetFileLastWriteTime( AStackString<>( dataFile ), dataFileTime ) );
+
+    // Read, re-using saved parse results
+    {
+        options.m_UseCacheRead = true;
+        options.m_UseCacheWrite = false;
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( LightCache::LoadPersistentData( AStackString<>( dataFile ) ) );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        // Results must be identical to parsing the files
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        TEST_ASSERT( fBuild.GetStats().GetLightCacheCount() == objStats.m_NumCacheHits );
+        TEST_ASSERT( LightCache::GetNumFilesReused() >= 5 ); // Includes files checked for in other include paths
+        TEST_ASSERT( LightCache::GetNumFilesParsed() == 0 );
+
+        CheckForDependencies( fBuild, expectedFiles, sizeof( expectedFiles ) / sizeof( const char * ) );
+
+        // Nothing changed, so data is not re-written
+        TEST_ASSERT( LightCache::SavePersistentData( AStackString<>( dataFile ) ) );
+        TEST_ASSERT( FileIO::GetFileLastWriteTime( AStackString<>( dataFile ) ) == dataFileTime );
+    }
+
+    // Modified header is re-parsed
+    {
+        const AStackString<> header( "Tools/FBuild/FBuildTest/Data/TestCache/LightCache_IncludeHierarchy/common.h" );
+        const uint64_t headerTime = FileIO::GetFileLastWriteTime( header );
+        TEST_ASSERT( FileIO::SetFileLastWriteTimeToNow( header ) );
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( LightCache::LoadPersistentData( AStackString<>( dataFile ) ) );
+        const bool buildOK = fBuild.Build( "ObjectList" );
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( header, headerTime ) );
+        TEST_ASSERT( buildOK );
+
+        // Contents are unchanged, so cache is still hit
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        TEST_ASSERT( LightCache::GetNumFilesParsed() == 1 );
+        TEST_ASSERT( LightCache::GetNumFilesReused() >= 4 );
+
+        // Data is re-written with the new time
+        TEST_ASSERT( LightCache::SavePersistentData( AStackString<>( dataFile ) ) );
+        TEST_ASSERT( FileIO::GetFileLastWriteTime( AStackString<>( dataFile ) ) != dataFileTime );
+    }
+
+    // Corrupt data is discarded
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( dataFile, FileStream::WRITE_ONLY ) );
+        TEST_ASSERT( f.WriteBuffer( "LCD", 3 ) == 3 );
+        f.Close();
+
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( LightCache::LoadPersistentData( AStackString<>( dataFile ) ) == false );
+    }
+}
+
 // Analyze_MSVC_WarningsOnly_Write
 //------------------------------------------------------------------------------
 void TestCache::Analyze_MSVC_WarningsOnly_Write() const
@@ -1112,29 +1342,1067 @@ void TestCache::ExtraFiles_GCNO() const
                 "../tmp/Test/Cache/ExtraFiles_GCNO/file.gcno" );
 }
 
-// CheckForDependencies
+// Cache_Verify
 //------------------------------------------------------------------------------
-void TestCache::CheckForDependencies( const FBuildForTest & fBuild, const char * const files[], size_t numFiles ) const
+void TestCache::Cache_Verify() const
 {
-    Array< const Node * > nodes;
-    fBuild.GetNodesOfType( Node::FILE_NODE, nodes );
-    for ( size_t i = 0; i < numFiles; ++i )
+    const char * const cachePath = "../tmp/Test/Cache/Cache_Verify/";
+    DeleteCacheFiles( cachePath );
+
+    const AStackString<> idA( "AABB0001" );
+    const AStackString<> idB( "AABB0002" );
+    const AStackString<> idC( "CCDD0003" );
+    const AStackString<> data( "Some data to be stored in the cache" );
+
+    Cache cache;
+    TEST_ASSERT( cache.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+    TEST_ASSERT( cache.Publish( idA, data.Get(), data.GetLength() ) );
+    TEST_ASSERT( cache.Publish( idB, data.Get(), data.GetLength() ) );
+    TEST_ASSERT( cache.Publish( idC, data.Get(), data.GetLength() ) );
+
+    AStackString<> fileB;
+    AStackString<> fileC;
+    fileB.Format( "%sAA%cBB%c%s", cachePath, NATIVE_SLASH, NATIVE_SLASH, idB.Get() );
+    fileC.Format( "%sCC%cDD%c%s", cachePath, NATIVE_SLASH, NATIVE_SLASH, idC.Get() );
+    AStackString<> quarantinedB;
+    AStackString<> quarantinedC;
+    quarantinedB.Format( "%sQuarantine%c%s", cachePath, NATIVE_SLASH, idB.Get() );
+    quarantinedC.Format( "%sQuarantine%c%s", cachePath, NATIVE_SLASH, idC.Get() );
+
+    // Intact entry
     {
-        AStackString<> file( files[ i ] );
-        #if defined( __WINDOWS__ )
-            file.Replace( '/', '\\' ); // Allow calling code to not have to care about the platform
-        #endif
-        bool found = false;
-        for ( const Node * node : nodes )
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( idA, retrievedData, retrievedSize ) );
+        TEST_ASSERT( ( retrievedSize == data.GetLength() ) && ( memcmp( retrievedData, data.Get(), retrievedSize ) == 0 ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    // Corrupt entry is a miss, and is moved aside
+    CorruptFile( fileB, 0 );
+    {
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( idB, retrievedData, retrievedSize ) == false );
+        TEST_ASSERT( retrievedData == nullptr );
+    }
+    TEST_ASSERT( FileIO::FileExists( fileB.Get() ) == false );
+    TEST_ASSERT( FileIO::FileExists( quarantinedB.Get() ) );
+
+    // Cost of checks is recorded
+    CacheVerifyStats stats;
+    cache.GetAndResetVerifyStats( stats );
+    TEST_ASSERT( stats.m_NumVerified == 2 );
+    TEST_ASSERT( stats.m_NumCorrupt == 1 );
+    TEST_ASSERT( stats.m_VerifiedBytes == ( data.GetLength() * 2 ) );
+
+    // Entry can be replaced
+    TEST_ASSERT( cache.Publish( idB, data.Get(), data.GetLength() ) );
+    {
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( idB, retrievedData, retrievedSize ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    // Scan finds truncated entries
+    CorruptFile( fileC, 10 );
+    TEST_ASSERT( cache.Verify( false ) );
+    TEST_ASSERT( FileIO::FileExists( fileC.Get() ) == false );
+    TEST_ASSERT( FileIO::FileExists( quarantinedC.Get() ) );
+    TEST_ASSERT( FileIO::FileExists( fileB.Get() ) );
+
+    // Quarantined entries are reported and trimmed
+    TEST_ASSERT( cache.OutputInfo( false ) );
+    TEST_ASSERT( cache.Trim( false, 0 ) );
+    TEST_ASSERT( FileIO::FileExists( quarantinedB.Get() ) == false );
+    TEST_ASSERT( FileIO::FileExists( quarantinedC.Get() ) == false );
+
+    cache.Shutdown();
+}
+
+// PackedCache_Basics
+//------------------------------------------------------------------------------
+void TestCache::PackedCache_Basics() const
+{
+    const AStackString<> cachePath( "../tmp/Test/Cache/PackedCache_Basics/" );
+    Array< AString > oldFiles;
+    FileIO::GetFiles( cachePath, AStackString<>( "*" ), false, &oldFiles );
+    for ( const AString & oldFile : oldFiles )
+    {
+        FileIO::FileDelete( oldFile.Get() );
+    }
+
+    // Enough entries to grow the index several times
+    const uint32_t numEntries = 10000;
+    AStackString<> cacheId;
+    AStackString<> data;
+
+    PackedCache cache;
+    TEST_ASSERT( cache.Init( cachePath, AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        data.Format( "Data%u", i );
+        TEST_ASSERT( cache.Publish( cacheId, data.Get(), data.GetLength() ) );
+    }
+
+    // Retrieve all entries
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        data.Format( "Data%u", i );
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( cacheId, retrievedData, retrievedSize ) );
+        TEST_ASSERT( ( retrievedSize == data.GetLength() ) && ( memcmp( retrievedData, data.Get(), retrievedSize ) == 0 ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    // Missing entry
+    {
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( AStackString<>( "Missing" ), retrievedData, retrievedSize ) == false );
+        TEST_ASSERT( retrievedData == nullptr );
+    }
+
+    // Replace an entry
+    const AStackString<> replacedData( "ReplacedData" );
+    TEST_ASSERT( cache.Publish( AStackString<>( "Entry0" ), replacedData.Get(), replacedData.GetLength() ) );
+
+    // A second instance (as used by another process) sees the same entries
+    {
+        PackedCache cache2;
+        TEST_ASSERT( cache2.Init( cachePath, AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache2.Retrieve( AStackString<>( "Entry0" ), retrievedData, retrievedSize ) );
+        TEST_ASSERT( ( retrievedSize == replacedData.GetLength() ) && ( memcmp( retrievedData, replacedData.Get(), retrievedSize ) == 0 ) );
+        cache2.FreeMemory( retrievedData, retrievedSize );
+
+        // Add more entries, growing the index again
+        for ( uint32_t i = numEntries; i < ( numEntries * 2 ); ++i )
         {
-            if ( node->GetName().EndsWith( file ) )
-            {
-                found = true;
-                break;
-            }
+            cacheId.Format( "Entry%u", i );
+            data.Format( "Data%u", i );
+            TEST_ASSERT( cache2.Publish( cacheId, data.Get(), data.GetLength() ) );
         }
-        TEST_ASSERTM( found, "Missing dependency: %s", files[ i ] );
+
+        cache2.Shutdown();
+    }
+
+    // Entries added by the other instance are visible
+    for ( uint32_t i = 1; i < ( numEntries * 2 ); i += 97 )
+    {
+        cacheId.Format( "Entry%u", i );
+        data.Format( "Data%u", i );
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( cacheId, retrievedData, retrievedSize ) );
+        TEST_ASSERT( ( retrievedSize == data.GetLength() ) && ( memcmp( retrievedData, data.Get(), retrievedSize ) == 0 ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    // Trim everything
+    TEST_ASSERT( cache.Trim( false, 0 ) );
+    {
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( AStackString<>( "Entry0" ), retrievedData, retrievedSize ) == false );
+    }
+    Array< AString > packFiles;
+    FileIO::GetFiles( cachePath, AStackString<>( "*.fpk" ), false, &packFiles );
+    TEST_ASSERT( packFiles.IsEmpty() );
+
+    // Cache is still usable after trimming
+    TEST_ASSERT( cache.Publish( AStackString<>( "Entry0" ), replacedData.Get(), replacedData.GetLength() ) );
+    {
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( AStackString<>( "Entry0" ), retrievedData, retrievedSize ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    cache.Shutdown();
+}
+
+// PackedCache_WriteRead
+//------------------------------------------------------------------------------
+void TestCache::PackedCache_WriteRead() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/PackedCache/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == objStats.m_NumProcessed );
+        TEST_ASSERT( objStats.m_NumBuilt == objStats.m_NumProcessed );
+    }
+
+    // Read
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == objStats.m_NumProcessed );
+        TEST_ASSERT( objStats.m_NumBuilt == 0 );
+    }
+}
+
+// PackedCache_TrimCompacts
+//------------------------------------------------------------------------------
+void TestCache::PackedCache_TrimCompacts() const
+{
+    const char * const cachePath = "../tmp/Test/Cache/PackedCache_TrimCompacts/";
+    DeleteCacheFiles( cachePath );
+
+    // Entries share a single pack
+    const uint32_t numEntries = 16;
+    const uint32_t entrySize = ( 256 * 1024 );
+    AString data;
+    data.SetLength( entrySize );
+    AStackString<> cacheId;
+
+    PackedCache cache;
+    TEST_ASSERT( cache.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        memset( data.Get(), (int)( 'A' + i ), entrySize );
+        TEST_ASSERT( cache.Publish( cacheId, data.Get(), entrySize ) );
+    }
+
+    // Make second half most recently used
+    for ( uint32_t i = ( numEntries / 2 ); i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( cacheId, retrievedData, retrievedSize ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    // Trim to half. Only the least recently used entries should be evicted, with
+    // the space they used reclaimed from the (still partially used) pack.
+    const uint32_t halfSizeMiB = ( ( numEntries / 2 ) * entrySize ) / MEGABYTE;
+    TEST_ASSERT( cache.Trim( false, halfSizeMiB ) );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        const bool hit = cache.Retrieve( cacheId, retrievedData, retrievedSize );
+        TEST_ASSERT( hit == ( i >= ( numEntries / 2 ) ) );
+        if ( hit )
+        {
+            memset( data.Get(), (int)( 'A' + i ), entrySize );
+            TEST_ASSERT( ( retrievedSize == entrySize ) && ( memcmp( retrievedData, data.Get(), entrySize ) == 0 ) );
+            cache.FreeMemory( retrievedData, retrievedSize );
+        }
+    }
+
+    // Pack files are within the limit
+    TEST_ASSERT( GetPackBytes( cachePath ) == ( ( numEntries / 2 ) * entrySize ) );
+
+    // Enforcing the limit does nothing while under it
+    TEST_ASSERT( cache.EnforceSizeLimit( halfSizeMiB ) );
+    Array< AString > cacheIds;
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheIds.EmplaceBack().Format( "Entry%u", i );
+    }
+    Array< bool > exists;
+    cache.ExistsBatch( cacheIds, exists );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        TEST_ASSERT( exists[ i ] == ( i >= ( numEntries / 2 ) ) );
+    }
+
+    // Once over the limit, only the least recently used entries are evicted,
+    // leaving some headroom below the limit
+    const uint32_t numNewEntries = 40; // 12 MiB in total
+    for ( uint32_t i = numEntries; i < ( numEntries + numNewEntries ); ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        memset( data.Get(), (int)( 'A' + ( i % 26 ) ), entrySize );
+        TEST_ASSERT( cache.Publish( cacheId, data.Get(), entrySize ) );
+        cacheIds.EmplaceBack( cacheId );
+    }
+    TEST_ASSERT( cache.EnforceSizeLimit( 10 ) ); // Trims to 9 MiB (36 entries)
+    cache.ExistsBatch( cacheIds, exists );
+    for ( uint32_t i = 0; i < ( numEntries + numNewEntries ); ++i )
+    {
+        TEST_ASSERT( exists[ i ] == ( i >= ( numEntries + numNewEntries - 36 ) ) );
+    }
+
+    cache.Shutdown();
+}
+
+// PackedCache_RecoverInterruptedUpdate
+//------------------------------------------------------------------------------
+void TestCache::PackedCache_RecoverInterruptedUpdate() const
+{
+    const char * const cachePath = "../tmp/Test/Cache/PackedCache_RecoverInterruptedUpdate/";
+    DeleteCacheFiles( cachePath );
+
+    const uint32_t numEntries = 100;
+    AStackString<> cacheId;
+    AStackString<> data;
+    {
+        PackedCache cache;
+        TEST_ASSERT( cache.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+        for ( uint32_t i = 0; i < numEntries; ++i )
+        {
+            cacheId.Format( "Entry%u", i );
+            data.Format( "Data%u", i );
+            TEST_ASSERT( cache.Publish( cacheId, data.Get(), data.GetLength() ) );
+        }
+        cache.Shutdown();
+    }
+
+    // Simulate a process terminating while modifying the index, part way
+    // through writing the last entry
+    Array< AString > indexFiles;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( "*.idx" ), false, &indexFiles );
+    TEST_ASSERT( indexFiles.GetSize() == 1 );
+    {
+        AString contents;
+        {
+            FileStream f;
+            TEST_ASSERT( f.Open( indexFiles[ 0 ].Get(), FileStream::READ_ONLY ) );
+            contents.SetLength( (uint32_t)f.GetFileSize() );
+            TEST_ASSERT( f.ReadBuffer( contents.Get(), contents.GetLength() ) == contents.GetLength() );
+        }
+        const uint32_t updateInProgress = 1;
+        memcpy( contents.Get() + 16, &updateInProgress, sizeof( updateInProgress ) ); // PackedCacheIndexHeader::m_UpdateInProgress
+        FileStream f;
+        TEST_ASSERT( f.Open( indexFiles[ 0 ].Get(), FileStream::WRITE_ONLY ) );
+        TEST_ASSERT( f.WriteBuffer( contents.Get(), contents.GetLength() ) == contents.GetLength() );
+    }
+    Array< AString > packFiles;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( "*.fpk" ), false, &packFiles );
+    TEST_ASSERT( packFiles.GetSize() == 1 );
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( packFiles[ 0 ].Get(), FileStream::READ_ONLY ) );
+        const size_t packSize = (size_t)f.GetFileSize();
+        f.Close();
+        CorruptFile( packFiles[ 0 ], packSize - 1 );
+    }
+
+    // An unreferenced pack (e.g. left by a previous failure) is removed
+    AStackString<> orphanedPack( cachePath );
+    orphanedPack += "PackFFFFFF00.fpk";
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( orphanedPack.Get(), FileStream::WRITE_ONLY ) );
+        TEST_ASSERT( f.WriteBuffer( "Orphaned", 8 ) == 8 );
+    }
+
+    // Index is recovered, keeping all complete entries
+    PackedCache cache;
+    TEST_ASSERT( cache.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        data.Format( "Data%u", i );
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        const bool hit = cache.Retrieve( cacheId, retrievedData, retrievedSize );
+        TEST_ASSERT( hit == ( i < ( numEntries - 1 ) ) );
+        if ( hit )
+        {
+            TEST_ASSERT( ( retrievedSize == data.GetLength() ) && ( memcmp( retrievedData, data.Get(), retrievedSize ) == 0 ) );
+            cache.FreeMemory( retrievedData, retrievedSize );
+        }
+    }
+    TEST_ASSERT( FileIO::FileExists( orphanedPack.Get() ) == false );
+
+    // Cache remains writable
+    TEST_ASSERT( cache.Publish( AStackString<>( "NewEntry" ), "NewData", 7 ) );
+    {
+        void * retrievedData = nullptr;
+        size_t retrievedSize = 0;
+        TEST_ASSERT( cache.Retrieve( AStackString<>( "NewEntry" ), retrievedData, retrievedSize ) );
+        cache.FreeMemory( retrievedData, retrievedSize );
+    }
+
+    cache.Shutdown();
+}
+
+// PackedCache_DeferredUsage
+//------------------------------------------------------------------------------
+void TestCache::PackedCache_DeferredUsage() const
+{
+    const char * const cachePath = "../tmp/Test/Cache/PackedCache_DeferredUsage/";
+    DeleteCacheFiles( cachePath );
+
+    const uint32_t numEntries = 16;
+    const uint32_t entrySize = ( 256 * 1024 );
+    AString data;
+    data.SetLength( entrySize );
+    AStackString<> cacheId;
+
+    PackedCache cache;
+    TEST_ASSERT( cache.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheId.Format( "Entry%u", i );
+        memset( data.Get(), (int)( 'A' + i ), entrySize );
+        TEST_ASSERT( cache.Publish( cacheId, data.Get(), entrySize ) );
+    }
+
+    // Another instance (as used by another process) retrieves the second half.
+    // Retrievals only share the index lock, with usage recorded later.
+    {
+        PackedCache cache2;
+        TEST_ASSERT( cache2.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+        for ( uint32_t i = ( numEntries / 2 ); i < numEntries; ++i )
+        {
+            cacheId.Format( "Entry%u", i );
+            void * retrievedData = nullptr;
+            size_t retrievedSize = 0;
+            TEST_ASSERT( cache2.Retrieve( cacheId, retrievedData, retrievedSize ) );
+            cache2.FreeMemory( retrievedData, retrievedSize );
+        }
+        cache2.Shutdown(); // Records usage
+    }
+
+    // Trim to half. Usage recorded by the other instance protects the second half.
+    const uint32_t halfSizeMiB = ( ( numEntries / 2 ) * entrySize ) / MEGABYTE;
+    TEST_ASSERT( cache.Trim( false, halfSizeMiB ) );
+    Array< AString > cacheIds;
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        cacheIds.EmplaceBack().Format( "Entry%u", i );
+    }
+    Array< bool > exists;
+    cache.ExistsBatch( cacheIds, exists );
+    for ( uint32_t i = 0; i < numEntries; ++i )
+    {
+        TEST_ASSERT( exists[ i ] == ( i >= ( numEntries / 2 ) ) );
+    }
+
+    cache.Shutdown();
+}
+
+// PackedCache_ConcurrentPublish
+//------------------------------------------------------------------------------
+void TestCache::PackedCache_ConcurrentPublish() const
+{
+    const char * const cachePath = "../tmp/Test/Cache/PackedCache_ConcurrentPublish/";
+    DeleteCacheFiles( cachePath );
+
+    // Several instances (as used by several processes) write to the same pack at once
+    const uint32_t numThreads = 4;
+    PackedCachePublishThreadData threadData[ numThreads ];
+    Thread threads[ numThreads ];
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        threadData[ i ].m_CachePath = cachePath;
+        threadData[ i ].m_ThreadIndex = i;
+        threadData[ i ].m_OK = false;
+        threads[ i ].Start( PackedCachePublishThreadFunc, "PackedCachePublish", &threadData[ i ] );
+    }
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        threads[ i ].Join();
+        TEST_ASSERT( threadData[ i ].m_OK );
+    }
+
+    // All entries are intact, with no space lost to overlapping writes
+    PackedCache cache;
+    TEST_ASSERT( cache.Init( AStackString<>( cachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() ) );
+    AStackString<> cacheId;
+    AString data;
+    uint64_t totalSize = 0;
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        for ( uint32_t j = 0; j < 100; ++j )
+        {
+            GetPackedCacheTestData( i, j, cacheId, data );
+            void * retrievedData = nullptr;
+            size_t retrievedSize = 0;
+            TEST_ASSERT( cache.Retrieve( cacheId, retrievedData, retrievedSize ) );
+            TEST_ASSERT( ( retrievedSize == data.GetLength() ) && ( memcmp( retrievedData, data.Get(), retrievedSize ) == 0 ) );
+            cache.FreeMemory( retrievedData, retrievedSize );
+            totalSize += data.GetLength();
+        }
+    }
+    TEST_ASSERT( GetPackBytes( cachePath ) == totalSize );
+
+    cache.Shutdown();
+}
+
+// TieredCache_WriteRead
+//------------------------------------------------------------------------------
+void TestCache::TieredCache_WriteRead() const
+{
+    const char * const localCachePath = "../tmp/Test/Cache/TieredCache/Local/";
+    DeleteCacheFiles( localCachePath );
+    DeleteCacheFiles( "../tmp/Test/Cache/TieredCache/Remote/" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/TieredCache/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    // Write - stored locally and remotely
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == 2 );
+        const TieredCacheStats & tierStats = fBuild.GetStats().m_TieredCacheStats;
+        TEST_ASSERT( tierStats.m_NumRemoteStores == 2 );
+        TEST_ASSERT( tierStats.m_NumRemoteFailed == 0 );
+
+        // Stores are queued once, in front of both tiers
+        const CacheWriteStats & writeStats = fBuild.GetStats().m_CacheWriteStats;
+        TEST_ASSERT( writeStats.m_NumQueued == 2 );
+    }
+
+    // Write - synchronously
+    {
+        options.m_CacheWriteSync = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        options.m_CacheWriteSync = false;
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == 2 );
+        const TieredCacheStats & tierStats = fBuild.GetStats().m_TieredCacheStats;
+        TEST_ASSERT( tierStats.m_NumRemoteStores == 2 );
+        TEST_ASSERT( fBuild.GetStats().m_CacheWriteStats.m_NumQueued == 0 );
+    }
+
+    // Lose local cache
+    DeleteCacheFiles( localCachePath );
+
+    // Read - remote hits are promoted to local cache
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        const TieredCacheStats & tierStats = fBuild.GetStats().m_TieredCacheStats;
+        TEST_ASSERT( tierStats.m_NumLocalHits == 0 );
+        TEST_ASSERT( tierStats.m_NumRemoteHits == 2 );
+        TEST_ASSERT( tierStats.m_NumPromoted == 2 );
+    }
+
+    // Read - local hits
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        const TieredCacheStats & tierStats = fBuild.GetStats().m_TieredCacheStats;
+        TEST_ASSERT( tierStats.m_NumLocalHits == 2 );
+        TEST_ASSERT( tierStats.m_NumRemoteHits == 0 );
+    }
+
+    // Lose remote cache
+    DeleteCacheFiles( "../tmp/Test/Cache/TieredCache/Remote/" );
+    const uint64_t localPackBytes = GetPackBytes( localCachePath );
+    TEST_ASSERT( localPackBytes > 0 );
+
+    // Write - only stored to the tier missing the entries
+    {
+        options.m_UseCacheRead = false;
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const CacheWriteStats & writeStats = fBuild.GetStats().m_CacheWriteStats;
+        TEST_ASSERT( writeStats.m_NumQueued == 2 );
+        TEST_ASSERT( writeStats.m_NumAlreadyPresent == 0 );
+        const TieredCacheStats & tierStats = fBuild.GetStats().m_TieredCacheStats;
+        TEST_ASSERT( tierStats.m_NumRemoteStores == 2 );
+
+        // No second copy was appended to the local packs
+        TEST_ASSERT( GetPackBytes( localCachePath ) == localPackBytes );
+    }
+}
+
+// CompressionDictionaries
+//------------------------------------------------------------------------------
+void TestCache::CompressionDictionaries() const
+{
+    const char * const cachePath = "../tmp/Test/Cache/CompressionDictionary/Cache/";
+    const char * const dictionaryFile = "../tmp/Test/Cache/CompressionDictionary/Dictionaries/Objects.lz4dict";
+    DeleteCacheFiles( cachePath );
+    DeleteCacheFiles( "../tmp/Test/Cache/CompressionDictionary/Dictionaries/" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/CompressionDictionary/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    // Populate cache (no dictionaries yet)
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.GetCompressionDictionary( CompressionDictionary::OBJECTS ) == nullptr );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheStores == 2 );
+    }
+
+    // Train
+    {
+        FBuildTestOptions trainOptions( options );
+        trainOptions.m_UseCacheWrite = false;
+        trainOptions.m_CacheTrain = true;
+        FBuildForTest fBuild( trainOptions );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.CacheTrain() );
+        TEST_ASSERT( FileIO::FileExists( dictionaryFile ) );
+    }
+
+    // Write - entries are compressed using the dictionary
+    DeleteCacheFiles( cachePath );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.GetCompressionDictionary( CompressionDictionary::OBJECTS ) );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheStores == 2 );
+    }
+
+    // Read
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheHits == 2 );
+    }
+
+    // Distributed - dictionaries are sent to the worker for job data and results
+    {
+        FBuildTestOptions distOptions( options );
+        distOptions.m_UseCacheRead = false;
+        distOptions.m_AllowDistributed = true;
+        distOptions.m_AllowLocalRace = false;
+        distOptions.m_NoLocalConsumptionOfRemoteJobs = true;
+
+        // Worker is created after loading the graph (loading is single threaded)
+        // but must outlive the client
+        UniquePtr< Server, DeleteDeletor > server;
+        uint64_t dictionaryId = 0;
+        {
+            FBuildForTest fBuild( distOptions );
+            TEST_ASSERT( fBuild.Initialize() );
+            dictionaryId = fBuild.GetCompressionDictionary( CompressionDictionary::OBJECTS )->GetId();
+
+            server = FNEW( Server );
+            server->Listen( Protocol::PROTOCOL_TEST_PORT );
+
+            TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+            TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumBuilt == 2 );
+            TEST_ASSERT( fBuild.GetStats().m_TotalRemoteCPUTimeMS > 0 );
+        }
+
+        // Worker releases dictionaries once no connected client uses them
+        const Timer timer;
+        while ( CompressionDictionary::Find( dictionaryId ) && ( timer.GetElapsed() < 10.0f ) )
+        {
+            Thread::Sleep( 10 );
+        }
+        TEST_ASSERT( CompressionDictionary::Find( dictionaryId ) == nullptr );
+    }
+
+    // Read without the dictionary - entries which need it are a clean miss
+    FileIO::FileDelete( dictionaryFile );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.GetCompressionDictionary( CompressionDictionary::OBJECTS ) == nullptr );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheHits == 0 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE ).m_NumCacheMisses == 2 );
+        TEST_ASSERT( GetRecordedOutput().Find( "Cache returned invalid data" ) == nullptr );
+    }
+}
+
+// LibraryCaching
+//------------------------------------------------------------------------------
+void TestCache::LibraryCaching() const
+{
+    DeleteCacheFiles( "../tmp/Test/Cache/LibraryCaching/Cache/" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/LibraryCaching/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Library" ) );
+
+        const FBuildStats::Stats & libStats = fBuild.GetStats().GetStatsFor( Node::LIBRARY_NODE );
+        TEST_ASSERT( libStats.m_NumCacheStores == 1 );
+        TEST_ASSERT( libStats.m_NumBuilt == 1 );
+    }
+
+    // Read - library is retrieved instead of being created
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "Library" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        const FBuildStats::Stats & libStats = fBuild.GetStats().GetStatsFor( Node::LIBRARY_NODE );
+        TEST_ASSERT( libStats.m_NumCacheHits == 1 );
+        TEST_ASSERT( libStats.m_NumBuilt == 0 );
+        TEST_ASSERT( FileIO::FileExists( "../tmp/Test/Cache/LibraryCaching/library.lib" ) );
+    }
+}
+
+// NodeOutputCaching
+//------------------------------------------------------------------------------
+void TestCache::NodeOutputCaching() const
+{
+    DeleteCacheFiles( "../tmp/Test/Cache/NodeOutputCaching/Cache/" );
+
+    // Inputs for each cached node
+    const char * const execInput = "../tmp/Test/Cache/NodeOutputCaching/Input/exec_input.txt";
+    const char * const testInput = "../tmp/Test/Cache/NodeOutputCaching/Input/test_input.txt";
+    const char * const additionalInput = "../tmp/Test/Cache/NodeOutputCaching/Input/additional.cpp";
+    EnsureDirExists( "../tmp/Test/Cache/NodeOutputCaching/Input/" );
+    MakeFile( execInput, "1" );
+    MakeFile( testInput, "1" );
+    MakeFile( additionalInput, "int Additional() { return 1; }\n" );
+    Env::SetEnvVariable( "NODE_OUTPUT_CACHING_ENV", AString( "1" ) );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/NodeOutputCaching/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "All" ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::EXEC_NODE ).m_NumCacheStores == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::TEST_NODE ).m_NumCacheStores == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::LIBRARY_NODE ).m_NumCacheStores == 1 );
+    }
+
+    // Read - everything is retrieved
+    options.m_UseCacheWrite = false;
+    options.m_UseCacheRead = true;
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "All" ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::EXEC_NODE ).m_NumCacheHits == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::TEST_NODE ).m_NumCacheHits == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::LIBRARY_NODE ).m_NumCacheHits == 1 );
+    }
+
+    // Change an input of each node (including an object from LibrarianAdditionalInputs)
+    MakeFile( execInput, "2" );
+    MakeFile( testInput, "2" );
+    MakeFile( additionalInput, "int Additional() { return 2; }\n" );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "All" ) );
+
+        const Node::Type types[] = { Node::EXEC_NODE, Node::TEST_NODE, Node::LIBRARY_NODE };
+        for ( const Node::Type type : types )
+        {
+            const FBuildStats::Stats & stats = fBuild.GetStats().GetStatsFor( type );
+            TEST_ASSERT( stats.m_NumCacheHits == 0 );
+            TEST_ASSERT( stats.m_NumCacheMisses == 1 );
+            TEST_ASSERT( stats.m_NumBuilt == 1 );
+        }
+    }
+
+    // Change the environment of the Exec and Test
+    options.m_UseCacheWrite = true;
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "All" ) ); // Store the new inputs
+    }
+    Env::SetEnvVariable( "NODE_OUTPUT_CACHING_ENV", AString( "2" ) );
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "All" ) );
+
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::EXEC_NODE ).m_NumCacheMisses == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::TEST_NODE ).m_NumCacheMisses == 1 );
+        TEST_ASSERT( fBuild.GetStats().GetStatsFor( Node::LIBRARY_NODE ).m_NumCacheHits == 1 );
+    }
+}
+
+// DependencyCacheKey
+//------------------------------------------------------------------------------
+void TestCache::DependencyCacheKey() const
+{
+    // Start with an empty cache so header changes are guaranteed to miss
+    DeleteCacheFiles( "../tmp/Test/Cache/DependencyCacheKey/Cache/" );
+
+    // Header included by file1.cpp
+    const char * const header = "../tmp/Test/Cache/DependencyCacheKey/Generated/generated.h";
+    EnsureDirExists( "../tmp/Test/Cache/DependencyCacheKey/Generated/" );
+    MakeFile( header, "#define GENERATED_VALUE 1\n" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/DependencyCacheKey/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    const char * const expectedFiles[] = { "DependencyCacheKey/file1.cpp", "Generated/generated.h" };
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == 2 );
+        TEST_ASSERT( fBuild.GetStats().GetDependencyCacheKeyCount() == 2 );
+
+        CheckForDependencies( fBuild, expectedFiles, sizeof( expectedFiles ) / sizeof( const char * ) );
+    }
+
+    // Read
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        TEST_ASSERT( objStats.m_NumBuilt == 0 );
+        TEST_ASSERT( fBuild.GetStats().GetDependencyCacheKeyCount() == 2 );
+
+        // Dependencies must be available even though the compiler was never run
+        CheckForDependencies( fBuild, expectedFiles, sizeof( expectedFiles ) / sizeof( const char * ) );
+    }
+
+    // Modify header
+    MakeFile( header, "#define GENERATED_VALUE 1234\n" );
+
+    // Read again - only the file using the header should miss
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 1 );
+        TEST_ASSERT( objStats.m_NumCacheMisses == 1 );
+        TEST_ASSERT( objStats.m_NumBuilt == 1 );
+    }
+}
+
+// DependencyCacheKey_Prefetch
+//------------------------------------------------------------------------------
+void TestCache::DependencyCacheKey_Prefetch() const
+{
+    DeleteCacheFiles( "../tmp/Test/Cache/DependencyCacheKey/Cache/" );
+
+    EnsureDirExists( "../tmp/Test/Cache/DependencyCacheKey/Generated/" );
+    MakeFile( "../tmp/Test/Cache/DependencyCacheKey/Generated/generated.h", "#define GENERATED_VALUE 1\n" );
+
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCache/DependencyCacheKey/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+    options.m_CacheVerbose = true;
+
+    // Write
+    {
+        options.m_UseCacheWrite = true;
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheStores == 2 );
+    }
+
+    // Read with prefetching
+    {
+        options.m_UseCacheWrite = false;
+        options.m_UseCacheRead = true;
+        options.m_CachePrefetch = true;
+        options.m_CachePrefetchWait_Debug = true; // Don't let build threads get there first
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        const FBuildStats::Stats & objStats = fBuild.GetStats().GetStatsFor( Node::OBJECT_NODE );
+        TEST_ASSERT( objStats.m_NumCacheHits == 2 );
+        TEST_ASSERT( objStats.m_NumBuilt == 0 );
+        TEST_ASSERT( fBuild.GetStats().GetDependencyCacheKeyCount() == 2 );
+
+        // Keys were formed in the background and reused by the build threads
+        const CachePrefetchStats & prefetchStats = fBuild.GetStats().m_CachePrefetchStats;
+        TEST_ASSERT( prefetchStats.m_NumQueued == 2 );
+        TEST_ASSERT( prefetchStats.m_NumRequested == 2 );
+        TEST_ASSERT( prefetchStats.m_NumHits == 2 );
+        TEST_ASSERT( prefetchStats.m_NumUsed == 2 );
+        TEST_ASSERT( prefetchStats.m_NumKeysReused == 2 );
+        TEST_ASSERT( prefetchStats.m_NumWasted == 0 );
+
+        // Dependencies come from the background key formation
+        const char * const expectedFiles[] = { "DependencyCacheKey/file1.cpp", "Generated/generated.h" };
+        CheckForDependencies( fBuild, expectedFiles, sizeof( expectedFiles ) / sizeof( const char * ) );
+    }
+}
+
+// CheckForDependencies
+//------------------------------------------------------------------------------
+void TestCache::CheckForDependencies( const FBuildForTest & fBuild, const char * const files[], size_t numFiles ) const
+{
+    Array< const Node * > nodes;
+    fBuild.GetNodesOfType( Node::FILE_NODE, nodes );
+    for ( size_t i = 0; i < numFiles; ++i )
+    {
+        AStackString<> file( files[ i ] );
+        #if defined( __WINDOWS__ )
+            file.Replace( '/', '\\' ); // Allow calling code to not have to care about the platform
+        #endif
+        bool found = false;
+        for ( const Node * node : nodes )
+        {
+            if ( node->GetName().EndsWith( file ) )
+            {
+                found = true;
+                break;
+            }
+        }
+        TEST_ASSERTM( found, "Missing dependency: %s", files[ i ] );
+    }
+}
+
+// DeleteCacheFiles
+//------------------------------------------------------------------------------
+void TestCache::DeleteCacheFiles( const char * cachePath ) const
+{
+    Array< AString > oldFiles;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( "*" ), true, &oldFiles );
+    for ( const AString & oldFile : oldFiles )
+    {
+        FileIO::FileDelete( oldFile.Get() );
+    }
+}
+
+// GetPackBytes
+//  - Total size of a PackedCache's pack files
+//------------------------------------------------------------------------------
+uint64_t TestCache::GetPackBytes( const char * cachePath ) const
+{
+    Array< AString > packFiles;
+    FileIO::GetFiles( AStackString<>( cachePath ), AStackString<>( "*.fpk" ), false, &packFiles );
+    uint64_t packBytes = 0;
+    for ( const AString & packFile : packFiles )
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( packFile.Get(), FileStream::READ_ONLY ) );
+        packBytes += f.GetFileSize();
+    }
+    return packBytes;
+}
+
+// PackedCachePublishThreadFunc
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestCache::PackedCachePublishThreadFunc( void * userData )
+{
+    PackedCachePublishThreadData & threadData = *static_cast< PackedCachePublishThreadData * >( userData );
+
+    PackedCache cache;
+    threadData.m_OK = cache.Init( AStackString<>( threadData.m_CachePath ), AString::GetEmpty(), true, true, false, AString::GetEmpty() );
+    AStackString<> cacheId;
+    AString data;
+    for ( uint32_t i = 0; ( i < 100 ) && threadData.m_OK; ++i )
+    {
+        GetPackedCacheTestData( threadData.m_ThreadIndex, i, cacheId, data );
+        threadData.m_OK = cache.Publish( cacheId, data.Get(), data.GetLength() );
+    }
+    cache.Shutdown();
+    return 0;
+}
+
+// GetPackedCacheTestData
+//------------------------------------------------------------------------------
+/*static*/ void TestCache::GetPackedCacheTestData( uint32_t threadIndex, uint32_t entryIndex, AString & outCacheId, AString & outData )
+{
+    outCacheId.Format( "Thread%u_Entry%u", threadIndex, entryIndex );
+    outData.SetLength( 4096 + ( entryIndex * 64 ) );
+    memset( outData.Get(), (int)( 'A' + ( ( threadIndex + entryIndex ) % 26 ) ), outData.GetLength() );
+}
+
+// CorruptFile
+//  - Flip the last byte of a file, or truncate it if newSize is non-zero
+//------------------------------------------------------------------------------
+void TestCache::CorruptFile( const AString & fileName, size_t newSize ) const
+{
+    AString contents;
+    {
+        FileStream f;
+        TEST_ASSERT( f.Open( fileName.Get(), FileStream::READ_ONLY ) );
+        contents.SetLength( (uint32_t)f.GetFileSize() );
+        TEST_ASSERT( f.ReadBuffer( contents.Get(), contents.GetLength() ) == contents.GetLength() );
+    }
+    TEST_ASSERT( contents.IsEmpty() == false );
+    if ( newSize > 0 )
+    {
+        contents.SetLength( (uint32_t)newSize );
+    }
+    else
+    {
+        contents[ contents.GetLength() - 1 ] = (char)~contents[ contents.GetLength() - 1 ];
     }
+    FileStream f;
+    TEST_ASSERT( f.Open( fileName.Get(), FileStream::WRITE_ONLY ) );
+    TEST_ASSERT( f.WriteBuffer( contents.Get(), contents.GetLength() ) == contents.GetLength() );
 }
 
 //------------------------------------------------------------------------------
@@ -6,6 +6,7 @@
 #include "FBuildTest.h"
 
 // FBuildCore
+#include "Tools/FBuild/FBuildCore/Cache/CacheWriteQueue.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Graph/SettingsNode.h"
 
@@ -23,6 +24,10 @@ private:
     void UsePlugin() const;
     void PluginOptionsSavedToDB() const;
 
+    // Batched and streaming functions (version 2 interface)
+    void BuildPlugin_V2() const;
+    void UsePlugin_V2() const;
+
     // Ensure old plugins with only mangled names on Windows continue to work)
     void BuildPlugin_Old() const;
     void UsePlugin_Old() const;
@@ -34,6 +39,8 @@ REGISTER_TESTS_BEGIN( TestCachePlugin )
     REGISTER_TEST( BuildPlugin )
     REGISTER_TEST( UsePlugin )
     REGISTER_TEST( PluginOptionsSavedToDB )
+    REGISTER_TEST( BuildPlugin_V2 )
+    REGISTER_TEST( UsePlugin_V2 )
 
     // Ensure old plugins with only mangled names on Windows continue to work)
     #if defined( __WINDOWS__ )
@@ -153,6 +160,80 @@ void TestCachePlugin::PluginOptionsSavedToDB() const
     }
 }
 
+// BuildPlugin_V2
+//------------------------------------------------------------------------------
+void TestCachePlugin::BuildPlugin_V2() const
+{
+    FBuildTestOptions options;
+    options.m_ForceCleanBuild = true;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCachePlugin/InterfaceV2/buildplugin.bff";
+
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    TEST_ASSERT( fBuild.Build( "Plugin-DLL-X64" ) );
+}
+
+// UsePlugin_V2
+//------------------------------------------------------------------------------
+void TestCachePlugin::UsePlugin_V2() const
+{
+    FBuildTestOptions options;
+    options.m_ForceCleanBuild = true;
+    options.m_UseCacheRead = true;
+    options.m_UseCacheWrite = true;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestCachePlugin/InterfaceV2/useplugin.bff";
+
+    // Plugin stores entries in this folder
+    EnsureDirExists( "../tmp/Test/CachePlugin/InterfaceV2/Cache/" );
+
+    // Write
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( GetRecordedOutput().Find( "Missing CachePluginDLL function" ) == nullptr );
+
+        TEST_ASSERT( fBuild.Build( "TestFiles-Lib" ) );
+        TEST_ASSERT( fBuild.GetStats().GetCacheStores() == 1 );
+
+        // Existence is checked and stores are made via the batch functions. The
+        // entry may be present already from a previous run.
+        const CacheWriteStats & writeStats = fBuild.GetStats().m_CacheWriteStats;
+        TEST_ASSERT( ( writeStats.m_NumPublished + writeStats.m_NumAlreadyPresent ) == 1 );
+        TEST_ASSERT( GetRecordedOutput().Find( "CacheExistsBatch Called" ) );
+    }
+
+    // Write again (entry should be skipped as it is already present)
+    {
+        options.m_UseCacheRead = false;
+
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( "TestFiles-Lib" ) );
+        const CacheWriteStats & writeStats = fBuild.GetStats().m_CacheWriteStats;
+        TEST_ASSERT( writeStats.m_NumPublished == 0 );
+        TEST_ASSERT( writeStats.m_NumAlreadyPresent == 1 );
+        TEST_ASSERT( GetRecordedOutput().Find( "CachePublish Called" ) == nullptr );
+    }
+
+    // Read (via streaming)
+    {
+        options.m_UseCacheRead = true;
+        options.m_UseCacheWrite = false;
+
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+
+        TEST_ASSERT( fBuild.Build( "TestFiles-Lib" ) );
+        TEST_ASSERT( fBuild.GetStats().GetCacheStores() == 0 );
+        TEST_ASSERT( fBuild.GetStats().GetCacheHits() == 1 );
+
+        TEST_ASSERT( GetRecordedOutput().Find( "CacheRetrieveStream Called" ) );
+        TEST_ASSERT( GetRecordedOutput().Find( "CacheRetrieve Called" ) == nullptr );
+    }
+}
+
 // BuildPlugin_Old
 //------------------------------------------------------------------------------
 void TestCachePlugin::BuildPlugin_Old() const
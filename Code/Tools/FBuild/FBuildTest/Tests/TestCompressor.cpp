@@ -10,6 +10,8 @@
 // Core
 #include "Core/Containers/UniquePtr.h"
 #include "Core/FileIO/FileStream.h"
+#include "Core/Math/Random.h"
+#include "Core/Process/Thread.h"
 #include "Core/Strings/AString.h"
 #include "Core/Time/Timer.h"
 #include "Core/Tracing/Tracing.h"
@@ -27,6 +29,18 @@ private:
     void CompressPreprocessedFile() const;
     void CompressObjFile() const;
     void TestHeaderValidity() const;
+    void CompressLarge() const;
+    void CompressLargeConcurrent() const;
+    void ConvertToBasicFormat() const;
+
+    struct CompressLargeThreadData
+    {
+        const char *    m_Data;
+        size_t          m_DataSize;
+        volatile bool   m_OK;
+    };
+    static void GenerateLargeData( UniquePtr< char > & outData, size_t & outDataSize );
+    static uint32_t CompressLargeThreadFunc( void * userData );
 
     void CompressSimpleHelper( const char * data,
                                size_t size,
@@ -42,6 +56,9 @@ REGISTER_TESTS_BEGIN( TestCompressor )
     REGISTER_TEST( CompressPreprocessedFile )
     REGISTER_TEST( CompressObjFile )
     REGISTER_TEST( TestHeaderValidity )
+    REGISTER_TEST( CompressLarge )
+    REGISTER_TEST( CompressLargeConcurrent )
+    REGISTER_TEST( ConvertToBasicFormat )
 REGISTER_TESTS_END
 
 // CompressSimple
@@ -226,4 +243,139 @@ void TestCompressor::TestHeaderValidity() const
     TEST_ASSERT( Compressor::IsValidData( buffer.Get(), 44 ) == false );
 }
 
+// CompressLarge
+//------------------------------------------------------------------------------
+void TestCompressor::CompressLarge() const
+{
+    UniquePtr< char > data;
+    size_t dataSize;
+    GenerateLargeData( data, dataSize );
+
+    const int32_t compressionLevels[] = { -1, 3 };
+    for ( const int32_t compressionLevel : compressionLevels )
+    {
+        // Compress
+        Compressor c;
+        TEST_ASSERT( c.Compress( data.Get(), dataSize, compressionLevel ) );
+        TEST_ASSERT( c.GetResultSize() < dataSize );
+        TEST_ASSERT( Compressor::IsValidData( c.GetResult(), c.GetResultSize() ) );
+        TEST_ASSERT( Compressor::GetUncompressedSize( c.GetResult(), c.GetResultSize() ) == dataSize );
+
+        // Decompress
+        Compressor d;
+        TEST_ASSERT( d.Decompress( c.GetResult() ) );
+        TEST_ASSERT( d.GetResultSize() == dataSize );
+        TEST_ASSERT( memcmp( data.Get(), d.GetResult(), dataSize ) == 0 );
+    }
+}
+
+// CompressLargeConcurrent
+//------------------------------------------------------------------------------
+void TestCompressor::CompressLargeConcurrent() const
+{
+    // Several threads compressing at once share the chunk helper threads
+    UniquePtr< char > data;
+    size_t dataSize;
+    GenerateLargeData( data, dataSize );
+
+    const uint32_t numThreads = 4;
+    CompressLargeThreadData threadData[ numThreads ];
+    Thread threads[ numThreads ];
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        threadData[ i ].m_Data = data.Get();
+        threadData[ i ].m_DataSize = dataSize;
+        threadData[ i ].m_OK = false;
+        threads[ i ].Start( CompressLargeThreadFunc, "CompressLarge", &threadData[ i ] );
+    }
+    for ( uint32_t i = 0; i < numThreads; ++i )
+    {
+        threads[ i ].Join();
+        TEST_ASSERT( threadData[ i ].m_OK );
+    }
+}
+
+// ConvertToBasicFormat
+//------------------------------------------------------------------------------
+void TestCompressor::ConvertToBasicFormat() const
+{
+    UniquePtr< char > data;
+    size_t dataSize;
+    GenerateLargeData( data, dataSize );
+
+    // Large data is chunked, which older versions can't decompress
+    Compressor c;
+    TEST_ASSERT( c.Compress( data.Get(), dataSize ) );
+    TEST_ASSERT( Compressor::IsBasicFormat( c.GetResult(), c.GetResultSize() ) == false );
+
+    // Convert
+    Compressor b;
+    TEST_ASSERT( b.ConvertToBasicFormat( c.GetResult() ) );
+    TEST_ASSERT( Compressor::IsBasicFormat( b.GetResult(), b.GetResultSize() ) );
+    TEST_ASSERT( b.GetResultSize() < dataSize );
+
+    // Decompress
+    Compressor d;
+    TEST_ASSERT( d.Decompress( b.GetResult() ) );
+    TEST_ASSERT( d.GetResultSize() == dataSize );
+    TEST_ASSERT( memcmp( data.Get(), d.GetResult(), dataSize ) == 0 );
+
+    // Small data is already in the basic format
+    Compressor s;
+    TEST_ASSERT( s.Compress( data.Get(), 64 * 1024 ) );
+    TEST_ASSERT( Compressor::IsBasicFormat( s.GetResult(), s.GetResultSize() ) );
+}
+
+// CompressLargeThreadFunc
+//------------------------------------------------------------------------------
+/*static*/ uint32_t TestCompressor::CompressLargeThreadFunc( void * userData )
+{
+    const CompressLargeThreadData * td = static_cast< const CompressLargeThreadData * >( userData );
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        Compressor c;
+        if ( ( c.Compress( td->m_Data, td->m_DataSize ) == false ) || ( c.GetResultSize() >= td->m_DataSize ) )
+        {
+            return 0;
+        }
+        Compressor d;
+        if ( ( d.Decompress( c.GetResult() ) == false ) ||
+             ( d.GetResultSize() != td->m_DataSize ) ||
+             ( memcmp( td->m_Data, d.GetResult(), td->m_DataSize ) != 0 ) )
+        {
+            return 0;
+        }
+    }
+    static_cast< CompressLargeThreadData * >( userData )->m_OK = true;
+    return 0;
+}
+
+// GenerateLargeData
+//------------------------------------------------------------------------------
+/*static*/ void TestCompressor::GenerateLargeData( UniquePtr< char > & outData, size_t & outDataSize )
+{
+    // Build a buffer large enough to be compressed in chunks, from repeated
+    // preprocessed source with an incompressible region (stored as-is)
+    UniquePtr< void > source;
+    size_t sourceSize;
+    {
+        FileStream fs;
+        TEST_ASSERT( fs.Open( "Tools/FBuild/FBuildTest/Data/TestCompressor/TestPreprocessedFile.ii" ) );
+        sourceSize = (size_t)fs.GetFileSize();
+        source = (char *)ALLOC( sourceSize );
+        TEST_ASSERT( (uint32_t)fs.Read( source.Get(), sourceSize ) == sourceSize );
+    }
+    outDataSize = ( 9 * MEGABYTE ) + 12345; // Partial last chunk
+    outData = (char *)ALLOC( outDataSize );
+    for ( size_t pos = 0; pos < outDataSize; pos += sourceSize )
+    {
+        memcpy( outData.Get() + pos, source.Get(), Math::Min( sourceSize, outDataSize - pos ) );
+    }
+    Random r( 1234 );
+    for ( size_t i = ( 2 * MEGABYTE ); i < ( 4 * MEGABYTE ); ++i )
+    {
+        outData.Get()[ i ] = (char)r.GetRand();
+    }
+}
+
 //------------------------------------------------------------------------------
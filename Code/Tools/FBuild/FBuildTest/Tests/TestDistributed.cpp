@@ -6,13 +6,17 @@
 #include "Tools/FBuild/FBuildTest/Tests/FBuildTest.h"
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Graph/CompilerNode.h"
 #include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
+#include "Tools/FBuild/FBuildCore/Helpers/ToolManifest.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Protocol.h"
 #include "Tools/FBuild/FBuildCore/Protocol/Server.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/Job.h"
 #include "Tools/FBuild/FBuildCore/WorkerPool/JobQueueRemote.h"
 
+#include "Core/FileIO/ConstMemoryStream.h"
 #include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/MemoryStream.h"
 #include "Core/Strings/AStackString.h"
 
 // Defines
@@ -31,6 +35,9 @@ private:
     void TestWith1RemoteWorkerThread() const;
     void TestWith4RemoteWorkerThreads() const;
     void WithPCH() const;
+    void ProfileRemoteSlotUsage() const;
+    void ToolchainFileStore() const;
+    void ToolchainDuplicateFiles() const;
     void RegressionTest_RemoteCrashOnErrorFormatting();
     void TestLocalRace();
     void RemoteRaceWinRemote();
@@ -61,6 +68,9 @@ REGISTER_TESTS_BEGIN( TestDistributed )
     REGISTER_TEST( TestWith1RemoteWorkerThread )
     REGISTER_TEST( TestWith4RemoteWorkerThreads )
     REGISTER_TEST( WithPCH )
+    REGISTER_TEST( ProfileRemoteSlotUsage )
+    REGISTER_TEST( ToolchainFileStore )
+    REGISTER_TEST( ToolchainDuplicateFiles )
     REGISTER_TEST( RegressionTest_RemoteCrashOnErrorFormatting )
     REGISTER_TEST( TestLocalRace )
     REGISTER_TEST( RemoteRaceWinRemote )
@@ -151,6 +161,221 @@ void TestDistributed::WithPCH() const
     TestHelper( target, 4 );
 }
 
+// ProfileRemoteSlotUsage
+//------------------------------------------------------------------------------
+void TestDistributed::ProfileRemoteSlotUsage() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/Batching/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_AllowLocalRace = false; // ensure all results are returned before the build completes
+    options.m_NumWorkerThreads = 4; // make several jobs available for distribution at once
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_ForceCleanBuild = true;
+    options.m_DistributionPort = Protocol::PROTOCOL_TEST_PORT;
+    ASSERT( options.m_Profile );
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+
+    // Jobs are requested and returned in batches
+    Server s( 4 );
+    s.Listen( Protocol::PROTOCOL_TEST_PORT );
+    #if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+        // Let jobs compiling in parallel complete before results are returned
+        Server::SetFakeResultBatchingDelay( 200 );
+    #endif
+
+    TEST_ASSERT( fBuild.Build( "Batching" ) );
+
+    #if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+        Server::SetFakeResultBatchingDelay( 0 );
+    #endif
+
+    // Check usage of remote worker slots was recorded
+    AString profile;
+    LoadFileContentsAsString( "fbuild_profile.json", profile );
+    TEST_ASSERT( profile.Find( "\"Worker: " ) );
+    TEST_ASSERT( profile.Find( "\"Jobs In Flight\"" ) );
+
+    // Check messages carried more than one job
+    Server::BatchStats requestJobs;
+    Server::BatchStats jobs;
+    Server::BatchStats jobResults;
+    s.GetBatchStats( requestJobs, jobs, jobResults );
+    TEST_ASSERT( requestJobs.m_MaxJobsPerMessage > 1 );
+    TEST_ASSERT( jobs.m_MaxJobsPerMessage > 1 );
+    TEST_ASSERT( jobs.m_NumJobs == 12 ); // Every job was sent in MSG_JOBS
+    TEST_ASSERT( jobResults.m_NumJobs == 12 ); // Every result was returned in MSG_JOB_RESULTS
+    #if defined( ENABLE_FAKE_RESULT_BATCHING_DELAY )
+        TEST_ASSERT( jobResults.m_MaxJobsPerMessage > 1 );
+    #endif
+}
+
+// ToolchainFileStore
+//------------------------------------------------------------------------------
+void TestDistributed::ToolchainFileStore() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/fbuild.bff";
+    options.m_AllowDistributed = true;
+    options.m_NumWorkerThreads = 1;
+    options.m_NoLocalConsumptionOfRemoteJobs = true; // ensure all jobs happen on the remote worker
+    options.m_ForceCleanBuild = true;
+    options.m_DistributionPort = Protocol::PROTOCOL_TEST_PORT;
+
+    AStackString<> storeDir;
+    VERIFY( FBuild::GetTempDir( storeDir ) );
+    #if defined( __WINDOWS__ )
+        storeDir += ".fbuild.tmp\\worker\\store";
+    #else
+        storeDir += "_fbuild.tmp/worker/store";
+    #endif
+
+    // Synchronize toolchain
+    Array< AString > toolchainFiles;
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        Server s( 1 );
+        s.Listen( Protocol::PROTOCOL_TEST_PORT );
+        TEST_ASSERT( fBuild.Build( "../tmp/Test/Distributed/dist.lib" ) );
+
+        // Find the files synchronized for the toolchain used by this build
+        // (the worker dir is shared with other tests)
+        Array< const Node * > compilers;
+        fBuild.GetNodesOfType( Node::COMPILER_NODE, compilers );
+        for ( const Node * compiler : compilers )
+        {
+            const ToolManifest & manifest = compiler->CastTo< CompilerNode >()->GetManifest();
+            if ( manifest.GetToolId() == 0 )
+            {
+                continue; // not used by this build
+            }
+            AStackString<> toolchainDir;
+            manifest.GetRemotePath( toolchainDir );
+            FileIO::GetFiles( toolchainDir, AStackString<>( "*" ), true, &toolchainFiles );
+        }
+    }
+    TEST_ASSERT( toolchainFiles.IsEmpty() == false );
+
+    // Synchronized toolchain files are added to the store
+    Array< AString > storeFiles;
+    FileIO::GetFiles( storeDir, AStackString<>( "*" ), false, &storeFiles );
+    TEST_ASSERT( storeFiles.IsEmpty() == false );
+
+    // Remove the synchronized toolchain
+    for ( const AString & file : toolchainFiles )
+    {
+        TEST_ASSERT( FileIO::FileDelete( file.Get() ) );
+    }
+
+    // Toolchain is assembled from the store
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        Server s( 1 );
+        s.Listen( Protocol::PROTOCOL_TEST_PORT );
+        TEST_ASSERT( fBuild.Build( "../tmp/Test/Distributed/dist.lib" ) );
+    }
+    for ( const AString & file : toolchainFiles )
+    {
+        TEST_ASSERT( FileIO::FileExists( file.Get() ) );
+    }
+
+    // No new content was stored
+    Array< AString > storeFilesAfter;
+    FileIO::GetFiles( storeDir, AStackString<>( "*" ), false, &storeFilesAfter );
+    TEST_ASSERT( storeFilesAfter.GetSize() == storeFiles.GetSize() );
+}
+
+// ToolchainDuplicateFiles
+//------------------------------------------------------------------------------
+void TestDistributed::ToolchainDuplicateFiles() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestDistributed/DuplicateFiles/fbuild.bff";
+    options.m_ForceCleanBuild = true;
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "Compiler-Duplicates" ) );
+
+    Array< const Node * > compilers;
+    fBuild.GetNodesOfType( Node::COMPILER_NODE, compilers );
+    TEST_ASSERT( compilers.GetSize() == 1 );
+    const ToolManifest & clientManifest = compilers[ 0 ]->CastTo< CompilerNode >()->GetManifest();
+    const Array< ToolManifestFile > & clientFiles = clientManifest.GetFiles();
+    TEST_ASSERT( clientFiles.GetSize() == 3 );
+
+    // Emulate the worker end
+    MemoryStream ms;
+    clientManifest.SerializeForRemote( ms );
+    ToolManifest remote( clientManifest.GetToolId() );
+
+    // Remove any toolchain left from previous runs
+    AStackString<> toolchainDir;
+    remote.GetRemotePath( toolchainDir );
+    Array< AString > oldFiles;
+    FileIO::GetFiles( toolchainDir, AStackString<>( "*" ), true, &oldFiles );
+    for ( const AString & file : oldFiles )
+    {
+        TEST_ASSERT( FileIO::FileDelete( file.Get() ) );
+    }
+
+    // Make the store unusable for the duplicated content
+    AStackString<> storeEntry;
+    VERIFY( FBuild::GetTempDir( storeEntry ) );
+    AStackString<> storeSubDir;
+    #if defined( __WINDOWS__ )
+        storeSubDir.Format( ".fbuild.tmp\\worker\\store\\%08x.%08x", clientFiles[ 1 ].GetHash(), clientFiles[ 1 ].GetUncompressedContentSize() );
+    #else
+        storeSubDir.Format( "_fbuild.tmp/worker/store/%08x.%08x", clientFiles[ 1 ].GetHash(), clientFiles[ 1 ].GetUncompressedContentSize() );
+    #endif
+    storeEntry += storeSubDir;
+    FileIO::FileDelete( storeEntry.Get() );
+    TEST_ASSERT( FileIO::EnsurePathExists( storeEntry ) ); // A directory can't be linked or copied
+
+    {
+        ConstMemoryStream cms( ms.GetData(), ms.GetSize() );
+        TEST_ASSERT( remote.DeserializeFromRemote( cms ) );
+    }
+
+    // Request files as Server::RequestMissingFiles does
+    // (only one of the duplicates is transferred)
+    size_t numTransferred = 0;
+    for ( size_t i = 0; i < remote.GetFiles().GetSize(); ++i )
+    {
+        if ( remote.GetFiles()[ i ].GetSyncState() != ToolManifestFile::NOT_SYNCHRONIZED )
+        {
+            continue;
+        }
+        const bool duplicate = remote.FindSynchronizingDuplicate( i );
+        remote.MarkFileAsSynchronizing( i );
+        if ( duplicate )
+        {
+            continue;
+        }
+        size_t dataSize = 0;
+        const void * data = clientManifest.GetFileData( (uint32_t)i, dataSize );
+        TEST_ASSERT( data );
+        bool corrupt = false;
+        TEST_ASSERT( remote.ReceiveFileData( (uint32_t)i, data, dataSize, corrupt ) );
+        TEST_ASSERT( corrupt == false );
+        ++numTransferred;
+    }
+    FileIO::DirectoryDelete( storeEntry );
+
+    // Duplicate was assembled from the received file, without the store
+    TEST_ASSERT( numTransferred == 2 );
+    TEST_ASSERT( remote.IsSynchronized() );
+    for ( size_t i = 0; i < remote.GetFiles().GetSize(); ++i )
+    {
+        AStackString<> remoteFile;
+        remote.GetRemoteFilePath( (uint32_t)i, remoteFile );
+        TEST_ASSERT( FileIO::FileExists( remoteFile.Get() ) );
+    }
+}
+
 // RegressionTest_RemoteCrashOnErrorFormatting
 //------------------------------------------------------------------------------
 void TestDistributed::RegressionTest_RemoteCrashOnErrorFormatting()
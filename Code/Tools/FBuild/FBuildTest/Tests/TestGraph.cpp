@@ -47,14 +47,19 @@ private:
     void TestCleanPathPartial() const;
     void SingleFileNode() const;
     void SingleFileNodeMissing() const;
+    void NodeMapGrowth() const;
+    void NodeMapConcurrentFind() const;
     void TestDirectoryListNode() const;
     void TestSerialization() const;
     void TestDeepGraph() const;
     void TestNoStopOnFirstError() const;
+    void RepeatBuildAfterFailure() const;
     void DBLocationChanged() const;
     void DBCorrupt() const;
     void BFFDirtied() const;
     void DBVersionChanged() const;
+    void DBJournal() const;
+    void InvalidateNodes() const;
     void FixupErrorPaths() const;
     void CyclicDependency() const;
 };
@@ -68,14 +73,19 @@ REGISTER_TESTS_BEGIN( TestGraph )
     REGISTER_TEST( TestCleanPathPartial )
     REGISTER_TEST( SingleFileNode )
     REGISTER_TEST( SingleFileNodeMissing )
+    REGISTER_TEST( NodeMapGrowth )
+    REGISTER_TEST( NodeMapConcurrentFind )
     REGISTER_TEST( TestDirectoryListNode )
     REGISTER_TEST( TestSerialization )
     REGISTER_TEST( TestDeepGraph )
     REGISTER_TEST( TestNoStopOnFirstError )
+    REGISTER_TEST( RepeatBuildAfterFailure )
     REGISTER_TEST( DBLocationChanged )
     REGISTER_TEST( DBCorrupt )
     REGISTER_TEST( BFFDirtied )
     REGISTER_TEST( DBVersionChanged )
+    REGISTER_TEST( DBJournal )
+    REGISTER_TEST( InvalidateNodes )
     REGISTER_TEST( FixupErrorPaths )
     REGISTER_TEST( CyclicDependency )
 REGISTER_TESTS_END
@@ -265,6 +275,105 @@ void TestGraph::SingleFileNodeMissing() const
     TEST_ASSERT( fb.Build( node ) == true );
 }
 
+// NodeMapGrowth
+//------------------------------------------------------------------------------
+void TestGraph::NodeMapGrowth() const
+{
+    FBuild fb;
+    NodeGraph ng( 1 ); // Start small to force the map to grow
+
+    // Create many nodes
+    const uint32_t numNodes = 20000;
+    Array< Node * > nodes( numNodes, false );
+    for ( uint32_t i = 0; i < numNodes; ++i )
+    {
+        AStackString<> name;
+        name.Format( "Dir/File%u.cpp", i );
+        nodes.Append( ng.CreateFileNode( name ) );
+    }
+
+    // All nodes can be found, regardless of case
+    for ( uint32_t i = 0; i < numNodes; ++i )
+    {
+        const AString & name = nodes[ i ]->GetName();
+        TEST_ASSERT( ng.FindNodeExact( name ) == nodes[ i ] );
+
+        AStackString<> upperName( name );
+        upperName.ToUpper();
+        TEST_ASSERT( ng.FindNodeExact( upperName ) == nodes[ i ] );
+    }
+
+    // Missing nodes are not found
+    TEST_ASSERT( ng.FindNode( AStackString<>( "Dir/File.cpp" ) ) == nullptr );
+}
+
+// NodeMapConcurrentFind
+//------------------------------------------------------------------------------
+void TestGraph::NodeMapConcurrentFind() const
+{
+    FBuild fb;
+    NodeGraph ng( 1 ); // Start small so lookups overlap with growth
+
+    const uint32_t numNodes = 10000;
+    for ( uint32_t i = 0; i < numNodes; ++i )
+    {
+        AStackString<> name;
+        name.Format( "Dir/File%u.cpp", i );
+        ng.CreateFileNode( name );
+    }
+
+    struct ThreadData
+    {
+        const NodeGraph *   m_NodeGraph;
+        uint32_t            m_NumNodes;
+        volatile bool       m_Stop;
+
+        static uint32_t ThreadFunc( void * userData )
+        {
+            const ThreadData & data = *static_cast< const ThreadData * >( userData );
+            uint32_t numMissing = 0;
+            do
+            {
+                for ( uint32_t i = 0; i < data.m_NumNodes; ++i )
+                {
+                    AStackString<> name;
+                    name.Format( "Dir/File%u.cpp", i );
+                    if ( data.m_NodeGraph->FindNode( name ) == nullptr )
+                    {
+                        ++numMissing;
+                    }
+                }
+            } while ( data.m_Stop == false );
+            return numMissing;
+        }
+    };
+    ThreadData data{ &ng, numNodes, false };
+
+    // Look up existing nodes on several threads...
+    const uint32_t numThreads = 4;
+    Thread threads[ numThreads ];
+    for ( Thread & thread : threads )
+    {
+        thread.Start( ThreadData::ThreadFunc, "NodeMapFind", &data );
+    }
+
+    // ...while more nodes are added
+    for ( uint32_t i = numNodes; i < ( numNodes * 4 ); ++i )
+    {
+        AStackString<> name;
+        name.Format( "Dir/File%u.cpp", i );
+        ng.CreateFileNode( name );
+    }
+    data.m_Stop = true;
+
+    // Existing nodes must always be found
+    for ( Thread & thread : threads )
+    {
+        TEST_ASSERT( thread.Join() == 0 );
+    }
+    TEST_ASSERT( ng.GetNodeCount() == ( numNodes * 4 ) );
+}
+
 // TestDirectoryListNode
 //------------------------------------------------------------------------------
 void TestGraph::TestDirectoryListNode() const
@@ -656,6 +765,22 @@ void TestGraph::TestNoStopOnFirstError() const
     }
 }
 
+// RepeatBuildAfterFailure
+//------------------------------------------------------------------------------
+void TestGraph::RepeatBuildAfterFailure() const
+{
+    // A failed build leaves nodes waiting on their dependencies. A subsequent
+    // build in the same process must not be blocked by that stale state.
+    FBuildTestOptions options;
+    options.m_NumWorkerThreads = 0; // ensure test behaves deterministically
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/NoStopOnFirstError/fbuild.bff";
+
+    FBuild fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "all" ) == false ); // Expect build to fail
+    TEST_ASSERT( fBuild.Build( "all" ) == false ); // Expect build to fail again (and not hang)
+}
+
 // DBLocationChanged
 //------------------------------------------------------------------------------
 void TestGraph::DBLocationChanged() const
@@ -899,6 +1024,171 @@ void TestGraph::DBVersionChanged() const
     TEST_ASSERT( GetRecordedOutput().Find( "Database version has changed" ) );
 }
 
+// DBJournal
+//------------------------------------------------------------------------------
+void TestGraph::DBJournal() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/DBJournal/fbuild.bff";
+    options.m_JournalDB = true;
+
+    const char * dbFile = "../tmp/Test/Graph/DBJournal/fbuild.fdb";
+    const char * journalFile = "../tmp/Test/Graph/DBJournal/fbuild.fdb.journal";
+    const char * sourceFile = "../tmp/Test/Graph/DBJournal/source.txt";
+
+    EnsureFileDoesNotExist( dbFile );
+    EnsureFileDoesNotExist( journalFile );
+    EnsureDirExists( "../tmp/Test/Graph/DBJournal/" );
+    MakeFile( sourceFile, "Original" );
+
+    // Initial build saves the entire DB
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+        TEST_ASSERT( FileIO::FileExists( journalFile ) == false );
+    }
+    AString db;
+    LoadFileContentsAsString( dbFile, db );
+    const uint64_t dbHash = xxHash3::Calc64( db.Get(), db.GetLength() );
+
+    // Modify the source, ensuring the filetime changes
+    {
+        AStackString<> sourceFileFullPath;
+        FileIO::GetCurrentDir( sourceFileFullPath );
+        sourceFileFullPath += '/';
+        sourceFileFullPath += sourceFile;
+        const uint64_t oldTime = FileIO::GetFileLastWriteTime( sourceFileFullPath );
+        MakeFile( sourceFile, "Modified" );
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( sourceFileFullPath, oldTime + 10000000000ULL ) );
+    }
+
+    // Rebuild appends to the journal instead of rewriting the DB
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 1, Node::COPY_FILE_NODE );
+        EnsureFileExists( journalFile );
+
+        LoadFileContentsAsString( dbFile, db );
+        TEST_ASSERT( xxHash3::Calc64( db.Get(), db.GetLength() ) == dbHash );
+    }
+
+    // Journal is applied when loading, so nothing needs building
+    {
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 0, Node::COPY_FILE_NODE );
+    }
+
+    // A full save rewrites the DB and discards the journal
+    {
+        options.m_JournalDB = false;
+        FBuild fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+        CheckStatsNode( 1, 0, Node::COPY_FILE_NODE );
+        TEST_ASSERT( FileIO::FileExists( journalFile ) == false );
+    }
+}
+
+// InvalidateNodes
+//------------------------------------------------------------------------------
+void TestGraph::InvalidateNodes() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestGraph/InvalidateNodes/fbuild.bff";
+
+    const char * sourceFile = "../tmp/Test/Graph/InvalidateNodes/source.txt";
+    const char * destFile = "../tmp/Test/Graph/InvalidateNodes/dest.txt";
+
+    EnsureDirExists( "../tmp/Test/Graph/InvalidateNodes/" );
+    EnsureFileDoesNotExist( destFile );
+    MakeFile( sourceFile, "Original" );
+
+    FBuildForTest fBuild( options );
+    TEST_ASSERT( fBuild.Initialize() );
+    TEST_ASSERT( fBuild.Build( "Copy" ) );
+
+    AString dest;
+    LoadFileContentsAsString( destFile, dest );
+    TEST_ASSERT( dest == "Original" );
+
+    // Modify the source, ensuring the filetime changes
+    AStackString<> sourceFileFullPath( sourceFile );
+    NodeGraph::CleanPath( sourceFileFullPath );
+    {
+        const uint64_t oldTime = FileIO::GetFileLastWriteTime( sourceFileFullPath );
+        MakeFile( sourceFile, "Modified" );
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( sourceFileFullPath, oldTime + 10000000000ULL ) );
+    }
+
+    // Unrelated changes don't cause anything to be re-evaluated
+    {
+        Array< AString > changedFiles;
+        changedFiles.EmplaceBack( "/Unrelated/File.txt" );
+        TEST_ASSERT( fBuild.InvalidateNodes( changedFiles ) );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        LoadFileContentsAsString( destFile, dest );
+        TEST_ASSERT( dest == "Original" );
+    }
+
+    // Changed source is re-evaluated, along with everything depending on it
+    {
+        Array< AString > changedFiles;
+        changedFiles.Append( sourceFileFullPath );
+        TEST_ASSERT( fBuild.InvalidateNodes( changedFiles ) );
+        TEST_ASSERT( fBuild.GetNode( sourceFileFullPath.Get() )->GetState() == Node::NOT_PROCESSED );
+        TEST_ASSERT( fBuild.GetNode( "Copy" )->GetState() == Node::NOT_PROCESSED );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        LoadFileContentsAsString( destFile, dest );
+        TEST_ASSERT( dest == "Modified" );
+    }
+
+    // Files beneath a changed directory (e.g. one which was renamed) are re-evaluated
+    {
+        const uint64_t oldTime = FileIO::GetFileLastWriteTime( sourceFileFullPath );
+        MakeFile( sourceFile, "Moved" );
+        TEST_ASSERT( FileIO::SetFileLastWriteTime( sourceFileFullPath, oldTime + 10000000000ULL ) );
+
+        Array< AString > changedFiles;
+        Array< AString > changedDirs;
+        AString & changedDir = changedDirs.EmplaceBack( sourceFileFullPath.Get(), sourceFileFullPath.FindLast( NATIVE_SLASH ) );
+        TEST_ASSERT( fBuild.InvalidateNodes( changedFiles, changedDirs ) );
+        TEST_ASSERT( fBuild.GetNode( sourceFileFullPath.Get() )->GetState() == Node::NOT_PROCESSED );
+        TEST_ASSERT( fBuild.GetNode( "Copy" )->GetState() == Node::NOT_PROCESSED );
+        TEST_ASSERT( fBuild.Build( "Copy" ) );
+        LoadFileContentsAsString( destFile, dest );
+        TEST_ASSERT( dest == "Moved" );
+
+        // A sibling directory with the same prefix is unrelated
+        changedDir += "Other";
+        TEST_ASSERT( fBuild.InvalidateNodes( changedFiles, changedDirs ) );
+        TEST_ASSERT( fBuild.GetNode( "Copy" )->GetState() == Node::UP_TO_DATE );
+    }
+
+    // Changes to the BFF can't be handled
+    {
+        Array< AString > changedFiles;
+        AString & bffFile = changedFiles.EmplaceBack( options.m_ConfigFile );
+        NodeGraph::CleanPath( bffFile );
+        TEST_ASSERT( fBuild.InvalidateNodes( changedFiles ) == false );
+
+        // Nor can changes to the directory containing it
+        Array< AString > changedDirs;
+        changedDirs.EmplaceBack( bffFile.Get(), bffFile.FindLast( NATIVE_SLASH ) );
+        changedFiles.Clear();
+        TEST_ASSERT( fBuild.InvalidateNodes( changedFiles, changedDirs ) == false );
+    }
+}
+
 // FixupErrorPaths
 //------------------------------------------------------------------------------
 void TestGraph::FixupErrorPaths() const
@@ -7,6 +7,7 @@
 
 #include "Tools/FBuild/FBuildCore/FBuild.h"
 #include "Tools/FBuild/FBuildCore/Helpers/CIncludeParser.h"
+#include "Tools/FBuild/FBuildCore/Helpers/DirectiveScanner.h"
 
 // Core
 #include "Core/FileIO/FileStream.h"
@@ -31,6 +32,11 @@ private:
     void TestClangMSExtensionsPreprocessedOutput() const;
     void TestEdgeCases() const;
     void ClangLineEndings() const;
+    void DirectiveScanner_EdgeCases() const;
+    void DirectiveScanner_Benchmark() const;
+
+    // Helpers
+    void CheckDirectiveScanner( const char * data, size_t dataSize ) const;
 };
 
 // Register Tests
@@ -48,6 +54,8 @@ REGISTER_TESTS_BEGIN( TestIncludeParser )
     REGISTER_TEST( TestClangMSExtensionsPreprocessedOutput )
     REGISTER_TEST( TestEdgeCases )
     REGISTER_TEST( ClangLineEndings )
+    REGISTER_TEST( DirectiveScanner_EdgeCases )
+    REGISTER_TEST( DirectiveScanner_Benchmark )
 REGISTER_TESTS_END
 
 // TestMSVCPreprocessedOutput
@@ -468,4 +476,167 @@ void TestIncludeParser::ClangLineEndings() const
     #endif
 }
 
+// DirectiveScanner_EdgeCases
+//------------------------------------------------------------------------------
+void TestIncludeParser::DirectiveScanner_EdgeCases() const
+{
+    // Place interesting sequences at every offset relative to the 32 byte blocks
+    // checked by the vectorized implementation and compare against the scalar one
+    const char * const fragments[] =
+    {
+        "\n#",         // hash at start of line
+        "\r#",         // hash after CR
+        "x#",           // hash not at start of line
+        "*/",           // end of comment block
+        "* /",          // not end of comment block
+        "**/",          // end of comment block after star
+        "\r\n",       // line end
+    };
+    for ( const char * fragment : fragments )
+    {
+        for ( uint32_t offset = 0; offset < 70; ++offset )
+        {
+            // Pad with '/*' so SkipCommentBlock can start at the beginning
+            AStackString<> data( "/*" );
+            for ( uint32_t i = 0; i < offset; ++i )
+            {
+                data += 'a';
+            }
+            data += fragment;
+            for ( uint32_t i = 0; i < 40; ++i )
+            {
+                data += 'b';
+            }
+            CheckDirectiveScanner( data.Get(), data.GetLength() );
+
+            // Also check with the fragment at the very end of the data
+            data.SetLength( 2 + offset + (uint32_t)AString::StrLen( fragment ) );
+            CheckDirectiveScanner( data.Get(), data.GetLength() );
+        }
+    }
+
+    // Null terminates a line or comment block
+    {
+        const char data[] = "/*aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\0*/bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb";
+        const size_t dataSize = sizeof( data ) - 1;
+        TEST_ASSERT( DirectiveScanner::FindLineEnd( data, data + dataSize ) == data + 44 );
+        TEST_ASSERT( DirectiveScanner::SkipCommentBlock( data, data + dataSize ) == data + 44 );
+        CheckDirectiveScanner( data, dataSize );
+    }
+
+    // Nothing found
+    {
+        const char data[] = "/*aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+        const size_t dataSize = sizeof( data ) - 1;
+        TEST_ASSERT( DirectiveScanner::FindLineEnd( data, data + dataSize ) == data + dataSize );
+        TEST_ASSERT( DirectiveScanner::FindHashAtLineStart( data + 1, data + dataSize ) == data + dataSize );
+        TEST_ASSERT( DirectiveScanner::SkipCommentBlock( data, data + dataSize ) == data + dataSize );
+    }
+
+    // Real world data
+    FileStream f;
+    TEST_ASSERT( f.Open( "Tools/FBuild/FBuildTest/Data/TestIncludeParser/fbuildcore.gcc.ii", FileStream::READ_ONLY ) );
+    const uint32_t fileSize = (uint32_t)f.GetFileSize();
+    AString mem;
+    mem.SetLength( fileSize );
+    TEST_ASSERT( f.Read( mem.Get(), fileSize ) == fileSize );
+    const char * pos = mem.Get();
+    const char * const end = mem.GetEnd();
+    uint32_t numLines = 0;
+    while ( pos < end )
+    {
+        const char * lineEnd = DirectiveScanner::FindLineEnd( pos, end );
+        TEST_ASSERT( lineEnd == DirectiveScanner::FindLineEnd_Scalar( pos, end ) );
+        pos = lineEnd + 1;
+        ++numLines;
+    }
+    TEST_ASSERT( numLines > 1000 );
+    pos = mem.Get() + 1;
+    uint32_t numHashes = 0;
+    while ( pos < end )
+    {
+        const char * hash = DirectiveScanner::FindHashAtLineStart( pos, end );
+        TEST_ASSERT( hash == DirectiveScanner::FindHashAtLineStart_Scalar( pos, end ) );
+        pos = hash + 1;
+        ++numHashes;
+    }
+    TEST_ASSERT( numHashes > 100 );
+}
+
+// DirectiveScanner_Benchmark
+//------------------------------------------------------------------------------
+void TestIncludeParser::DirectiveScanner_Benchmark() const
+{
+    FileStream f;
+    TEST_ASSERT( f.Open( "Tools/FBuild/FBuildTest/Data/TestIncludeParser/fbuildcore.gcc.ii", FileStream::READ_ONLY ) );
+    const uint32_t fileSize = (uint32_t)f.GetFileSize();
+    AString mem;
+    mem.SetLength( fileSize );
+    TEST_ASSERT( f.Read( mem.Get(), fileSize ) == fileSize );
+
+    const char * const begin = mem.Get();
+    const char * const end = mem.GetEnd();
+    const size_t repeatCount( 50 );
+    const float mib = (float)( fileSize * repeatCount ) / ( 1024.0f * 1024.0f );
+
+    // Line by line, as done by LightCache
+    for ( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        const bool scalar = ( pass == 0 );
+        size_t numLines = 0;
+        const Timer t;
+        for ( size_t i = 0; i < repeatCount; ++i )
+        {
+            const char * pos = begin;
+            while ( pos < end )
+            {
+                pos = scalar ? DirectiveScanner::FindLineEnd_Scalar( pos, end )
+                             : DirectiveScanner::FindLineEnd( pos, end );
+                ++pos;
+                ++numLines;
+            }
+        }
+        const float time = t.GetElapsed();
+        OUTPUT( "FindLineEnd%s : %2.3fs (%2.1f MiB/sec) (%zu lines)\n", scalar ? " (scalar)" : "         ", (double)time, (double)( mib / time ), numLines );
+    }
+
+    // Directive search, as done by CIncludeParser
+    for ( uint32_t pass = 0; pass < 2; ++pass )
+    {
+        const bool scalar = ( pass == 0 );
+        size_t numHashes = 0;
+        const Timer t;
+        for ( size_t i = 0; i < repeatCount; ++i )
+        {
+            const char * pos = begin + 1;
+            while ( pos < end )
+            {
+                pos = scalar ? DirectiveScanner::FindHashAtLineStart_Scalar( pos, end )
+                             : DirectiveScanner::FindHashAtLineStart( pos, end );
+                ++pos;
+                ++numHashes;
+            }
+        }
+        const float time = t.GetElapsed();
+        OUTPUT( "FindHashAtLineStart%s : %2.3fs (%2.1f MiB/sec) (%zu directives)\n", scalar ? " (scalar)" : "         ", (double)time, (double)( mib / time ), numHashes );
+    }
+
+    OUTPUT( "DirectiveScanner vectorized: %s\n", DirectiveScanner::IsVectorized() ? "yes" : "no" );
+}
+
+// CheckDirectiveScanner
+//------------------------------------------------------------------------------
+void TestIncludeParser::CheckDirectiveScanner( const char * data, size_t dataSize ) const
+{
+    TEST_ASSERT( ( dataSize >= 2 ) && ( data[ 0 ] == '/' ) && ( data[ 1 ] == '*' ) );
+    const char * const end = data + dataSize;
+
+    TEST_ASSERT( DirectiveScanner::SkipCommentBlock( data, end ) == DirectiveScanner::SkipCommentBlock_Scalar( data, end ) );
+    for ( const char * pos = data + 1; pos <= end; ++pos )
+    {
+        TEST_ASSERT( DirectiveScanner::FindLineEnd( pos, end ) == DirectiveScanner::FindLineEnd_Scalar( pos, end ) );
+        TEST_ASSERT( DirectiveScanner::FindHashAtLineStart( pos, end ) == DirectiveScanner::FindHashAtLineStart_Scalar( pos, end ) );
+    }
+}
+
 //------------------------------------------------------------------------------
@@ -0,0 +1,170 @@
+// TestJobQueue.cpp
+//------------------------------------------------------------------------------
+
+// Includes
+//------------------------------------------------------------------------------
+#include "FBuildTest.h"
+
+// FBuildCore
+#include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/JobQueue.h"
+#include "Tools/FBuild/FBuildCore/WorkerPool/WorkerThread.h"
+
+// Core
+#include "Core/Process/Thread.h"
+#include "Core/Time/Timer.h"
+
+// TestJobQueue
+//------------------------------------------------------------------------------
+class TestJobQueue : public FBuildTest
+{
+private:
+    DECLARE_TESTS
+
+    void CostTree_Ordering() const;
+    void CostTree_Stealing() const;
+    void ParallelFor_WakesWorkers() const;
+};
+
+// Register Tests
+//------------------------------------------------------------------------------
+REGISTER_TESTS_BEGIN( TestJobQueue )
+    REGISTER_TEST( CostTree_Ordering )
+    REGISTER_TEST( CostTree_Stealing )
+    REGISTER_TEST( ParallelFor_WakesWorkers )
+REGISTER_TESTS_END
+
+// CostTree_Ordering
+//------------------------------------------------------------------------------
+void TestJobQueue::CostTree_Ordering() const
+{
+    // Non power of 2 number of sub queues, some of which are empty
+    JobCostTree tree( 5 );
+    tree.Update( 0, true, 3 );
+    tree.Update( 1, true, 10 );
+    tree.Update( 2, true, 7 );
+    tree.Update( 3, false, 0 );
+    tree.Update( 4, true, 0 ); // A zero cost job is still a job
+
+    // Sub queues should be found in order of decreasing cost as they are drained
+    const uint32_t expectedOrder[] = { 1, 2, 0, 4 };
+    for ( const uint32_t expected : expectedOrder )
+    {
+        uint32_t leaf = 0xFFFFFFFF;
+        TEST_ASSERT( tree.FindMostExpensive( 3, leaf ) );
+        TEST_ASSERT( leaf == expected );
+        tree.Update( leaf, false, 0 );
+    }
+
+    // Nothing left
+    uint32_t leaf = 0xFFFFFFFF;
+    TEST_ASSERT( tree.FindMostExpensive( 0, leaf ) == false );
+
+    // A sub queue whose top job becomes cheaper is re-ordered
+    tree.Update( 0, true, 50 );
+    tree.Update( 4, true, 40 );
+    TEST_ASSERT( tree.FindMostExpensive( 0, leaf ) && ( leaf == 0 ) );
+    tree.Update( 0, true, 5 );
+    TEST_ASSERT( tree.FindMostExpensive( 0, leaf ) && ( leaf == 4 ) );
+}
+
+// CostTree_Stealing
+//------------------------------------------------------------------------------
+void TestJobQueue::CostTree_Stealing() const
+{
+    JobCostTree tree( 8 );
+
+    // A worker whose own sub queue is empty takes work from another
+    tree.Update( 6, true, 1 );
+    uint32_t leaf = 0xFFFFFFFF;
+    TEST_ASSERT( tree.FindMostExpensive( 2, leaf ) && ( leaf == 6 ) );
+
+    // When costs are equal, a worker prefers its own sub queue
+    tree.Update( 2, true, 1 );
+    TEST_ASSERT( tree.FindMostExpensive( 2, leaf ) && ( leaf == 2 ) );
+    TEST_ASSERT( tree.FindMostExpensive( 6, leaf ) && ( leaf == 6 ) );
+
+    // ...but not over a more expensive job elsewhere
+    tree.Update( 7, true, 2 );
+    TEST_ASSERT( tree.FindMostExpensive( 2, leaf ) && ( leaf == 7 ) );
+
+    // A worker with no preference among equals still gets one of them
+    tree.Update( 7, false, 0 );
+    TEST_ASSERT( tree.FindMostExpensive( 0, leaf ) && ( ( leaf == 2 ) || ( leaf == 6 ) ) );
+
+    // Rebuilding the internal nodes gives the same answers
+    tree.Rebuild();
+    TEST_ASSERT( tree.FindMostExpensive( 6, leaf ) && ( leaf == 6 ) );
+    tree.Update( 2, false, 0 );
+    tree.Update( 6, false, 0 );
+    tree.Rebuild();
+    TEST_ASSERT( tree.FindMostExpensive( 0, leaf ) == false );
+}
+
+// ParallelForData
+//------------------------------------------------------------------------------
+namespace
+{
+    #define JOBQUEUE_TEST_MAX_THREADS 16
+
+    struct ParallelForData
+    {
+        volatile uint32_t m_ChunksPerThread[ JOBQUEUE_TEST_MAX_THREADS ];
+    };
+
+    void ParallelForTestFunc( uint32_t /*firstItem*/, uint32_t /*numItems*/, void * userData )
+    {
+        ParallelForData * data = static_cast<ParallelForData *>( userData );
+        const uint16_t threadIndex = WorkerThread::GetThreadIndex();
+        ASSERT( threadIndex < JOBQUEUE_TEST_MAX_THREADS );
+        AtomicInc( &data->m_ChunksPerThread[ threadIndex ] );
+
+        // Take long enough that the main thread can't finish alone before idle
+        // workers would wake up by themselves
+        Thread::Sleep( 20 );
+    }
+}
+
+// ParallelFor_WakesWorkers
+//------------------------------------------------------------------------------
+void TestJobQueue::ParallelFor_WakesWorkers() const
+{
+    FBuildTestOptions options;
+    options.m_NumWorkerThreads = 4;
+    const FBuildForTest fBuild( options );
+    FBuildForTest::ClearStopBuild();
+    JobQueue jobQueue( 4 );
+
+    // Let the workers go idle (they wait up to 500ms for a wakeup)
+    Thread::Sleep( 50 );
+
+    ParallelForData data;
+    for ( volatile uint32_t & count : data.m_ChunksPerThread )
+    {
+        count = 0;
+    }
+
+    const Timer t;
+    jobQueue.ParallelFor( 16, 1, ParallelForTestFunc, &data );
+    const float elapsed = t.GetElapsed();
+
+    // All chunks were processed exactly once
+    uint32_t totalChunks = 0;
+    uint32_t numWorkersHelped = 0;
+    for ( uint32_t i = 0; i < JOBQUEUE_TEST_MAX_THREADS; ++i )
+    {
+        totalChunks += data.m_ChunksPerThread[ i ];
+        if ( ( i > 0 ) && ( data.m_ChunksPerThread[ i ] > 0 ) )
+        {
+            ++numWorkersHelped;
+        }
+    }
+    TEST_ASSERT( totalChunks == 16 );
+
+    // Idle workers must have been woken to help, rather than the main thread
+    // doing the work alone (16 x 20ms) before they time out
+    TEST_ASSERTM( numWorkersHelped >= 2, "Workers helped: %u", numWorkersHelped );
+    TEST_ASSERTM( elapsed < 0.3f, "Elapsed: %2.3fs", (double)elapsed );
+}
+
+//------------------------------------------------------------------------------
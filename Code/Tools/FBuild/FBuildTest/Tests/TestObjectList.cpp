@@ -9,8 +9,12 @@
 #include "Tools/FBuild/FBuildCore/BFF/BFFParser.h"
 #include "Tools/FBuild/FBuildCore/BFF/Functions/FunctionObjectList.h"
 #include "Tools/FBuild/FBuildCore/FBuild.h"
+#include "Tools/FBuild/FBuildCore/Graph/ObjectNode.h"
 
 // Core
+#include "Core/FileIO/FileIO.h"
+#include "Core/FileIO/FileStream.h"
+#include "Core/FileIO/PathUtils.h"
 #include "Core/Strings/AStackString.h"
 
 // TestObjectList
@@ -28,6 +32,7 @@ private:
     void ExtraOutputFolders_PathExtraction() const;
     void ObjectListChaining() const;
     void ObjectListChaining_Bad() const;
+    void ManyInputFiles() const;
     #if defined( __WINDOWS__ )
         void ExtraOutputFolders_Build() const;
     #endif
@@ -43,6 +48,7 @@ REGISTER_TESTS_BEGIN( TestObjectList )
     REGISTER_TEST( ExtraOutputFolders_PathExtraction )
     REGISTER_TEST( ObjectListChaining )
     REGISTER_TEST( ObjectListChaining_Bad )
+    REGISTER_TEST( ManyInputFiles )
     #if defined( __WINDOWS__ )
         REGISTER_TEST( ExtraOutputFolders_Build )
     #endif
@@ -350,4 +356,83 @@ void TestObjectList::ObjectListChaining_Bad() const
     }
 #endif
 
+// ManyInputFiles
+//  - Ensure dynamic dependencies are correct when created in parallel
+//------------------------------------------------------------------------------
+void TestObjectList::ManyInputFiles() const
+{
+    FBuildTestOptions options;
+    options.m_ConfigFile = "Tools/FBuild/FBuildTest/Data/TestObjectList/ManyInputFiles/fbuild.bff";
+    const char * dbFile = "../tmp/Test/ObjectList/ManyInputFiles/fbuild.fdb";
+
+    // Generate input files
+    const uint32_t numFiles = 100; // More than one chunk of work
+    const AStackString<> inputPath( "../tmp/Test/ObjectList/ManyInputFiles/Input/" );
+    TEST_ASSERT( FileIO::EnsurePathExists( inputPath ) );
+    for ( uint32_t i = 0; i < numFiles; ++i )
+    {
+        AStackString<> fileName;
+        fileName.Format( "%sFile%u.cpp", inputPath.Get(), i );
+        AStackString<> contents;
+        contents.Format( "int Function%u() { return %u; }\n", i, i );
+        FileStream f;
+        TEST_ASSERT( f.Open( fileName.Get(), FileStream::WRITE_ONLY ) );
+        TEST_ASSERT( f.WriteBuffer( contents.Get(), contents.GetLength() ) == contents.GetLength() );
+    }
+
+    // Check each object is created for the matching input
+    auto checkDynamicDependencies = [ numFiles ]( const FBuildForTest & fBuild )
+    {
+        const Node * objectListNode = fBuild.GetNode( "ObjectList" );
+        TEST_ASSERT( objectListNode );
+        const Dependencies & deps = objectListNode->GetDynamicDependencies();
+        TEST_ASSERT( deps.GetSize() == numFiles );
+        for ( const Dependency & dep : deps )
+        {
+            TEST_ASSERT( dep.GetNode()->GetType() == Node::OBJECT_NODE );
+            const ObjectNode * on = dep.GetNode()->CastTo< ObjectNode >();
+
+            // File123.cpp -> File123.o/.obj
+            const AString & src = on->GetSourceFile()->GetName();
+            const char * srcStem = src.FindLast( NATIVE_SLASH ) + 1;
+            const AStackString<> stem( srcStem, src.FindLast( '.' ) );
+            AStackString<> expectedObj( NATIVE_SLASH_STR );
+            expectedObj += stem;
+            #if defined( __WINDOWS__ )
+                expectedObj += ".obj";
+            #else
+                expectedObj += ".o";
+            #endif
+            TEST_ASSERT( on->GetName().EndsWith( expectedObj ) );
+        }
+    };
+
+    // Build
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize() );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+        TEST_ASSERT( fBuild.SaveDependencyGraph( dbFile ) );
+
+        checkDynamicDependencies( fBuild );
+
+        // Check stats
+        //               Seen,      Built,      Type
+        CheckStatsNode(  numFiles,  numFiles,   Node::OBJECT_NODE );
+    }
+
+    // Check no-rebuild (existing object nodes are re-used)
+    {
+        FBuildForTest fBuild( options );
+        TEST_ASSERT( fBuild.Initialize( dbFile ) );
+        TEST_ASSERT( fBuild.Build( "ObjectList" ) );
+
+        checkDynamicDependencies( fBuild );
+
+        // Check stats
+        //               Seen,      Built,      Type
+        CheckStatsNode(  numFiles,  0,          Node::OBJECT_NODE );
+    }
+}
+
 //------------------------------------------------------------------------------